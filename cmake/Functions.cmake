@@ -478,6 +478,18 @@ macro(dune_probe_functions)
     "sys/types.h;sys/socket.h;winsock2.h"
     DUNE_SYS_HAS_SOCKET)
 
+  dune_test_function(recvmmsg
+    "int"
+    "int;struct mmsghdr*;unsigned int;int;struct timespec*"
+    "sys/types.h;sys/socket.h"
+    DUNE_SYS_HAS_RECVMMSG)
+
+  dune_test_function(sendmmsg
+    "int"
+    "int;struct mmsghdr*;unsigned int;int"
+    "sys/types.h;sys/socket.h"
+    DUNE_SYS_HAS_SENDMMSG)
+
   dune_test_function(WSAStartup
     "int"
     "WORD;WSADATA*"
@@ -122,6 +122,7 @@ macro(dune_probe_headers)
   dune_test_header(sys/stat.h)
   dune_test_header(sys/statfs.h)
   dune_test_header(sys/sendfile.h)
+  dune_test_header(sys/epoll.h)
   dune_test_header(sys/time.h)
   dune_test_header(sys/timex.h)
   dune_test_header(sys/types.h)
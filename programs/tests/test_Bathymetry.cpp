@@ -0,0 +1,134 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+#include <DUNE/Simulation/Bathymetry.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using DUNE_NAMESPACES;
+using DUNE::Simulation::Bathymetry;
+
+//! Depth of a bottom sloping towards north.
+static double
+slope(double x, double y)
+{
+  (void)y;
+  return 10.0 + 0.1 * x;
+}
+
+int
+main(void)
+{
+  Test test("Simulation::Bathymetry");
+
+  //! Samples on a 2 m lattice over 100 x 60 m.
+  std::vector<Bathymetry::Sample> samples;
+  for (unsigned i = 0; i <= 50; ++i)
+  {
+    for (unsigned j = 0; j <= 30; ++j)
+    {
+      Bathymetry::Sample s = {i * 2.0, j * 2.0, slope(i * 2.0, j * 2.0)};
+      samples.push_back(s);
+    }
+  }
+
+  Bathymetry bathy;
+  bathy.setDefaultDepth(100.0);
+  bathy.create(41.0, -8.0, samples, 2.0, 3.0);
+  test.boolean("create()", bathy.getRows() == 51 + 1 && bathy.getColumns() == 31 + 1);
+
+  test.boolean("depth at node", std::abs(bathy.getDepth(20.0, 30.0) - slope(20.0, 30.0)) < 1e-5);
+  test.boolean("bilinear depth", std::abs(bathy.getDepth(21.3, 30.7) - slope(21.3, 30.7)) < 1e-5);
+  test.boolean("depth out of bounds", bathy.getDepth(-10.0, 30.0) == 100.0);
+
+  bathy.setOffset(1.5);
+  test.boolean("depth offset", std::abs(bathy.getDepth(21.3, 30.7) - slope(21.3, 30.7) - 1.5) < 1e-5);
+  bathy.setOffset(0.0);
+
+  Path path("/tmp/test_Bathymetry.bin");
+  bathy.save(path.str());
+
+  Bathymetry loaded;
+  loaded.setDefaultDepth(100.0);
+  loaded.load(path.str());
+  test.boolean("load()", loaded.getRows() == bathy.getRows() && loaded.getColumns() == bathy.getColumns()
+               && loaded.getLatitude() == 41.0 && loaded.getLongitude() == -8.0);
+
+  bool same = true;
+  for (double x = 0; x < 100.0; x += 0.7)
+    same = same && loaded.getDepth(x, 17.0) == bathy.getDepth(x, 17.0);
+  test.boolean("loaded depths", same);
+
+  double dirs[3][3] =
+  {
+    {0.0, 0.0, 1.0},
+    {std::sqrt(0.5), 0.0, std::sqrt(0.5)},
+    {-1.0, 0.0, 0.0}
+  };
+  double ranges[3];
+  loaded.getRanges(50.0, 30.0, 5.0, dirs, 3, 40.0, ranges);
+
+  // Down: 15 - 5. At 45 degrees: 5 + r / sqrt(2) = 10 + 0.1 * (50 + r / sqrt(2)).
+  test.boolean("vertical beam range", std::abs(ranges[0] - 10.0) < 1e-3);
+  test.boolean("slanted beam range", std::abs(ranges[1] - 10.0 / 0.9 * std::sqrt(2.0)) < 1e-2);
+  test.boolean("horizontal beam range", ranges[2] == 40.0);
+
+  // A grid with a gap: nodes without data are ignored.
+  samples.clear();
+  Bathymetry::Sample a = {0.0, 0.0, 10.0};
+  Bathymetry::Sample b = {20.0, 20.0, 20.0};
+  samples.push_back(a);
+  samples.push_back(b);
+  bathy.create(0.0, 0.0, samples, 10.0, 1.0);
+  test.boolean("depth near sample", std::abs(bathy.getDepth(1.0, 1.0) - 10.0) < 1e-9);
+  test.boolean("depth without data", bathy.getDepth(10.0, 10.0) == 100.0);
+
+  bool thrown = false;
+  try
+  {
+    loaded.load("/dev/null");
+  }
+  catch (std::runtime_error& e)
+  {
+    thrown = true;
+  }
+  test.boolean("load() invalid file", thrown);
+
+  path.remove();
+
+  return test.getReturnValue();
+}
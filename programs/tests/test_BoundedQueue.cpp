@@ -0,0 +1,115 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using namespace DUNE::Concurrency;
+
+class Producer: public Thread
+{
+public:
+  Producer(BoundedQueue<unsigned>& queue, unsigned count):
+    m_queue(queue),
+    m_count(count)
+  { }
+
+  void
+  run(void)
+  {
+    for (unsigned i = 0; i < m_count; ++i)
+      m_queue.push(i);
+  }
+
+private:
+  BoundedQueue<unsigned>& m_queue;
+  unsigned m_count;
+};
+
+int
+main(void)
+{
+  Test test("Concurrency::BoundedQueue");
+
+  {
+    BoundedQueue<unsigned> queue(4, 3);
+    bool room = true;
+    for (unsigned i = 0; i < 6; ++i)
+      room = queue.push(i) && room;
+
+    test.boolean("push() discards when full", !room);
+    test.boolean("size()", queue.size() == 4);
+    test.boolean("getDropped()", queue.getDropped() == 2);
+    test.boolean("getPeak()", queue.getPeak() == 4);
+    test.boolean("getHighWaterCrossings()", queue.getHighWaterCrossings() == 1);
+
+    std::vector<unsigned> items;
+    test.boolean("popAll() with limit", queue.popAll(items, 3) == 3);
+    test.boolean("popAll() keeps order", items[0] == 2 && items[1] == 3 && items[2] == 4);
+    test.boolean("popAll()", queue.popAll(items) == 1 && items.back() == 5);
+    test.boolean("empty()", queue.empty());
+    test.boolean("waitForItems() timeout", !queue.waitForItems(0.01));
+
+    queue.push(0);
+    queue.push(1);
+    queue.push(2);
+    test.boolean("getHighWaterCrossings() rearms", queue.getHighWaterCrossings() == 2);
+
+    queue.setCapacity(1);
+    test.boolean("setCapacity()", queue.size() == 1 && queue.getDropped() == 4);
+  }
+
+  {
+    const unsigned count = 10000;
+    BoundedQueue<unsigned> queue(count);
+    Producer producer(queue, count);
+    producer.start();
+
+    std::vector<unsigned> items;
+    while (items.size() < count && queue.waitForItems(1.0))
+      queue.popAll(items);
+
+    producer.stopAndJoin();
+
+    bool ordered = items.size() == count;
+    for (unsigned i = 0; ordered && i < count; ++i)
+      ordered = (items[i] == i);
+
+    test.boolean("concurrent push()/popAll()", ordered);
+    test.boolean("no drops below capacity", queue.getDropped() == 0);
+  }
+
+  return test.getReturnValue();
+}
@@ -0,0 +1,276 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <cstdarg>
+#include <cstdio>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using DUNE_NAMESPACES;
+
+//! Number of dispatches used to measure latency.
+static const unsigned c_dispatches = 200000;
+//! Number of bound message types in the loaded table.
+static const unsigned c_types = 2000;
+
+class Sink: public Tasks::AbstractTask
+{
+public:
+  Sink(void):
+    count(0)
+  { }
+
+  void
+  receive(const IMC::SharedMessage& msg)
+  {
+    (void)msg;
+    ++count;
+  }
+
+  const char*
+  getName(void) const
+  {
+    return "Sink";
+  }
+
+  void inf(const char*, ...) { }
+  void war(const char*, ...) { }
+  void err(const char*, ...) { }
+  void cri(const char*, ...) { }
+  void debug(const char*, ...) { }
+  void trace(const char*, ...) { }
+  void spew(const char*, ...) { }
+
+  void
+  run(void)
+  { }
+
+  std::atomic<unsigned> count;
+};
+
+//! Recipient whose queue is always full.
+class Stalled: public Sink
+{
+public:
+  Stalled(void):
+    offers(0)
+  { }
+
+  bool
+  tryReceive(const IMC::SharedMessage& msg, bool expired)
+  {
+    (void)msg;
+    ++offers;
+    return expired;
+  }
+
+  std::atomic<unsigned> offers;
+};
+
+class Dispatcher: public Concurrency::Thread
+{
+public:
+  Dispatcher(IMC::Bus& bus, const IMC::Message& msg):
+    m_bus(bus),
+    m_msg(msg)
+  { }
+
+  void
+  run(void)
+  {
+    m_bus.dispatch(&m_msg);
+  }
+
+private:
+  IMC::Bus& m_bus;
+  const IMC::Message& m_msg;
+};
+
+class Churn: public Concurrency::Thread
+{
+public:
+  Churn(IMC::Bus& bus, Sink& sink, uint16_t first, uint16_t count):
+    m_bus(bus),
+    m_sink(sink),
+    m_first(first),
+    m_count(count)
+  { }
+
+  void
+  run(void)
+  {
+    while (!isStopping())
+    {
+      for (uint16_t id = m_first; id < m_first + m_count; ++id)
+        m_bus.registerRecipient(&m_sink, id);
+      for (uint16_t id = m_first; id < m_first + m_count; ++id)
+        m_bus.unregisterRecipient(&m_sink, id);
+    }
+  }
+
+private:
+  IMC::Bus& m_bus;
+  Sink& m_sink;
+  uint16_t m_first;
+  uint16_t m_count;
+};
+
+static double
+measure(IMC::Bus& bus, const IMC::Message& msg)
+{
+  uint64_t start = Time::Clock::getNsec();
+  for (unsigned i = 0; i < c_dispatches; ++i)
+    bus.dispatch(&msg);
+  return (double)(Time::Clock::getNsec() - start) / c_dispatches;
+}
+
+int
+main(void)
+{
+  Test test("IMC::Bus");
+
+  IMC::Temperature temp;
+  IMC::Pressure press;
+
+  {
+    IMC::Bus bus;
+    Sink a;
+    Sink b;
+
+    bus.registerRecipient(&a, temp.getId());
+    bus.registerRecipient(&a, temp.getId());
+    bus.registerRecipient(&b, temp.getId());
+    bus.dispatch(&temp);
+    test.boolean("dispatch() to all recipients", a.count == 1 && b.count == 1);
+
+    bus.dispatch(&temp, &a);
+    test.boolean("dispatch() excludes task", a.count == 1 && b.count == 2);
+
+    bus.dispatch(&press);
+    test.boolean("dispatch() without recipients", a.count == 1 && b.count == 2);
+
+    bus.unregisterRecipient(&a, temp.getId());
+    bus.dispatch(&temp);
+    test.boolean("unregisterRecipient()", a.count == 1 && b.count == 3);
+
+    bus.pause();
+    bus.dispatch(&temp);
+    test.boolean("pause() holds messages", b.count == 3);
+    bus.resume();
+    test.boolean("resume() delivers messages", b.count == 4);
+
+    bus.unregisterRecipient(&b, temp.getId());
+    bus.unregisterRecipient(&b, temp.getId());
+    bus.dispatch(&temp);
+    test.boolean("unregister all recipients", b.count == 4);
+  }
+
+  {
+    IMC::Bus bus;
+    Sink sink;
+    Sink other;
+    bus.registerRecipient(&sink, temp.getId());
+
+    Churn churn(bus, other, 3000, 16);
+    churn.start();
+    for (unsigned i = 0; i < c_dispatches; ++i)
+      bus.dispatch(&temp);
+    churn.stopAndJoin();
+
+    test.boolean("dispatch() during subscription changes", sink.count == c_dispatches);
+  }
+
+  {
+    IMC::Bus bus;
+    Sink sink;
+    Sink other;
+    bus.registerRecipient(&sink, temp.getId());
+
+    // Another recipient of the same message comes and goes.
+    Churn churn(bus, other, temp.getId(), 1);
+    churn.start();
+    for (unsigned i = 0; i < c_dispatches; ++i)
+      bus.dispatch(&temp);
+    churn.stopAndJoin();
+
+    test.boolean("dispatch() while recipients of the message change",
+                 sink.count == c_dispatches && other.count <= c_dispatches);
+  }
+
+  {
+    IMC::Bus bus;
+    Stalled stalled;
+    Sink other;
+    bus.registerRecipient(&stalled, temp.getId());
+
+    Dispatcher dispatcher(bus, temp);
+    dispatcher.start();
+    while (stalled.offers == 0)
+      Delay::waitUsec(100);
+
+    // The dispatcher waits for room outside the read section.
+    uint64_t start = Time::Clock::getNsec();
+    bus.registerRecipient(&other, press.getId());
+    double wait = (double)(Time::Clock::getNsec() - start) / 1e9;
+    dispatcher.stopAndJoin();
+
+    test.boolean("blocked recipient does not stall subscriptions", wait < 0.05);
+    test.boolean("blocked recipient offered again", stalled.offers > 1);
+  }
+
+  {
+    IMC::Bus bus;
+    Sink sink;
+    size_t bindings = bus.getBindings().size();
+    bus.registerRecipient(&sink, temp.getId());
+    bus.registerRecipient(&sink, temp.getId());
+    test.boolean("registerRecipient() twice adds one binding", bus.getBindings().size() == bindings + 1);
+  }
+
+  {
+    IMC::Bus bus;
+    Sink sink;
+    bus.registerRecipient(&sink, temp.getId());
+    double sparse = measure(bus, temp);
+
+    for (unsigned i = 1; i <= c_types; ++i)
+      bus.registerRecipient(&sink, (uint16_t)(temp.getId() + i * 31));
+    double dense = measure(bus, temp);
+
+    std::fprintf(stderr, "  dispatch latency: %.1f ns (1 type), %.1f ns (%u types)\n",
+                 sparse, dense, c_types + 1);
+  }
+
+  return test.getReturnValue();
+}
@@ -0,0 +1,133 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Kristoffer Gryte                                                 *
+//***************************************************************************
+// Test and benchmark program for DUNE::Algorithms::CRC16 class.            *
+//***************************************************************************
+// ISO C++ headers
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// DUNE headers
+#include <DUNE/Algorithms/CRC16.hpp>
+#include <DUNE/Time/Clock.hpp>
+#include "Test.hpp"
+
+using namespace DUNE::Algorithms;
+using DUNE::Time::Clock;
+
+//! Total number of bytes processed per benchmark.
+static const double c_bench_bytes = 64e6;
+
+static uint16_t
+reference(const uint8_t* p, size_t len, uint16_t crc)
+{
+  for (size_t i = 0; i < len; ++i)
+    crc = CRC16::compute(p[i], crc);
+  return crc;
+}
+
+static double
+benchmark(CRC16::Implementation impl, const uint8_t* p, size_t len)
+{
+  unsigned rounds = (unsigned)(c_bench_bytes / len) + 1;
+  uint16_t crc = 0;
+
+  uint64_t start = Clock::getNsec();
+  for (unsigned i = 0; i < rounds; ++i)
+    crc = CRC16::compute(impl, p, len, crc);
+  uint64_t elapsed = Clock::getNsec() - start;
+
+  // Keep the result alive.
+  if (crc == 0x1234)
+    std::fprintf(stderr, " ");
+
+  return (double)rounds * len / elapsed;
+}
+
+int
+main(void)
+{
+  Test test("DUNE::Algorithms::CRC16");
+
+  const char* check = "123456789";
+  test.boolean("CRC-16/ARC check value",
+               CRC16::compute((const uint8_t*)check, 9) == 0xBB3D);
+
+  std::vector<uint8_t> data(70000);
+  std::srand(1);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = (uint8_t)std::rand();
+
+  const CRC16::Implementation impls[] =
+  {
+    CRC16::IMPL_BYTEWISE,
+    CRC16::IMPL_SLICE_BY_8,
+    CRC16::IMPL_CARRYLESS
+  };
+  const char* names[] = {"bytewise", "slice-by-8", "carry-less"};
+
+  for (unsigned i = 0; i < 3; ++i)
+  {
+    bool ok = true;
+    for (size_t len = 0; len < 600 && ok; ++len)
+    {
+      for (size_t off = 0; off < 16 && ok; off += 5)
+      {
+        uint16_t init = (uint16_t)(len * 7919 + off);
+        ok = CRC16::compute(impls[i], &data[off], len, init) == reference(&data[off], len, init);
+      }
+    }
+
+    ok = ok && CRC16::compute(impls[i], &data[3], 65535, 0xffff) == reference(&data[3], 65535, 0xffff);
+
+    char label[64];
+    std::sprintf(label, "%s matches table", names[i]);
+    test.boolean(label, ok);
+  }
+
+  bool ok = true;
+  for (uint16_t len = 0; len < 600 && ok; ++len)
+    ok = CRC16::compute(&data[1], len, 0x55aa) == reference(&data[1], len, 0x55aa);
+  test.boolean("compute() matches table", ok);
+
+  std::fprintf(stderr, "  default implementation: %s\n", names[CRC16::getImplementation()]);
+
+  const size_t sizes[] = {22, 64, 256, 1024, 8192, 65535};
+  std::fprintf(stderr, "  %8s %12s %12s %12s\n", "bytes", names[0], names[1], names[2]);
+  for (unsigned s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+  {
+    std::fprintf(stderr, "  %8u", (unsigned)sizes[s]);
+    for (unsigned i = 0; i < 3; ++i)
+      std::fprintf(stderr, " %7.2f GB/s", benchmark(impls[i], &data[0], sizes[s]));
+    std::fprintf(stderr, "\n");
+  }
+
+  return test.getReturnValue();
+}
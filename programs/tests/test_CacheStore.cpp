@@ -0,0 +1,145 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+
+// ISO C++ 98 headers.
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+#include <Transports/Cache/Store.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using DUNE_NAMESPACES;
+using Transports::Cache::Store;
+
+//! Store one entity information message.
+static void
+putEntity(Store& store, uint8_t id, const std::string& label)
+{
+  IMC::EntityInfo msg;
+  msg.id = id;
+  msg.label = label;
+  store.put(&msg);
+}
+
+//! Retrieve the label of an entity from the store.
+static std::string
+getLabel(Store& store, uint8_t id, size_t& count)
+{
+  std::vector<IMC::Message*> msgs;
+  store.get(msgs);
+  count = msgs.size();
+
+  std::string label;
+  for (size_t i = 0; i < msgs.size(); ++i)
+  {
+    IMC::EntityInfo* info = static_cast<IMC::EntityInfo*>(msgs[i]);
+    if (info->id == id)
+      label = info->label;
+    delete msgs[i];
+  }
+
+  return label;
+}
+
+int
+main(void)
+{
+  Test test("Cache Store");
+
+  Path path("/tmp/test_CacheStore.lsf");
+  Path tmp(path.str() + ".tmp");
+  if (path.exists())
+    path.remove();
+
+  {
+    Store store(path);
+    test.boolean("open empty", store.open() == 0);
+
+    putEntity(store, 1, "first");
+    putEntity(store, 2, "second");
+    putEntity(store, 1, "third");
+    test.boolean("stale record counted", store.getStaleBytes() > 0);
+  }
+
+  {
+    Store store(path);
+    test.boolean("reopen", store.open() == 0);
+
+    size_t count = 0;
+    test.boolean("put replaces", getLabel(store, 1, count) == "third" && count == 2);
+  }
+
+  {
+    // Partial record left by an interrupted write.
+    std::ofstream ofs(path.c_str(), std::ios::binary | std::ios::app);
+    ofs.write("\x54\xfe\x01\x00", 4);
+    ofs.close();
+
+    Store store(path);
+    test.boolean("partial record discarded", store.open() == 4);
+    test.boolean("partial record truncated", (uint64_t)path.size() == store.getLiveBytes());
+
+    size_t count = 0;
+    test.boolean("records kept", getLabel(store, 2, count) == "second" && count == 2);
+  }
+
+  {
+    Store store(path);
+    store.open();
+
+    std::string label(64, 'x');
+    bool compacted = false;
+    for (unsigned i = 0; i < 4000; ++i)
+    {
+      label[i % label.size()] = 'a' + (i % 26);
+      putEntity(store, 1, label);
+      compacted = compacted || store.getStaleBytes() == 0;
+    }
+
+    test.boolean("compacted", compacted && store.getStaleBytes() < Transports::Cache::c_compaction_minimum);
+    test.boolean("segment size", (uint64_t)path.size() == store.getLiveBytes() + store.getStaleBytes());
+    test.boolean("temporary segment renamed", !tmp.exists());
+
+    Store other(path);
+    other.open();
+    size_t count = 0;
+    test.boolean("reopen after compaction", getLabel(other, 1, count) == label && count == 2);
+  }
+
+  path.remove();
+
+  return test.getReturnValue();
+}
@@ -0,0 +1,329 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+
+// ISO C++ 98 headers.
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+#include <Transports/DataStore/DataStore.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using DUNE_NAMESPACES;
+using namespace Transports::DataStore;
+
+//! Task that owns the data store.
+class Owner: public Tasks::Task
+{
+public:
+  Owner(Tasks::Context& ctx):
+    Tasks::Task("Owner", ctx)
+  { }
+
+  void
+  onMain(void)
+  { }
+};
+
+//! Original position and time of a sample, indexed by its text.
+struct Origin
+{
+  double lat;
+  double lon;
+  double time;
+  int priority;
+};
+
+//! Create a sample carrying a text message of a given length.
+static DataSample*
+createSample(const std::string& tag, size_t length, double time, int priority,
+             double lat = 41.0, double lon = -8.0)
+{
+  IMC::DevDataText* msg = new IMC::DevDataText;
+  msg->value = tag;
+  if (msg->value.size() < length)
+    msg->value.resize(length, '.');
+
+  DataSample* s = new DataSample;
+  s->latDegs = lat;
+  s->lonDegs = lon;
+  s->zMeters = 1.0;
+  s->timestamp = time;
+  s->priority = priority;
+  s->source = 0x1234;
+  s->sample = msg;
+  return s;
+}
+
+//! Retrieve the text of a polled sample.
+static std::string
+getTag(const IMC::RemoteData* data)
+{
+  const HistoricSample* s = static_cast<const HistoricSample*>(data);
+  return static_cast<const IMC::DevDataText*>(s->sample.get())->value.substr(0, 4);
+}
+
+//! Serialize the fields of a polled message.
+static std::vector<uint8_t>
+serialize(const IMC::HistoricData* data)
+{
+  std::vector<uint8_t> bfr(data->getPayloadSerializationSize());
+  data->serializeFields(&bfr[0]);
+  return bfr;
+}
+
+//! Read a whole file.
+static std::vector<char>
+readFile(const Path& path)
+{
+  std::vector<char> data;
+  std::FILE* fd = std::fopen(path.c_str(), "rb");
+  if (fd == NULL)
+    return data;
+
+  char bfr[4096];
+  size_t rv = 0;
+  while ((rv = std::fread(bfr, 1, sizeof(bfr), fd)) > 0)
+    data.insert(data.end(), bfr, bfr + rv);
+
+  std::fclose(fd);
+  return data;
+}
+
+//! Write a whole file.
+static void
+writeFile(const Path& path, const std::vector<char>& data, size_t size)
+{
+  std::FILE* fd = std::fopen(path.c_str(), "wb");
+  if (size > 0)
+    std::fwrite(&data[0], 1, size, fd);
+  std::fclose(fd);
+}
+
+int
+main(void)
+{
+  Test test("Transports::DataStore");
+
+  Tasks::Context ctx;
+  Owner task(ctx);
+  Path path("/tmp/test_DataStore.dat");
+  double now = std::floor(Clock::getSinceEpoch());
+
+  // Save and load.
+  {
+    DataStore store(&task);
+    for (int i = 0; i < 20; ++i)
+      store.addSample(createSample(String::str("%04d", i), 10 + i * 3, now - i * 10, i % 4,
+                                   41.0 + i * 0.001, -8.0 - i * 0.001));
+
+    test.boolean("snapshot saved", store.save(path) && !store.isDirty());
+    test.boolean("temporary snapshot renamed", !Path(path.str() + ".tmp").exists());
+
+    DataStore copy(&task);
+    test.boolean("snapshot loaded", copy.load(path) == 20 && !copy.isDirty());
+    test.boolean("loaded size matches",
+                 copy.getSize() == store.getSize() && copy.getCount() == store.getCount());
+
+    IMC::HistoricData* a = store.pollSamples(65535);
+    IMC::HistoricData* b = copy.pollSamples(65535);
+    test.boolean("loaded samples match", a != NULL && b != NULL && serialize(a) == serialize(b));
+    delete a;
+    delete b;
+  }
+
+  // Truncated and corrupted snapshots.
+  {
+    std::vector<char> data = readFile(path);
+    bool truncated = !data.empty();
+    for (size_t size = 0; size < data.size(); ++size)
+    {
+      writeFile(path, data, size);
+      DataStore store(&task);
+      if (store.load(path) != -1 || store.getCount() != 0)
+        truncated = false;
+    }
+
+    test.boolean("truncated snapshots rejected", truncated);
+
+    bool corrupted = !data.empty();
+    for (size_t i = 0; i < data.size(); i += 7)
+    {
+      std::vector<char> bad = data;
+      bad[i] ^= 0x10;
+      writeFile(path, bad, bad.size());
+      DataStore store(&task);
+      if (store.load(path) != -1 || store.getCount() != 0)
+        corrupted = false;
+    }
+
+    test.boolean("corrupted snapshots rejected", corrupted);
+
+    path.remove();
+    DataStore store(&task);
+    test.boolean("missing snapshot rejected", store.load(path) == -1);
+  }
+
+  // Eviction at capacity: lowest priority first, then oldest.
+  {
+    // Each sample takes 15 + 2 + 33 bytes.
+    DataStore store(&task);
+    store.setLimits(250, 0);
+    store.addSample(createSample("0000", 33, now - 10, 1));
+    store.addSample(createSample("0001", 33, now - 9, 1));
+    store.addSample(createSample("0002", 33, now - 8, 2));
+    store.addSample(createSample("0003", 33, now - 7, 1));
+    store.addSample(createSample("0004", 33, now - 6, 3));
+    test.boolean("store full", store.getCount() == 5 && store.getSize() == 250);
+
+    store.addSample(createSample("0005", 33, now - 5, 2));
+    store.addSample(createSample("0006", 33, now - 4, 0));
+    store.addSample(createSample("0007", 33, now - 20, 1));
+
+    unsigned evicted = 0;
+    unsigned duplicates = 0;
+    store.getDiscarded(evicted, duplicates);
+    test.boolean("evicted count", evicted == 3 && store.getCount() == 5);
+
+    std::vector<std::string> tags;
+    IMC::HistoricData* data = store.pollSamples(65535);
+    if (data != NULL)
+    {
+      IMC::MessageList<IMC::RemoteData>::const_iterator itr = data->data.begin();
+      for (; itr != data->data.end(); ++itr)
+        tags.push_back(getTag(*itr));
+      delete data;
+    }
+
+    std::vector<std::string> expected;
+    expected.push_back("0004");
+    expected.push_back("0005");
+    expected.push_back("0002");
+    expected.push_back("0003");
+    expected.push_back("0001");
+    test.boolean("lowest priority and oldest evicted", tags == expected);
+  }
+
+  // Deduplication keeps the sample with highest priority.
+  {
+    DataStore store(&task);
+    store.setDeduplication(10, 0);
+    store.addSample(createSample("0000", 10, now, 1));
+    store.addSample(createSample("0001", 10, now + 5, 3));
+    store.addSample(createSample("0002", 10, now + 6, 2));
+    store.addSample(createSample("0003", 10, now + 30, 1));
+
+    unsigned evicted = 0;
+    unsigned duplicates = 0;
+    store.getDiscarded(evicted, duplicates);
+    test.boolean("duplicates dropped", duplicates == 2 && store.getCount() == 2);
+
+    std::vector<std::string> tags;
+    IMC::HistoricData* data = store.pollSamples(65535);
+    if (data != NULL)
+    {
+      IMC::MessageList<IMC::RemoteData>::const_iterator itr = data->data.begin();
+      for (; itr != data->data.end(); ++itr)
+        tags.push_back(getTag(*itr));
+      delete data;
+    }
+
+    test.boolean("highest priority duplicate kept",
+                 tags.size() == 2 && tags[0] == "0001" && tags[1] == "0003");
+  }
+
+  // Packing respects the size budget and the 16 bit offsets.
+  {
+    std::srand(1234);
+    DataStore store(&task);
+    std::map<std::string, Origin> origins;
+    for (int i = 0; i < 400; ++i)
+    {
+      Origin o;
+      o.lat = 41.0 + (std::rand() % 1000 - 500) * 0.001;
+      o.lon = -8.0 + (std::rand() % 1000 - 500) * 0.001;
+      o.time = now - std::rand() % 100000;
+      o.priority = std::rand() % 6;
+      std::string tag = String::str("%04d", i);
+      origins[tag] = o;
+      store.addSample(createSample(tag, std::rand() % 120, o.time, o.priority, o.lat, o.lon));
+    }
+
+    int budgets[] = {200, 300, 500, 1000, 2000};
+    bool fits = true;
+    bool offsets = true;
+    bool drained = false;
+    for (unsigned n = 0; n < 1000; ++n)
+    {
+      int budget = budgets[n % 5];
+      IMC::HistoricData* data = store.pollSamples(budget);
+      if (data == NULL)
+      {
+        drained = store.getCount() == 0;
+        break;
+      }
+
+      if ((int)data->getSerializationSize() > budget)
+        fits = false;
+
+      IMC::MessageList<IMC::RemoteData>::const_iterator itr = data->data.begin();
+      for (; itr != data->data.end(); ++itr)
+      {
+        const HistoricSample* s = static_cast<const HistoricSample*>(*itr);
+        const Origin& o = origins[getTag(s)];
+
+        double lat = Angles::radians(data->base_lat);
+        double lon = Angles::radians(data->base_lon);
+        WGS84::displace(s->x, s->y, &lat, &lon);
+        double dist = WGS84::distance(lat, lon, 0,
+                                      Angles::radians(o.lat), Angles::radians(o.lon), 0);
+
+        if (dist > 5.0 || std::fabs((double)data->base_time + s->t - o.time) > 1.0
+            || s->priority != o.priority)
+          offsets = false;
+      }
+
+      delete data;
+    }
+
+    test.boolean("packed messages fit the budget", fits);
+    test.boolean("packed offsets are exact", offsets);
+    test.boolean("all samples packed", drained);
+  }
+
+  return test.getReturnValue();
+}
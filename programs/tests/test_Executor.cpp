@@ -0,0 +1,210 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using DUNE_NAMESPACES;
+
+//! Periodic task that counts its cycles.
+class Cycler: public Tasks::Periodic
+{
+public:
+  Cycler(Tasks::Context& ctx, double frequency, double work = 0):
+    Tasks::Periodic("Cycler", ctx),
+    m_work(work),
+    m_running(0),
+    m_overlapped(false)
+  {
+    setFrequency(frequency);
+  }
+
+  void
+  task(void)
+  {
+    if (++m_running > 1)
+      m_overlapped = true;
+    if (m_work > 0)
+      Delay::wait(m_work);
+    --m_running;
+  }
+
+  bool
+  overlapped(void) const
+  {
+    return m_overlapped;
+  }
+
+private:
+  //! Time spent in each cycle.
+  double m_work;
+  //! Number of cycles running.
+  int m_running;
+  //! Two cycles ran at the same time.
+  bool m_overlapped;
+};
+
+//! Periodic task that fails on its third cycle.
+class Failing: public Tasks::Periodic
+{
+public:
+  Failing(Tasks::Context& ctx):
+    Tasks::Periodic("Failing", ctx)
+  {
+    setFrequency(100);
+  }
+
+  void
+  task(void)
+  {
+    if (getRunCount() == 2)
+      throw std::runtime_error("failure");
+  }
+};
+
+//! Periodic task that stalls in its first cycle and records the
+//! start time of each cycle.
+class Staller: public Tasks::Periodic
+{
+public:
+  Staller(Tasks::Context& ctx, double frequency, double stall):
+    Tasks::Periodic("Staller", ctx),
+    m_stall(stall)
+  {
+    setFrequency(frequency);
+  }
+
+  void
+  task(void)
+  {
+    starts.push_back(Clock::get());
+    if (starts.size() == 1)
+      Delay::wait(m_stall);
+  }
+
+  //! Start time of each cycle.
+  std::vector<double> starts;
+
+private:
+  //! Time spent in the first cycle.
+  double m_stall;
+};
+
+int
+main(void)
+{
+  Test test("Tasks::Executor");
+
+  Tasks::Context ctx;
+  std::vector<unsigned> cores;
+  Tasks::Executor executor(2, cores);
+
+  std::vector<Cycler*> tasks;
+  for (unsigned i = 0; i < 20; ++i)
+    tasks.push_back(new Cycler(ctx, 50));
+  Cycler slow(ctx, 20, 0.03);
+
+  for (size_t i = 0; i < tasks.size(); ++i)
+    executor.add(tasks[i]);
+  executor.add(&slow);
+
+  Delay::wait(1.0);
+
+  for (size_t i = 0; i < tasks.size(); ++i)
+    executor.remove(tasks[i]);
+  executor.remove(&slow);
+
+  bool rate = true;
+  bool overlapped = slow.overlapped();
+  Tasks::Periodic::TimingStatistics stats;
+  for (size_t i = 0; i < tasks.size(); ++i)
+  {
+    rate = rate && tasks[i]->getRunCount() >= 45 && tasks[i]->getRunCount() <= 51;
+    overlapped = overlapped || tasks[i]->overlapped();
+    tasks[i]->getTimingStatistics(stats);
+    rate = rate && stats.runs == tasks[i]->getRunCount();
+  }
+
+  test.boolean("cycle rate", rate);
+  test.boolean("no concurrent cycles", !overlapped);
+
+  slow.getTimingStatistics(stats);
+  test.boolean("execution time histogram", stats.runs > 0 && stats.exec_hist[3] == stats.runs);
+  test.boolean("execution time", stats.exec_max >= 0.03 && stats.exec_sum / stats.runs < 0.05);
+
+  // Removed tasks no longer run.
+  unsigned count = tasks[0]->getRunCount();
+  Delay::wait(0.1);
+  test.boolean("remove()", tasks[0]->getRunCount() == count);
+
+  // A failing cycle is not rescheduled.
+  Failing failing(ctx);
+  executor.add(&failing);
+  Delay::wait(0.2);
+  executor.remove(&failing);
+  test.boolean("failing task", failing.getRunCount() == 2);
+
+  // Overruns: cycles longer than the period.
+  Cycler overrun(ctx, 100, 0.015);
+  executor.add(&overrun);
+  Delay::wait(0.5);
+  executor.remove(&overrun);
+  overrun.getTimingStatistics(stats);
+  test.boolean("overruns", stats.runs > 0 && stats.overruns == stats.runs);
+
+  // Late cycles: the first cycle of each task (period 0.5 s) ends
+  // 0.1 s and 0.7 s after the next deadline.
+  Staller late(ctx, 2, 0.6);
+  Staller stalled(ctx, 2, 1.2);
+  executor.add(&late);
+  executor.add(&stalled);
+  Delay::wait(2.5);
+  executor.remove(&late);
+  executor.remove(&stalled);
+
+  test.boolean("late by less than a period runs at once",
+               late.starts.size() >= 2 && late.starts[1] - late.starts[0] < 0.75);
+  test.boolean("late by more than a period skips deadlines",
+               stalled.starts.size() >= 3
+               && stalled.starts[1] - stalled.starts[0] < 1.35
+               && stalled.starts[2] - stalled.starts[1] > 0.2);
+
+  for (size_t i = 0; i < tasks.size(); ++i)
+    delete tasks[i];
+
+  return test.getReturnValue();
+}
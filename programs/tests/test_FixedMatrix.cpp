@@ -0,0 +1,183 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <cmath>
+#include <string>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using DUNE_NAMESPACES;
+
+//! Fill a pair of matrices with the same pseudo-random values.
+template <size_t R, size_t C>
+static void
+randomize(FixedMatrix<R, C>& f, Matrix& m, unsigned seed)
+{
+  m.resize(R, C);
+  for (size_t i = 0; i < R * C; ++i)
+  {
+    seed = seed * 1103515245 + 12345;
+    f(i) = ((seed >> 8) % 2000) / 1000.0 - 1.0;
+    m(i) = f(i);
+  }
+}
+
+//! Compare fixed and dynamic matrices.
+template <size_t R, size_t C>
+static bool
+almostEqual(const FixedMatrix<R, C>& f, const Matrix& m, double max_error = 1e-12)
+{
+  if (m.rows() != R || m.columns() != C)
+    return false;
+
+  for (size_t i = 0; i < R * C; ++i)
+  {
+    if (std::fabs(f(i) - m(i)) > max_error)
+      return false;
+  }
+
+  return true;
+}
+
+int
+main(void)
+{
+  Test test("Math::FixedMatrix");
+
+  FixedMatrix<4, 4> fa, fp, fq;
+  Matrix da, dp, dq;
+  randomize(fa, da, 1);
+  randomize(fp, dp, 2);
+  randomize(fq, dq, 3);
+
+  {
+    FixedMatrix<4, 4> f;
+    test.boolean("FixedMatrix()", f.norm_inf() == 0.0);
+
+    const double data[] = {1, 2, 3, 4, 5, 6};
+    FixedMatrix<2, 3> g(data);
+    test.boolean("FixedMatrix(array)", g(1, 0) == 4.0 && g(5) == 6.0);
+
+    f.identity();
+    test.boolean("identity()", f == FixedMatrix<4, 4>(Matrix(4)));
+  }
+
+  {
+    test.boolean("operator+", almostEqual(FixedMatrix<4, 4>(fa + fp), da + dp));
+    test.boolean("operator-", almostEqual(FixedMatrix<4, 4>(fa - fp), da - dp));
+    test.boolean("operator*(double)", almostEqual(FixedMatrix<4, 4>(2.0 * fa / 4.0), 2.0 * da / 4.0));
+    test.boolean("operator*", almostEqual(fa * fp, da * dp));
+    test.boolean("transpose()", almostEqual(FixedMatrix<4, 4>(transpose(fa)), transpose(da)));
+  }
+
+  {
+    FixedMatrix<4, 4> f = fa * fp * transpose(fa) + fq;
+    Matrix d = da * dp * transpose(da) + dq;
+    test.boolean("A * P * transpose(A) + Q", almostEqual(f, d));
+
+    f = transpose(f);
+    test.boolean("operator= (aliased)", almostEqual(f, transpose(d)));
+
+    f -= transpose(f);
+    test.boolean("operator-= (aliased)", almostEqual(f, transpose(d) - d));
+  }
+
+  {
+    FixedMatrix<4, 4> f = inverse(fp);
+    test.boolean("inverse()", almostEqual(f, inverse(dp), 1e-9));
+    test.boolean("inverse() * matrix", FixedMatrix<4, 4>(f * fp - FixedMatrix<4, 4>(Matrix(4))).norm_inf() < 1e-9);
+
+    try
+    {
+      inverse(FixedMatrix<3, 3>(1.0));
+      test.failed("inverse() of singular matrix");
+    }
+    catch (Matrix::Error& e)
+    {
+      test.passed("inverse() of singular matrix");
+    }
+  }
+
+  {
+    FixedMatrix<2, 3> b = fa.get<2, 3>(1, 1);
+    test.boolean("get()", almostEqual(b, da.get(1, 2, 1, 3)));
+
+    FixedMatrix<4, 4> f = fp;
+    f.set(2, 0, b);
+    Matrix d = dp;
+    d.set(2, 3, 0, 2, da.get(1, 2, 1, 3));
+    test.boolean("set()", almostEqual(f, d));
+
+    test.boolean("row()", almostEqual(fa.row(2), da.row(2)));
+    test.boolean("column()", almostEqual(fa.column(3), da.column(3)));
+    test.boolean("norm_2()", std::fabs(fa.norm_2() - da.norm_2()) < 1e-12);
+    test.boolean("trace()", std::fabs(fa.trace() - da.trace()) < 1e-12);
+
+    try
+    {
+      fa.get<2, 2>(3, 0);
+      test.failed("get() out of range");
+    }
+    catch (Matrix::Error& e)
+    {
+      test.passed("get() out of range");
+    }
+  }
+
+  {
+    FixedVector<3> a = fa.get<3, 1>(0, 0);
+    FixedVector<3> b = fa.get<3, 1>(0, 1);
+    test.boolean("cross()", almostEqual(cross(a, b), Matrix::cross(a, b)));
+    test.boolean("dot()", std::fabs(dot(a, b) - Matrix::dot(a, b)) < 1e-12);
+  }
+
+  {
+    Matrix d = fa;
+    test.boolean("operator Matrix()", almostEqual(fa, d));
+    test.boolean("FixedMatrix(Matrix)", FixedMatrix<4, 4>(d) == fa);
+    test.boolean("FixedMatrix * Matrix", almostEqual(fa, fa * Matrix(4)));
+
+    try
+    {
+      FixedMatrix<3, 4> f(d);
+      test.failed("FixedMatrix(Matrix) dimensions");
+    }
+    catch (Matrix::Error& e)
+    {
+      test.passed("FixedMatrix(Matrix) dimensions");
+    }
+  }
+
+  return test.getReturnValue();
+}
@@ -0,0 +1,420 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Task headers.
+#include <Maneuver/VehicleFormation/FormCollAvoid/Team.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using DUNE_NAMESPACES;
+using namespace Maneuver::VehicleFormation::FormCollAvoid;
+
+//! Distance between vehicles in the formation shape.
+static const double c_spacing = 40.0;
+//! Neighbour search radius of the benchmark.
+static const double c_radius = 100.0;
+//! Minimum benchmark duration per team size (s).
+static const double c_bench_time = 0.2;
+
+//! Deterministic pseudo-random value in [-1, 1].
+static double
+prandom(unsigned& seed)
+{
+  seed = seed * 1103515245 + 12345;
+  return ((seed >> 8) % 2000) / 1000.0 - 1.0;
+}
+
+//! Team flying east in a square formation, stored as in the task.
+struct Team
+{
+  Matrix state;
+  Matrix accel;
+  Matrix form;
+  TeamState arrays;
+
+  Team(unsigned n, unsigned seed):
+    state(12, n + 1, 0.0),
+    accel(3, n + 1, 0.0),
+    form(3, n, 0.0)
+  {
+    unsigned side = (unsigned)std::ceil(std::sqrt((double)n));
+    state(3, 0) = 18.0;
+
+    arrays.resize(n);
+    for (unsigned i = 0; i < n; ++i)
+    {
+      form(0, i) = -c_spacing * (i / side + 1);
+      form(1, i) = c_spacing * ((double)(i % side) - side / 2.0);
+      state(0, i + 1) = form(0, i) + 5.0 * prandom(seed);
+      state(1, i + 1) = form(1, i) + 5.0 * prandom(seed);
+      state(3, i + 1) = 18.0 + prandom(seed);
+      state(4, i + 1) = prandom(seed);
+      accel(0, i + 1) = 0.5 * prandom(seed);
+      accel(1, i + 1) = 0.5 * prandom(seed);
+      arrays.set(i, state, accel, form);
+    }
+  }
+};
+
+//! Pair parameters of a vehicle flying east in a straight line.
+static PairParameters
+parameters(const Team& team, unsigned i)
+{
+  PairParameters p;
+  p.earth_fixed = false;
+  p.curved = false;
+  p.turnrate = 0.0;
+  p.turnrad = 0.0;
+  p.form_cos = 1.0;
+  p.form_sin = 0.0;
+  p.form_pos[0] = team.form(0, i);
+  p.form_pos[1] = team.form(1, i);
+  p.accel_lim_x[0] = 1.5;
+  p.accel_lim_x[1] = 0.0;
+  p.accel_lim_y[0] = 0.0;
+  p.accel_lim_y[1] = 9.81 * std::tan(0.75 * 0.6);
+  p.wind[0] = 2.0;
+  p.wind[1] = -1.0;
+  p.deconfliction_dist = 19.0;
+  p.deconfliction_offset = 7.0;
+  p.k_deconfliction_dist = 5.0 * 2.5 * (team.arrays.size() - 1);
+  p.k_long_dist1 = 1.5;
+  p.k_long_dist2 = 4.0;
+  p.speed_max = 22.0;
+  p.acc_safety_marg = 0.3;
+  p.speed_rel_min = 0.5;
+  return p;
+}
+
+//! Previous pair computation, on heap allocated matrices, used as reference.
+static void
+legacyPair(const Team& team, unsigned ind_uav, unsigned ind_uav2, const PairParameters& p, PairTerms& t)
+{
+  const Matrix& md_uav_state = team.state;
+  double t_rot_formation[4] = {p.form_cos, -p.form_sin, p.form_sin, p.form_cos};
+  Matrix md_rot_formation = Matrix(t_rot_formation, 2, 2);
+  Matrix vd_form_pos1 = Matrix(p.form_pos, 2, 1);
+  Matrix vd_body_accel_lim_x = Matrix(p.accel_lim_x, 2, 1);
+  Matrix vd_body_accel_lim_y = Matrix(p.accel_lim_y, 2, 1);
+  Matrix vd_wind = Matrix(p.wind, 2, 1);
+
+  Matrix vd_inter_uav_state = md_uav_state.get(0, 5, ind_uav2 + 1, ind_uav2 + 1) -
+  md_uav_state.get(0, 5, ind_uav + 1, ind_uav + 1);
+  Matrix vd_inter_uav_pos = vd_inter_uav_state.get(0, 1, 0, 0);
+  double d_inter_uav_dist = vd_inter_uav_pos.norm_2();
+  double d_inter_uav_angle = std::atan2(vd_inter_uav_pos(1), vd_inter_uav_pos(0));
+  double mt_rot[4] = {std::cos(d_inter_uav_angle), -std::sin(d_inter_uav_angle),
+                      std::sin(d_inter_uav_angle), std::cos(d_inter_uav_angle)};
+  Matrix md_rot = Matrix(mt_rot, 2, 2);
+  Matrix vd_inter_uav_x = md_rot.column(0);
+  Matrix vd_inter_uav_y = md_rot.column(1);
+
+  Matrix vd_form_pos2 = team.form.get(0, 1, ind_uav2, ind_uav2);
+  Matrix vd_inter_uav_des_pos = md_rot_formation * (vd_form_pos1 - vd_form_pos2);
+  Matrix vd_inter_uav_des_vel = Matrix(2, 1, 0.0);
+  vd_inter_uav_des_vel(0) = vd_inter_uav_state(1) * p.turnrate;
+  vd_inter_uav_des_vel(1) = -vd_inter_uav_state(0) * p.turnrate;
+  Matrix vd_inter_uav_des_acc = vd_inter_uav_state.get(0, 1, 0, 0) * p.turnrate * p.turnrate;
+
+  Matrix vd_err = -vd_inter_uav_state.get(0, 1, 0, 0) - vd_inter_uav_des_pos;
+  double d_err_y = Matrix::dot(vd_err, vd_inter_uav_y);
+  double d_err_x = Matrix::dot(vd_err, vd_inter_uav_x);
+  int int_Max = 1;
+  if (d_err_x < p.deconfliction_dist - d_inter_uav_dist)
+  {
+    int_Max = 2;
+    d_err_x = p.deconfliction_dist - d_inter_uav_dist;
+  }
+  Matrix vd_deriv_err = -vd_inter_uav_state.get(3, 4, 0, 0) - vd_inter_uav_des_vel;
+  double d_deriv_err_x = Matrix::dot(vd_deriv_err, vd_inter_uav_x);
+  double d_deriv_err_y = Matrix::dot(vd_deriv_err, vd_inter_uav_y);
+
+  double d_vel_proj_x = Matrix::dot(md_uav_state.get(3, 4, ind_uav2 + 1, ind_uav2 + 1) - vd_wind, vd_inter_uav_x);
+  double d_accel_max_proj_x = std::abs(Matrix::dot(vd_body_accel_lim_x, vd_inter_uav_x)) +
+  std::abs(Matrix::dot(vd_body_accel_lim_y, vd_inter_uav_x));
+  double d_vel_proj_y = Matrix::dot(md_uav_state.get(3, 4, ind_uav2 + 1, ind_uav2 + 1) - vd_wind, vd_inter_uav_y);
+  double d_accel_max_proj_y = std::abs(Matrix::dot(vd_body_accel_lim_x, vd_inter_uav_y)) +
+  std::abs(Matrix::dot(vd_body_accel_lim_y, vd_inter_uav_y));
+
+  double d_c1 = std::max(p.speed_max - d_vel_proj_x, p.speed_rel_min);
+  double d_c2 = p.deconfliction_offset * 2 * p.speed_max / (p.speed_max + d_vel_proj_x);
+  if (d_err_x < 0)
+    d_c2 = std::max(4 * (1 + p.acc_safety_marg) * d_c1 * d_c1 / (27 * d_accel_max_proj_x), d_c2);
+
+  double d_err_x_s_conv;
+  d_err_x = std::min(d_err_x, d_c2 * 0.5);
+  if (d_inter_uav_dist < p.deconfliction_dist)
+    d_err_x_s_conv = (d_deriv_err_x > 0) ? d_err_x : std::min(d_err_x, 0.0);
+  else
+    d_err_x_s_conv = d_err_x;
+
+  if (int_Max == 2 && 2 * p.deconfliction_dist > std::abs(d_err_y))
+    d_err_y = (d_err_y < 0) ? -2 * p.deconfliction_dist : 2 * p.deconfliction_dist;
+
+  double d_des_dist = vd_inter_uav_des_pos.norm_2();
+  double d_predicted_dist = d_inter_uav_dist + std::min(0.0, d_deriv_err_x * std::abs(d_deriv_err_x) *
+                                                        (1 + p.acc_safety_marg) / d_accel_max_proj_x);
+  double d_dist2confl = d_predicted_dist - p.deconfliction_dist;
+  if (d_dist2confl < 0)
+    t.weight = 1 + d_dist2confl / p.deconfliction_offset * d_dist2confl / p.deconfliction_offset * p.k_deconfliction_dist;
+  else if (d_predicted_dist <= d_des_dist * p.k_long_dist1)
+    t.weight = 1;
+  else if (d_predicted_dist < d_des_dist * p.k_long_dist2)
+  {
+    double t_dist_gain = (d_predicted_dist - d_des_dist * p.k_long_dist1) / (d_des_dist * (p.k_long_dist2 - p.k_long_dist1));
+    t.weight = 1 - t_dist_gain * t_dist_gain;
+  }
+  else
+    t.weight = 0;
+
+  double d_c3;
+  double d_c4;
+  if (d_err_y < 0)
+  {
+    d_c3 = std::max(p.speed_max - d_vel_proj_y, p.speed_rel_min);
+    d_c4 = 4 * (1 + p.acc_safety_marg) * d_c3 * d_c3 / (27 * d_accel_max_proj_y);
+  }
+  else
+  {
+    d_c3 = std::min(-p.speed_max - d_vel_proj_y, -p.speed_rel_min);
+    d_c4 = -4 * (1 + p.acc_safety_marg) * d_c3 * d_c3 / (27 * d_accel_max_proj_y);
+  }
+
+  double t_surf_x = d_c1 * d_err_x / (d_err_x - d_c2);
+  double t_surf_y = d_c3 * d_err_y / (d_err_y - d_c4);
+  Matrix vd_surf = vd_deriv_err - t_surf_x * vd_inter_uav_x - t_surf_y * vd_inter_uav_y;
+
+  double d_inter_uav_angle_dot = Matrix::dot(vd_inter_uav_state.get(3, 4, 0, 0), vd_inter_uav_y / d_inter_uav_dist);
+  Matrix vt_surf_deriv = Matrix(2, 1, 0.0);
+  vt_surf_deriv(0) = d_c1 * d_c2 * d_deriv_err_x / ((d_err_x_s_conv - d_c2) * (d_err_x_s_conv - d_c2)) +
+  t_surf_y * d_inter_uav_angle_dot;
+  vt_surf_deriv(1) = d_c3 * d_c4 * d_deriv_err_y / ((d_err_y - d_c4) * (d_err_y - d_c4)) -
+  t_surf_x * d_inter_uav_angle_dot;
+  Matrix vt_virt_err = team.accel.get(0, 1, ind_uav2 + 1, ind_uav2 + 1) + vd_inter_uav_des_acc - md_rot * vt_surf_deriv;
+
+  t.surf[0] = vd_surf(0);
+  t.surf[1] = vd_surf(1);
+  t.virt_err[0] = vt_virt_err(0);
+  t.virt_err[1] = vt_virt_err(1);
+}
+
+//! Weighted sums of the pair terms of one vehicle.
+struct Sums
+{
+  double weight;
+  double surf[2];
+  double virt_err[2];
+  unsigned pairs;
+
+  Sums(void):
+    weight(0.0),
+    pairs(0)
+  {
+    surf[0] = surf[1] = virt_err[0] = virt_err[1] = 0.0;
+  }
+
+  void
+  add(const PairTerms& t)
+  {
+    ++pairs;
+    if (t.weight == 0)
+      return;
+
+    weight += t.weight;
+    for (unsigned k = 0; k < 2; ++k)
+    {
+      surf[k] += t.weight * t.surf[k];
+      virt_err[k] += t.weight * t.virt_err[k];
+    }
+  }
+
+  double
+  difference(const Sums& other) const
+  {
+    double diff = std::abs(weight - other.weight);
+    for (unsigned k = 0; k < 2; ++k)
+    {
+      diff = std::max(diff, std::abs(surf[k] - other.surf[k]));
+      diff = std::max(diff, std::abs(virt_err[k] - other.virt_err[k]));
+    }
+    return diff;
+  }
+};
+
+//! Inter-vehicle terms of a whole team control step.
+//! @param mode 0: previous implementation, 1: team arrays, 2: team arrays and neighbour grid.
+static void
+step(const Team& team, unsigned mode, NeighbourGrid& grid, std::vector<unsigned>& neighbours,
+     std::vector<Sums>& sums)
+{
+  unsigned n = team.arrays.size();
+  PairTerms t;
+  sums.assign(n, Sums());
+
+  if (mode == 2)
+    grid.build(team.arrays, c_radius);
+
+  for (unsigned i = 0; i < n; ++i)
+  {
+    PairParameters p = parameters(team, i);
+
+    if (mode == 2)
+    {
+      grid.query(team.arrays, i, c_radius, neighbours);
+      for (unsigned k = 0; k < neighbours.size(); ++k)
+      {
+        if (computePairTerms(team.arrays, i, neighbours[k], p, false, t))
+          sums[i].add(t);
+      }
+      continue;
+    }
+
+    for (unsigned j = 0; j < n; ++j)
+    {
+      if (i == j)
+        continue;
+
+      if (mode == 0)
+      {
+        legacyPair(team, i, j, p, t);
+        sums[i].add(t);
+      }
+      else if (computePairTerms(team.arrays, i, j, p, false, t))
+      {
+        sums[i].add(t);
+      }
+    }
+  }
+}
+
+int
+main(void)
+{
+  Test test("Maneuver::VehicleFormation::FormCollAvoid team");
+
+  NeighbourGrid grid;
+  std::vector<unsigned> neighbours;
+
+  {
+    Team team(50, 7);
+    // A straggler far from its formation position has no weight in the
+    // control of the other vehicles.
+    team.state(0, 50) += 5000.0;
+    team.arrays.set(49, team.state, team.accel, team.form);
+
+    std::vector<Sums> legacy;
+    std::vector<Sums> arrays;
+    step(team, 0, grid, neighbours, legacy);
+    step(team, 1, grid, neighbours, arrays);
+
+    double diff = 0.0;
+    unsigned skipped = 0;
+    for (unsigned i = 0; i < legacy.size(); ++i)
+    {
+      diff = std::max(diff, legacy[i].difference(arrays[i]));
+      skipped += legacy[i].pairs - arrays[i].pairs;
+    }
+    test.boolean("pair terms match previous implementation", diff < 1e-9);
+    test.boolean("zero weight pairs skipped", skipped > 0);
+
+    PairTerms t;
+    PairParameters p = parameters(team, 0);
+    test.boolean("complete computation of zero weight pair",
+                 computePairTerms(team.arrays, 0, 49, p, true, t) && t.weight == 0);
+  }
+
+  {
+    Team team(200, 11);
+    grid.build(team.arrays, 60.0);
+
+    bool same = true;
+    std::vector<unsigned> brute;
+    for (unsigned i = 0; i < 200 && same; ++i)
+    {
+      double radius = (i % 3 + 1) * 20.0;
+      grid.query(team.arrays, i, radius, neighbours);
+
+      brute.clear();
+      for (unsigned j = 0; j < 200; ++j)
+      {
+        double rx = team.arrays.x[j] - team.arrays.x[i];
+        double ry = team.arrays.y[j] - team.arrays.y[i];
+        if (j != i && rx * rx + ry * ry <= radius * radius)
+          brute.push_back(j);
+      }
+
+      std::sort(neighbours.begin(), neighbours.end());
+      same = (neighbours == brute);
+    }
+    test.boolean("grid query matches exhaustive search", same);
+
+    team.arrays.x[0] += 500.0;
+    grid.update(team.arrays, 0);
+    grid.query(team.arrays, 0, 60.0, neighbours);
+    test.boolean("grid update after move", neighbours.empty());
+  }
+
+  //! Scalability benchmark.
+  static const unsigned c_sizes[] = {3, 5, 10, 25, 50, 100, 200};
+  std::fprintf(stderr, "  inter-vehicle terms per team control step (us):\n");
+  std::fprintf(stderr, "    vehicles   previous     arrays  arrays+grid (radius %.0f m)\n", c_radius);
+  for (unsigned k = 0; k < sizeof(c_sizes) / sizeof(c_sizes[0]); ++k)
+  {
+    Team team(c_sizes[k], 3);
+    std::vector<Sums> sums;
+    double times[3];
+
+    for (unsigned mode = 0; mode < 3; ++mode)
+    {
+      unsigned iterations = 0;
+      double start = Clock::get();
+      do
+      {
+        step(team, mode, grid, neighbours, sums);
+        ++iterations;
+      }
+      while (Clock::get() - start < c_bench_time);
+      times[mode] = (Clock::get() - start) * 1e6 / iterations;
+    }
+
+    std::fprintf(stderr, "    %8u %10.1f %10.1f %10.1f\n", c_sizes[k], times[0], times[1], times[2]);
+  }
+
+  return test.getReturnValue();
+}
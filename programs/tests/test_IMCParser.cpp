@@ -0,0 +1,188 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <cstdio>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using DUNE_NAMESPACES;
+
+//! Number of messages in the stream.
+static const unsigned c_messages = 64;
+//! Number of passes used to measure throughput.
+static const unsigned c_passes = 200;
+
+struct Collector
+{
+  Collector(void):
+    count(0),
+    sum(0)
+  { }
+
+  void
+  operator()(IMC::Message* msg)
+  {
+    ++count;
+    sum += static_cast<IMC::Temperature*>(msg)->value;
+    delete msg;
+  }
+
+  unsigned count;
+  double sum;
+};
+
+static void
+append(std::vector<uint8_t>& stream, const IMC::Message& msg)
+{
+  uint8_t bfr[1024];
+  uint16_t n = IMC::Packet::serialize(&msg, bfr, sizeof(bfr));
+  stream.insert(stream.end(), bfr, bfr + n);
+}
+
+int
+main(void)
+{
+  Test test("IMC::Parser");
+
+  // Build a stream with valid frames, garbage and a corrupted frame.
+  std::vector<uint8_t> stream;
+  double expected = 0;
+  for (unsigned i = 0; i < c_messages; ++i)
+  {
+    IMC::Temperature temp;
+    temp.value = i;
+    append(stream, temp);
+    expected += i;
+
+    if (i % 8 == 0)
+    {
+      stream.push_back(0x54);
+      stream.push_back(0x00);
+      stream.push_back(0xfe);
+      stream.push_back(0x12);
+    }
+  }
+
+  IMC::Temperature bad;
+  bad.value = 1000;
+  size_t bad_pos = stream.size();
+  append(stream, bad);
+  stream[bad_pos + DUNE_IMC_CONST_HEADER_SIZE] ^= 0xff;
+
+  IMC::Temperature last;
+  last.value = c_messages;
+  append(stream, last);
+  expected += c_messages;
+
+  {
+    IMC::Parser parser;
+    Collector collector;
+    for (size_t i = 0; i < stream.size(); ++i)
+    {
+      IMC::Message* msg = parser.parse(stream[i]);
+      if (msg)
+        collector(msg);
+    }
+
+    test.boolean("parse(uint8_t)", collector.count == c_messages + 1 && collector.sum == expected);
+  }
+
+  {
+    IMC::Parser parser;
+    Collector collector;
+    size_t n = parser.parse(&stream[0], stream.size(), collector);
+    test.boolean("parse() whole buffer", n == c_messages + 1 && collector.count == n && collector.sum == expected);
+  }
+
+  {
+    bool ok = true;
+    for (size_t chunk = 1; chunk <= 64; ++chunk)
+    {
+      IMC::Parser parser;
+      Collector collector;
+      for (size_t i = 0; i < stream.size(); i += chunk)
+        parser.parse(&stream[i], std::min(chunk, stream.size() - i), collector);
+
+      ok = ok && collector.count == c_messages + 1 && collector.sum == expected;
+    }
+
+    test.boolean("parse() split in chunks", ok);
+  }
+
+  {
+    IMC::Parser parser;
+    Collector collector;
+    size_t half = stream.size() / 2;
+    for (size_t i = 0; i < half; ++i)
+    {
+      IMC::Message* msg = parser.parse(stream[i]);
+      if (msg)
+        collector(msg);
+    }
+
+    parser.parse(&stream[half], stream.size() - half, collector);
+    test.boolean("parse() after parse(uint8_t)", collector.count == c_messages + 1 && collector.sum == expected);
+  }
+
+  {
+    IMC::Parser byte_parser;
+    IMC::Parser bulk_parser;
+    Collector collector;
+
+    uint64_t start = Time::Clock::getNsec();
+    for (unsigned p = 0; p < c_passes; ++p)
+    {
+      for (size_t i = 0; i < stream.size(); ++i)
+      {
+        IMC::Message* msg = byte_parser.parse(stream[i]);
+        if (msg)
+          collector(msg);
+      }
+    }
+    double byte_time = (Time::Clock::getNsec() - start) / 1e9;
+
+    start = Time::Clock::getNsec();
+    for (unsigned p = 0; p < c_passes; ++p)
+      bulk_parser.parse(&stream[0], stream.size(), collector);
+    double bulk_time = (Time::Clock::getNsec() - start) / 1e9;
+
+    double mbytes = (double)stream.size() * c_passes / 1e6;
+    std::fprintf(stderr, "  throughput: %.1f MB/s (per byte), %.1f MB/s (bulk)\n",
+                 mbytes / byte_time, mbytes / bulk_time);
+    test.boolean("throughput measured", collector.count == 2 * c_passes * (c_messages + 1));
+  }
+
+  return test.getReturnValue();
+}
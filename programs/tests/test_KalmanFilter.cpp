@@ -0,0 +1,283 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <cmath>
+#include <cstdio>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using DUNE_NAMESPACES;
+
+//! Number of states of the AUV navigation filter.
+static const size_t c_states = 9;
+//! Number of outputs of the AUV navigation filter with two beacons.
+static const size_t c_outputs = 8;
+//! Number of benchmark iterations.
+static const unsigned c_iterations = 20000;
+
+//! Previous filter implementation, used as reference.
+struct LegacyFilter
+{
+  Matrix x, a, c, p, q, r, innov;
+
+  void
+  predict(void)
+  {
+    x = a * x;
+    p = a * p * transpose(a) + q;
+  }
+
+  void
+  update(void)
+  {
+    Matrix s = c * p * transpose(c) + r;
+    Matrix s_1 = inverse(s);
+    Matrix k = p * transpose(c) * s_1;
+    x = x + k * innov;
+    p = p - k * c * p;
+  }
+};
+
+//! Deterministic pseudo-random value in [-1, 1].
+static double
+prandom(unsigned& seed)
+{
+  seed = seed * 1103515245 + 12345;
+  return ((seed >> 8) % 2000) / 1000.0 - 1.0;
+}
+
+//! Maximum absolute difference between two matrices.
+static double
+difference(const Matrix& a, const Matrix& b)
+{
+  return (a - b).norm_inf();
+}
+
+//! Configure a filter and a reference with the same model.
+static void
+setup(KalmanFilter& kal, LegacyFilter& ref, unsigned seed)
+{
+  kal.reset(c_states, c_outputs);
+  ref.x.resizeAndFill(c_states, 1, 0.0);
+  ref.a = Matrix(c_states);
+  ref.c.resizeAndFill(c_outputs, c_states, 0.0);
+  ref.q.resizeAndFill(c_states, c_states, 0.0);
+  ref.r.resizeAndFill(c_outputs, c_outputs, 0.0);
+  ref.innov.resizeAndFill(c_outputs, 1, 0.0);
+
+  // Sparse, near-identity transition.
+  for (size_t i = 0; i < c_states; ++i)
+  {
+    ref.a(i, i) = 1.0;
+    if (i + 1 < c_states)
+      ref.a(i, i + 1) = 0.1 * prandom(seed);
+  }
+
+  // Covariance: B * B' + I.
+  Matrix b(c_states, c_states);
+  for (size_t i = 0; i < c_states * c_states; ++i)
+    b(i) = prandom(seed);
+  ref.p = b * transpose(b) + Matrix(c_states);
+
+  for (size_t i = 0; i < c_states; ++i)
+  {
+    ref.x(i) = prandom(seed);
+    ref.q(i, i) = 0.01 + 0.01 * std::fabs(prandom(seed));
+    kal.setState(i, ref.x(i));
+    kal.setProcessNoise(i, ref.q(i, i));
+    for (size_t j = 0; j < c_states; ++j)
+      kal.setCovariance(i, j, ref.p(i, j));
+  }
+
+  kal.setTransitions(ref.a);
+
+  // Direct observations of single states and two ranges.
+  const size_t direct[] = {4, 5, 2, 3, 0, 1};
+  for (size_t i = 0; i < c_outputs; ++i)
+  {
+    if (i < 6)
+    {
+      ref.c(i, direct[i]) = 1.0;
+    }
+    else
+    {
+      ref.c(i, 0) = prandom(seed);
+      ref.c(i, 1) = prandom(seed);
+    }
+
+    ref.r(i, i) = 0.1 + std::fabs(prandom(seed));
+    kal.setMeasurementNoise(i, ref.r(i, i));
+    for (size_t j = 0; j < c_states; ++j)
+      kal.setObservation(i, j, ref.c(i, j));
+  }
+}
+
+//! Set the same innovations in a filter and a reference.
+static void
+innovate(KalmanFilter& kal, LegacyFilter& ref, unsigned& seed)
+{
+  for (size_t i = 0; i < c_outputs; ++i)
+  {
+    ref.innov(i) = 0.5 * prandom(seed);
+    kal.setInnovation(i, ref.innov(i));
+  }
+}
+
+int
+main(void)
+{
+  Test test("Navigation::KalmanFilter");
+
+  {
+    KalmanFilter kal;
+    LegacyFilter ref;
+    setup(kal, ref, 1);
+
+    Matrix x0 = kal.getState();
+    kal.predict();
+    ref.predict();
+    test.boolean("predict() state", difference(kal.getState(), ref.x) < 1e-12);
+    test.boolean("predict() covariance", difference(kal.getCovariance(), ref.p) < 1e-12);
+    test.boolean("predict() leaves copies unchanged", x0(0) != kal.getState(0));
+
+    unsigned seed = 2;
+    innovate(kal, ref, seed);
+    kal.update(0.0);
+    ref.update();
+    test.boolean("batch update() state", difference(kal.getState(), ref.x) < 1e-9);
+    test.boolean("batch update() covariance", difference(kal.getCovariance(), ref.p) < 1e-9);
+  }
+
+  {
+    KalmanFilter kal;
+    LegacyFilter ref;
+    setup(kal, ref, 3);
+    kal.setSequentialUpdates(true);
+
+    unsigned seed = 4;
+    double state = 0;
+    double covariance = 0;
+    double asymmetry = 0;
+    for (unsigned i = 0; i < 100; ++i)
+    {
+      kal.predict();
+      ref.predict();
+      innovate(kal, ref, seed);
+      kal.update(0.0);
+      ref.update();
+
+      state = std::max(state, difference(kal.getState(), ref.x));
+      covariance = std::max(covariance, difference(kal.getCovariance(), ref.p));
+      asymmetry = std::max(asymmetry, difference(kal.getCovariance(), transpose(kal.getCovariance())));
+    }
+
+    test.boolean("sequential update() state", state < 1e-9);
+    test.boolean("sequential update() covariance", covariance < 1e-9);
+    test.boolean("sequential update() symmetry", asymmetry == 0.0);
+  }
+
+  {
+    KalmanFilter kal;
+    LegacyFilter ref;
+    setup(kal, ref, 5);
+    kal.setSequentialUpdates(true);
+
+    // Correlated noise falls back to the batch update.
+    ref.r(6, 7) = ref.r(7, 6) = 0.05;
+    kal.setMeasurementNoise(6, 7, 0.05);
+    kal.setMeasurementNoise(7, 6, 0.05);
+
+    unsigned seed = 6;
+    innovate(kal, ref, seed);
+    kal.update(0.0);
+    ref.update();
+    test.boolean("correlated noise update()", difference(kal.getCovariance(), ref.p) < 1e-9);
+  }
+
+  {
+    KalmanFilter kal;
+    LegacyFilter ref;
+    setup(kal, ref, 7);
+    kal.setSequentialUpdates(true);
+
+    for (size_t i = 0; i < c_outputs; ++i)
+      kal.setInnovation(i, 0.0);
+
+    // Same filter without the first measurement.
+    KalmanFilter other = kal;
+    for (size_t j = 0; j < c_states; ++j)
+      other.setObservation(0, j, 0.0);
+    other.update(0.0);
+
+    kal.setInnovation(0, 1000.0);
+    test.boolean("sequential update() gating", kal.update(9.0) == -1);
+    test.boolean("gated measurement is skipped", difference(kal.getCovariance(), other.getCovariance()) < 1e-12
+                 && difference(kal.getState(), other.getState()) < 1e-12);
+  }
+
+  // Benchmark.
+  double times[3] = {0, 0, 0};
+  for (unsigned mode = 0; mode < 3; ++mode)
+  {
+    KalmanFilter kal;
+    LegacyFilter ref;
+    setup(kal, ref, 8);
+    kal.setSequentialUpdates(mode == 2);
+
+    unsigned seed = 9;
+    double start = Clock::get();
+    for (unsigned i = 0; i < c_iterations; ++i)
+    {
+      innovate(kal, ref, seed);
+      if (mode == 0)
+      {
+        ref.predict();
+        ref.update();
+      }
+      else
+      {
+        kal.predict();
+        kal.update(0.0);
+      }
+    }
+    times[mode] = (Clock::get() - start) * 1e6 / c_iterations;
+  }
+
+  std::fprintf(stderr, "  %u states, %u outputs, predict + update:\n", (unsigned)c_states, (unsigned)c_outputs);
+  std::fprintf(stderr, "    previous implementation: %8.2f us\n", times[0]);
+  std::fprintf(stderr, "    in-place, batch update:  %8.2f us\n", times[1]);
+  std::fprintf(stderr, "    in-place, sequential:    %8.2f us\n", times[2]);
+
+  return test.getReturnValue();
+}
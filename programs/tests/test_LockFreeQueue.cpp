@@ -0,0 +1,140 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using namespace DUNE::Concurrency;
+
+//! Number of producer threads.
+static const unsigned c_producers = 4;
+//! Number of elements per producer.
+static const unsigned c_count = 100000;
+
+class Producer: public Thread
+{
+public:
+  Producer(LockFreeQueue<unsigned>& queue, unsigned id):
+    m_queue(queue),
+    m_id(id)
+  { }
+
+  void
+  run(void)
+  {
+    for (unsigned i = 0; i < c_count; ++i)
+    {
+      while (!m_queue.tryPush(m_id * c_count + i))
+        Scheduler::yield();
+    }
+  }
+
+private:
+  LockFreeQueue<unsigned>& m_queue;
+  unsigned m_id;
+};
+
+int
+main(void)
+{
+  Test test("Concurrency::LockFreeQueue");
+
+  {
+    LockFreeQueue<unsigned> queue(5);
+    test.boolean("getCapacity() rounds to power of two", queue.getCapacity() == 8);
+
+    bool room = true;
+    for (unsigned i = 0; i < 8; ++i)
+      room = queue.tryPush(i) && room;
+
+    test.boolean("tryPush() until full", room);
+    test.boolean("tryPush() fails when full", !queue.tryPush(8));
+    test.boolean("size()", queue.size() == 8);
+
+    unsigned v = 0;
+    bool order = true;
+    for (unsigned i = 0; i < 8; ++i)
+      order = queue.tryPop(v) && v == i && order;
+
+    test.boolean("tryPop() keeps order", order);
+    test.boolean("tryPop() fails when empty", !queue.tryPop(v));
+    test.boolean("empty()", queue.empty());
+  }
+
+  {
+    LockFreeQueue<unsigned> queue(64);
+    std::vector<Producer*> producers;
+    for (unsigned i = 0; i < c_producers; ++i)
+    {
+      producers.push_back(new Producer(queue, i));
+      producers.back()->start();
+    }
+
+    std::vector<unsigned> last(c_producers, 0);
+    std::vector<bool> seen(c_producers, false);
+    unsigned total = 0;
+    bool order = true;
+    while (total < c_producers * c_count)
+    {
+      unsigned v = 0;
+      if (!queue.tryPop(v))
+      {
+        Scheduler::yield();
+        continue;
+      }
+
+      unsigned id = v / c_count;
+      unsigned seq = v % c_count;
+      if (seen[id] && seq != last[id] + 1)
+        order = false;
+
+      seen[id] = true;
+      last[id] = seq;
+      ++total;
+    }
+
+    for (unsigned i = 0; i < c_producers; ++i)
+    {
+      producers[i]->join();
+      delete producers[i];
+    }
+
+    test.boolean("concurrent producers deliver every element", total == c_producers * c_count);
+    test.boolean("concurrent producers keep per-producer order", order);
+    test.boolean("empty() after concurrent use", queue.empty());
+  }
+
+  return test.getReturnValue();
+}
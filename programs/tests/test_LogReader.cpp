@@ -0,0 +1,209 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using DUNE_NAMESPACES;
+
+//! Number of messages in the test log.
+static const unsigned c_count = 200000;
+//! Time stamp of the first message.
+static const double c_origin = 1600000000.0;
+
+//! Write a test log, optionally with its index.
+static void
+writeLog(const std::string& path, IMC::LogIndex* index)
+{
+  std::ofstream ofs(path.c_str(), std::ios::binary);
+  Utils::ByteBuffer bfr;
+  uint64_t offset = 0;
+
+  IMC::Temperature temp;
+  IMC::EntityInfo info;
+  for (unsigned i = 0; i < c_count; ++i)
+  {
+    IMC::Message* msg = &temp;
+    if (i % 1000 == 0)
+    {
+      info.id = i / 1000;
+      info.label = String::str("Entity %u", i / 1000);
+      msg = &info;
+    }
+    else
+    {
+      temp.value = i;
+    }
+
+    msg->setSourceEntity(i % 7);
+    msg->setTimeStamp(c_origin + i * 0.01);
+    IMC::Packet::serialize(msg, bfr);
+    ofs.write(bfr.getBufferSigned(), bfr.getSize());
+
+    if (index != NULL)
+      index->add(bfr.getBuffer(), bfr.getSize(), offset);
+    offset += bfr.getSize();
+  }
+}
+
+int
+main(void)
+{
+  Test test("IMC::LogReader");
+
+  Path lsf("test_LogReader.lsf");
+  std::string idx = IMC::LogIndex::getPath(lsf.str());
+
+  {
+    IMC::LogIndex index;
+    index.open(idx);
+    writeLog(lsf.str(), &index);
+  }
+
+  {
+    IMC::LogReader reader(lsf.str());
+    test.boolean("index written while logging is used", !reader.isIndexRebuilt());
+    test.boolean("all packets indexed", reader.getCount() == c_count);
+
+    size_t blocks = (c_count + IMC::LogIndex::c_block_packets - 1) / IMC::LogIndex::c_block_packets;
+    test.boolean("one index entry per block", (size_t)Path(idx).size()
+                 == IMC::LogIndex::c_header_size + blocks * sizeof(IMC::LogIndex::Block));
+
+    size_t i = reader.seek(c_origin + 1000.0);
+    IMC::Message* msg = reader.getMessage(i);
+    test.boolean("seek() by time", i == 100000 && msg->getId() == IMC::EntityInfo::getIdStatic()
+                 && msg->getTimeStamp() >= c_origin + 1000.0);
+    delete msg;
+
+    test.boolean("seek() past the end", reader.seek(c_origin + 1e6) == reader.getCount());
+
+    size_t n = 0;
+    for (i = reader.find(IMC::EntityInfo::getIdStatic()); i < reader.getCount();
+         i = reader.find(IMC::EntityInfo::getIdStatic(), i + 1))
+      ++n;
+    test.boolean("find() by message type", n == c_count / 1000);
+
+    IMC::Temperature* temp = static_cast<IMC::Temperature*>(reader.getMessage(12345));
+    test.boolean("getMessage()", temp->value == 12345 && temp->getSourceEntity() == 12345 % 7);
+    delete temp;
+
+    // Compare with a sequential skip through the stream.
+    double start = Clock::get();
+    std::ifstream ifs(lsf.c_str(), std::ios::binary);
+    IMC::Message* m = NULL;
+    while ((m = IMC::Packet::deserialize(ifs)) != NULL)
+    {
+      bool done = m->getTimeStamp() >= c_origin + 1500.0;
+      delete m;
+      if (done)
+        break;
+    }
+    double sequential = Clock::get() - start;
+
+    start = Clock::get();
+    i = reader.seek(c_origin + 1500.0);
+    double indexed = Clock::get() - start;
+    std::fprintf(stderr, "  skip to packet %u: sequential %.3f ms, indexed %.3f ms\n",
+                 (unsigned)i, sequential * 1e3, indexed * 1e3);
+  }
+
+  Path(idx).remove();
+
+  {
+    IMC::LogReader reader(lsf.str());
+    test.boolean("missing index is rebuilt", reader.isIndexRebuilt() && reader.getCount() == c_count);
+    test.boolean("rebuilt index is saved", Path(idx).isFile());
+  }
+
+  {
+    IMC::LogReader reader(lsf.str());
+    test.boolean("saved index is used", !reader.isIndexRebuilt() && reader.getCount() == c_count);
+  }
+
+  // Append a packet and a truncated packet that are not indexed.
+  {
+    std::ofstream ofs(lsf.c_str(), std::ios::binary | std::ios::app);
+    Utils::ByteBuffer bfr;
+    IMC::Temperature temp;
+    temp.setTimeStamp(c_origin + c_count);
+    IMC::Packet::serialize(&temp, bfr);
+    ofs.write(bfr.getBufferSigned(), bfr.getSize());
+    ofs.write(bfr.getBufferSigned(), bfr.getSize() / 2);
+  }
+
+  {
+    IMC::LogReader reader(lsf.str());
+    test.boolean("packets after index are indexed", reader.isIndexRebuilt() && reader.getCount() == c_count + 1);
+    test.boolean("seek() in extended index", reader.seek(c_origin + c_count) == c_count);
+  }
+
+  {
+    std::ofstream ofs(idx.c_str(), std::ios::binary);
+    ofs << "garbage garbage garbage";
+  }
+
+  {
+    IMC::LogReader reader(lsf.str());
+    test.boolean("invalid index is rebuilt", reader.isIndexRebuilt() && reader.getCount() == c_count + 1);
+  }
+
+  // Corrupt the payload of the tenth packet.
+  {
+    uint64_t offset = 0;
+    {
+      IMC::LogReader reader(lsf.str(), false);
+      offset = reader.getEntry(9).offset + DUNE_IMC_CONST_HEADER_SIZE;
+    }
+
+    std::fstream fs(lsf.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+    fs.seekp(offset);
+    fs.put('\xff');
+    fs.put('\xff');
+  }
+
+  Path(idx).remove();
+
+  {
+    IMC::LogReader reader(lsf.str());
+    test.boolean("scan stops at invalid CRC", reader.isIndexRebuilt() && reader.getCount() == 9);
+  }
+
+  lsf.remove();
+  Path(idx).remove();
+
+  return test.getReturnValue();
+}
@@ -0,0 +1,215 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <string>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using DUNE_NAMESPACES;
+
+//! Task that only logs.
+class Chatty: public Tasks::Task
+{
+public:
+  Chatty(Tasks::Context& ctx):
+    Tasks::Task("Chatty", ctx)
+  { }
+
+  void
+  onMain(void)
+  { }
+};
+
+//! Task that records log book entries.
+class Reader: public Tasks::Task
+{
+public:
+  Reader(Tasks::Context& ctx):
+    Tasks::Task("Reader", ctx)
+  {
+    bind<IMC::LogBookEntry>(this);
+  }
+
+  void
+  consume(const IMC::LogBookEntry* msg)
+  {
+    texts.push_back(msg->text);
+  }
+
+  void
+  read(void)
+  {
+    consumeMessages();
+  }
+
+  void
+  onMain(void)
+  { }
+
+  std::vector<std::string> texts;
+};
+
+//! Wait for a number of messages to be written.
+static Tasks::LogSink::Statistics
+waitWritten(Tasks::LogSink& sink, uint64_t count)
+{
+  Tasks::LogSink::Statistics stats;
+  for (unsigned i = 0; i < 100; ++i)
+  {
+    sink.getStatistics(stats);
+    if (stats.written >= count)
+      break;
+    Delay::wait(0.02);
+  }
+
+  Delay::wait(0.1);
+  sink.getStatistics(stats);
+  return stats;
+}
+
+int
+main(void)
+{
+  Test test("Tasks::LogSink");
+
+  Tasks::Context ctx;
+  Chatty task(ctx);
+
+  {
+    Tasks::LogSink sink(ctx, 10.0, 5);
+    ctx.logs = &sink;
+    sink.start();
+
+    // A burst from a single call site.
+    for (unsigned i = 0; i < 100; ++i)
+      task.inf("frame %u", i);
+
+    // Identical messages of a call site are collapsed.
+    const char* texts[] = {"same", "same", "same", "different"};
+    for (unsigned i = 0; i < 4; ++i)
+      task.inf("%s", texts[i]);
+
+    Tasks::LogSink::Statistics stats = waitWritten(sink, 8);
+    test.boolean("rate limit", stats.suppressed == 95);
+    test.boolean("repetitions collapsed", stats.collapsed == 2);
+    test.boolean("messages written", stats.written == 8);
+    test.boolean("no messages dropped", stats.dropped == 0);
+    ctx.logs = NULL;
+  }
+
+  {
+    Tasks::LogSink sink(ctx, 0, 1, 32);
+    ctx.logs = &sink;
+
+    // Fill the ring before the sink starts draining it.
+    for (unsigned i = 0; i < 40; ++i)
+      task.inf("message %u", i);
+    sink.start();
+
+    Tasks::LogSink::Statistics stats = waitWritten(sink, 33);
+    test.boolean("full ring drops messages", stats.dropped == 8 && stats.written == 33);
+    test.boolean("no rate limit", stats.suppressed == 0);
+    ctx.logs = NULL;
+  }
+
+  {
+    Reader reader(ctx);
+    Tasks::LogSink sink(ctx, 10.0, 5);
+    ctx.logs = &sink;
+    sink.start();
+
+    // Warnings and errors are never rate limited.
+    for (unsigned i = 0; i < 10; ++i)
+    {
+      task.war("warning %u", i);
+      task.err("error %u", i);
+    }
+
+    Tasks::LogSink::Statistics stats = waitWritten(sink, 20);
+    test.boolean("warnings and errors not limited", stats.suppressed == 0 && stats.written == 20);
+
+    // Call sites sharing a format string are limited separately.
+    for (unsigned i = 0; i < 5; ++i)
+    {
+      task.inf("%s", String::str("first %u", i).c_str());
+      task.inf("%s", String::str("second %u", i).c_str());
+    }
+
+    stats = waitWritten(sink, 30);
+    test.boolean("call sites limited separately", stats.suppressed == 0 && stats.written == 30);
+
+    // The next admitted message reports the suppressed ones.
+    for (unsigned i = 0; i < 11; ++i)
+    {
+      Delay::wait(i == 10 ? 0.2 : 0.0);
+      task.inf("burst %u", i);
+    }
+
+    stats = waitWritten(sink, 36);
+    reader.read();
+
+    bool reported = false;
+    for (size_t i = 0; i < reader.texts.size(); ++i)
+    {
+      const std::string& text = reader.texts[i];
+      if (text.find("burst 10 (5 messages suppressed at call site") == 0
+          && text.find("\"burst %u\"") != std::string::npos)
+        reported = true;
+    }
+
+    test.boolean("suppressed messages reported with call site", stats.suppressed == 5 && reported);
+    ctx.logs = NULL;
+  }
+
+  {
+    Reader reader(ctx);
+    Tasks::LogSink sink(ctx, 0, 1, 32);
+    ctx.logs = &sink;
+
+    // Warnings are written by the logging thread when the ring is
+    // full.
+    for (unsigned i = 0; i < 40; ++i)
+      task.war("warning %u", i);
+    sink.start();
+
+    Tasks::LogSink::Statistics stats = waitWritten(sink, 32);
+    reader.read();
+    test.boolean("full ring keeps warnings", stats.dropped == 0 && stats.written == 32
+                 && reader.texts.size() == 40);
+    ctx.logs = NULL;
+  }
+
+  return test.getReturnValue();
+}
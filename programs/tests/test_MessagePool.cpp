@@ -0,0 +1,108 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <cstdio>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using DUNE_NAMESPACES;
+
+//! Find statistics of the size class of a given object size.
+static IMC::MessagePool::Statistics
+find(size_t size)
+{
+  std::vector<IMC::MessagePool::Statistics> stats;
+  IMC::MessagePool::getStatistics(stats);
+
+  for (size_t i = 0; i < stats.size(); ++i)
+  {
+    if (stats[i].size >= size && stats[i].size < size + 16)
+      return stats[i];
+  }
+
+  IMC::MessagePool::Statistics none = {0, 0, 0, 0, 0};
+  return none;
+}
+
+int
+main(void)
+{
+  Test test("IMC::MessagePool");
+
+  IMC::Message* msg = IMC::Factory::produce(IMC::Temperature::getIdStatic());
+  test.boolean("Factory::produce() by id", msg != NULL && msg->getId() == IMC::Temperature::getIdStatic());
+  delete msg;
+
+  test.boolean("Factory::produce() unknown id", IMC::Factory::produce(65535) == NULL);
+
+  IMC::MessagePool::Statistics before = find(sizeof(IMC::Temperature));
+  test.boolean("released object is cached", before.cached >= 1 && before.in_use == 0);
+
+  // Steady state: every allocation reuses a cached object.
+  IMC::Temperature temp;
+  temp.value = 1.0;
+  for (unsigned i = 0; i < 1000; ++i)
+  {
+    IMC::Message* a = IMC::Factory::produce(IMC::Temperature::getIdStatic());
+    IMC::Message* b = temp.clone();
+    delete a;
+    delete b;
+  }
+
+  IMC::MessagePool::Statistics after = find(sizeof(IMC::Temperature));
+  uint64_t fresh_before = before.allocations - before.reuses;
+  uint64_t fresh_after = after.allocations - after.reuses;
+  test.boolean("steady state reuses objects", after.allocations == before.allocations + 2000
+               && fresh_after - fresh_before <= 1);
+  test.boolean("no objects leaked", after.in_use == 0);
+
+  IMC::Message* clone = temp.clone();
+  test.boolean("clone() from pool", *clone == temp);
+  delete clone;
+
+  IMC::MessagePool::trim();
+  test.boolean("trim()", find(sizeof(IMC::Temperature)).cached == 0);
+
+  std::vector<IMC::MessagePool::Statistics> stats;
+  IMC::MessagePool::getStatistics(stats);
+  for (size_t i = 0; i < stats.size(); ++i)
+  {
+    std::fprintf(stderr, "  %4u bytes: %llu allocations, %llu reuses, %lld in use, %u cached\n",
+                 (unsigned)stats[i].size, (unsigned long long)stats[i].allocations,
+                 (unsigned long long)stats[i].reuses, (long long)stats[i].in_use, stats[i].cached);
+  }
+
+  return test.getReturnValue();
+}
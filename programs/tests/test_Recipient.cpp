@@ -0,0 +1,141 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+
+// ISO C++ 98 headers.
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using DUNE_NAMESPACES;
+
+//! Task that records the order of delivered messages.
+class Recorder: public Tasks::Task
+{
+public:
+  Recorder(Tasks::Context& ctx):
+    Tasks::Task("Recorder", ctx)
+  {
+    bind<IMC::Temperature>(this);
+    bind<IMC::Pressure>(this);
+  }
+
+  void
+  consume(const IMC::Temperature* msg)
+  {
+    order.push_back(msg->value);
+  }
+
+  void
+  consume(const IMC::Pressure* msg)
+  {
+    order.push_back(msg->value);
+  }
+
+  void
+  onMain(void)
+  { }
+
+  std::vector<double> order;
+};
+
+int
+main(void)
+{
+  Test test("Tasks::Recipient");
+
+  Tasks::Context ctx;
+  Recorder task(ctx);
+  IMC::Temperature temp;
+  IMC::Pressure press;
+
+  {
+    Tasks::Recipient recipient(&task, ctx);
+    recipient.bind(temp.getId(), new Tasks::Consumer<Recorder, IMC::Temperature>(task, &Recorder::consume));
+    recipient.bind(press.getId(), new Tasks::Consumer<Recorder, IMC::Pressure>(task, &Recorder::consume));
+    recipient.setCapacity(2);
+    recipient.setOverflowPolicy(Tasks::Recipient::OP_COALESCE);
+
+    // 1 and 2 fill the queue, 3 is coalesced and replaced by 5.
+    temp.value = 1;
+    recipient.put(IMC::SharedMessage::copy(&temp));
+    temp.value = 2;
+    recipient.put(IMC::SharedMessage::copy(&temp));
+    press.value = 3;
+    recipient.put(IMC::SharedMessage::copy(&press));
+    press.value = 5;
+    recipient.put(IMC::SharedMessage::copy(&press));
+
+    // 4 takes the place of 1 in the queue, but arrived after 3.
+    recipient.setOverflowPolicy(Tasks::Recipient::OP_DROP_OLDEST);
+    temp.value = 4;
+    recipient.put(IMC::SharedMessage::copy(&temp));
+    recipient.runCallBacks();
+
+    Tasks::Recipient::Statistics stats;
+    recipient.getStatistics(stats);
+    test.boolean("coalesced messages replaced", stats.coalesced == 1 && stats.dropped == 1);
+    test.boolean("delivery in arrival order", task.order.size() == 3
+                 && task.order[0] == 2 && task.order[1] == 5 && task.order[2] == 4);
+  }
+
+  {
+    Tasks::Recipient recipient(&task, ctx);
+    recipient.bind(temp.getId(), new Tasks::Consumer<Recorder, IMC::Temperature>(task, &Recorder::consume));
+    recipient.setCapacity(2);
+    recipient.setOverflowPolicy(Tasks::Recipient::OP_BLOCK);
+
+    for (unsigned i = 0; i < 3; ++i)
+      recipient.put(IMC::SharedMessage::copy(&temp));
+
+    Tasks::Recipient::Statistics stats;
+    recipient.getStatistics(stats);
+    test.boolean("block timeout drops message", stats.depth == 2 && stats.dropped == 1);
+
+    bool left = !recipient.tryPut(IMC::SharedMessage::copy(&temp), false);
+    bool dropped = recipient.tryPut(IMC::SharedMessage::copy(&temp), true);
+    recipient.getStatistics(stats);
+    test.boolean("offer without waiting", left && dropped && stats.dropped == 2);
+  }
+
+  {
+    Tasks::Recipient recipient(&task, ctx);
+    recipient.wakeUp();
+
+    double start = Clock::get();
+    recipient.waitForMessages(5.0);
+    test.boolean("wakeUp() ends the next wait", Clock::get() - start < 1.0);
+  }
+
+  return test.getReturnValue();
+}
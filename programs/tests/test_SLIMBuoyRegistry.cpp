@@ -0,0 +1,150 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+
+// ISO C++ 98 headers.
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+#include <Transports/MQTT/SLIMMessageBridge/BuoyRegistry.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using DUNE_NAMESPACES;
+using Transports::MQTT::SLIMMessageBridge::BuoyRegistry;
+using Transports::MQTT::SLIMMessageBridge::BuoyPosition;
+
+//! Overwrite one byte of a file.
+static void
+patch(const Path& path, std::streamoff offset, char value)
+{
+  std::fstream fs(path.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+  fs.seekp(offset);
+  fs.write(&value, 1);
+}
+
+//! Copy a file, keeping only the first bytes.
+static void
+truncate(const Path& src, const Path& dst, size_t size)
+{
+  std::ifstream ifs(src.c_str(), std::ios::binary);
+  std::string data((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+  std::ofstream ofs(dst.c_str(), std::ios::binary | std::ios::trunc);
+  ofs.write(data.data(), std::min(size, data.size()));
+}
+
+int
+main(void)
+{
+  Test test("SLIM Buoy Registry");
+
+  Path path("/tmp/test_SLIMBuoyRegistry.dat");
+  Path copy(path.str() + ".copy");
+  Path tmp(path.str() + ".tmp");
+
+  {
+    BuoyRegistry registry;
+    registry.update(1, 100, -100, 1000.0);
+    registry.update(2, 200, -200, 2000.0);
+    registry.update(3, 300, -300, 3000.0);
+    test.boolean("save", registry.save(path) && !registry.isDirty());
+    test.boolean("temporary file renamed", path.exists() && !tmp.exists());
+  }
+
+  {
+    BuoyRegistry registry;
+    test.boolean("load", registry.load(path, 3000.0) == 3 && !registry.isDirty());
+
+    const BuoyPosition* pos = registry.find(2);
+    test.boolean("positions restored", pos != NULL && pos->latitude == 200
+                 && pos->longitude == -200 && pos->timestamp == 2000.0);
+  }
+
+  {
+    BuoyRegistry registry(1000, 1500.0);
+    test.boolean("stale entries skipped", registry.load(path, 3000.0) == 2 && registry.find(1) == NULL);
+  }
+
+  {
+    BuoyRegistry registry;
+    registry.update(2, 0, 0, 2500.0);
+    test.boolean("newer entries kept", registry.load(path, 3000.0) == 2
+                 && registry.find(2)->timestamp == 2500.0);
+  }
+
+  {
+    BuoyRegistry registry;
+    test.boolean("missing file", registry.load(Path("/tmp/test_SLIMBuoyRegistry.none"), 0.0) == -1);
+  }
+
+  // Header: magic (4 bytes) and record count (4 bytes, little endian).
+  {
+    truncate(path, copy, 1000);
+    patch(copy, 4, 100);
+    BuoyRegistry registry;
+    test.boolean("record count beyond file", registry.load(copy, 3000.0) == -1 && registry.size() == 0);
+  }
+
+  {
+    truncate(path, copy, 1000);
+    patch(copy, 4, 2);
+    BuoyRegistry registry;
+    test.boolean("record count below file", registry.load(copy, 3000.0) == -1 && registry.size() == 0);
+  }
+
+  {
+    truncate(path, copy, 8 + 2 * 18);
+    BuoyRegistry registry;
+    test.boolean("truncated snapshot", registry.load(copy, 3000.0) == -1);
+  }
+
+  {
+    truncate(path, copy, 1000);
+    patch(copy, 10, 0x7f);
+    BuoyRegistry registry;
+    test.boolean("corrupted record", registry.load(copy, 3000.0) == -1);
+  }
+
+  {
+    truncate(path, copy, 1000);
+    patch(copy, 0, 0);
+    BuoyRegistry registry;
+    test.boolean("bad magic", registry.load(copy, 3000.0) == -1);
+  }
+
+  path.remove();
+  copy.remove();
+
+  return test.getReturnValue();
+}
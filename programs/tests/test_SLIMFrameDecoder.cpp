@@ -0,0 +1,130 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+
+// ISO C++ 98 headers.
+#include <cstddef>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+#include <Transports/MQTT/SLIMMessageBridge/FrameDecoder.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using DUNE_NAMESPACES;
+using Transports::MQTT::SLIMMessageBridge::FrameDecoder;
+
+//! Payload with a header (serial 5, time 1000) and alternating fish
+//! tag and sensor frames.
+static const uint8_t c_payload[] =
+{
+  0x00, 0x14, 0x00, 0x00, 0x03, 0xe8,
+  // R256 detection of transmitter 42.
+  0x01, 0x00, 0x2a, 0x10, 0x20,
+  // Sensor reading.
+  0x02, 0xff, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06,
+  // R04K detection of transmitter 0x1234.
+  0x03, 0x01, 0x12, 0x34, 0x08, 0x01,
+  // Sensor reading.
+  0x04, 0xff, 0x00, 0x10, 0x07, 0x08, 0x09, 0x0a
+};
+
+//! Decode a payload.
+static size_t
+decode(FrameDecoder& decoder, const std::vector<uint8_t>& payload)
+{
+  FrameDecoder::Header hdr;
+  if (!FrameDecoder::decodeHeader(&payload[0], payload.size(), hdr))
+    return 0;
+
+  return decoder.decodeFrames(&payload[0], payload.size(), hdr, 1, 2);
+}
+
+int
+main(void)
+{
+  Test test("SLIM Frame Decoder");
+
+  FrameDecoder decoder;
+  std::vector<uint8_t> payload(c_payload, c_payload + sizeof(c_payload));
+
+  {
+    FrameDecoder::Header hdr;
+    test.boolean("header", FrameDecoder::decodeHeader(&payload[0], payload.size(), hdr)
+                 && hdr.serial == 5 && hdr.timestamp == 1000 && hdr.flag == FrameDecoder::HF_TBR);
+    test.boolean("short header", !FrameDecoder::decodeHeader(&payload[0], FrameDecoder::c_header_size, hdr));
+  }
+
+  {
+    size_t decoded = decode(decoder, payload);
+    test.boolean("mixed frames decoded", decoded == payload.size() && decoder.getCount() == 4
+                 && decoder.getSensorCount() == 2 && decoder.getTagCount() == 2);
+
+    bool order = true;
+    for (size_t i = 0; i < decoder.getCount(); ++i)
+    {
+      uint16_t id = (i % 2 == 0) ? IMC::TBRFishTag::getIdStatic() : IMC::TBRSensor::getIdStatic();
+      order = order && decoder.getMessage(i).getId() == id;
+    }
+    test.boolean("frames in payload order", order);
+
+    IMC::TBRFishTag& first = static_cast<IMC::TBRFishTag&>(decoder.getMessage(0));
+    IMC::TBRFishTag& second = static_cast<IMC::TBRFishTag&>(decoder.getMessage(2));
+    test.boolean("fish tag fields", first.trans_id == 42 && first.unix_timestamp == 1001
+                 && first.lat == 1 && first.lon == 2 && second.trans_id == 0x1234);
+
+    IMC::TBRSensor& sensor = static_cast<IMC::TBRSensor&>(decoder.getMessage(3));
+    test.boolean("sensor fields", sensor.unix_timestamp == 1004 && sensor.temperature == 16
+                 && sensor.avg_noise_level == 7 && sensor.recv_mem_addr == 10);
+  }
+
+  {
+    std::vector<uint8_t> truncated(payload.begin(), payload.end() - 3);
+    size_t decoded = decode(decoder, truncated);
+    test.boolean("truncated frame discarded", decoded == truncated.size() - 5 && decoder.getCount() == 3);
+  }
+
+  {
+    std::vector<uint8_t> padded(payload);
+    padded.resize(payload.size() + 7, 0);
+    size_t decoded = decode(decoder, padded);
+    test.boolean("trailing padding consumed", decoded == padded.size() && decoder.getCount() == 4);
+  }
+
+  {
+    std::vector<uint8_t> unknown(payload);
+    unknown[FrameDecoder::c_header_size + 1] = 0x09;
+    size_t decoded = decode(decoder, unknown);
+    test.boolean("unknown frame stops decoding", decoded == FrameDecoder::c_header_size && decoder.getCount() == 0);
+  }
+
+  return test.getReturnValue();
+}
@@ -0,0 +1,73 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using DUNE_NAMESPACES;
+
+int
+main(void)
+{
+  Test test("IMC::SharedMessage");
+
+  IMC::Temperature original;
+  original.value = 10.0;
+
+  IMC::SharedMessage a = IMC::SharedMessage::copy(&original);
+  test.boolean("copy()", !a.isNull() && a.get() != &original && *a.get() == original);
+  test.boolean("getReferenceCount()", a.getReferenceCount() == 1);
+
+  {
+    IMC::SharedMessage b = a;
+    IMC::SharedMessage c;
+    c = b;
+    test.boolean("copies share message", b.get() == a.get() && c.get() == a.get());
+    test.boolean("copies increment count", a.getReferenceCount() == 3);
+
+    IMC::Temperature* mut = static_cast<IMC::Temperature*>(c.getMutable());
+    mut->value = 20.0;
+    test.boolean("getMutable() detaches shared", c.get() != a.get() && c.getReferenceCount() == 1);
+    test.boolean("getMutable() leaves others intact",
+                 static_cast<const IMC::Temperature*>(a.get())->value == 10.0);
+    test.boolean("getMutable() on unique handle", c.getMutable() == c.get());
+  }
+
+  test.boolean("release decrements count", a.getReferenceCount() == 1);
+
+  IMC::SharedMessage null;
+  test.boolean("null handle", null.isNull() && null.get() == NULL && null.getReferenceCount() == 0);
+  a = null;
+  test.boolean("assign null", a.isNull());
+
+  return test.getReturnValue();
+}
@@ -0,0 +1,182 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+
+// ISO C++ 98 headers.
+#include <string>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using DUNE_NAMESPACES;
+
+//! Task with a slow and a fast callback.
+class Listener: public Tasks::Task
+{
+public:
+  Listener(Tasks::Context& ctx):
+    Tasks::Task("Listener", ctx)
+  {
+    bind<IMC::Temperature>(this);
+    bind<IMC::Pressure>(this);
+  }
+
+  void
+  consume(const IMC::Temperature* msg)
+  {
+    (void)msg;
+    Delay::wait(0.002);
+  }
+
+  void
+  consume(const IMC::Pressure* msg)
+  {
+    (void)msg;
+  }
+
+  void
+  consume(void)
+  {
+    consumeMessages();
+  }
+
+  void
+  onMain(void)
+  { }
+};
+
+//! Task that only dispatches.
+class Talker: public Tasks::Task
+{
+public:
+  Talker(Tasks::Context& ctx):
+    Tasks::Task("Talker", ctx)
+  { }
+
+  void
+  onMain(void)
+  { }
+};
+
+//! Thread that burns CPU time until stopped.
+class Spinner: public Concurrency::Thread
+{
+public:
+  void
+  run(void)
+  {
+    volatile unsigned x = 0;
+    while (!isStopping())
+      ++x;
+  }
+};
+
+//! Find callback statistics of a message type.
+static const Tasks::Recipient::CallbackStatistics*
+find(const std::vector<Tasks::Recipient::CallbackStatistics>& stats, uint32_t id)
+{
+  for (size_t i = 0; i < stats.size(); ++i)
+  {
+    if (stats[i].id == id)
+      return &stats[i];
+  }
+
+  return NULL;
+}
+
+int
+main(void)
+{
+  Test test("Tasks::Task profiling");
+
+  Tasks::Context ctx;
+  Listener listener(ctx);
+  Listener other(ctx);
+  Talker talker(ctx);
+
+  IMC::Temperature temp;
+  IMC::Pressure press;
+  for (unsigned i = 0; i < 5; ++i)
+    talker.dispatch(temp);
+  for (unsigned i = 0; i < 20; ++i)
+    talker.dispatch(press);
+  IMC::Heartbeat hb;
+  talker.dispatch(hb);
+  listener.consume();
+
+  Tasks::Task::DispatchStatistics dstats;
+  talker.getDispatchStatistics(dstats);
+  test.boolean("dispatch count", dstats.dispatched == 26);
+  test.boolean("dispatch fan-out", dstats.deliveries == 50 && dstats.fanout_max == 2);
+
+  talker.getDispatchStatistics(dstats);
+  test.boolean("dispatch statistics reset", dstats.dispatched == 0 && dstats.deliveries == 0);
+
+  std::vector<Tasks::Recipient::CallbackStatistics> cstats;
+  listener.getCallbackStatistics(cstats);
+  const Tasks::Recipient::CallbackStatistics* t = find(cstats, temp.getId());
+  const Tasks::Recipient::CallbackStatistics* p = find(cstats, press.getId());
+  test.boolean("callback statistics per message type", cstats.size() == 2 && t != NULL && p != NULL);
+  test.boolean("callback calls", t != NULL && t->calls == 5 && p != NULL && p->calls == 20);
+  test.boolean("slow callback time", t != NULL && t->time_sum >= 0.01 && t->time_max >= 0.002
+               && t->time_hist[3] + t->time_hist[4] == 5);
+  test.boolean("fast callback time", p != NULL && p->time_max < t->time_max);
+
+  listener.getCallbackStatistics(cstats);
+  test.boolean("callback statistics reset", cstats.empty());
+
+  ctx.report.set("Listener", "profile", "{\"callbacks\": 25}");
+  ctx.report.set("Talker", "profile", "{}");
+  ctx.report.set("Listener", "queue", "{\"depth\": 0}");
+  ctx.report.set("Listener", "profile", "{\"callbacks\": 0}");
+  std::string report = ctx.report.toJSON();
+  std::string tasks = "\"tasks\": {\"Listener\": {\"profile\": {\"callbacks\": 0}, "
+    "\"queue\": {\"depth\": 0}}, \"Talker\": {\"profile\": {}}}}";
+  test.boolean("task report", report.compare(0, 9, "{\"time\": ") == 0
+               && report.size() > tasks.size()
+               && report.compare(report.size() - tasks.size(), tasks.size(), tasks) == 0);
+
+  Spinner spinner;
+  test.boolean("no CPU time before start", spinner.getCpuTime() < 0);
+  spinner.start();
+  Delay::wait(0.3);
+  double cpu_time = spinner.getCpuTime();
+  spinner.stopAndJoin();
+#if defined(DUNE_OS_LINUX)
+  test.boolean("thread CPU time", cpu_time >= 0.05);
+#else
+  test.boolean("thread CPU time", cpu_time < 0);
+#endif
+
+  return test.getReturnValue();
+}
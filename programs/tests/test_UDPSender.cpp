@@ -0,0 +1,165 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+
+// ISO C++ 98 headers.
+#include <cstring>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Transports headers.
+#include <Transports/UDP/Sender.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using DUNE_NAMESPACES;
+using Transports::UDP::Sender;
+
+//! Coalescing window (s).
+static const double c_window = 0.005;
+
+//! Task without traffic.
+class Quiet: public Tasks::Task
+{
+public:
+  Quiet(Tasks::Context& ctx):
+    Tasks::Task("Quiet", ctx)
+  {
+    bind<IMC::Temperature>(this);
+  }
+
+  void
+  consume(const IMC::Temperature* msg)
+  {
+    (void)msg;
+  }
+
+  void
+  wait(double timeout)
+  {
+    waitForMessages(timeout);
+  }
+
+  void
+  onMain(void)
+  { }
+};
+
+//! Receive all datagrams available within a timeout.
+static unsigned
+receive(UDPSocket& rx, double timeout)
+{
+  uint8_t bfr[1024];
+  unsigned count = 0;
+  while (Poll::poll(rx, timeout))
+  {
+    rx.read(bfr, sizeof(bfr));
+    ++count;
+    timeout = 0.05;
+  }
+
+  return count;
+}
+
+//! One iteration of the main loop of Transports.UDP.
+static void
+iterate(Sender& sender, Quiet& task)
+{
+  sender.flushIfDue();
+  task.wait(sender.getWaitTime(1.0));
+  sender.flushIfDue();
+}
+
+int
+main(void)
+{
+  Test test("Transports::UDP::Sender");
+
+  Tasks::Context ctx;
+  Quiet task(ctx);
+  UDPSocket tx;
+  UDPSocket rx;
+  uint16_t rx_port = 0;
+  for (uint16_t port = 40100; port < 40200 && rx_port == 0; ++port)
+  {
+    try
+    {
+      rx.bind(port, Address::Loopback, false);
+      rx_port = port;
+    }
+    catch (...)
+    { }
+  }
+
+  test.boolean("bind()", rx_port != 0);
+
+  Sender sender(tx);
+  uint8_t data[16];
+  std::memset(data, 0xaa, sizeof(data));
+
+  // A single datagram is sent when the window expires.
+  sender.queue(data, sizeof(data));
+  sender.add(Address::Loopback, rx_port);
+  sender.schedule(c_window);
+  double start = Clock::get();
+  iterate(sender, task);
+  test.boolean("queued datagram sent without further traffic",
+               sender.getPending() == 0 && Clock::get() - start < 0.5 && receive(rx, 1.0) == 1);
+
+  // The flush became overdue while the loop was busy.
+  sender.queue(data, sizeof(data));
+  sender.add(Address::Loopback, rx_port);
+  sender.schedule(c_window);
+  Delay::wait(c_window * 4);
+  test.boolean("overdue flush does not wait forever", sender.getWaitTime(1.0) > 0);
+  iterate(sender, task);
+  test.boolean("overdue datagram sent", sender.getPending() == 0 && receive(rx, 1.0) == 1);
+
+  // System calls are counted per call, not per batch.
+  sender.resetStatistics();
+  for (unsigned i = 0; i < 100; ++i)
+  {
+    sender.queue(data, sizeof(data));
+    sender.add(Address::Loopback, rx_port);
+  }
+  sender.flush();
+  receive(rx, 1.0);
+
+  const Sender::Statistics& stats = sender.getStatistics();
+#if defined(DUNE_SYS_HAS_SENDMMSG)
+  test.boolean("system calls", stats.datagrams == 100 && stats.syscalls == 2);
+#else
+  test.boolean("system calls", stats.datagrams == 100 && stats.syscalls == 100);
+#endif
+
+  return test.getReturnValue();
+}
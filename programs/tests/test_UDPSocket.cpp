@@ -0,0 +1,121 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <cstring>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/Network.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using namespace DUNE::Network;
+
+//! Number of datagrams of each test batch.
+static const unsigned c_count = 64;
+
+int
+main(void)
+{
+  Test test("Network::UDPSocket");
+
+  UDPSocket tx;
+
+  // Bind the receiving socket to a free port.
+  UDPSocket rx;
+  uint16_t rx_port = 0;
+  for (uint16_t port = 40000; port < 40100 && rx_port == 0; ++port)
+  {
+    try
+    {
+      rx.bind(port, Address::Loopback, false);
+      rx_port = port;
+    }
+    catch (...)
+    { }
+  }
+
+  test.boolean("bind()", rx_port != 0);
+
+  // Payloads of different sizes.
+  std::vector<std::vector<uint8_t> > payloads(c_count);
+  std::vector<UDPSocket::Datagram> out(c_count);
+  for (unsigned i = 0; i < c_count; ++i)
+  {
+    payloads[i].resize(1 + i * 7, (uint8_t)i);
+    out[i].data = &payloads[i][0];
+    out[i].size = payloads[i].size();
+    out[i].addr = Address(Address::Loopback);
+    out[i].port = rx_port;
+  }
+
+  size_t sent = tx.write(&out[0], c_count);
+  test.boolean("write() batch", sent == c_count);
+
+  std::vector<uint8_t> bfr(c_count * 1024);
+  std::vector<UDPSocket::Datagram> in(c_count);
+  size_t received = 0;
+  unsigned calls = 0;
+  bool valid = true;
+  while (received < c_count)
+  {
+    for (unsigned i = 0; i < c_count; ++i)
+    {
+      in[i].data = &bfr[i * 1024];
+      in[i].size = 1024;
+    }
+
+    size_t rv = rx.read(&in[0], c_count - received);
+    for (size_t i = 0; i < rv; ++i)
+    {
+      const std::vector<uint8_t>& expected = payloads[received + i];
+      valid = valid && in[i].size == expected.size()
+        && std::memcmp(in[i].data, &expected[0], expected.size()) == 0
+        && in[i].addr == Address::Loopback;
+    }
+
+    received += rv;
+    ++calls;
+  }
+
+  test.boolean("read() batch", received == c_count && valid);
+  test.boolean("read() system calls", calls < c_count);
+
+  // Single datagram interface interoperates with batches.
+  uint8_t single[4] = {1, 2, 3, 4};
+  tx.write(single, sizeof(single), Address::Loopback, rx_port);
+  in[0].data = &bfr[0];
+  in[0].size = 1024;
+  test.boolean("read() single", rx.read(&in[0], 1) == 1 && in[0].size == sizeof(single)
+               && std::memcmp(in[0].data, single, sizeof(single)) == 0);
+
+  return test.getReturnValue();
+}
@@ -0,0 +1,202 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <string>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using DUNE_NAMESPACES;
+
+//! Order of wake ups of all tickers.
+static std::string s_trace;
+
+//! Thread that sleeps for a fixed period.
+class Ticker: public Concurrency::Thread
+{
+public:
+  Ticker(char name, double period, unsigned count):
+    m_name(name),
+    m_period(period),
+    m_count(count)
+  { }
+
+  void
+  run(void)
+  {
+    for (unsigned i = 0; i < m_count; ++i)
+    {
+      Delay::wait(m_period);
+      s_trace += m_name;
+    }
+  }
+
+private:
+  //! Name appended to the trace.
+  char m_name;
+  //! Sleep period (s).
+  double m_period;
+  //! Number of periods.
+  unsigned m_count;
+};
+
+//! Thread that waits on a condition.
+class Sleeper: public Concurrency::Thread
+{
+public:
+  Sleeper(double timeout):
+    m_timeout(timeout),
+    m_ready(false),
+    m_signaled(false),
+    m_elapsed(0)
+  { }
+
+  void
+  run(void)
+  {
+    uint64_t start = Clock::getNsec();
+    m_cond.lock();
+    while (!m_ready)
+    {
+      if (!m_cond.wait(m_timeout))
+        break;
+    }
+    m_signaled = m_ready;
+    m_cond.unlock();
+    m_elapsed = Clock::getNsec() - start;
+  }
+
+  void
+  notify(void)
+  {
+    m_cond.lock();
+    m_ready = true;
+    m_cond.signal();
+    m_cond.unlock();
+  }
+
+  bool
+  signaled(void) const
+  {
+    return m_signaled;
+  }
+
+  uint64_t
+  elapsed(void) const
+  {
+    return m_elapsed;
+  }
+
+private:
+  //! Condition timeout (s).
+  double m_timeout;
+  //! Condition.
+  Concurrency::Condition m_cond;
+  //! True if notified.
+  bool m_ready;
+  //! True if woken by notify().
+  bool m_signaled;
+  //! Logical time spent waiting (ns).
+  uint64_t m_elapsed;
+};
+
+//! Thread that wakes a sleeper after a delay.
+class Waker: public Concurrency::Thread
+{
+public:
+  Waker(Sleeper& sleeper, double delay):
+    m_sleeper(sleeper),
+    m_delay(delay)
+  { }
+
+  void
+  run(void)
+  {
+    Delay::wait(m_delay);
+    m_sleeper.notify();
+  }
+
+private:
+  //! Sleeper to wake.
+  Sleeper& m_sleeper;
+  //! Delay before notifying (s).
+  double m_delay;
+};
+
+int
+main(void)
+{
+  Test test("Time::VirtualClock");
+
+  Clock::setVirtual();
+  test.boolean("setVirtual()", VirtualClock::isEnabled());
+
+  double rt = Clock::getRT();
+  uint64_t start = Clock::getNsec();
+  double epoch = Clock::getSinceEpoch();
+
+  {
+    Ticker a('A', 100.0, 3);
+    Ticker b('B', 150.0, 3);
+    a.start();
+    b.start();
+    a.join();
+    b.join();
+  }
+
+  test.boolean("logical time advanced", Clock::getNsec() - start == (uint64_t)450 * c_nsec_per_sec);
+  test.boolean("epoch time advanced", Clock::getSinceEpoch() - epoch > 449.0);
+  test.boolean("as fast as possible", Clock::getRT() - rt < 5.0);
+
+  // Equal deadlines resume in order of arrival.
+  test.boolean("deterministic order", s_trace == "ABABAB");
+
+  {
+    Sleeper sleeper(1000.0);
+    Waker waker(sleeper, 20.0);
+    sleeper.start();
+    waker.start();
+    sleeper.join();
+    waker.join();
+    test.boolean("Condition::signal()", sleeper.signaled() && sleeper.elapsed() == (uint64_t)20 * c_nsec_per_sec);
+  }
+
+  {
+    Sleeper sleeper(30.0);
+    sleeper.start();
+    sleeper.join();
+    test.boolean("Condition::wait() timeout", !sleeper.signaled() && sleeper.elapsed() == (uint64_t)30 * c_nsec_per_sec);
+  }
+
+  return test.getReturnValue();
+}
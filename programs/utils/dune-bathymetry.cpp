@@ -0,0 +1,81 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+// Utility program to convert bathymetry configuration files to grids.      *
+//***************************************************************************
+
+// ISO C++ headers
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <vector>
+
+// DUNE headers
+#include <DUNE/Simulation/Bathymetry.hpp>
+#include <DUNE/Time/Clock.hpp>
+
+using DUNE::Simulation::Bathymetry;
+
+int
+main(int argc, char** argv)
+{
+  if (argc < 3 || argc > 5)
+  {
+    std::cerr << "Usage: " << argv[0] << " <bathymetry.ini> <bathymetry.bin> [cell size] [radius]" << std::endl
+              << "  cell size -- distance between grid nodes in meters (default: 5)" << std::endl
+              << "  radius    -- interpolation radius in meters (default: 10)" << std::endl;
+    return 1;
+  }
+
+  double cell = (argc > 3) ? std::atof(argv[3]) : 5.0;
+  double radius = (argc > 4) ? std::atof(argv[4]) : 10.0;
+
+  try
+  {
+    double start = DUNE::Time::Clock::get();
+
+    double lat = 0;
+    double lon = 0;
+    std::vector<Bathymetry::Sample> samples;
+    Bathymetry::readSamples(argv[1], lat, lon, samples);
+
+    Bathymetry bathy;
+    bathy.create(lat, lon, samples, cell, radius);
+    bathy.save(argv[2]);
+
+    std::cout << samples.size() << " samples, " << bathy.getRows() << " x " << bathy.getColumns()
+              << " nodes, " << DUNE::Time::Clock::get() - start << " s" << std::endl;
+  }
+  catch (std::exception& e)
+  {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
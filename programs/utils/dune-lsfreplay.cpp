@@ -33,10 +33,38 @@
 #include <iostream>
 #include <iomanip>
 #include <map>
+#include <set>
+#include <limits>
 #include <DUNE/DUNE.hpp>
 
 using DUNE_NAMESPACES;
 
+//! Read the next message to replay.
+//! @param reader indexed reader or NULL.
+//! @param cursor next packet of the indexed reader.
+//! @param is input stream if there is no indexed reader.
+//! @param ids messages to replay (all if empty).
+//! @param stop time stamp after which no filtering is done.
+//! @return message or NULL if there are no more messages.
+static IMC::Message*
+readMessage(IMC::LogReader* reader, size_t& cursor, std::istream* is,
+            const std::set<uint16_t>& ids, double stop)
+{
+  if (reader == NULL)
+    return IMC::Packet::deserialize(*is);
+
+  // Skip filtered messages without deserializing them.
+  while (cursor < reader->getCount() && !ids.empty()
+         && reader->getEntry(cursor).time < stop
+         && ids.find(reader->getEntry(cursor).id) == ids.end())
+    ++cursor;
+
+  if (cursor >= reader->getCount())
+    return NULL;
+
+  return reader->getMessage(cursor++);
+}
+
 static
 void
 usage(void)
@@ -52,7 +80,7 @@ usage(void)
             << "f1 ... fn can be:\n"
             << "\t* Gzipped LSF files (.gz extension)\n"
             << "\t* LLF log dir names (will look for Data.lsf.gz in it)\n"
-            << "\t* plain LSF files\n";
+            << "\t* plain LSF files (indexed, the index is built if missing)\n";
 }
 
 int
@@ -60,6 +88,7 @@ main(int argc, char** argv)
 {
   double speed = 1, begin = 0, end = -1;
   std::map<std::string, bool> filter;
+  std::set<uint16_t> filter_ids;
   bool filtering = false;
   int verbose = 0;
   uint16_t src = 0xFFFF, dst = 0xFFFF;
@@ -156,7 +185,18 @@ main(int argc, char** argv)
         std::vector<std::string> list;
         DUNE::Utils::String::split(*argv, ",", list);
         for (uint16_t i = 0; i < list.size(); ++i)
+        {
           filter[list[i]] = true;
+
+          try
+          {
+            filter_ids.insert(IMC::Factory::getIdFromAbbrev(list[i]));
+          }
+          catch (...)
+          {
+            std::cerr << "Unknown message: " << list[i] << '\n';
+          }
+        }
         filtering = true;
       }
       break;
@@ -192,7 +232,9 @@ main(int argc, char** argv)
   for (; *argv != 0; argv++)
   {
     Path file(*argv);
-    std::istream* is;
+    std::istream* is = NULL;
+    IMC::LogReader* reader = NULL;
+    size_t cursor = 0;
 
     if (file.isDirectory())
     {
@@ -209,16 +251,24 @@ main(int argc, char** argv)
 
     Compression::Methods method = Compression::Factory::detect(file.c_str());
     if (method == METHOD_UNKNOWN)
-      is = new std::ifstream(file.c_str(), std::ios::binary);
+    {
+      reader = new IMC::LogReader(file.str());
+      if (verbose >= 1 && reader->isIndexRebuilt())
+        std::cout << file << ": indexed " << reader->getCount() << " messages\n";
+    }
     else
+    {
       is = new Compression::FileInput(file.c_str(), method);
+    }
 
     IMC::Message* m;
+    std::set<uint16_t> no_filter;
 
-    m = IMC::Packet::deserialize(*is);
+    m = readMessage(reader, cursor, is, no_filter, 0);
     if (!m)
     {
       std::cerr << file << " contains no messages\n";
+      delete reader;
       delete is;
       continue;
     }
@@ -226,14 +276,28 @@ main(int argc, char** argv)
     DUNE::Utils::ByteBuffer bb;
 
     double time_origin = m->getTimeStamp();
-    if (begin >= 0)
+    double stop = end >= 0 ? time_origin + end : std::numeric_limits<double>::infinity();
+
+    if (reader != NULL && begin > 0)
+    {
+      delete m;
+      cursor = reader->seek(time_origin + begin);
+      m = readMessage(reader, cursor, is, no_filter, 0);
+
+      if (!m)
+      {
+        std::cerr << "no messages for specified time range" << std::endl;
+        return 1;
+      }
+    }
+    else if (begin >= 0)
     {
       do
       {
         if (m->getTimeStamp() - time_origin >= begin)
           break;
         delete m;
-        m = IMC::Packet::deserialize(*is);
+        m = readMessage(reader, cursor, is, no_filter, 0);
       }
       while (m);
 
@@ -287,7 +351,8 @@ main(int argc, char** argv)
       if (end >= 0 && vtime >= end)
         break;
     }
-    while ((m = IMC::Packet::deserialize(*is)) != 0);
+    while ((m = readMessage(reader, cursor, is, filter_ids, stop)) != 0);
+    delete reader;
     delete is;
   }
   return 0;
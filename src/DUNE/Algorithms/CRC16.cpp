@@ -27,9 +27,23 @@
 // Author: Ricardo Martins                                                  *
 //***************************************************************************
 
+// ISO C++ 98 headers.
+#include <cstring>
+
 // DUNE headers.
 #include <DUNE/Algorithms/CRC16.hpp>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define DUNE_CRC16_CLMUL_X86
+#  include <immintrin.h>
+#elif defined(__GNUC__) && defined(__aarch64__) && defined(__AARCH64EL__) \
+  && defined(__ARM_FEATURE_CRYPTO) && defined(__linux__)
+#  define DUNE_CRC16_CLMUL_ARM
+#  include <arm_neon.h>
+#  include <sys/auxv.h>
+#  include <asm/hwcap.h>
+#endif
+
 namespace DUNE
 {
   namespace Algorithms
@@ -69,5 +83,227 @@ namespace DUNE
       0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641,
       0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040
     };
+
+    //! Slice-by-8 tables: entry [k][i] is the CRC of byte i followed
+    //! by k zero bytes.
+    static uint16_t s_slice[8][256];
+    //! Folding constants (x^191 mod P and x^127 mod P, bit reflected
+    //! in 64-bit lanes).
+    static uint64_t s_fold_lo;
+    static uint64_t s_fold_hi;
+    //! True if the tables were initialized (zero-initialized, so
+    //! the bytewise implementation is used during static
+    //! initialization).
+    static bool s_ready;
+    //! True if carry-less multiplication is supported.
+    static bool s_carryless;
+
+    //! Compute x^n mod P, with bit d holding the coefficient of x^d.
+    static uint16_t
+    xpowModP(unsigned n)
+    {
+      uint32_t r = 1;
+      for (unsigned i = 0; i < n; ++i)
+      {
+        r <<= 1;
+        if (r & 0x10000)
+          r ^= 0x18005;
+      }
+
+      return (uint16_t)r;
+    }
+
+    //! Map a polynomial of degree < 64 to the bit reflected layout of
+    //! a 64-bit lane (coefficient of x^d at bit 63 - d).
+    static uint64_t
+    reflect64(uint16_t poly)
+    {
+      uint64_t r = 0;
+      for (unsigned d = 0; d < 16; ++d)
+      {
+        if (poly & (1 << d))
+          r |= (uint64_t)1 << (63 - d);
+      }
+
+      return r;
+    }
+
+    static uint16_t
+    computeBytewise(const uint8_t* buffer, size_t len, uint16_t crc)
+    {
+      while (len--)
+        crc = (crc >> 8) ^ c_crc16_ibm_table[(crc ^ *buffer++) & 0xff];
+
+      return crc;
+    }
+
+    static uint16_t
+    computeSliceBy8(const uint8_t* p, size_t len, uint16_t crc)
+    {
+      for (; len >= 8; len -= 8, p += 8)
+      {
+        crc = s_slice[7][(p[0] ^ crc) & 0xff]
+        ^ s_slice[6][p[1] ^ (crc >> 8)]
+        ^ s_slice[5][p[2]]
+        ^ s_slice[4][p[3]]
+        ^ s_slice[3][p[4]]
+        ^ s_slice[2][p[5]]
+        ^ s_slice[1][p[6]]
+        ^ s_slice[0][p[7]];
+      }
+
+      return computeBytewise(p, len, crc);
+    }
+
+    // Carry-less folding. A 16-byte block holds the polynomial
+    // l(x) * x^64 + h(x), where l and h are its bit reflected low and
+    // high 64-bit lanes. Appending 16 bytes multiplies it by x^128,
+    // which is congruent (mod P) to l(x) * (x^191 mod P) * x +
+    // h(x) * (x^127 mod P) * x, and the extra x is exactly the one bit
+    // shift introduced by multiplying bit reflected operands. The
+    // result has less than 128 bits, so the next block is simply
+    // XORed in. The CRC of the final block is the CRC of the data.
+
+#if defined(DUNE_CRC16_CLMUL_X86)
+    __attribute__((target("pclmul,sse2")))
+    static uint16_t
+    computeCarryless(const uint8_t* p, size_t len, uint16_t crc)
+    {
+      if (len < 32)
+        return computeSliceBy8(p, len, crc);
+
+      const __m128i k = _mm_set_epi64x((long long)s_fold_hi, (long long)s_fold_lo);
+      __m128i v = _mm_loadu_si128((const __m128i*)p);
+      v = _mm_xor_si128(v, _mm_cvtsi32_si128(crc));
+      p += 16;
+      len -= 16;
+
+      for (; len >= 16; len -= 16, p += 16)
+      {
+        __m128i lo = _mm_clmulepi64_si128(v, k, 0x00);
+        __m128i hi = _mm_clmulepi64_si128(v, k, 0x11);
+        v = _mm_xor_si128(_mm_xor_si128(lo, hi), _mm_loadu_si128((const __m128i*)p));
+      }
+
+      uint8_t block[16];
+      _mm_storeu_si128((__m128i*)block, v);
+      return computeSliceBy8(p, len, computeSliceBy8(block, sizeof(block), 0));
+    }
+
+    static bool
+    detectCarryless(void)
+    {
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse2");
+    }
+
+#elif defined(DUNE_CRC16_CLMUL_ARM)
+    static uint16_t
+    computeCarryless(const uint8_t* p, size_t len, uint16_t crc)
+    {
+      if (len < 32)
+        return computeSliceBy8(p, len, crc);
+
+      const poly64_t k_lo = (poly64_t)s_fold_lo;
+      const poly64_t k_hi = (poly64_t)s_fold_hi;
+      uint8x16_t v = vld1q_u8(p);
+      v = veorq_u8(v, vreinterpretq_u8_u16(vsetq_lane_u16(crc, vdupq_n_u16(0), 0)));
+      p += 16;
+      len -= 16;
+
+      for (; len >= 16; len -= 16, p += 16)
+      {
+        poly64x2_t lanes = vreinterpretq_p64_u8(v);
+        poly128_t lo = vmull_p64(vgetq_lane_p64(lanes, 0), k_lo);
+        poly128_t hi = vmull_p64(vgetq_lane_p64(lanes, 1), k_hi);
+        v = veorq_u8(veorq_u8(vreinterpretq_u8_p128(lo), vreinterpretq_u8_p128(hi)), vld1q_u8(p));
+      }
+
+      uint8_t block[16];
+      vst1q_u8(block, v);
+      return computeSliceBy8(p, len, computeSliceBy8(block, sizeof(block), 0));
+    }
+
+    static bool
+    detectCarryless(void)
+    {
+      return (getauxval(AT_HWCAP) & HWCAP_PMULL) != 0;
+    }
+
+#else
+    static uint16_t
+    computeCarryless(const uint8_t* p, size_t len, uint16_t crc)
+    {
+      return computeSliceBy8(p, len, crc);
+    }
+
+    static bool
+    detectCarryless(void)
+    {
+      return false;
+    }
+#endif
+
+    //! Initializes tables and detects processor features.
+    static struct Initializer
+    {
+      Initializer(void)
+      {
+        std::memcpy(s_slice[0], c_crc16_ibm_table, sizeof(s_slice[0]));
+        for (unsigned k = 1; k < 8; ++k)
+        {
+          for (unsigned i = 0; i < 256; ++i)
+          {
+            uint16_t prev = s_slice[k - 1][i];
+            s_slice[k][i] = (prev >> 8) ^ c_crc16_ibm_table[prev & 0xff];
+          }
+        }
+
+        s_fold_lo = reflect64(xpowModP(191));
+        s_fold_hi = reflect64(xpowModP(127));
+        s_carryless = detectCarryless();
+        s_ready = true;
+      }
+    } s_initializer;
+
+    uint16_t
+    CRC16::compute(Implementation impl, const uint8_t* buffer, size_t len, uint16_t crc)
+    {
+      if (!s_ready)
+        return computeBytewise(buffer, len, crc);
+
+      switch (impl)
+      {
+        case IMPL_BYTEWISE:
+          return computeBytewise(buffer, len, crc);
+
+        case IMPL_SLICE_BY_8:
+          return computeSliceBy8(buffer, len, crc);
+
+        default:
+          return computeBlock(buffer, len, crc);
+      }
+    }
+
+    CRC16::Implementation
+    CRC16::getImplementation(void)
+    {
+      if (!s_ready)
+        return IMPL_BYTEWISE;
+
+      return s_carryless ? IMPL_CARRYLESS : IMPL_SLICE_BY_8;
+    }
+
+    uint16_t
+    CRC16::computeBlock(const uint8_t* buffer, size_t len, uint16_t crc)
+    {
+      if (!s_ready)
+        return computeBytewise(buffer, len, crc);
+
+      if (s_carryless)
+        return computeCarryless(buffer, len, crc);
+
+      return computeSliceBy8(buffer, len, crc);
+    }
   }
 }
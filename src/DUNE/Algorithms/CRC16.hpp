@@ -30,6 +30,9 @@
 #ifndef DUNE_ALGORITHMS_CRC16_HPP_INCLUDED_
 #define DUNE_ALGORITHMS_CRC16_HPP_INCLUDED_
 
+// ISO C++ 98 headers.
+#include <cstddef>
+
 // DUNE headers.
 #include <DUNE/Config.hpp>
 
@@ -44,9 +47,26 @@ namespace DUNE
 
     //! CRC-16-IBM Algorithm.
     //! The polynomial used is x^16 + x^15 + x^2 + 1 (0x8005)
+    //!
+    //! Short buffers are processed one byte at a time. Longer buffers
+    //! are folded 16 bytes at a time with carry-less multiplication
+    //! (PCLMULQDQ on x86, PMULL on AArch64) when the processor
+    //! supports it, or processed 8 bytes at a time with slice-by-8
+    //! tables otherwise. All implementations produce the same result.
     class CRC16
     {
     public:
+      //! Available implementations.
+      enum Implementation
+      {
+        //! One byte at a time.
+        IMPL_BYTEWISE,
+        //! Eight bytes at a time (slice-by-8).
+        IMPL_SLICE_BY_8,
+        //! Carry-less multiplication folding.
+        IMPL_CARRYLESS
+      };
+
       //! Compute the CRC-16-IBM of a given data buffer.
       //! @param buffer data buffer.
       //! @param len data buffer length.
@@ -55,6 +75,9 @@ namespace DUNE
       static inline uint16_t
       compute(const uint8_t* buffer, uint16_t len, uint16_t crc = 0)
       {
+        if (len >= c_block_size)
+          return computeBlock(buffer, len, crc);
+
         while (len--)
           crc = (crc >> 8) ^ c_crc16_ibm_table[(crc ^ *buffer++) & 0xff];
 
@@ -70,6 +93,36 @@ namespace DUNE
       {
         return (crc >> 8) ^ c_crc16_ibm_table[(crc ^ byte) & 0xff];
       }
+
+      //! Compute the CRC-16-IBM of a given data buffer using a
+      //! specific implementation. If the implementation is not
+      //! supported by the processor the fastest supported one is
+      //! used instead.
+      //! @param impl implementation.
+      //! @param buffer data buffer.
+      //! @param len data buffer length.
+      //! @param crc CRC-16-IBM value to update.
+      //! @return computed CRC-16-IBM.
+      static uint16_t
+      compute(Implementation impl, const uint8_t* buffer, size_t len, uint16_t crc = 0);
+
+      //! Retrieve the implementation used for long buffers.
+      //! @return implementation.
+      static Implementation
+      getImplementation(void);
+
+    private:
+      //! Minimum buffer length processed by computeBlock().
+      static const uint16_t c_block_size = 32;
+
+      //! Compute the CRC-16-IBM of a long data buffer using the
+      //! fastest supported implementation.
+      //! @param buffer data buffer.
+      //! @param len data buffer length.
+      //! @param crc CRC-16-IBM value to update.
+      //! @return computed CRC-16-IBM.
+      static uint16_t
+      computeBlock(const uint8_t* buffer, size_t len, uint16_t crc);
     };
   }
 }
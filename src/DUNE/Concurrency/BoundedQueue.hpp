@@ -0,0 +1,246 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+#ifndef DUNE_CONCURRENCY_BOUNDED_QUEUE_HPP_INCLUDED_
+#define DUNE_CONCURRENCY_BOUNDED_QUEUE_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <deque>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/Config.hpp>
+#include <DUNE/Concurrency/ScopedCondition.hpp>
+
+namespace DUNE
+{
+  namespace Concurrency
+  {
+    //! The BoundedQueue is a thread-safe FIFO with a maximum
+    //! capacity. When the queue is full the oldest element is
+    //! discarded to make room for the new one. Consumers are expected
+    //! to drain the queue in bulk with popAll(). The queue keeps track
+    //! of discarded elements and of how many times its depth crossed a
+    //! configurable high-water mark.
+    template <typename T>
+    class BoundedQueue
+    {
+    public:
+      //! Constructor.
+      //! @param[in] capacity maximum number of elements.
+      //! @param[in] high_water depth above which the queue is
+      //! considered congested (zero to use capacity).
+      BoundedQueue(size_t capacity = 1024, size_t high_water = 0):
+        m_capacity(capacity),
+        m_high_water(high_water),
+        m_above(false),
+        m_dropped(0),
+        m_crossings(0),
+        m_peak(0)
+      { }
+
+      //! Set the maximum number of elements. Excess elements are
+      //! discarded, oldest first.
+      //! @param[in] capacity maximum number of elements.
+      void
+      setCapacity(size_t capacity)
+      {
+        ScopedCondition l(m_cond);
+        m_capacity = capacity;
+        while (m_queue.size() > m_capacity)
+        {
+          m_queue.pop_front();
+          ++m_dropped;
+        }
+      }
+
+      //! Set the high-water mark.
+      //! @param[in] high_water depth above which the queue is
+      //! considered congested (zero to use capacity).
+      void
+      setHighWaterMark(size_t high_water)
+      {
+        ScopedCondition l(m_cond);
+        m_high_water = high_water;
+      }
+
+      //! Add an element to the end of the queue, discarding the
+      //! oldest element if the queue is full, and signal waiting
+      //! threads.
+      //! @param[in] v element to insert.
+      //! @return true if no element was discarded, false otherwise.
+      bool
+      push(const T& v)
+      {
+        ScopedCondition l(m_cond);
+        bool room = true;
+
+        if (m_capacity == 0)
+        {
+          ++m_dropped;
+          return false;
+        }
+
+        if (m_queue.size() >= m_capacity)
+        {
+          m_queue.pop_front();
+          ++m_dropped;
+          room = false;
+        }
+
+        m_queue.push_back(v);
+
+        if (m_queue.size() > m_peak)
+          m_peak = m_queue.size();
+
+        size_t mark = (m_high_water == 0) ? m_capacity : m_high_water;
+        if (!m_above && m_queue.size() >= mark)
+        {
+          m_above = true;
+          ++m_crossings;
+        }
+
+        m_cond.signal();
+        return room;
+      }
+
+      //! Move elements from the queue to the end of a vector.
+      //! @param[out] out destination vector.
+      //! @param[in] max maximum number of elements to move (zero
+      //! to move all).
+      //! @return number of elements moved.
+      size_t
+      popAll(std::vector<T>& out, size_t max = 0)
+      {
+        ScopedCondition l(m_cond);
+        size_t count = m_queue.size();
+        if (max != 0 && max < count)
+          count = max;
+
+        out.insert(out.end(), m_queue.begin(), m_queue.begin() + count);
+        m_queue.erase(m_queue.begin(), m_queue.begin() + count);
+
+        size_t mark = (m_high_water == 0) ? m_capacity : m_high_water;
+        if (m_queue.size() < mark)
+          m_above = false;
+
+        return count;
+      }
+
+      //! Wait for elements to be available.
+      //! @param[in] timeout timeout in seconds, use a negative number
+      //! to wait forever.
+      //! @return true if at least one element is available, false
+      //! otherwise.
+      bool
+      waitForItems(double timeout = -1.0)
+      {
+        ScopedCondition l(m_cond);
+        if (m_queue.empty())
+          m_cond.wait(timeout);
+
+        return !m_queue.empty();
+      }
+
+      //! Wake threads waiting for elements.
+      void
+      wakeup(void)
+      {
+        ScopedCondition l(m_cond);
+        m_cond.broadcast();
+      }
+
+      //! Retrieve the number of elements currently in the queue.
+      //! @return number of elements.
+      size_t
+      size(void)
+      {
+        ScopedCondition l(m_cond);
+        return m_queue.size();
+      }
+
+      //! Verify if the queue has elements.
+      //! @return true if the queue has no elements, false otherwise.
+      bool
+      empty(void)
+      {
+        ScopedCondition l(m_cond);
+        return m_queue.empty();
+      }
+
+      //! Retrieve the number of discarded elements.
+      //! @return number of discarded elements.
+      uint64_t
+      getDropped(void)
+      {
+        ScopedCondition l(m_cond);
+        return m_dropped;
+      }
+
+      //! Retrieve how many times the queue depth reached the
+      //! high-water mark.
+      //! @return number of high-water mark crossings.
+      uint64_t
+      getHighWaterCrossings(void)
+      {
+        ScopedCondition l(m_cond);
+        return m_crossings;
+      }
+
+      //! Retrieve the maximum depth reached by the queue.
+      //! @return maximum depth.
+      size_t
+      getPeak(void)
+      {
+        ScopedCondition l(m_cond);
+        return m_peak;
+      }
+
+    private:
+      //! Internal queue data structure.
+      std::deque<T> m_queue;
+      //! Internal queue condition.
+      Condition m_cond;
+      //! Maximum number of elements.
+      size_t m_capacity;
+      //! High-water mark.
+      size_t m_high_water;
+      //! True if depth is above the high-water mark.
+      bool m_above;
+      //! Number of discarded elements.
+      uint64_t m_dropped;
+      //! Number of high-water mark crossings.
+      uint64_t m_crossings;
+      //! Maximum depth.
+      size_t m_peak;
+    };
+  }
+}
+
+#endif
@@ -41,7 +41,8 @@ namespace DUNE
   namespace Concurrency
   {
     Condition::Condition(void):
-      m_clock_monotonic(false)
+      m_clock_monotonic(false),
+      m_waiters(NULL)
     {
 #if defined(DUNE_SYS_HAS_PTHREAD_COND)
       int rv = 0;
@@ -94,6 +95,9 @@ namespace DUNE
 #if defined(DUNE_SYS_HAS_PTHREAD_COND)
       int rv = 0;
 
+      if (Time::VirtualClock::isEnabled())
+        return Time::VirtualClock::wait(&m_waiters, &m_mutex, t > 0 ? (int64_t)(t * Time::c_nsec_per_sec_fp) : -1);
+
       if (t > 0)
       {
         if (Time::Clock::getTimeMultiplier() != 1.0)
@@ -143,6 +147,9 @@ namespace DUNE
     Condition::broadcast(void)
     {
 #if defined(DUNE_SYS_HAS_PTHREAD_COND)
+      if (Time::VirtualClock::isEnabled())
+        Time::VirtualClock::signal(&m_waiters, true);
+
       int rv = pthread_cond_broadcast(&m_cond);
 
       if (rv != 0)
@@ -154,6 +161,9 @@ namespace DUNE
     Condition::signal(void)
     {
 #if defined(DUNE_SYS_HAS_PTHREAD_COND)
+      if (Time::VirtualClock::isEnabled())
+        Time::VirtualClock::signal(&m_waiters, false);
+
       int rv = pthread_cond_signal(&m_cond);
 
       if (rv != 0)
@@ -33,6 +33,7 @@
 // DUNE headers.
 #include <DUNE/Config.hpp>
 #include <DUNE/Concurrency/Initializer.hpp>
+#include <DUNE/Time/VirtualClock.hpp>
 
 // POSIX headers.
 #if defined(DUNE_SYS_HAS_PTHREAD_H)
@@ -78,6 +79,8 @@ namespace DUNE
       pthread_mutex_t m_mutex;
       bool m_clock_monotonic;
 #endif
+      //! Waiters when using logical time.
+      Time::VirtualClock::Waiter* m_waiters;
 
       // Non - copyable.
       Condition(Condition const&);
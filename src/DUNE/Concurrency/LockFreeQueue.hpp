@@ -0,0 +1,218 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+#ifndef DUNE_CONCURRENCY_LOCK_FREE_QUEUE_HPP_INCLUDED_
+#define DUNE_CONCURRENCY_LOCK_FREE_QUEUE_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <cstddef>
+
+// ISO C++ 11 headers.
+#include <atomic>
+
+// DUNE headers.
+#include <DUNE/Config.hpp>
+
+namespace DUNE
+{
+  namespace Concurrency
+  {
+    //! Bounded lock-free FIFO supporting multiple producers and
+    //! multiple consumers. Elements are stored in a ring buffer whose
+    //! cells carry a sequence number that tells producers and
+    //! consumers whether the cell is free or holds data, so that
+    //! push and pop only need a single compare-and-swap on the
+    //! respective position counter. The capacity is rounded up to
+    //! the next power of two.
+    template <typename T>
+    class LockFreeQueue
+    {
+    public:
+      //! Constructor.
+      //! @param[in] capacity minimum number of elements.
+      explicit LockFreeQueue(size_t capacity)
+      {
+        size_t size = 2;
+        while (size < capacity)
+          size <<= 1;
+
+        m_mask = size - 1;
+        m_cells = new Cell[size];
+        for (size_t i = 0; i < size; ++i)
+          m_cells[i].seq.store(i, std::memory_order_relaxed);
+
+        m_push_pos.store(0, std::memory_order_relaxed);
+        m_pop_pos.store(0, std::memory_order_relaxed);
+      }
+
+      //! Destructor.
+      ~LockFreeQueue(void)
+      {
+        delete [] m_cells;
+      }
+
+      //! Add an element to the end of the queue.
+      //! @param[in] v element to insert.
+      //! @return true if the element was inserted, false if the
+      //! queue is full.
+      bool
+      tryPush(const T& v)
+      {
+        Cell* cell = NULL;
+        size_t pos = m_push_pos.load(std::memory_order_relaxed);
+
+        while (true)
+        {
+          cell = &m_cells[pos & m_mask];
+          size_t seq = cell->seq.load(std::memory_order_acquire);
+          ptrdiff_t diff = (ptrdiff_t)seq - (ptrdiff_t)pos;
+
+          if (diff == 0)
+          {
+            if (m_push_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+              break;
+          }
+          else if (diff < 0)
+          {
+            return false;
+          }
+          else
+          {
+            pos = m_push_pos.load(std::memory_order_relaxed);
+          }
+        }
+
+        cell->data = v;
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+      }
+
+      //! Remove the first element of the queue.
+      //! @param[out] v removed element.
+      //! @return true if an element was removed, false if the queue
+      //! is empty.
+      bool
+      tryPop(T& v)
+      {
+        Cell* cell = NULL;
+        size_t pos = m_pop_pos.load(std::memory_order_relaxed);
+
+        while (true)
+        {
+          cell = &m_cells[pos & m_mask];
+          size_t seq = cell->seq.load(std::memory_order_acquire);
+          ptrdiff_t diff = (ptrdiff_t)seq - (ptrdiff_t)(pos + 1);
+
+          if (diff == 0)
+          {
+            if (m_pop_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+              break;
+          }
+          else if (diff < 0)
+          {
+            return false;
+          }
+          else
+          {
+            pos = m_pop_pos.load(std::memory_order_relaxed);
+          }
+        }
+
+        v = cell->data;
+        // Release resources held by the element.
+        cell->data = T();
+        cell->seq.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+      }
+
+      //! Retrieve the number of elements in the queue. The value is
+      //! only exact when there are no concurrent operations.
+      //! @return number of elements.
+      size_t
+      size(void) const
+      {
+        size_t push = m_push_pos.load(std::memory_order_acquire);
+        size_t pop = m_pop_pos.load(std::memory_order_acquire);
+        return (push > pop) ? (push - pop) : 0;
+      }
+
+      //! Verify if the queue has elements.
+      //! @return true if the queue has no elements, false otherwise.
+      bool
+      empty(void) const
+      {
+        return size() == 0;
+      }
+
+      //! Retrieve the maximum number of elements.
+      //! @return capacity.
+      size_t
+      getCapacity(void) const
+      {
+        return m_mask + 1;
+      }
+
+    private:
+      //! Size of a cache line.
+      static const size_t c_cache_line = 64;
+
+      //! Ring buffer cell.
+      struct Cell
+      {
+        //! Sequence number.
+        std::atomic<size_t> seq;
+        //! Element.
+        T data;
+      };
+
+      //! Ring buffer.
+      Cell* m_cells;
+      //! Index mask.
+      size_t m_mask;
+      //! Padding to keep producer and consumer positions on
+      //! separate cache lines.
+      char m_pad0[c_cache_line];
+      //! Position of next push.
+      std::atomic<size_t> m_push_pos;
+      //! Padding.
+      char m_pad1[c_cache_line - sizeof(std::atomic<size_t>)];
+      //! Position of next pop.
+      std::atomic<size_t> m_pop_pos;
+
+      //! Non - copyable.
+      LockFreeQueue(const LockFreeQueue&);
+
+      //! Non - assignable.
+      LockFreeQueue&
+      operator=(const LockFreeQueue&);
+    };
+  }
+}
+
+#endif
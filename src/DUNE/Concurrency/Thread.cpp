@@ -62,6 +62,10 @@
 #  include <sys/syscall.h>
 #endif
 
+#if defined(DUNE_SYS_HAS_TIME_H)
+#  include <time.h>
+#endif
+
 #if defined(DUNE_OS_LINUX)
 //! Number of useful fields in /proc/stat.
 static const unsigned c_proc_stat_values = 8;
@@ -87,7 +91,9 @@ dune_concurrency_thread_entry_point(void* data)
 #endif
 
   td->m_start_barrier.wait();
+  DUNE::Time::VirtualClock::enter(td->m_ticket);
   td->run();
+  DUNE::Time::VirtualClock::leave();
 
 #if defined(DUNE_OS_LINUX)
   td->m_id = -1;
@@ -103,7 +109,8 @@ namespace DUNE
   namespace Concurrency
   {
     Thread::Thread(void):
-      m_start_barrier(2)
+      m_start_barrier(2),
+      m_ticket(NULL)
     {
 #if defined(DUNE_OS_LINUX)
       m_id = -1;
@@ -143,9 +150,13 @@ namespace DUNE
 #if defined(DUNE_SYS_HAS_PTHREAD)
       setStateImpl(StateStarting);
 
+      m_ticket = Time::VirtualClock::spawn();
       int rv = pthread_create(&m_handle, &m_attr, dune_concurrency_thread_entry_point, this);
       if (rv != 0)
+      {
+        Time::VirtualClock::cancel(m_ticket);
         throw ThreadError("failed to start thread", rv);
+      }
 
       m_start_barrier.wait();
 #endif
@@ -161,7 +172,9 @@ namespace DUNE
     Thread::joinImpl(void)
     {
 #if defined(DUNE_SYS_HAS_PTHREAD)
+      bool scheduled = Time::VirtualClock::suspend();
       int rv = pthread_join(m_handle, 0);
+      Time::VirtualClock::resume(scheduled);
       if (rv != 0)
         throw ThreadError("failed to join thread", rv);
 #endif
@@ -240,6 +253,29 @@ namespace DUNE
       m_state = state;
     }
 
+    double
+    Thread::getCpuTime(void)
+    {
+#if defined(DUNE_OS_LINUX)
+      if (m_id == -1)
+        return -1;
+
+      clockid_t cid;
+      if (pthread_getcpuclockid(m_handle, &cid) != 0)
+        return -1;
+
+      timespec ts;
+      if (clock_gettime(cid, &ts) != 0)
+        return -1;
+
+      return ts.tv_sec + ts.tv_nsec / 1e9;
+
+      // Not implemented.
+#else
+      return -1;
+#endif
+    }
+
     int
     Thread::getProcessorUsage(void)
     {
@@ -40,6 +40,7 @@
 #include <DUNE/Concurrency/Mutex.hpp>
 #include <DUNE/Concurrency/Scheduler.hpp>
 #include <DUNE/Concurrency/Barrier.hpp>
+#include <DUNE/Time/VirtualClock.hpp>
 
 extern "C" void*
 dune_concurrency_thread_entry_point(void*);
@@ -74,6 +75,11 @@ namespace DUNE
       int
       getProcessorUsage(void);
 
+      //! Get the CPU time consumed by the thread.
+      //! @return CPU time in seconds or -1 if not available.
+      double
+      getCpuTime(void);
+
     protected:
       void
       startImpl(void);
@@ -98,6 +104,8 @@ namespace DUNE
       //! Barrier used to return from start() when the thread
       //! actually started.
       Barrier m_start_barrier;
+      //! First turn of the thread when using logical time.
+      Time::VirtualClock::Waiter* m_ticket;
 
 #if defined(DUNE_SYS_HAS_PTHREAD)
       //! POSIX thread handle.
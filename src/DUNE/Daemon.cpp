@@ -33,10 +33,12 @@
 #include <cstddef>
 #include <limits>
 #include <queue>
+#include <vector>
 
 // DUNE headers.
 #include <DUNE/Daemon.hpp>
 #include <DUNE/Version.hpp>
+#include <DUNE/IMC/MessagePool.hpp>
 #include <DUNE/I18N.hpp>
 #include <DUNE/Tasks/Factory.hpp>
 #include <DUNE/Tasks/Manager.hpp>
@@ -131,11 +133,35 @@ namespace DUNE
       inf(DTR("execution profiles: %s"), profiles.c_str());
     }
 
+    // Logical time for as-fast-as-possible simulations.
+    bool virtual_time = false;
+    m_ctx.config.get("General", "Time - Virtual", "false", virtual_time);
+    if (virtual_time)
+    {
+      Time::Clock::setVirtual();
+      inf(DTR("using virtual time"));
+    }
+
     // CPU usage.
     m_ctx.config.get("General", "CPU Usage - Maximum", "65", m_cpu_max_usage);
     m_ctx.config.get("General", "CPU Usage - Moving Average Samples", "10", m_cpu_avg_samples);
     m_cpu_avg = new Math::MovingAverage<double>(m_cpu_avg_samples);
 
+    // Task queue state.
+    double queue_period = 0;
+    m_ctx.config.get("General", "Task Queues - Report Period", "10", queue_period);
+    m_queue_counter.setTop(queue_period);
+
+    // Periodic task timing state.
+    double timing_period = 0;
+    m_ctx.config.get("General", "Periodic Tasks - Report Period", "10", timing_period);
+    m_timing_counter.setTop(timing_period);
+
+    // Task profiles.
+    double profile_period = 0;
+    m_ctx.config.get("General", "Task Profiles - Report Period", "10", profile_period);
+    m_profile_counter.setTop(profile_period);
+
     m_tman = new DUNE::Tasks::Manager(m_ctx);
 
     bind<IMC::RestartSystem>(this);
@@ -307,6 +333,28 @@ namespace DUNE
       dispatch(sto_usage);
     }
 
+    // Report task queue states.
+    if (m_queue_counter.getTop() > 0 && m_queue_counter.overflow())
+    {
+      m_queue_counter.reset();
+      m_tman->reportQueueStates();
+    }
+
+    // Report periodic task timing states.
+    if (m_timing_counter.getTop() > 0 && m_timing_counter.overflow())
+    {
+      m_timing_counter.reset();
+      m_tman->reportTimingStates();
+    }
+
+    // Report task profiles.
+    if (m_profile_counter.getTop() > 0 && m_profile_counter.overflow())
+    {
+      m_profile_counter.reset();
+      m_tman->reportProfiles();
+      reportMessagePool();
+    }
+
     // Dispatch heartbeat.
     IMC::Heartbeat hb;
     dispatch(hb);
@@ -320,6 +368,30 @@ namespace DUNE
     dispatch(qpcs);
   }
 
+  void
+  Daemon::reportMessagePool(void)
+  {
+    std::vector<IMC::MessagePool::Statistics> stats;
+    IMC::MessagePool::getStatistics(stats);
+
+    std::ostringstream os;
+    os << "[";
+    for (size_t i = 0; i < stats.size(); ++i)
+    {
+      if (i > 0)
+        os << ", ";
+      os << "{\"size\": " << stats[i].size
+         << ", \"allocations\": " << stats[i].allocations
+         << ", \"reuses\": " << stats[i].reuses
+         << ", \"in_use\": " << stats[i].in_use
+         << ", \"cached\": " << stats[i].cached
+         << "}";
+    }
+    os << "]";
+
+    m_ctx.report.set(getName(), "message_pool", os.str());
+  }
+
   void
   Daemon::onMain(void)
   {
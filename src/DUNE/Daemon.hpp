@@ -98,6 +98,12 @@ namespace DUNE
     uint64_t m_fs_capacity;
     //! Periodic counter.
     Time::Counter<double> m_periodic_counter;
+    //! Task queue state report counter.
+    Time::Counter<double> m_queue_counter;
+    //! Periodic task timing state report counter.
+    Time::Counter<double> m_timing_counter;
+    //! Task profile report counter.
+    Time::Counter<double> m_profile_counter;
     //! Save configuration file name.
     std::string m_scfg_file;
     //! Saved configuration parameters.
@@ -116,6 +122,10 @@ namespace DUNE
 
     void
     dispatchPeriodic(void);
+
+    //! Publish the usage of the message pool in the task report.
+    void
+    reportMessagePool(void);
   };
 }
 
@@ -0,0 +1,155 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <fstream>
+
+// DUNE headers.
+#include <DUNE/Config.hpp>
+#include <DUNE/FileSystem/MappedFile.hpp>
+#include <DUNE/FileSystem/Exceptions.hpp>
+
+// POSIX headers.
+#if defined(DUNE_SYS_HAS_SYS_TYPES_H)
+#  include <sys/types.h>
+#endif
+
+#if defined(DUNE_SYS_HAS_SYS_STAT_H)
+#  include <sys/stat.h>
+#endif
+
+#if defined(DUNE_SYS_HAS_FCNTL_H)
+#  include <fcntl.h>
+#endif
+
+#if defined(DUNE_SYS_HAS_UNISTD_H)
+#  include <unistd.h>
+#endif
+
+#if defined(DUNE_SYS_HAS_SYS_MMAN_H)
+#  include <sys/mman.h>
+#endif
+
+namespace DUNE
+{
+  namespace FileSystem
+  {
+    MappedFile::MappedFile(void):
+      m_data(NULL),
+      m_size(0),
+      m_mapped(false)
+    { }
+
+    MappedFile::MappedFile(const std::string& path):
+      m_data(NULL),
+      m_size(0),
+      m_mapped(false)
+    {
+      open(path);
+    }
+
+    MappedFile::~MappedFile(void)
+    {
+      close();
+    }
+
+    void
+    MappedFile::open(const std::string& path)
+    {
+      close();
+
+#if defined(DUNE_SYS_HAS_MMAP)
+      int fd = ::open(path.c_str(), O_RDONLY);
+      if (fd == -1)
+        throw FileReadError(path);
+
+      struct stat st;
+      if (fstat(fd, &st) != 0)
+      {
+        ::close(fd);
+        throw FileReadError(path);
+      }
+
+      m_size = st.st_size;
+      if (m_size > 0)
+      {
+        void* addr = mmap(NULL, m_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED)
+        {
+          m_size = 0;
+          ::close(fd);
+          throw FileReadError(path);
+        }
+
+#  if defined(MADV_SEQUENTIAL)
+        madvise(addr, m_size, MADV_SEQUENTIAL);
+#  endif
+
+        m_data = static_cast<const uint8_t*>(addr);
+        m_mapped = true;
+      }
+
+      // The mapping remains valid after the descriptor is closed.
+      ::close(fd);
+#else
+      std::ifstream ifs(path.c_str(), std::ios::binary);
+      if (!ifs.is_open())
+        throw FileReadError(path, "unable to open");
+
+      ifs.seekg(0, std::ios::end);
+      m_buffer.resize(ifs.tellg());
+      ifs.seekg(0, std::ios::beg);
+
+      if (!m_buffer.empty())
+      {
+        ifs.read(reinterpret_cast<char*>(&m_buffer[0]), m_buffer.size());
+        if ((size_t)ifs.gcount() != m_buffer.size())
+          throw FileReadError(path, "short read");
+        m_data = &m_buffer[0];
+      }
+
+      m_size = m_buffer.size();
+#endif
+    }
+
+    void
+    MappedFile::close(void)
+    {
+#if defined(DUNE_SYS_HAS_MMAP)
+      if (m_mapped)
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+
+      m_data = NULL;
+      m_size = 0;
+      m_mapped = false;
+      std::vector<uint8_t>().swap(m_buffer);
+    }
+  }
+}
@@ -24,94 +24,87 @@
 // https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
 // http://ec.europa.eu/idabc/eupl.html.                                     *
 //***************************************************************************
-// Author: Eduardo Marques                                                  *
+// Author: Eivind Jølsgard                                                 *
 //***************************************************************************
 
-#ifndef SIMULATORS_ENVIRONMENT_QUAD_TREE_HPP_INCLUDED_
-#define SIMULATORS_ENVIRONMENT_QUAD_TREE_HPP_INCLUDED_
+#ifndef DUNE_FILE_SYSTEM_MAPPED_FILE_HPP_INCLUDED_
+#define DUNE_FILE_SYSTEM_MAPPED_FILE_HPP_INCLUDED_
 
 // ISO C++ 98 headers.
-#include <iomanip>
-#include <iostream>
+#include <cstddef>
+#include <string>
 #include <vector>
 
 // DUNE headers.
 #include <DUNE/Config.hpp>
 
-// Local headers.
-#include "Point.hpp"
-#include "Bounds.hpp"
-
-namespace Simulators
+namespace DUNE
 {
-  namespace Environment
+  namespace FileSystem
   {
-    //! Forward declaration.
-    struct Node;
-
-    //! "Quad-tree" structure used to index spatial data in two dimensions.
-    class QuadTree
+    // Export DLL Symbol.
+    class DUNE_DLL_SYM MappedFile;
+
+    //! Read-only view of the contents of a file. The file is mapped
+    //! in memory when the system supports it, and read into a buffer
+    //! otherwise. The view reflects the size of the file at the time
+    //! it was opened.
+    class MappedFile
     {
     public:
-      //! Item datum.
-      struct Item
-      {
-        double x, y, value;
-      };
-
-      //! Iteration handle.
-      class Iteration
-      {
-      public:
-        virtual void
-        process(const Item& item) = 0;
-
-        virtual
-        ~Iteration(){ }
-      };
-
       //! Constructor.
-      QuadTree(const Bounds& bounds);
-
-      ~QuadTree();
+      MappedFile(void);
 
-      //! Insert an item.
-      //! Returns 'false' if item is out-of-bounds.
-      bool
-      insert(const Item& item);
-
-      //! Iterate tree.
-      void
-      iterate(Iteration& iteration) const;
+      //! Constructor.
+      //! @param path file path.
+      MappedFile(const std::string& path);
 
-      //! Iterate tree over a given area.
-      void
-      iterate(Iteration& iteration, const Bounds& area) const;
+      //! Destructor.
+      ~MappedFile(void);
 
-      //! Clear entire tree.
+      //! Map a file, releasing the previous one.
+      //! @param path file path.
+      //! @throw FileReadError if the file cannot be mapped.
       void
-      clear(void);
+      open(const std::string& path);
 
-      //! Remove items in a given area.
+      //! Release the mapped file.
       void
-      remove(const Bounds& area);
+      close(void);
 
-      //! Search for items in a given area.
-      //! If any are found returns 'true' and adds results to 'item' vector.
-      bool
-      search(const Bounds& area, std::vector<Item>& items) const;
+      //! Retrieve contents of the file.
+      //! @return pointer to first byte or NULL if empty.
+      const uint8_t*
+      getData(void) const
+      {
+        return m_data;
+      }
 
-      //! Get number of elements in a given area.
-      uint32_t
-      size(const Bounds& area) const;
+      //! Retrieve size of the file.
+      //! @return number of bytes.
+      size_t
+      getSize(void) const
+      {
+        return m_size;
+      }
 
     private:
-      Bounds m_bounds;     //!< Bounds.
-      Node* m_root;     //!< Node handle providing actual implementation.
+      //! First byte of the contents.
+      const uint8_t* m_data;
+      //! Number of bytes.
+      size_t m_size;
+      //! True if m_data is a memory mapping.
+      bool m_mapped;
+      //! Contents when memory mapping is not available.
+      std::vector<uint8_t> m_buffer;
+
+      //! Non-copyable.
+      MappedFile(const MappedFile&);
+
+      //! Non-assignable.
+      MappedFile&
+      operator=(const MappedFile&);
     };
-
-    std::ostream&
-    operator<<(std::ostream& os, const QuadTree& tree);
   }
 }
 
@@ -29,6 +29,7 @@
 
 // ISO C++ 98 headers.
 #include <algorithm>
+#include <cstring>
 
 // DUNE headers.
 #include <DUNE/Streams/Terminal.hpp>
@@ -37,32 +38,43 @@
 #include <DUNE/IMC/Bus.hpp>
 #include <DUNE/IMC/Message.hpp>
 #include <DUNE/IMC/Definitions.hpp>
+#include <DUNE/Time/Clock.hpp>
+#include <DUNE/Time/Delay.hpp>
 
 namespace DUNE
 {
   namespace IMC
   {
+    //! Time between checks while waiting for a grace period (us).
+    static const uint64_t c_grace_wait_usec = 50;
+    //! Time between offers to recipients with full queues (us).
+    static const uint64_t c_retry_wait_usec = 1000;
+    //! Maximum time a dispatch waits for room in full queues (s).
+    static const double c_block_timeout = 0.1;
+
     struct BackLogEntry
     {
-      BackLogEntry(const Message* msg, Tasks::AbstractTask* exc):
-        message(msg->clone()),
+      BackLogEntry(const SharedMessage& msg, Tasks::AbstractTask* exc):
+        message(msg),
         exclude(exc)
       {  }
 
-      ~BackLogEntry(void)
-      {
-        delete message;
-      }
-
       //! Message.
-      Message* message;
+      SharedMessage message;
       //! Exclude this task.
       Tasks::AbstractTask* exclude;
     };
 
-    Bus::Bus(void):
-      m_paused(false)
-    { }
+    Bus::Bus(void)
+    {
+      m_paused.store(false);
+      Table* table = new Table;
+      std::memset(table->pages, 0, sizeof(table->pages));
+      m_table.store(table);
+      m_epoch.store(0);
+      m_readers[0].store(0);
+      m_readers[1].store(0);
+    }
 
     Bus::~Bus(void)
     {
@@ -75,50 +87,239 @@ namespace DUNE
 
       for (unsigned i = 0; i < m_bind_msgs.size(); ++i)
         delete m_bind_msgs[i];
+
+      const Table* table = m_table.load();
+      for (unsigned i = 0; i < c_page_count; ++i)
+      {
+        const Page* page = table->pages[i];
+        if (page == NULL)
+          continue;
+
+        for (unsigned j = 0; j < c_page_size; ++j)
+          delete page->lists[j];
+        delete page;
+      }
+      delete table;
+    }
+
+    unsigned
+    Bus::enter(void)
+    {
+      while (true)
+      {
+        unsigned epoch = m_epoch.load();
+        unsigned parity = epoch & 1;
+        m_readers[parity].fetch_add(1);
+
+        // The epoch did not change: the writer will wait for us.
+        if (m_epoch.load() == epoch)
+          return parity;
+
+        m_readers[parity].fetch_sub(1, std::memory_order_release);
+      }
+    }
+
+    void
+    Bus::synchronize(void)
+    {
+      unsigned parity = m_epoch.fetch_add(1) & 1;
+
+      while (m_readers[parity].load(std::memory_order_acquire) != 0)
+        Time::Delay::waitUsec(c_grace_wait_usec);
+    }
+
+    void
+    Bus::update(uint16_t id, const RecipientList* list)
+    {
+      const Table* old_table = m_table.load();
+      const Page* old_page = old_table->pages[id / c_page_size];
+      const RecipientList* old_list = lookup(old_table, id);
+
+      Page* page = new Page;
+      if (old_page == NULL)
+        std::memset(page->lists, 0, sizeof(page->lists));
+      else
+        std::memcpy(page->lists, old_page->lists, sizeof(page->lists));
+      page->lists[id % c_page_size] = list;
+
+      Table* table = new Table;
+      std::memcpy(table->pages, old_table->pages, sizeof(table->pages));
+      table->pages[id / c_page_size] = page;
+
+      m_table.store(table);
+      synchronize();
+
+      delete old_list;
+      delete old_page;
+      delete old_table;
     }
 
     void
     Bus::registerRecipient(Tasks::AbstractTask* task, uint16_t id)
     {
+      Concurrency::ScopedMutex l(m_lock);
+
+      const RecipientList* old_list = lookup(m_table.load(), id);
+      RecipientList* list = NULL;
+      if (old_list == NULL)
+      {
+        list = new RecipientList;
+      }
+      else
+      {
+        if (std::find(old_list->begin(), old_list->end(), task) != old_list->end())
+          return;
+        list = new RecipientList(*old_list);
+      }
+
       TransportBindings* bind = new TransportBindings;
       bind->setSourceEntity(DUNE_IMC_CONST_SYS_EID);
       bind->setTimeStamp();
       bind->consumer = task->getName();
       bind->message_id = id;
-
-      Concurrency::ScopedRWLock l(m_lock, true);
       m_bind_msgs.push_back(bind);
-      TransportList::iterator itr = std::find(m_recipients[id].begin(), m_recipients[id].end(), task);
-      if (itr == m_recipients[id].end())
-        m_recipients[id].push_back(task);
+
+      list->push_back(task);
+      update(id, list);
     }
 
     void
     Bus::unregisterRecipient(Tasks::AbstractTask* task, uint16_t id)
     {
-      Concurrency::ScopedRWLock l(m_lock, true);
-      m_recipients[id].remove(task);
+      Concurrency::ScopedMutex l(m_lock);
+
+      const RecipientList* old_list = lookup(m_table.load(), id);
+      if (old_list == NULL)
+        return;
+
+      if (std::find(old_list->begin(), old_list->end(), task) == old_list->end())
+        return;
+
+      RecipientList* list = new RecipientList(*old_list);
+      list->erase(std::remove(list->begin(), list->end(), task), list->end());
+      if (list->empty())
+      {
+        delete list;
+        list = NULL;
+      }
+
+      update(id, list);
     }
 
-    void
+    size_t
     Bus::dispatch(const Message* msg, Tasks::AbstractTask* task)
     {
+      if (m_paused.load(std::memory_order_acquire))
+      {
+        Concurrency::ScopedMutex lock(m_paused_lock);
+        if (m_paused.load(std::memory_order_relaxed))
+        {
+          m_back_log.push(new BackLogEntry(SharedMessage::copy(msg), task));
+          return 0;
+        }
+      }
+
+      size_t count = 0;
+      RecipientList blocked;
+      // Copy lazily, so that messages without recipients are never
+      // copied.
+      SharedMessage shared;
+      unsigned parity = enter();
+      const RecipientList* list = lookup(m_table.load(std::memory_order_acquire), msg->getId());
+      if (list != NULL)
+      {
+        for (size_t i = 0; i < list->size(); ++i)
+        {
+          Tasks::AbstractTask* recipient = (*list)[i];
+          if (recipient == task)
+            continue;
+
+          if (shared.isNull())
+            shared = SharedMessage::copy(msg);
+
+          if (!recipient->tryReceive(shared, false))
+            blocked.push_back(recipient);
+          ++count;
+        }
+      }
+      leave(parity);
+
+      if (!blocked.empty())
+        retry(shared, blocked);
+
+      return count;
+    }
+
+    size_t
+    Bus::dispatch(const SharedMessage& msg, Tasks::AbstractTask* task)
+    {
+      if (m_paused.load(std::memory_order_acquire))
       {
         Concurrency::ScopedMutex lock(m_paused_lock);
-        if (m_paused)
+        if (m_paused.load(std::memory_order_relaxed))
         {
           m_back_log.push(new BackLogEntry(msg, task));
-          return;
+          return 0;
+        }
+      }
+
+      return deliver(msg, task);
+    }
+
+    size_t
+    Bus::deliver(const SharedMessage& msg, Tasks::AbstractTask* task)
+    {
+      size_t count = 0;
+      RecipientList blocked;
+      unsigned parity = enter();
+      const RecipientList* list = lookup(m_table.load(std::memory_order_acquire), msg->getId());
+      if (list != NULL)
+      {
+        for (size_t i = 0; i < list->size(); ++i)
+        {
+          if ((*list)[i] != task)
+          {
+            if (!(*list)[i]->tryReceive(msg, false))
+              blocked.push_back((*list)[i]);
+            ++count;
+          }
         }
       }
+      leave(parity);
+
+      if (!blocked.empty())
+        retry(msg, blocked);
 
-      uint16_t id = msg->getId();
-      Concurrency::ScopedRWLock l(m_lock);
-      TransportList& dlst(m_recipients[id]);
-      for (TransportList::iterator itr = dlst.begin(); itr != dlst.end(); ++itr)
+      return count;
+    }
+
+    void
+    Bus::retry(const SharedMessage& msg, RecipientList& blocked)
+    {
+      double deadline = Time::Clock::get() + c_block_timeout;
+
+      while (!blocked.empty())
       {
-        if (*itr != task)
-          (*itr)->receive(msg);
+        // Wait outside the read section: a blocked recipient must
+        // not stall subscription changes.
+        Time::Delay::waitUsec(c_retry_wait_usec);
+        bool expired = Time::Clock::get() >= deadline;
+
+        size_t n = 0;
+        unsigned parity = enter();
+        const RecipientList* list = lookup(m_table.load(std::memory_order_acquire), msg->getId());
+        for (size_t i = 0; i < blocked.size(); ++i)
+        {
+          // Recipients that unregistered may no longer exist.
+          if (list == NULL || std::find(list->begin(), list->end(), blocked[i]) == list->end())
+            continue;
+
+          if (!blocked[i]->tryReceive(msg, expired))
+            blocked[n++] = blocked[i];
+        }
+        leave(parity);
+
+        blocked.resize(n);
       }
     }
 
@@ -126,7 +327,7 @@ namespace DUNE
     Bus::resume(void)
     {
       m_paused_lock.lock();
-      m_paused = false;
+      m_paused.store(false, std::memory_order_release);
       m_paused_lock.unlock();
 
       while (!m_back_log.empty())
@@ -134,7 +335,7 @@ namespace DUNE
         BackLogEntry* entry = m_back_log.pop();
         if (entry != NULL)
         {
-          dispatch(entry->message, entry->exclude);
+          deliver(entry->message, entry->exclude);
           delete entry;
         }
       }
@@ -143,7 +344,7 @@ namespace DUNE
     const std::vector<TransportBindings*>
     Bus::getBindings(void)
     {
-      Concurrency::ScopedRWLock l(m_lock);
+      Concurrency::ScopedMutex l(m_lock);
       return m_bind_msgs;
     }
   }
@@ -32,18 +32,19 @@
 
 // ISO C++ 98 headers.
 #include <cstddef>
-#include <map>
-#include <list>
 #include <string>
 #include <utility>
 #include <vector>
 #include <queue>
 
+// ISO C++ 11 headers.
+#include <atomic>
+
 // DUNE headers.
 #include <DUNE/Tasks/AbstractTask.hpp>
+#include <DUNE/IMC/SharedMessage.hpp>
 #include <DUNE/Concurrency/TSQueue.hpp>
 #include <DUNE/Concurrency/ScopedMutex.hpp>
-#include <DUNE/Concurrency/ScopedRWLock.hpp>
 
 namespace DUNE
 {
@@ -56,6 +57,16 @@ namespace DUNE
     // Export DLL Symbol.
     class DUNE_DLL_SYM Bus;
 
+    //! The message bus keeps, for each message identification
+    //! number, a contiguous array of recipients. The table of
+    //! recipients is immutable once published: subscription changes
+    //! build a new table and swap it in (read-copy-update), so that
+    //! dispatching never takes a lock. Retired tables are released
+    //! after all dispatches that might be using them have finished.
+    //! Recipients whose queues are full and that block their
+    //! producers are offered the message again after the dispatch
+    //! left the table, so that subscription changes never wait for
+    //! a blocked producer.
     class Bus
     {
     public:
@@ -79,17 +90,27 @@ namespace DUNE
       void
       unregisterRecipient(Tasks::AbstractTask* task, uint16_t id);
 
-      //! Dispatches a message to registered listeners.
+      //! Dispatches a message to registered listeners. The message
+      //! is copied once and the copy is shared by all recipients.
       //! @param msg message to dispatch.
       //! @param task do not deliver message to this task.
-      void
+      //! @return number of recipients (zero if the bus is paused).
+      size_t
       dispatch(const Message* msg, Tasks::AbstractTask* task = NULL);
 
+      //! Dispatches a shared message to registered listeners without
+      //! copying it.
+      //! @param msg message to dispatch.
+      //! @param task do not deliver message to this task.
+      //! @return number of recipients (zero if the bus is paused).
+      size_t
+      dispatch(const SharedMessage& msg, Tasks::AbstractTask* task = NULL);
+
       inline void
       pause(void)
       {
         Concurrency::ScopedMutex lock(m_paused_lock);
-        m_paused = true;
+        m_paused.store(true, std::memory_order_release);
       }
 
       void
@@ -99,20 +120,99 @@ namespace DUNE
       getBindings(void);
 
     private:
-      typedef std::list<Tasks::AbstractTask*> TransportList;
-      //! Table of recipients.
-      std::map<uint16_t, TransportList> m_recipients;
-      //! Internal list lock.
-      Concurrency::RWLock m_lock;
-      //! Bus is paused.
-      bool m_paused;
-      //! Pause lock.
+      //! Number of message identifiers per table page.
+      static const unsigned c_page_size = 256;
+      //! Number of table pages (covers all 16-bit identifiers).
+      static const unsigned c_page_count = 65536 / c_page_size;
+
+      //! Recipients of a message identifier.
+      typedef std::vector<Tasks::AbstractTask*> RecipientList;
+
+      //! Table page, indexed by the low byte of the identifier.
+      struct Page
+      {
+        const RecipientList* lists[c_page_size];
+      };
+
+      //! Table of recipients, indexed by the high byte of the
+      //! identifier. Pages and lists are shared between consecutive
+      //! tables when they are not modified.
+      struct Table
+      {
+        const Page* pages[c_page_count];
+      };
+
+      //! Published table of recipients.
+      std::atomic<const Table*> m_table;
+      //! Current grace period.
+      std::atomic<unsigned> m_epoch;
+      //! Number of dispatches running in each grace period parity.
+      std::atomic<unsigned> m_readers[2];
+      //! Serializes table updates and bindings list.
+      Concurrency::Mutex m_lock;
+      //! Bus is paused. Checked without locking when dispatching.
+      std::atomic<bool> m_paused;
+      //! Serializes pausing, resuming and the back log.
       Concurrency::Mutex m_paused_lock;
       //! List containing all generated TransportBindings for future logging/reference.
       std::vector<TransportBindings*> m_bind_msgs;
       //! Back log queue. Saves messages when Bus is paused.
       Concurrency::TSQueue<BackLogEntry*> m_back_log;
 
+      //! Retrieve recipients of a given message identifier.
+      //! @param table table of recipients.
+      //! @param id message identification number.
+      //! @return list of recipients or NULL.
+      static const RecipientList*
+      lookup(const Table* table, uint16_t id)
+      {
+        const Page* page = table->pages[id / c_page_size];
+        if (page == NULL)
+          return NULL;
+        return page->lists[id % c_page_size];
+      }
+
+      //! Publish a new list of recipients of a given message
+      //! identifier and release the replaced objects once no
+      //! dispatch can be using them. Must be called with m_lock held.
+      //! @param id message identification number.
+      //! @param list new list of recipients (NULL if empty).
+      void
+      update(uint16_t id, const RecipientList* list);
+
+      //! Mark the beginning of a dispatch.
+      //! @return grace period parity to be passed to leave().
+      unsigned
+      enter(void);
+
+      //! Mark the end of a dispatch.
+      //! @param parity grace period parity returned by enter().
+      void
+      leave(unsigned parity)
+      {
+        m_readers[parity].fetch_sub(1, std::memory_order_release);
+      }
+
+      //! Wait until all dispatches that started before this call
+      //! have finished.
+      void
+      synchronize(void);
+
+      //! Offer a message to recipients whose queues were full until
+      //! it fits or the blocking timeout expires. Recipients that
+      //! unregistered in the meantime are skipped.
+      //! @param msg message.
+      //! @param blocked recipients still waiting for the message.
+      void
+      retry(const SharedMessage& msg, RecipientList& blocked);
+
+      //! Deliver a message to the recipients of its identifier.
+      //! @param msg message to dispatch.
+      //! @param task do not deliver message to this task.
+      //! @return number of recipients.
+      size_t
+      deliver(const SharedMessage& msg, Tasks::AbstractTask* task);
+
       //! Non - copyable.
       Bus(Bus const&);
 
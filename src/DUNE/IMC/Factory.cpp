@@ -69,22 +69,47 @@ namespace DUNE
 #include <DUNE/IMC/Factory.def>
     };
 
-    static std::pair<int, Creator> creator_pairs_id[] =
+    static const std::pair<uint16_t, Creator> creator_pairs_id[] =
     {
 #define MESSAGE(id, abbrev)                                     \
-      std::pair<int, Creator>(id, &create<abbrev>),
+      std::pair<uint16_t, Creator>(id, &create<abbrev>),
 #include <DUNE/IMC/Factory.def>
     };
 
-    DUNE_DECLARE_STATIC_MAP(creators_by_id, int, Creator, creator_pairs_id);
+    //! Creators indexed by message identification number.
+    struct CreatorTable
+    {
+      Creator creators[65536];
+
+      CreatorTable(void)
+      {
+        for (size_t i = 0; i < 65536; ++i)
+          creators[i] = NULL;
+
+        for (size_t i = 0; i < sizeof(creator_pairs_id) / sizeof(creator_pairs_id[0]); ++i)
+          creators[creator_pairs_id[i].first] = creator_pairs_id[i].second;
+      }
+    };
+
+    //! Retrieve the table of creators.
+    static const CreatorTable&
+    getCreators(void)
+    {
+      static const CreatorTable table;
+      return table;
+    }
     DUNE_DECLARE_STATIC_MAP(map_id_abbrev, uint32_t, std::string, pairs_id_abbrev);
     DUNE_DECLARE_STATIC_MAP(map_abbrev_id, std::string, uint32_t, pairs_abbrev_id);
 
     Message*
     Factory::produce(uint32_t id)
     {
-      if (creators_by_id[id])
-        return creators_by_id[id]();
+      if (id < 65536)
+      {
+        Creator creator = getCreators().creators[id];
+        if (creator != NULL)
+          return creator();
+      }
 
       DUNE_DBG("IMC Message Factory", "unknown message " << id);
       return 0;
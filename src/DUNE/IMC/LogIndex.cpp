@@ -0,0 +1,257 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <cstdio>
+#include <cstring>
+
+// DUNE headers.
+#include <DUNE/IMC/LogIndex.hpp>
+#include <DUNE/IMC/Constants.hpp>
+#include <DUNE/IMC/Packet.hpp>
+#include <DUNE/Algorithms/CRC16.hpp>
+#include <DUNE/FileSystem/Exceptions.hpp>
+#include <DUNE/Utils/ByteCopy.hpp>
+
+namespace DUNE
+{
+  namespace IMC
+  {
+    //! Index file identification ("LSFI" in little-endian hosts).
+    static const uint32_t c_magic = 0x4946534c;
+    //! Index file format version.
+    static const uint16_t c_version = 2;
+
+    LogIndex::LogIndex(void)
+    {
+      std::memset(&m_block, 0, sizeof(m_block));
+    }
+
+    LogIndex::~LogIndex(void)
+    {
+      close();
+    }
+
+    std::string
+    LogIndex::getPath(const std::string& lsf)
+    {
+      return lsf + ".idx";
+    }
+
+    void
+    LogIndex::open(const std::string& path)
+    {
+      close();
+
+      m_ofs.open(path.c_str(), std::ios::binary | std::ios::trunc);
+      if (!m_ofs.is_open())
+        throw FileSystem::FileWriteError(path);
+
+      writeHeader(m_ofs);
+    }
+
+    void
+    LogIndex::close(void)
+    {
+      if (!m_ofs.is_open())
+        return;
+
+      if (m_block.count > 0)
+        m_ofs.write(reinterpret_cast<const char*>(&m_block), sizeof(m_block));
+
+      m_ofs.close();
+      std::memset(&m_block, 0, sizeof(m_block));
+    }
+
+    bool
+    LogIndex::add(const uint8_t* packet, size_t size, uint64_t offset)
+    {
+      Entry entry;
+      if (!parse(packet, size, offset, entry))
+        return false;
+
+      append(m_block, entry);
+      if (m_block.count == c_block_packets)
+      {
+        m_ofs.write(reinterpret_cast<const char*>(&m_block), sizeof(m_block));
+        std::memset(&m_block, 0, sizeof(m_block));
+      }
+
+      return true;
+    }
+
+    void
+    LogIndex::flush(void)
+    {
+      if (m_ofs.is_open())
+        m_ofs.flush();
+    }
+
+    void
+    LogIndex::write(const std::string& path, const Block* blocks, size_t count)
+    {
+      // Readers must never see a partially written index.
+      std::string tmp = path + ".tmp";
+
+      {
+        std::ofstream ofs(tmp.c_str(), std::ios::binary | std::ios::trunc);
+        if (!ofs.is_open())
+          throw FileSystem::FileWriteError(tmp);
+
+        writeHeader(ofs);
+        if (count > 0)
+          ofs.write(reinterpret_cast<const char*>(blocks), count * sizeof(Block));
+
+        ofs.close();
+        if (ofs.fail())
+        {
+          std::remove(tmp.c_str());
+          throw FileSystem::FileWriteError(tmp, "short write");
+        }
+      }
+
+      if (std::rename(tmp.c_str(), path.c_str()) != 0)
+      {
+        std::remove(tmp.c_str());
+        throw FileSystem::FileWriteError(path);
+      }
+    }
+
+    bool
+    LogIndex::check(const uint8_t* data, size_t size)
+    {
+      if (data == NULL || size < c_header_size)
+        return false;
+
+      uint32_t magic;
+      uint16_t version;
+      uint16_t entry_size;
+      uint16_t block_packets;
+      std::memcpy(&magic, data, sizeof(magic));
+      std::memcpy(&version, data + 4, sizeof(version));
+      std::memcpy(&entry_size, data + 6, sizeof(entry_size));
+      std::memcpy(&block_packets, data + 8, sizeof(block_packets));
+
+      return magic == c_magic && version == c_version && entry_size == sizeof(Block)
+      && block_packets == c_block_packets;
+    }
+
+    size_t
+    LogIndex::scan(const uint8_t* data, size_t size, size_t pos, std::vector<Block>& blocks)
+    {
+      while (pos < size)
+      {
+        Entry entry;
+        if (!parse(data + pos, size - pos, pos, entry) || !verify(data + pos, entry))
+          break;
+
+        if (blocks.empty() || blocks.back().count == c_block_packets)
+        {
+          Block block;
+          std::memset(&block, 0, sizeof(block));
+          blocks.push_back(block);
+        }
+
+        append(blocks.back(), entry);
+        pos += getPacketSize(entry);
+      }
+
+      return pos;
+    }
+
+    bool
+    LogIndex::parse(const uint8_t* data, size_t size, uint64_t offset, Entry& entry)
+    {
+      if (size < DUNE_IMC_CONST_HEADER_SIZE)
+        return false;
+
+      uint16_t sync;
+      std::memcpy(&sync, data, sizeof(sync));
+      if (sync != DUNE_IMC_CONST_SYNC && sync != DUNE_IMC_CONST_SYNC_REV)
+        return false;
+
+      Header hdr;
+      Packet::deserializeHeader(hdr, data, DUNE_IMC_CONST_HEADER_SIZE);
+      if (c_packet_overhead + hdr.size > size)
+        return false;
+
+      entry.time = hdr.timestamp;
+      entry.offset = offset;
+      entry.id = hdr.mgid;
+      entry.size = hdr.size;
+      entry.src_ent = hdr.src_ent;
+      return true;
+    }
+
+    void
+    LogIndex::append(Block& block, const Entry& entry)
+    {
+      if (block.count == 0)
+      {
+        block.offset = entry.offset;
+        block.time_max = entry.time;
+      }
+      else if (entry.time > block.time_max)
+      {
+        block.time_max = entry.time;
+      }
+
+      block.size += getPacketSize(entry);
+      ++block.count;
+    }
+
+    bool
+    LogIndex::verify(const uint8_t* data, const Entry& entry)
+    {
+      uint16_t sync;
+      std::memcpy(&sync, data, sizeof(sync));
+
+      uint16_t rcrc = 0;
+      if (sync == DUNE_IMC_CONST_SYNC_REV)
+        Utils::ByteCopy::rcopy(rcrc, data + DUNE_IMC_CONST_HEADER_SIZE + entry.size);
+      else
+        Utils::ByteCopy::copy(rcrc, data + DUNE_IMC_CONST_HEADER_SIZE + entry.size);
+
+      return Algorithms::CRC16::compute(data, DUNE_IMC_CONST_HEADER_SIZE + entry.size) == rcrc;
+    }
+
+    void
+    LogIndex::writeHeader(std::ostream& os)
+    {
+      uint8_t header[c_header_size] = {0};
+      uint16_t entry_size = sizeof(Block);
+      uint16_t block_packets = c_block_packets;
+      std::memcpy(header, &c_magic, sizeof(c_magic));
+      std::memcpy(header + 4, &c_version, sizeof(c_version));
+      std::memcpy(header + 6, &entry_size, sizeof(entry_size));
+      std::memcpy(header + 8, &block_packets, sizeof(block_packets));
+      os.write(reinterpret_cast<const char*>(header), sizeof(header));
+    }
+  }
+}
@@ -0,0 +1,211 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+#ifndef DUNE_IMC_LOG_INDEX_HPP_INCLUDED_
+#define DUNE_IMC_LOG_INDEX_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/Config.hpp>
+#include <DUNE/IMC/Header.hpp>
+
+namespace DUNE
+{
+  namespace IMC
+  {
+    // Export DLL Symbol.
+    class DUNE_DLL_SYM LogIndex;
+
+    //! Index of the packets of an LSF file. The index is stored next
+    //! to the LSF file (see getPath()) as a small header followed by
+    //! one fixed-size entry per block of c_block_packets consecutive
+    //! packets, in file order. Packets inside a block are found by
+    //! walking their headers from the start of the block. Entries are
+    //! stored in host byte order; an index written by a host with a
+    //! different byte order is rejected and rebuilt.
+    class LogIndex
+    {
+    public:
+      //! Description of a packet, read from its header.
+      struct Entry
+      {
+        //! Time stamp of the message.
+        fp64_t time;
+        //! Offset of the packet in the LSF file.
+        uint64_t offset;
+        //! Message identification number.
+        uint16_t id;
+        //! Payload size.
+        uint16_t size;
+        //! Source entity.
+        uint8_t src_ent;
+      };
+
+      //! Index entry of a block of packets.
+      struct Block
+      {
+        //! Largest time stamp of the packets in the block.
+        fp64_t time_max;
+        //! Offset of the first packet in the LSF file.
+        uint64_t offset;
+        //! Number of bytes taken by the packets.
+        uint32_t size;
+        //! Number of packets.
+        uint32_t count;
+      };
+
+      //! Size of the index header.
+      static const size_t c_header_size = 16;
+      //! Number of packets per block (all blocks but the last are
+      //! full).
+      static const size_t c_block_packets = 256;
+
+      //! Constructor.
+      LogIndex(void);
+
+      //! Destructor.
+      ~LogIndex(void);
+
+      //! Retrieve path of the index of an LSF file.
+      //! @param lsf path to LSF file.
+      //! @return path to index file.
+      static std::string
+      getPath(const std::string& lsf);
+
+      //! Create an empty index, replacing any existing one.
+      //! @param path path to index file.
+      //! @throw FileSystem::FileWriteError on failure.
+      void
+      open(const std::string& path);
+
+      //! Close the index, writing the last partial block.
+      void
+      close(void);
+
+      //! Test if the index is open.
+      //! @return true if open, false otherwise.
+      bool
+      isOpen(void) const
+      {
+        return m_ofs.is_open();
+      }
+
+      //! Add a packet to the index. Packets must be added in the
+      //! order they are written to the LSF file.
+      //! @param packet serialized packet.
+      //! @param size size of packet.
+      //! @param offset offset of the packet in the LSF file.
+      //! @return true if the packet was added, false if it is invalid.
+      bool
+      add(const uint8_t* packet, size_t size, uint64_t offset);
+
+      //! Write complete blocks to storage. Packets of the current
+      //! block are written when it is complete or the index is closed.
+      void
+      flush(void);
+
+      //! Write a complete index atomically.
+      //! @param path path to index file.
+      //! @param blocks index entries.
+      //! @param count number of entries.
+      //! @throw FileSystem::FileWriteError on failure.
+      static void
+      write(const std::string& path, const Block* blocks, size_t count);
+
+      //! Check the header of an index.
+      //! @param data contents of the index file.
+      //! @param size size of the index file.
+      //! @return true if the index can be used by this host.
+      static bool
+      check(const uint8_t* data, size_t size);
+
+      //! Index the packets of an LSF buffer. Scanning stops at the
+      //! first truncated packet or packet with an invalid CRC.
+      //! @param data LSF data.
+      //! @param size number of bytes in data.
+      //! @param pos offset where scanning starts (the end of the last
+      //! block, if any).
+      //! @param blocks vector where entries are appended or extended.
+      //! @return offset after the last valid packet.
+      static size_t
+      scan(const uint8_t* data, size_t size, size_t pos, std::vector<Block>& blocks);
+
+      //! Describe a packet from its header.
+      //! @param data serialized packet.
+      //! @param size number of bytes available.
+      //! @param offset offset of the packet in the LSF file.
+      //! @param entry packet description.
+      //! @return true if data starts with a valid header, false otherwise.
+      static bool
+      parse(const uint8_t* data, size_t size, uint64_t offset, Entry& entry);
+
+      //! Retrieve the total size of a packet.
+      //! @param entry packet description.
+      //! @return size of header, payload and footer.
+      static size_t
+      getPacketSize(const Entry& entry)
+      {
+        return c_packet_overhead + entry.size;
+      }
+
+    private:
+      //! Header and footer size.
+      static const size_t c_packet_overhead = 22;
+      //! Index output stream.
+      std::ofstream m_ofs;
+      //! Block being filled.
+      Block m_block;
+
+      //! Add a packet to a block.
+      //! @param block block.
+      //! @param entry packet description.
+      static void
+      append(Block& block, const Entry& entry);
+
+      //! Verify the CRC of a packet.
+      //! @param data serialized packet.
+      //! @param entry packet description.
+      //! @return true if the CRC matches, false otherwise.
+      static bool
+      verify(const uint8_t* data, const Entry& entry);
+
+      //! Write the index header.
+      //! @param os output stream.
+      static void
+      writeHeader(std::ostream& os);
+    };
+  }
+}
+
+#endif
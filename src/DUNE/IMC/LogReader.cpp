@@ -0,0 +1,219 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+// DUNE headers.
+#include <DUNE/IMC/LogReader.hpp>
+#include <DUNE/IMC/Constants.hpp>
+#include <DUNE/IMC/Packet.hpp>
+
+namespace DUNE
+{
+  namespace IMC
+  {
+    LogReader::LogReader(const std::string& path, bool save):
+      m_lsf(path),
+      m_count(0),
+      m_decoded(0),
+      m_rebuilt(false)
+    {
+      std::string idx_path = LogIndex::getPath(path);
+      int64_t tail = -1;
+
+      try
+      {
+        FileSystem::MappedFile idx(idx_path);
+        tail = load(idx.getData(), idx.getSize());
+      }
+      catch (...)
+      { }
+
+      if (tail != (int64_t)m_lsf.getSize())
+      {
+        bool valid = tail >= 0;
+        m_rebuilt = true;
+
+        if (!valid)
+        {
+          m_blocks.clear();
+          tail = 0;
+        }
+        else if (!m_blocks.empty() && m_blocks.back().count < LogIndex::c_block_packets)
+        {
+          // Packets after a partial block belong to it.
+          tail = m_blocks.back().offset;
+          m_blocks.pop_back();
+        }
+
+        LogIndex::scan(m_lsf.getData(), m_lsf.getSize(), tail, m_blocks);
+
+        // An incomplete index belongs to a log that is still being
+        // written and must not be replaced.
+        if (save && !valid)
+        {
+          try
+          {
+            LogIndex::write(idx_path, m_blocks.empty() ? NULL : &m_blocks[0], m_blocks.size());
+          }
+          catch (...)
+          { }
+        }
+      }
+
+      double max = 0;
+      m_block_max.reserve(m_blocks.size());
+      for (size_t i = 0; i < m_blocks.size(); ++i)
+      {
+        if (i == 0 || m_blocks[i].time_max > max)
+          max = m_blocks[i].time_max;
+
+        m_block_max.push_back(max);
+        m_count += m_blocks[i].count;
+      }
+
+      m_decoded = m_blocks.size();
+    }
+
+    int64_t
+    LogReader::load(const uint8_t* data, size_t size)
+    {
+      if (!LogIndex::check(data, size))
+        return -1;
+
+      const LogIndex::Block* blocks = reinterpret_cast<const LogIndex::Block*>(data + LogIndex::c_header_size);
+      m_blocks.assign(blocks, blocks + (size - LogIndex::c_header_size) / sizeof(LogIndex::Block));
+
+      // The index may be written ahead of the data.
+      while (!m_blocks.empty() && m_blocks.back().offset + m_blocks.back().size > m_lsf.getSize())
+        m_blocks.pop_back();
+
+      if (m_blocks.empty())
+        return 0;
+
+      for (size_t i = 0; i < m_blocks.size(); ++i)
+      {
+        bool full = m_blocks[i].count == LogIndex::c_block_packets;
+        bool last = i + 1 == m_blocks.size();
+        bool contiguous = last || m_blocks[i + 1].offset == m_blocks[i].offset + m_blocks[i].size;
+
+        if (m_blocks[i].count == 0 || !contiguous || (!full && !last))
+        {
+          m_blocks.clear();
+          return -1;
+        }
+      }
+
+      if (!isValid(m_blocks.front()) || !isValid(m_blocks.back()))
+      {
+        m_blocks.clear();
+        return -1;
+      }
+
+      const LogIndex::Block& last = m_blocks.back();
+      return last.offset + last.size;
+    }
+
+    bool
+    LogReader::isValid(const LogIndex::Block& block) const
+    {
+      LogIndex::Entry entry;
+      if (!LogIndex::parse(m_lsf.getData() + block.offset, m_lsf.getSize() - block.offset, block.offset, entry))
+        return false;
+
+      return entry.time <= block.time_max && LogIndex::getPacketSize(entry) <= block.size;
+    }
+
+    const std::vector<LogIndex::Entry>&
+    LogReader::decode(size_t block) const
+    {
+      if (block == m_decoded)
+        return m_packets;
+
+      const LogIndex::Block& b = m_blocks[block];
+      const uint8_t* data = m_lsf.getData();
+      size_t pos = b.offset;
+
+      m_packets.resize(b.count);
+      for (size_t i = 0; i < b.count; ++i)
+      {
+        if (!LogIndex::parse(data + pos, m_lsf.getSize() - pos, pos, m_packets[i]))
+        {
+          m_decoded = m_blocks.size();
+          throw std::runtime_error("corrupted LSF index block");
+        }
+
+        pos += LogIndex::getPacketSize(m_packets[i]);
+      }
+
+      m_decoded = block;
+      return m_packets;
+    }
+
+    Message*
+    LogReader::getMessage(size_t i, Message* msg) const
+    {
+      const LogIndex::Entry& entry = getEntry(i);
+      return Packet::deserialize(m_lsf.getData() + entry.offset, LogIndex::getPacketSize(entry), msg);
+    }
+
+    size_t
+    LogReader::seek(double time) const
+    {
+      // The first block whose maximum reaches the given time holds
+      // the first packet at or after it.
+      std::vector<double>::const_iterator itr = std::lower_bound(m_block_max.begin(), m_block_max.end(), time);
+      if (itr == m_block_max.end())
+        return m_count;
+
+      for (size_t i = (itr - m_block_max.begin()) * LogIndex::c_block_packets; i < m_count; ++i)
+      {
+        if (getEntry(i).time >= time)
+          return i;
+      }
+
+      return m_count;
+    }
+
+    size_t
+    LogReader::find(uint16_t id, size_t from) const
+    {
+      for (size_t i = from; i < m_count; ++i)
+      {
+        if (getEntry(i).id == id)
+          return i;
+      }
+
+      return m_count;
+    }
+  }
+}
@@ -0,0 +1,171 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+#ifndef DUNE_IMC_LOG_READER_HPP_INCLUDED_
+#define DUNE_IMC_LOG_READER_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/Config.hpp>
+#include <DUNE/FileSystem/MappedFile.hpp>
+#include <DUNE/IMC/LogIndex.hpp>
+#include <DUNE/IMC/Message.hpp>
+
+namespace DUNE
+{
+  namespace IMC
+  {
+    // Export DLL Symbol.
+    class DUNE_DLL_SYM LogReader;
+
+    //! Random access reader of uncompressed LSF files. The LSF file
+    //! is mapped in memory, so that packets can be located by time or
+    //! message type and accessed without copying. The index locates
+    //! blocks of packets; the headers of the packets in the block
+    //! last accessed are kept in memory. A missing or invalid index
+    //! is rebuilt by scanning the packets and saved for later use;
+    //! packets written after the index (e.g., a log that is still
+    //! open) are indexed in memory. Not thread-safe.
+    class LogReader
+    {
+    public:
+      //! Constructor.
+      //! @param path path to LSF file.
+      //! @param save save a rebuilt index next to the LSF file.
+      //! @throw FileSystem::FileReadError if the file cannot be read.
+      LogReader(const std::string& path, bool save = true);
+
+      //! Retrieve number of packets.
+      //! @return number of packets.
+      size_t
+      getCount(void) const
+      {
+        return m_count;
+      }
+
+      //! Retrieve the description of a packet.
+      //! @param i packet number.
+      //! @return packet description, valid until a packet of another
+      //! block is accessed.
+      const LogIndex::Entry&
+      getEntry(size_t i) const
+      {
+        return decode(i / LogIndex::c_block_packets)[i % LogIndex::c_block_packets];
+      }
+
+      //! Retrieve a serialized packet.
+      //! @param i packet number.
+      //! @return pointer to first byte of the packet.
+      const uint8_t*
+      getPacket(size_t i) const
+      {
+        return m_lsf.getData() + getEntry(i).offset;
+      }
+
+      //! Deserialize a packet.
+      //! @param i packet number.
+      //! @param msg message to fill or NULL to create a new one.
+      //! @return deserialized message.
+      Message*
+      getMessage(size_t i, Message* msg = NULL) const;
+
+      //! Find the first packet with a time stamp equal or greater
+      //! than a given time.
+      //! @param time time stamp.
+      //! @return packet number or getCount() if there is none.
+      size_t
+      seek(double time) const;
+
+      //! Find the next packet of a given message type.
+      //! @param id message identification number.
+      //! @param from first packet to consider.
+      //! @return packet number or getCount() if there is none.
+      size_t
+      find(uint16_t id, size_t from = 0) const;
+
+      //! Test if the index had to be built or extended.
+      //! @return true if the index was (re)built, false otherwise.
+      bool
+      isIndexRebuilt(void) const
+      {
+        return m_rebuilt;
+      }
+
+    private:
+      //! LSF file.
+      FileSystem::MappedFile m_lsf;
+      //! Index entries.
+      std::vector<LogIndex::Block> m_blocks;
+      //! Number of packets.
+      size_t m_count;
+      //! Maximum time stamp up to the end of each block.
+      std::vector<double> m_block_max;
+      //! Block whose packets are in m_packets.
+      mutable size_t m_decoded;
+      //! Descriptions of the packets of the last accessed block.
+      mutable std::vector<LogIndex::Entry> m_packets;
+      //! True if the index was (re)built.
+      bool m_rebuilt;
+
+      //! Load an index file.
+      //! @param data contents of the index file.
+      //! @param size size of the index file.
+      //! @return offset of the first packet not indexed, or -1 if the
+      //! index is not valid.
+      int64_t
+      load(const uint8_t* data, size_t size);
+
+      //! Test if an index entry points to a block of packets.
+      //! @param block index entry.
+      //! @return true if the entry is consistent with the LSF file.
+      bool
+      isValid(const LogIndex::Block& block) const;
+
+      //! Read the headers of the packets of a block.
+      //! @param block block number.
+      //! @return packet descriptions.
+      //! @throw std::runtime_error if the block is corrupted.
+      const std::vector<LogIndex::Entry>&
+      decode(size_t block) const;
+
+      //! Non-copyable.
+      LogReader(const LogReader&);
+
+      //! Non-assignable.
+      LogReader&
+      operator=(const LogReader&);
+    };
+  }
+}
+
+#endif
@@ -35,6 +35,7 @@
 #include <DUNE/Time/Clock.hpp>
 #include <DUNE/IMC/Constants.hpp>
 #include <DUNE/IMC/Header.hpp>
+#include <DUNE/IMC/MessagePool.hpp>
 #include <DUNE/IMC/Packet.hpp>
 #include <DUNE/IMC/AddressResolver.hpp>
 
@@ -65,6 +66,40 @@ namespace DUNE
       ~Message(void)
       { }
 
+      //! Allocate message storage from the message pool.
+      //! @param size object size.
+      //! @return pointer to storage.
+      static void*
+      operator new(size_t size)
+      {
+        return MessagePool::allocate(size);
+      }
+
+      //! Return message storage to the message pool.
+      //! @param ptr pointer to storage.
+      //! @param size object size.
+      static void
+      operator delete(void* ptr, size_t size)
+      {
+        MessagePool::release(ptr, size);
+      }
+
+      //! Placement new.
+      static void*
+      operator new(size_t size, void* ptr)
+      {
+        (void)size;
+        return ptr;
+      }
+
+      //! Placement delete.
+      static void
+      operator delete(void* ptr, void* place)
+      {
+        (void)ptr;
+        (void)place;
+      }
+
       //! Retrieve a copy of the message.
       //! @return message copy.
       virtual Message*
@@ -0,0 +1,210 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <new>
+
+// ISO C++ 11 headers.
+#include <atomic>
+
+// DUNE headers.
+#include <DUNE/Concurrency/Mutex.hpp>
+#include <DUNE/Concurrency/ScopedMutex.hpp>
+#include <DUNE/IMC/MessagePool.hpp>
+
+namespace DUNE
+{
+  namespace IMC
+  {
+    //! Size class granularity (bytes).
+    static const size_t c_granularity = 16;
+    //! Number of size classes.
+    static const size_t c_classes = 64;
+    //! Maximum number of cached objects per size class.
+    static const unsigned c_max_cached = 4096;
+
+    //! Cached object.
+    struct FreeBlock
+    {
+      FreeBlock* next;
+    };
+
+    //! Size class.
+    struct SizeClass
+    {
+      SizeClass(void):
+        head(NULL),
+        cached(0),
+        allocations(0),
+        reuses(0),
+        releases(0)
+      { }
+
+      //! Free list lock.
+      Concurrency::Mutex lock;
+      //! Free list.
+      FreeBlock* head;
+      //! Number of cached objects.
+      unsigned cached;
+      //! Number of allocations.
+      std::atomic<uint64_t> allocations;
+      //! Number of allocations served from the free list.
+      std::atomic<uint64_t> reuses;
+      //! Number of releases.
+      std::atomic<uint64_t> releases;
+    };
+
+    //! Retrieve the size classes. They are created on first use, so
+    //! that the pool is usable during static initialization, and
+    //! never destroyed, so that it is usable during static
+    //! destruction.
+    static SizeClass*
+    getClasses(void)
+    {
+      static SizeClass* classes = new SizeClass[c_classes];
+      return classes;
+    }
+
+    //! Retrieve the size class index of a given object size.
+    static inline size_t
+    getClass(size_t size)
+    {
+      return (size + c_granularity - 1) / c_granularity - 1;
+    }
+
+    void*
+    MessagePool::allocate(size_t size)
+    {
+      size_t idx = getClass(size);
+      if (size == 0 || idx >= c_classes)
+        return ::operator new(size);
+
+      SizeClass& sc = getClasses()[idx];
+      sc.allocations.fetch_add(1, std::memory_order_relaxed);
+
+      FreeBlock* block = NULL;
+      {
+        Concurrency::ScopedMutex l(sc.lock);
+        block = sc.head;
+        if (block != NULL)
+        {
+          sc.head = block->next;
+          --sc.cached;
+        }
+      }
+
+      if (block == NULL)
+        return ::operator new((idx + 1) * c_granularity);
+
+      sc.reuses.fetch_add(1, std::memory_order_relaxed);
+      return block;
+    }
+
+    void
+    MessagePool::release(void* ptr, size_t size)
+    {
+      if (ptr == NULL)
+        return;
+
+      size_t idx = getClass(size);
+      if (size == 0 || idx >= c_classes)
+      {
+        ::operator delete(ptr);
+        return;
+      }
+
+      SizeClass& sc = getClasses()[idx];
+      sc.releases.fetch_add(1, std::memory_order_relaxed);
+
+      FreeBlock* block = static_cast<FreeBlock*>(ptr);
+      {
+        Concurrency::ScopedMutex l(sc.lock);
+        if (sc.cached < c_max_cached)
+        {
+          block->next = sc.head;
+          sc.head = block;
+          ++sc.cached;
+          block = NULL;
+        }
+      }
+
+      if (block != NULL)
+        ::operator delete(block);
+    }
+
+    void
+    MessagePool::getStatistics(std::vector<Statistics>& stats)
+    {
+      stats.clear();
+
+      SizeClass* classes = getClasses();
+      for (size_t i = 0; i < c_classes; ++i)
+      {
+        SizeClass& sc = classes[i];
+        Statistics entry;
+        entry.allocations = sc.allocations.load(std::memory_order_relaxed);
+        if (entry.allocations == 0)
+          continue;
+
+        entry.size = (i + 1) * c_granularity;
+        entry.reuses = sc.reuses.load(std::memory_order_relaxed);
+        entry.in_use = (int64_t)(entry.allocations - sc.releases.load(std::memory_order_relaxed));
+
+        sc.lock.lock();
+        entry.cached = sc.cached;
+        sc.lock.unlock();
+
+        stats.push_back(entry);
+      }
+    }
+
+    void
+    MessagePool::trim(void)
+    {
+      SizeClass* classes = getClasses();
+      for (size_t i = 0; i < c_classes; ++i)
+      {
+        SizeClass& sc = classes[i];
+
+        sc.lock.lock();
+        FreeBlock* block = sc.head;
+        sc.head = NULL;
+        sc.cached = 0;
+        sc.lock.unlock();
+
+        while (block != NULL)
+        {
+          FreeBlock* next = block->next;
+          ::operator delete(block);
+          block = next;
+        }
+      }
+    }
+  }
+}
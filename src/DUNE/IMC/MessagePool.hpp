@@ -0,0 +1,95 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+#ifndef DUNE_IMC_MESSAGE_POOL_HPP_INCLUDED_
+#define DUNE_IMC_MESSAGE_POOL_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <cstddef>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/Config.hpp>
+
+namespace DUNE
+{
+  namespace IMC
+  {
+    // Export DLL Symbol.
+    class DUNE_DLL_SYM MessagePool;
+
+    //! Storage pool for IMC messages. Message objects are grouped in
+    //! size classes (in practice one per message type) and released
+    //! objects are kept in a free list of their class, so that
+    //! creating, cloning and deleting messages in steady state does
+    //! not reach the system allocator. Objects larger than the
+    //! largest class are allocated with ::operator new.
+    class MessagePool
+    {
+    public:
+      //! Statistics of a size class.
+      struct Statistics
+      {
+        //! Object size (bytes).
+        size_t size;
+        //! Number of allocations.
+        uint64_t allocations;
+        //! Number of allocations served from the free list.
+        uint64_t reuses;
+        //! Number of objects currently in use.
+        int64_t in_use;
+        //! Number of objects in the free list.
+        unsigned cached;
+      };
+
+      //! Allocate storage for a message object.
+      //! @param size object size.
+      //! @return pointer to storage.
+      static void*
+      allocate(size_t size);
+
+      //! Release storage of a message object.
+      //! @param ptr pointer to storage.
+      //! @param size object size.
+      static void
+      release(void* ptr, size_t size);
+
+      //! Retrieve statistics of the size classes that were used.
+      //! @param stats output vector.
+      static void
+      getStatistics(std::vector<Statistics>& stats);
+
+      //! Return all cached objects to the system allocator.
+      static void
+      trim(void);
+    };
+  }
+}
+
+#endif
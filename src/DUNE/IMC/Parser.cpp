@@ -27,6 +27,10 @@
 // Author: Eduardo Marques                                                  *
 //***************************************************************************
 
+// ISO C++ 98 headers.
+#include <algorithm>
+#include <cstring>
+
 // DUNE headers.
 #include <DUNE/IMC/Parser.hpp>
 #include <DUNE/IMC/Packet.hpp>
@@ -132,5 +136,121 @@ namespace DUNE
 
       return m;
     }
+
+    size_t
+    Parser::parse(const uint8_t* data, size_t len, Sink sink, void* ctx)
+    {
+      size_t count = 0;
+      size_t need = 0;
+
+      // Discard bytes already consumed by parse(uint8_t).
+      if (m_pos > 0)
+      {
+        m_buf.erase(m_buf.begin(), m_buf.begin() + std::min((size_t)m_pos, m_buf.size()));
+        m_pos = 0;
+      }
+      m_stage = c_sync;
+
+      // Complete the frame left over from the previous call, copying
+      // only the bytes it needs.
+      while (!m_buf.empty())
+      {
+        size_t start = extract(&m_buf[0], m_buf.size(), sink, ctx, count, need);
+        m_buf.erase(m_buf.begin(), m_buf.begin() + start);
+        if (m_buf.empty())
+          break;
+
+        if (len == 0)
+          return count;
+
+        size_t take = std::min(need - m_buf.size(), len);
+        m_buf.insert(m_buf.end(), data, data + take);
+        data += take;
+        len -= take;
+      }
+
+      size_t start = extract(data, len, sink, ctx, count, need);
+      m_buf.assign(data + start, data + len);
+      return count;
+    }
+
+    size_t
+    Parser::extract(const uint8_t* data, size_t len, Sink sink, void* ctx, size_t& count, size_t& need)
+    {
+      size_t pos = 0;
+
+      while (pos < len)
+      {
+        size_t start = findSync(data, pos, len);
+        if (start >= len)
+          break;
+
+        size_t avail = len - start;
+        if (avail < DUNE_IMC_CONST_HEADER_SIZE)
+        {
+          need = DUNE_IMC_CONST_HEADER_SIZE;
+          return start;
+        }
+
+        Header hdr;
+        try
+        {
+          Packet::deserializeHeader(hdr, data + start, DUNE_IMC_CONST_HEADER_SIZE);
+        }
+        catch (...)
+        {
+          pos = start + 1;
+          continue;
+        }
+
+        size_t total = DUNE_IMC_CONST_HEADER_SIZE + hdr.size + DUNE_IMC_CONST_FOOTER_SIZE;
+        if (avail < total)
+        {
+          need = total;
+          return start;
+        }
+
+        Message* msg = 0;
+        try
+        {
+          msg = Packet::deserializePayload(hdr, data + start, total, 0);
+        }
+        catch (...)
+        {
+          pos = start + 1;
+          continue;
+        }
+
+        ++count;
+        sink(ctx, msg);
+        pos = start + total;
+      }
+
+      return len;
+    }
+
+    size_t
+    Parser::findSync(const uint8_t* data, size_t pos, size_t len)
+    {
+      // Both byte orders of the synchronization number contain 0xFE,
+      // so a single memchr() finds candidates of either one.
+      while (pos < len)
+      {
+        const uint8_t* ptr = static_cast<const uint8_t*>(std::memchr(data + pos, 0xfe, len - pos));
+        if (ptr == NULL)
+          return (data[len - 1] == 0x54) ? len - 1 : len;
+
+        size_t idx = ptr - data;
+        if (idx > pos && data[idx - 1] == 0x54)
+          return idx - 1;
+
+        if (idx + 1 == len || data[idx + 1] == 0x54)
+          return idx;
+
+        pos = idx + 1;
+      }
+
+      return len;
+    }
   }
 }
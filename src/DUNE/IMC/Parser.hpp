@@ -31,6 +31,7 @@
 #define DUNE_IMC_PARSER_HPP_INCLUDED_
 
 // ISO C++ 98 headers.
+#include <cstddef>
 #include <vector>
 
 // DUNE headers.
@@ -63,7 +64,64 @@ namespace DUNE
       Message*
       parse(uint8_t byte);
 
+      //! Parse a buffer and deliver every complete message found in
+      //! it. Frames are validated and deserialized in place, only the
+      //! bytes of a trailing incomplete frame are kept for the next
+      //! call. The callback is invoked as callback(Message*) and
+      //! takes ownership of the message.
+      //! @param data data buffer.
+      //! @param len number of bytes in data.
+      //! @param callback callable object.
+      //! @return number of messages delivered.
+      template <typename Callback>
+      size_t
+      parse(const uint8_t* data, size_t len, Callback& callback)
+      {
+        return parse(data, len, &invoke<Callback>, &callback);
+      }
+
     private:
+      //! Function used to deliver parsed messages.
+      typedef void (*Sink)(void* ctx, Message* msg);
+
+      //! Adapt a callable object to a Sink.
+      template <typename Callback>
+      static void
+      invoke(void* ctx, Message* msg)
+      {
+        (*static_cast<Callback*>(ctx))(msg);
+      }
+
+      //! Parse a buffer, delivering messages to a sink.
+      //! @param data data buffer.
+      //! @param len number of bytes in data.
+      //! @param sink message sink.
+      //! @param ctx sink context.
+      //! @return number of messages delivered.
+      size_t
+      parse(const uint8_t* data, size_t len, Sink sink, void* ctx);
+
+      //! Extract all complete frames of a buffer.
+      //! @param data data buffer.
+      //! @param len number of bytes in data.
+      //! @param sink message sink.
+      //! @param ctx sink context.
+      //! @param count incremented for each delivered message.
+      //! @param need number of bytes needed to complete the trailing
+      //! frame.
+      //! @return offset of the trailing incomplete frame, or len if
+      //! there is none.
+      static size_t
+      extract(const uint8_t* data, size_t len, Sink sink, void* ctx, size_t& count, size_t& need);
+
+      //! Find the next candidate synchronization number.
+      //! @param data data buffer.
+      //! @param pos first position to search.
+      //! @param len number of bytes in data.
+      //! @return offset of candidate or len if there is none.
+      static size_t
+      findSync(const uint8_t* data, size_t pos, size_t len);
+
       //! Parser stage constants.
       enum ParserStage
       {
@@ -0,0 +1,202 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+#ifndef DUNE_IMC_SHARED_MESSAGE_HPP_INCLUDED_
+#define DUNE_IMC_SHARED_MESSAGE_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <cstddef>
+
+// DUNE headers.
+#include <DUNE/Config.hpp>
+#include <DUNE/Concurrency/AtomicCounter.hpp>
+#include <DUNE/IMC/Message.hpp>
+
+namespace DUNE
+{
+  namespace IMC
+  {
+    // Export DLL Symbol.
+    class DUNE_DLL_SYM SharedMessage;
+
+    //! Reference counted handle to an immutable message. Copies of
+    //! the handle share the same message object, which is deleted
+    //! when the last handle is released. The reference count is
+    //! updated atomically, so handles can be passed between threads.
+    //! A mutable message can only be obtained with getMutable(),
+    //! which clones the message if it is shared.
+    class SharedMessage
+    {
+    public:
+      //! Create a null handle.
+      SharedMessage(void):
+        m_block(NULL)
+      { }
+
+      //! Create a handle taking ownership of a message.
+      //! @param[in] msg message object (may be null).
+      explicit SharedMessage(Message* msg):
+        m_block(NULL)
+      {
+        if (msg != NULL)
+          m_block = new Block(msg);
+      }
+
+      //! Copy constructor.
+      //! @param[in] other handle to share.
+      SharedMessage(const SharedMessage& other):
+        m_block(other.m_block)
+      {
+        acquire();
+      }
+
+      //! Destructor.
+      ~SharedMessage(void)
+      {
+        release();
+      }
+
+      //! Assignment operator.
+      //! @param[in] other handle to share.
+      //! @return this handle.
+      SharedMessage&
+      operator=(const SharedMessage& other)
+      {
+        if (m_block != other.m_block)
+        {
+          other.acquire();
+          release();
+          m_block = other.m_block;
+        }
+
+        return *this;
+      }
+
+      //! Create a handle to a copy of a message.
+      //! @param[in] msg message to copy.
+      //! @return handle.
+      static SharedMessage
+      copy(const Message* msg)
+      {
+        return SharedMessage(msg->clone());
+      }
+
+      //! Test if the handle refers to a message.
+      //! @return true if handle is null, false otherwise.
+      bool
+      isNull(void) const
+      {
+        return m_block == NULL;
+      }
+
+      //! Retrieve the shared message.
+      //! @return message object or null.
+      const Message*
+      get(void) const
+      {
+        return (m_block == NULL) ? NULL : m_block->msg;
+      }
+
+      const Message*
+      operator->(void) const
+      {
+        return get();
+      }
+
+      //! Retrieve a message that can be modified. If other handles
+      //! share the message, this handle is detached to a private copy
+      //! first.
+      //! @return mutable message object or null.
+      Message*
+      getMutable(void)
+      {
+        if (m_block == NULL)
+          return NULL;
+
+        if (m_block->refs.add(0) > 1)
+        {
+          Block* block = new Block(m_block->msg->clone());
+          release();
+          m_block = block;
+        }
+
+        return m_block->msg;
+      }
+
+      //! Retrieve the number of handles sharing the message.
+      //! @return reference count (zero for null handles).
+      int
+      getReferenceCount(void) const
+      {
+        return (m_block == NULL) ? 0 : m_block->refs.add(0);
+      }
+
+    private:
+      //! Shared state.
+      struct Block
+      {
+        Block(Message* m):
+          msg(m),
+          refs(1)
+        { }
+
+        ~Block(void)
+        {
+          delete msg;
+        }
+
+        //! Message object.
+        Message* msg;
+        //! Number of handles.
+        mutable Concurrency::AtomicCounter refs;
+      };
+
+      //! Shared state.
+      Block* m_block;
+
+      void
+      acquire(void) const
+      {
+        if (m_block != NULL)
+          m_block->refs.add(1);
+      }
+
+      void
+      release(void)
+      {
+        if (m_block != NULL && m_block->refs.sub(1) == 0)
+          delete m_block;
+
+        m_block = NULL;
+      }
+    };
+  }
+}
+
+#endif
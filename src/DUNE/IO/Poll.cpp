@@ -36,6 +36,7 @@
 #include <DUNE/System/Error.hpp>
 #include <DUNE/Time/Constants.hpp>
 #include <DUNE/Time/Utils.hpp>
+#include <DUNE/Time/VirtualClock.hpp>
 #include <DUNE/IO/Poll.hpp>
 
 namespace DUNE
@@ -113,6 +114,9 @@ namespace DUNE
         FD_SET(*itr, &m_rfd);
       }
 
+      // Do not hold logical time while waiting for the outside world.
+      bool scheduled = (timeout != 0.0) && Time::VirtualClock::suspend();
+
       if (timeout < 0.0)
       {
         rv = select(max + 1, &m_rfd, NULL, NULL, NULL);
@@ -123,6 +127,10 @@ namespace DUNE
         rv = select(max + 1, &m_rfd, NULL, NULL, &tv);
       }
 
+      int error = errno;
+      Time::VirtualClock::resume(scheduled);
+      errno = error;
+
       if (rv == -1)
       {
         //! Workaround for when we are interrupted by a signal.
@@ -149,6 +157,8 @@ namespace DUNE
       FD_SET(handle, &rfd);
 
       int rv = 0;
+      bool scheduled = (timeout != 0.0) && Time::VirtualClock::suspend();
+
       if (timeout < 0.0)
       {
         rv = select(handle + 1, &rfd, NULL, NULL, NULL);
@@ -159,6 +169,10 @@ namespace DUNE
         rv = select(handle + 1, &rfd, NULL, NULL, &tv);
       }
 
+      int error = errno;
+      Time::VirtualClock::resume(scheduled);
+      errno = error;
+
       if (rv == -1)
       {
         //! Workaround for when we are interrupted by a signal.
@@ -0,0 +1,723 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+#ifndef DUNE_MATH_FIXED_MATRIX_HPP_INCLUDED_
+#define DUNE_MATH_FIXED_MATRIX_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+// DUNE headers.
+#include <DUNE/Math/Matrix.hpp>
+
+namespace DUNE
+{
+  namespace Math
+  {
+    template <size_t R, size_t C>
+    class FixedMatrix;
+
+    //! Base of fixed size matrix expressions. Sums, differences,
+    //! scalings and transpositions of fixed size matrices are not
+    //! evaluated when written: they build light-weight expression
+    //! objects that are evaluated element by element when assigned
+    //! to a FixedMatrix, so that chains like A * P * transpose(A) + Q
+    //! need no intermediate storage other than the products.
+    //! Expressions keep references to the matrices they use and must
+    //! be assigned before the end of the statement.
+    //! @tparam E concrete expression type.
+    //! @tparam R number of rows.
+    //! @tparam C number of columns.
+    template <typename E, size_t R, size_t C>
+    class MatrixExpression
+    {
+    public:
+      //! Get number of rows.
+      //! @return number of rows.
+      static constexpr size_t
+      rows(void)
+      {
+        return R;
+      }
+
+      //! Get number of columns.
+      //! @return number of columns.
+      static constexpr size_t
+      columns(void)
+      {
+        return C;
+      }
+
+      //! Get number of elements.
+      //! @return number of elements.
+      static constexpr size_t
+      size(void)
+      {
+        return R * C;
+      }
+
+      //! Retrieve the concrete expression.
+      //! @return concrete expression.
+      const E&
+      derived(void) const
+      {
+        return static_cast<const E&>(*this);
+      }
+
+      //! Evaluate an element of the expression.
+      //! @param[in] i row index.
+      //! @param[in] j column index.
+      //! @return value of the element.
+      double
+      element(size_t i, size_t j) const
+      {
+        return derived().element(i, j);
+      }
+    };
+
+    //! Storage of expression operands: matrices are kept by
+    //! reference, expressions by value.
+    template <typename E>
+    struct MatrixOperand
+    {
+      typedef const E type;
+    };
+
+    template <size_t R, size_t C>
+    struct MatrixOperand<FixedMatrix<R, C> >
+    {
+      typedef const FixedMatrix<R, C>& type;
+    };
+
+    //! Element-wise sum of two expressions.
+    template <typename L, typename Rh, size_t R, size_t C>
+    class MatrixSum: public MatrixExpression<MatrixSum<L, Rh, R, C>, R, C>
+    {
+    public:
+      MatrixSum(const L& l, const Rh& r):
+        m_l(l),
+        m_r(r)
+      { }
+
+      double
+      element(size_t i, size_t j) const
+      {
+        return m_l.element(i, j) + m_r.element(i, j);
+      }
+
+    private:
+      typename MatrixOperand<L>::type m_l;
+      typename MatrixOperand<Rh>::type m_r;
+    };
+
+    //! Element-wise difference of two expressions.
+    template <typename L, typename Rh, size_t R, size_t C>
+    class MatrixDifference: public MatrixExpression<MatrixDifference<L, Rh, R, C>, R, C>
+    {
+    public:
+      MatrixDifference(const L& l, const Rh& r):
+        m_l(l),
+        m_r(r)
+      { }
+
+      double
+      element(size_t i, size_t j) const
+      {
+        return m_l.element(i, j) - m_r.element(i, j);
+      }
+
+    private:
+      typename MatrixOperand<L>::type m_l;
+      typename MatrixOperand<Rh>::type m_r;
+    };
+
+    //! Expression multiplied by a scalar.
+    template <typename E, size_t R, size_t C>
+    class MatrixScale: public MatrixExpression<MatrixScale<E, R, C>, R, C>
+    {
+    public:
+      MatrixScale(const E& e, double x):
+        m_e(e),
+        m_x(x)
+      { }
+
+      double
+      element(size_t i, size_t j) const
+      {
+        return m_e.element(i, j) * m_x;
+      }
+
+    private:
+      typename MatrixOperand<E>::type m_e;
+      double m_x;
+    };
+
+    //! Transpose of an expression.
+    template <typename E, size_t R, size_t C>
+    class MatrixTranspose: public MatrixExpression<MatrixTranspose<E, R, C>, R, C>
+    {
+    public:
+      explicit MatrixTranspose(const E& e):
+        m_e(e)
+      { }
+
+      double
+      element(size_t i, size_t j) const
+      {
+        return m_e.element(j, i);
+      }
+
+    private:
+      typename MatrixOperand<E>::type m_e;
+    };
+
+    //! Matrix with dimensions fixed at compile time. Elements are
+    //! stored in row-major order inside the object, so matrices live
+    //! on the stack and operations never allocate memory. Mismatched
+    //! dimensions are compile errors. Conversion to and from Matrix
+    //! allows code to be migrated incrementally.
+    //! @tparam R number of rows.
+    //! @tparam C number of columns.
+    template <size_t R, size_t C>
+    class FixedMatrix: public MatrixExpression<FixedMatrix<R, C>, R, C>
+    {
+    public:
+      static_assert(R > 0 && C > 0, "invalid matrix dimensions");
+
+      //! Construct a zero matrix.
+      FixedMatrix(void)
+      {
+        fill(0.0);
+      }
+
+      //! Construct a matrix filled with a constant value.
+      //! @param[in] v value of all elements.
+      explicit FixedMatrix(double v)
+      {
+        fill(v);
+      }
+
+      //! Construct a matrix from an array, in row-major order.
+      //! @param[in] data elements.
+      explicit FixedMatrix(const double (&data)[R * C])
+      {
+        std::memcpy(m_data, data, sizeof(m_data));
+      }
+
+      //! Construct a matrix from a dynamic matrix.
+      //! @param[in] m matrix with the same dimensions.
+      explicit FixedMatrix(const Matrix& m)
+      {
+        if (m.rows() != R || m.columns() != C)
+          throw Matrix::Error("Incompatible dimensions!");
+
+        std::copy(m.begin(), m.end(), m_data);
+      }
+
+      //! Evaluate an expression.
+      //! @param[in] e expression.
+      template <typename E>
+      FixedMatrix(const MatrixExpression<E, R, C>& e)
+      {
+        assign(e.derived());
+      }
+
+      //! Evaluate an expression. The expression may refer to this
+      //! matrix.
+      //! @param[in] e expression.
+      //! @return reference to this matrix.
+      template <typename E>
+      FixedMatrix&
+      operator=(const MatrixExpression<E, R, C>& e)
+      {
+        FixedMatrix tmp(e);
+        std::memcpy(m_data, tmp.m_data, sizeof(m_data));
+        return *this;
+      }
+
+      //! Convert to a dynamic matrix.
+      //! @return matrix with the same elements.
+      operator Matrix(void) const
+      {
+        return Matrix(m_data, R, C);
+      }
+
+      //! Pointer to first element.
+      double*
+      begin(void)
+      {
+        return m_data;
+      }
+
+      //! Pointer to one past the last element.
+      double*
+      end(void)
+      {
+        return m_data + R * C;
+      }
+
+      //! Pointer to first element.
+      const double*
+      begin(void) const
+      {
+        return m_data;
+      }
+
+      //! Pointer to one past the last element.
+      const double*
+      end(void) const
+      {
+        return m_data + R * C;
+      }
+
+      //! Fill matrix with a constant value.
+      //! @param[in] value value of all elements.
+      void
+      fill(double value)
+      {
+        for (size_t i = 0; i < R * C; ++i)
+          m_data[i] = value;
+      }
+
+      //! Make this an identity matrix.
+      void
+      identity(void)
+      {
+        fill(0.0);
+        for (size_t i = 0; i < R && i < C; ++i)
+          m_data[i * C + i] = 1.0;
+      }
+
+      //! Retrieve an element.
+      //! @param[in] i row index.
+      //! @param[in] j column index.
+      //! @return value of the element.
+      double
+      element(size_t i, size_t j) const
+      {
+        return m_data[i * C + j];
+      }
+
+      //! Retrieve a reference to an element.
+      //! @param[in] i row index.
+      //! @param[in] j column index.
+      //! @return reference to the element.
+      double&
+      operator()(size_t i, size_t j)
+      {
+        return m_data[i * C + j];
+      }
+
+      //! Retrieve an element.
+      //! @param[in] i row index.
+      //! @param[in] j column index.
+      //! @return value of the element.
+      double
+      operator()(size_t i, size_t j) const
+      {
+        return m_data[i * C + j];
+      }
+
+      //! Retrieve a reference to an element, in row-major order.
+      //! @param[in] i element index.
+      //! @return reference to the element.
+      double&
+      operator()(size_t i)
+      {
+        return m_data[i];
+      }
+
+      //! Retrieve an element, in row-major order.
+      //! @param[in] i element index.
+      //! @return value of the element.
+      double
+      operator()(size_t i) const
+      {
+        return m_data[i];
+      }
+
+      //! Extract a block of the matrix.
+      //! @tparam R2 number of rows of the block.
+      //! @tparam C2 number of columns of the block.
+      //! @param[in] i row of the first element.
+      //! @param[in] j column of the first element.
+      //! @return block.
+      template <size_t R2, size_t C2>
+      FixedMatrix<R2, C2>
+      get(size_t i, size_t j) const
+      {
+        static_assert(R2 <= R && C2 <= C, "block is larger than matrix");
+
+        if (i > R - R2 || j > C - C2)
+          throw Matrix::Error("Invalid index!");
+
+        FixedMatrix<R2, C2> s;
+        for (size_t k = 0; k < R2; ++k)
+          for (size_t l = 0; l < C2; ++l)
+            s(k, l) = m_data[(i + k) * C + j + l];
+
+        return s;
+      }
+
+      //! Replace a block of the matrix.
+      //! @param[in] i row of the first element.
+      //! @param[in] j column of the first element.
+      //! @param[in] m block.
+      //! @return reference to this matrix.
+      template <size_t R2, size_t C2>
+      FixedMatrix&
+      set(size_t i, size_t j, const FixedMatrix<R2, C2>& m)
+      {
+        static_assert(R2 <= R && C2 <= C, "block is larger than matrix");
+
+        if (i > R - R2 || j > C - C2)
+          throw Matrix::Error("Invalid index!");
+
+        for (size_t k = 0; k < R2; ++k)
+          for (size_t l = 0; l < C2; ++l)
+            m_data[(i + k) * C + j + l] = m(k, l);
+
+        return *this;
+      }
+
+      //! Extract a row.
+      //! @param[in] i row index.
+      //! @return row.
+      FixedMatrix<1, C>
+      row(size_t i) const
+      {
+        return get<1, C>(i, 0);
+      }
+
+      //! Extract a column.
+      //! @param[in] j column index.
+      //! @return column.
+      FixedMatrix<R, 1>
+      column(size_t j) const
+      {
+        return get<R, 1>(0, j);
+      }
+
+      //! Compute the Euclidean norm of the elements.
+      //! @return norm.
+      double
+      norm_2(void) const
+      {
+        double n = 0;
+        for (size_t i = 0; i < R * C; ++i)
+          n += m_data[i] * m_data[i];
+        return std::sqrt(n);
+      }
+
+      //! Compute the maximum absolute value of the elements.
+      //! @return norm.
+      double
+      norm_inf(void) const
+      {
+        double n = 0;
+        for (size_t i = 0; i < R * C; ++i)
+          n = std::max(std::fabs(m_data[i]), n);
+        return n;
+      }
+
+      //! Compute the sum of the diagonal elements.
+      //! @return trace.
+      double
+      trace(void) const
+      {
+        double t = 0;
+        for (size_t i = 0; i < R && i < C; ++i)
+          t += m_data[i * C + i];
+        return t;
+      }
+
+      //! Compare matrices for equality.
+      //! @param[in] m matrix to compare.
+      //! @return true if matrices are equal, false otherwise.
+      bool
+      operator==(const FixedMatrix& m) const
+      {
+        for (size_t i = 0; i < R * C; ++i)
+        {
+          if (m_data[i] != m.m_data[i])
+            return false;
+        }
+
+        return true;
+      }
+
+      //! Add an expression to this matrix.
+      //! @param[in] e expression.
+      //! @return reference to this matrix.
+      template <typename E>
+      FixedMatrix&
+      operator+=(const MatrixExpression<E, R, C>& e)
+      {
+        FixedMatrix tmp(e);
+        for (size_t i = 0; i < R * C; ++i)
+          m_data[i] += tmp.m_data[i];
+        return *this;
+      }
+
+      //! Subtract an expression from this matrix.
+      //! @param[in] e expression.
+      //! @return reference to this matrix.
+      template <typename E>
+      FixedMatrix&
+      operator-=(const MatrixExpression<E, R, C>& e)
+      {
+        FixedMatrix tmp(e);
+        for (size_t i = 0; i < R * C; ++i)
+          m_data[i] -= tmp.m_data[i];
+        return *this;
+      }
+
+      //! Multiply this matrix by a scalar.
+      //! @param[in] x scalar.
+      //! @return reference to this matrix.
+      FixedMatrix&
+      operator*=(double x)
+      {
+        for (size_t i = 0; i < R * C; ++i)
+          m_data[i] *= x;
+        return *this;
+      }
+
+      //! Divide this matrix by a scalar.
+      //! @param[in] x scalar.
+      //! @return reference to this matrix.
+      FixedMatrix&
+      operator/=(double x)
+      {
+        for (size_t i = 0; i < R * C; ++i)
+          m_data[i] /= x;
+        return *this;
+      }
+
+    private:
+      //! Elements in row-major order.
+      double m_data[R * C];
+
+      template <typename E>
+      void
+      assign(const E& e)
+      {
+        for (size_t i = 0; i < R; ++i)
+          for (size_t j = 0; j < C; ++j)
+            m_data[i * C + j] = e.element(i, j);
+      }
+    };
+
+    //! Column vector with dimension fixed at compile time.
+    template <size_t N>
+    using FixedVector = FixedMatrix<N, 1>;
+
+    template <typename L, typename Rh, size_t R, size_t C>
+    inline MatrixSum<L, Rh, R, C>
+    operator+(const MatrixExpression<L, R, C>& l, const MatrixExpression<Rh, R, C>& r)
+    {
+      return MatrixSum<L, Rh, R, C>(l.derived(), r.derived());
+    }
+
+    template <typename L, typename Rh, size_t R, size_t C>
+    inline MatrixDifference<L, Rh, R, C>
+    operator-(const MatrixExpression<L, R, C>& l, const MatrixExpression<Rh, R, C>& r)
+    {
+      return MatrixDifference<L, Rh, R, C>(l.derived(), r.derived());
+    }
+
+    template <typename E, size_t R, size_t C>
+    inline MatrixScale<E, R, C>
+    operator-(const MatrixExpression<E, R, C>& e)
+    {
+      return MatrixScale<E, R, C>(e.derived(), -1.0);
+    }
+
+    template <typename E, size_t R, size_t C>
+    inline MatrixScale<E, R, C>
+    operator*(const MatrixExpression<E, R, C>& e, double x)
+    {
+      return MatrixScale<E, R, C>(e.derived(), x);
+    }
+
+    template <typename E, size_t R, size_t C>
+    inline MatrixScale<E, R, C>
+    operator*(double x, const MatrixExpression<E, R, C>& e)
+    {
+      return MatrixScale<E, R, C>(e.derived(), x);
+    }
+
+    template <typename E, size_t R, size_t C>
+    inline MatrixScale<E, R, C>
+    operator/(const MatrixExpression<E, R, C>& e, double x)
+    {
+      return MatrixScale<E, R, C>(e.derived(), 1.0 / x);
+    }
+
+    //! Multiply two expressions. The product is evaluated at once,
+    //! so that each element of the operands is computed only once
+    //! per use.
+    //! @param[in] l left operand (R x K).
+    //! @param[in] r right operand (K x C).
+    //! @return product (R x C).
+    template <typename L, typename Rh, size_t R, size_t K, size_t C>
+    inline FixedMatrix<R, C>
+    operator*(const MatrixExpression<L, R, K>& l, const MatrixExpression<Rh, K, C>& r)
+    {
+      FixedMatrix<R, C> s;
+      for (size_t i = 0; i < R; ++i)
+      {
+        for (size_t k = 0; k < K; ++k)
+        {
+          double v = l.derived().element(i, k);
+          for (size_t j = 0; j < C; ++j)
+            s(i, j) += v * r.derived().element(k, j);
+        }
+      }
+
+      return s;
+    }
+
+    //! Transpose an expression.
+    //! @param[in] e expression.
+    //! @return transposed expression.
+    template <typename E, size_t R, size_t C>
+    inline MatrixTranspose<E, C, R>
+    transpose(const MatrixExpression<E, R, C>& e)
+    {
+      return MatrixTranspose<E, C, R>(e.derived());
+    }
+
+    //! Invert a square matrix using Gauss-Jordan elimination with
+    //! partial pivoting.
+    //! @param[in] a matrix to invert.
+    //! @return inverted matrix.
+    //! @throw Matrix::Error if the matrix is singular.
+    template <typename E, size_t N>
+    inline FixedMatrix<N, N>
+    inverse(const MatrixExpression<E, N, N>& a)
+    {
+      FixedMatrix<N, N> m(a);
+      FixedMatrix<N, N> s;
+      s.identity();
+
+      for (size_t k = 0; k < N; ++k)
+      {
+        size_t p = k;
+        for (size_t i = k + 1; i < N; ++i)
+        {
+          if (std::fabs(m(i, k)) > std::fabs(m(p, k)))
+            p = i;
+        }
+
+        if (std::fabs(m(p, k)) < Matrix::get_precision())
+          throw Matrix::Error("Inversion error!");
+
+        if (p != k)
+        {
+          for (size_t j = 0; j < N; ++j)
+          {
+            std::swap(m(k, j), m(p, j));
+            std::swap(s(k, j), s(p, j));
+          }
+        }
+
+        double d = 1.0 / m(k, k);
+        for (size_t j = 0; j < N; ++j)
+        {
+          m(k, j) *= d;
+          s(k, j) *= d;
+        }
+
+        for (size_t i = 0; i < N; ++i)
+        {
+          if (i == k || m(i, k) == 0.0)
+            continue;
+
+          double f = m(i, k);
+          for (size_t j = 0; j < N; ++j)
+          {
+            m(i, j) -= f * m(k, j);
+            s(i, j) -= f * s(k, j);
+          }
+        }
+      }
+
+      return s;
+    }
+
+    //! Compute the dot product of two vectors.
+    //! @param[in] a first vector.
+    //! @param[in] b second vector.
+    //! @return dot product.
+    template <size_t N>
+    inline double
+    dot(const FixedVector<N>& a, const FixedVector<N>& b)
+    {
+      double d = 0;
+      for (size_t i = 0; i < N; ++i)
+        d += a(i) * b(i);
+      return d;
+    }
+
+    //! Compute the cross product of two vectors.
+    //! @param[in] a first vector.
+    //! @param[in] b second vector.
+    //! @return cross product.
+    inline FixedVector<3>
+    cross(const FixedVector<3>& a, const FixedVector<3>& b)
+    {
+      FixedVector<3> c;
+      c(0) = a(1) * b(2) - a(2) * b(1);
+      c(1) = a(2) * b(0) - a(0) * b(2);
+      c(2) = a(0) * b(1) - a(1) * b(0);
+      return c;
+    }
+
+    template <size_t R, size_t C>
+    inline std::ostream&
+    operator<<(std::ostream& os, const FixedMatrix<R, C>& a)
+    {
+      for (size_t i = 0; i < R; ++i)
+      {
+        for (size_t j = 0; j < C; ++j)
+          os << a(i, j) << " ";
+        os << std::endl;
+      }
+
+      return os;
+    }
+  }
+}
+
+#endif
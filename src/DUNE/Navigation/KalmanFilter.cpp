@@ -28,6 +28,9 @@
 // Author: José Braga                                                       *
 //***************************************************************************
 
+// ISO C++ 98 headers.
+#include <algorithm>
+
 // DUNE headers.
 #include <DUNE/Navigation/KalmanFilter.hpp>
 
@@ -35,7 +38,8 @@ namespace DUNE
 {
   namespace Navigation
   {
-    KalmanFilter::KalmanFilter(void)
+    KalmanFilter::KalmanFilter(void):
+      m_sequential(false)
     {
       m_state_count = 1;
       Math::Matrix I(1);
@@ -43,7 +47,8 @@ namespace DUNE
       m_x = m_y = m_ax = m_ap = m_c = m_p = m_q = m_r = m_innov = I;
     }
 
-    KalmanFilter::KalmanFilter(Math::Matrix& A, Math::Matrix& C, Math::Matrix& P, Math::Matrix& Q)
+    KalmanFilter::KalmanFilter(Math::Matrix& A, Math::Matrix& C, Math::Matrix& P, Math::Matrix& Q):
+      m_sequential(false)
     {
       m_ax = A;
       m_ap = A;
@@ -113,15 +118,94 @@ namespace DUNE
       if (u.rows() != b.columns() || u.columns() != 1)
         throw std::runtime_error(DTR("invalid dimensions"));
 
-      m_x = m_ax * m_x + b * u;
-      m_p = m_ap * m_p * transpose(m_ap) + m_q;
+      if ((size_t)b.rows() != m_state_count)
+        throw std::runtime_error(DTR("invalid dimensions"));
+
+      size_t n = m_state_count;
+      size_t m = u.rows();
+      m_work.resize(n * n + 4 * n);
+
+      const double* ax = m_ax.cbegin();
+      const double* bp = b.cbegin();
+      const double* up = u.cbegin();
+      double* x = storage(m_x);
+      double* t = &m_work[0];
+
+      for (size_t i = 0; i < n; ++i)
+      {
+        double v = 0;
+        for (size_t k = 0; k < n; ++k)
+          v += ax[i * n + k] * x[k];
+        for (size_t k = 0; k < m; ++k)
+          v += bp[i * m + k] * up[k];
+        t[i] = v;
+      }
+
+      std::copy(t, t + n, x);
+      propagate();
     }
 
     void
     KalmanFilter::predict(void)
     {
-      m_x = m_ax * m_x;
-      m_p = m_ap * m_p * transpose(m_ap) + m_q;
+      size_t n = m_state_count;
+      m_work.resize(n * n + 4 * n);
+
+      const double* ax = m_ax.cbegin();
+      double* x = storage(m_x);
+      double* t = &m_work[0];
+
+      for (size_t i = 0; i < n; ++i)
+      {
+        double v = 0;
+        for (size_t k = 0; k < n; ++k)
+          v += ax[i * n + k] * x[k];
+        t[i] = v;
+      }
+
+      std::copy(t, t + n, x);
+      propagate();
+    }
+
+    void
+    KalmanFilter::propagate(void)
+    {
+      size_t n = m_state_count;
+      const double* ap = m_ap.cbegin();
+      const double* q = m_q.cbegin();
+      double* p = storage(m_p);
+      double* t = &m_work[n];
+
+      // t = Ap * P
+      for (size_t i = 0; i < n; ++i)
+      {
+        double* ti = t + i * n;
+        std::fill(ti, ti + n, 0.0);
+        for (size_t k = 0; k < n; ++k)
+        {
+          double v = ap[i * n + k];
+          if (v == 0.0)
+            continue;
+
+          const double* pk = p + k * n;
+          for (size_t j = 0; j < n; ++j)
+            ti[j] += v * pk[j];
+        }
+      }
+
+      // P = t * Ap' + Q, computing the symmetric product once.
+      for (size_t i = 0; i < n; ++i)
+      {
+        for (size_t j = i; j < n; ++j)
+        {
+          double v = 0;
+          for (size_t k = 0; k < n; ++k)
+            v += t[i * n + k] * ap[j * n + k];
+
+          p[i * n + j] = v + q[i * n + j];
+          p[j * n + i] = v + q[j * n + i];
+        }
+      }
     }
 
     int
@@ -139,6 +223,9 @@ namespace DUNE
       if (m_r.rows() != m_r.columns() || m_r.rows() != m_innov.rows())
         throw std::runtime_error(DTR("invalid dimensions"));
 
+      if (m_sequential && isNoiseDiagonal())
+        return updateSequential(threshold);
+
       // Measurement prediction covariance.
       Math::Matrix S = (m_c * m_p * transpose(m_c)) + m_r;
       Math::Matrix S_1;
@@ -175,6 +262,123 @@ namespace DUNE
       return 0;
     }
 
+    int
+    KalmanFilter::updateSequential(float threshold)
+    {
+      size_t n = m_state_count;
+      size_t m = m_innov.rows();
+      m_work.resize(n * n + 4 * n);
+
+      const double* c = m_c.cbegin();
+      const double* r = m_r.cbegin();
+      const double* innov = m_innov.cbegin();
+      double* x = storage(m_x);
+      double* p = storage(m_p);
+
+      // State correction applied so far.
+      double* dx = &m_work[0];
+      // P * c'
+      double* pc = dx + n;
+      // Kalman gain.
+      double* k = pc + n;
+
+      std::fill(dx, dx + n, 0.0);
+      int rv = 0;
+
+      for (size_t i = 0; i < m; ++i)
+      {
+        const double* ci = c + i * n;
+
+        // Innovations were computed for the predicted state: account
+        // for the corrections of previous measurements.
+        double e = innov[i];
+        bool observed = false;
+        for (size_t j = 0; j < n; ++j)
+        {
+          if (ci[j] != 0.0)
+          {
+            e -= ci[j] * dx[j];
+            observed = true;
+          }
+        }
+
+        if (!observed)
+          continue;
+
+        std::fill(pc, pc + n, 0.0);
+        for (size_t j = 0; j < n; ++j)
+        {
+          if (ci[j] == 0.0)
+            continue;
+
+          for (size_t a = 0; a < n; ++a)
+            pc[a] += p[a * n + j] * ci[j];
+        }
+
+        double cpc = 0;
+        for (size_t j = 0; j < n; ++j)
+          cpc += ci[j] * pc[j];
+
+        double ri = r[i * m + i];
+        double s = cpc + ri;
+        if (s <= 0.0)
+          continue;
+
+        // Check if innovation is above a threshold value.
+        // Set threshold to 0 to accept everything.
+        if (threshold != 0 && (e * e / s) >= threshold)
+        {
+          rv = -1;
+          continue;
+        }
+
+        for (size_t a = 0; a < n; ++a)
+        {
+          k[a] = pc[a] / s;
+          x[a] += k[a] * e;
+          dx[a] += k[a] * e;
+        }
+
+        // Joseph form: P = (I - k c) P (I - k c)' + k r k', where
+        // (I - k c) P c' = pc - k (c P c').
+        for (size_t a = 0; a < n; ++a)
+        {
+          double mca = pc[a] - k[a] * cpc;
+          for (size_t b = a; b < n; ++b)
+          {
+            double mcb = pc[b] - k[b] * cpc;
+            double v = (p[a * n + b]
+                        - 0.5 * (k[a] * pc[b] + k[b] * pc[a])
+                        - 0.5 * (mca * k[b] + mcb * k[a])
+                        + ri * k[a] * k[b]);
+
+            p[a * n + b] = v;
+            p[b * n + a] = v;
+          }
+        }
+      }
+
+      return rv;
+    }
+
+    bool
+    KalmanFilter::isNoiseDiagonal(void) const
+    {
+      size_t m = m_r.rows();
+      const double* r = m_r.cbegin();
+
+      for (size_t i = 0; i < m; ++i)
+      {
+        for (size_t j = 0; j < m; ++j)
+        {
+          if (i != j && r[i * m + j] != 0.0)
+            return false;
+        }
+      }
+
+      return true;
+    }
+
     void
     KalmanFilter::setState(short pos, double value)
     {
@@ -46,6 +46,7 @@
 #include <stdexcept>
 #include <string>
 #include <cmath>
+#include <vector>
 
 // DUNE headers.
 #include <DUNE/Config.hpp>
@@ -103,12 +104,31 @@ namespace DUNE
       void
       predict(void);
 
-      //! Kalman Filter update function.
+      //! Kalman Filter update function. If sequential updates are
+      //! enabled and the measurement noise covariance matrix is
+      //! diagonal, each measurement is processed as a scalar update
+      //! (see setSequentialUpdates()).
       //! @param threshold threshold to reject large state innovations.
       //! @return 0 if update is successful, -1 otherwise.
       int
       update(float threshold);
 
+      //! Enable or disable sequential scalar updates. With
+      //! uncorrelated measurements, processing one measurement at a
+      //! time is equivalent to the batch update but needs no matrix
+      //! inversion or temporary matrices. The covariance is updated
+      //! in place using the Joseph form, which keeps it symmetric and
+      //! positive definite. When a threshold is given to update(),
+      //! each measurement is gated on its own and rejected
+      //! measurements are skipped.
+      //! @param enable true to enable, false to always use batch
+      //! updates.
+      void
+      setSequentialUpdates(bool enable)
+      {
+        m_sequential = enable;
+      }
+
       //! Get filter state value.
       //! @param pos matrix index.
       //! @return state matrix value.
@@ -123,7 +143,7 @@ namespace DUNE
 
       //! Get state matrix.
       //! @return state matrix.
-      inline Math::Matrix
+      inline const Math::Matrix&
       getState(void) const
       {
         return m_x;
@@ -141,7 +161,7 @@ namespace DUNE
 
       //! Get state transition matrix.
       //! @return state transition matrix.
-      inline Math::Matrix
+      inline const Math::Matrix&
       getStateTransition(void) const
       {
         return m_ax;
@@ -154,7 +174,7 @@ namespace DUNE
 
       //! Get state covariance transition matrix.
       //! @return state covariance transition matrix.
-      inline Math::Matrix
+      inline const Math::Matrix&
       getCovarianceTransition(void) const
       {
         return m_ap;
@@ -224,7 +244,7 @@ namespace DUNE
 
       //! Get output transition matrix.
       //! @return output transition matrix.
-      inline Math::Matrix
+      inline const Math::Matrix&
       getObservation(void) const
       {
         return m_c;
@@ -276,7 +296,7 @@ namespace DUNE
 
       //! Get state covariance matrix.
       //! @return state covariance matrix.
-      inline Math::Matrix
+      inline const Math::Matrix&
       getCovariance(void) const
       {
         return m_p;
@@ -361,6 +381,38 @@ namespace DUNE
       Math::Matrix m_r;
       //! Innovation vector.
       Math::Matrix m_innov;
+      //! Process measurements as sequential scalar updates.
+      bool m_sequential;
+      //! Workspace of in-place computations.
+      std::vector<double> m_work;
+
+      //! Propagate the state covariance matrix in place.
+      void
+      propagate(void);
+
+      //! Update state and covariance with one measurement at a time.
+      //! @param threshold threshold to reject large innovations.
+      //! @return 0 if all measurements were used, -1 otherwise.
+      int
+      updateSequential(float threshold);
+
+      //! Test if the measurement noise covariance matrix is diagonal.
+      //! @return true if diagonal, false otherwise.
+      bool
+      isNoiseDiagonal(void) const;
+
+      //! Retrieve writable storage of a matrix. Copies sharing the
+      //! storage are detached first, so that in-place updates never
+      //! change them.
+      //! @param m matrix.
+      //! @return pointer to the first element.
+      static double*
+      storage(Math::Matrix& m)
+      {
+        // Non-const element access detaches shared copies.
+        (void)m(0);
+        return m.begin();
+      }
     };
   }
 }
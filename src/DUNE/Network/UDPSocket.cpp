@@ -28,7 +28,9 @@
 //***************************************************************************
 
 // ISO C++ 98 headers.
+#include <algorithm>
 #include <cerrno>
+#include <cstring>
 
 // DUNE headers.
 #include <DUNE/Config.hpp>
@@ -220,16 +222,133 @@ namespace DUNE
       int rv = sendto(m_handle, (const char*)buffer, size, 0, (::sockaddr*)&host_sai, (::socklen_t)sock_len);
 
       if (rv == -1)
+        throwWriteError(host);
+
+      return rv;
+    }
+
+    size_t
+    UDPSocket::write(const Datagram* dgrams, size_t count, unsigned* syscalls)
+    {
+#if defined(DUNE_SYS_HAS_SENDMMSG)
+      sockaddr_in hosts[c_max_batch];
+      iovec iovs[c_max_batch];
+      mmsghdr hdrs[c_max_batch];
+
+      size_t sent = 0;
+      while (sent < count)
+      {
+        unsigned batch = (unsigned)std::min(count - sent, (size_t)c_max_batch);
+        for (unsigned i = 0; i < batch; ++i)
+        {
+          const Datagram& dgram = dgrams[sent + i];
+          hosts[i].sin_family = AF_INET;
+          hosts[i].sin_port = Utils::ByteCopy::toBE(dgram.port);
+          hosts[i].sin_addr.s_addr = dgram.addr.toInteger();
+          iovs[i].iov_base = dgram.data;
+          iovs[i].iov_len = dgram.size;
+          std::memset(&hdrs[i], 0, sizeof(hdrs[i]));
+          hdrs[i].msg_hdr.msg_name = &hosts[i];
+          hdrs[i].msg_hdr.msg_namelen = sizeof(hosts[i]);
+          hdrs[i].msg_hdr.msg_iov = &iovs[i];
+          hdrs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        if (syscalls != NULL)
+          ++(*syscalls);
+
+        int rv = sendmmsg(m_handle, hdrs, batch, 0);
+        if (rv == -1)
+        {
+          if (sent == 0)
+            throwWriteError(dgrams[0].addr);
+          break;
+        }
+
+        sent += rv;
+        if ((unsigned)rv < batch)
+          break;
+      }
+
+      return sent;
+#else
+      for (size_t i = 0; i < count; ++i)
       {
-        if (errno == EHOSTUNREACH)
-          throw HostUnreachable(host.str());
-        else if (errno == ENETUNREACH)
-          throw NetworkUnreachable(host.str());
-        else
-          throw NetworkError(DTR("error sending data"), DUNE_SOCKET_ERROR);
+        if (syscalls != NULL)
+          ++(*syscalls);
+
+        try
+        {
+          write(dgrams[i].data, dgrams[i].size, dgrams[i].addr, dgrams[i].port);
+        }
+        catch (...)
+        {
+          if (i == 0)
+            throw;
+          return i;
+        }
+      }
+
+      return count;
+#endif
+    }
+
+    size_t
+    UDPSocket::read(Datagram* dgrams, size_t count, unsigned* syscalls)
+    {
+      if (count == 0)
+        return 0;
+
+#if defined(DUNE_SYS_HAS_RECVMMSG)
+      sockaddr_in hosts[c_max_batch];
+      iovec iovs[c_max_batch];
+      mmsghdr hdrs[c_max_batch];
+
+      unsigned batch = (unsigned)std::min(count, (size_t)c_max_batch);
+      for (unsigned i = 0; i < batch; ++i)
+      {
+        iovs[i].iov_base = dgrams[i].data;
+        iovs[i].iov_len = dgrams[i].size;
+        std::memset(&hdrs[i], 0, sizeof(hdrs[i]));
+        hdrs[i].msg_hdr.msg_name = &hosts[i];
+        hdrs[i].msg_hdr.msg_namelen = sizeof(hosts[i]);
+        hdrs[i].msg_hdr.msg_iov = &iovs[i];
+        hdrs[i].msg_hdr.msg_iovlen = 1;
+      }
+
+      if (syscalls != NULL)
+        ++(*syscalls);
+
+      int rv = recvmmsg(m_handle, hdrs, batch, MSG_WAITFORONE, NULL);
+      if (rv <= 0)
+        throw NetworkError(DTR("error receiving data"), DUNE_SOCKET_ERROR);
+
+      for (int i = 0; i < rv; ++i)
+      {
+        dgrams[i].size = hdrs[i].msg_len;
+        dgrams[i].addr = (::sockaddr*)&hosts[i];
+        dgrams[i].port = Utils::ByteCopy::fromBE(hosts[i].sin_port);
       }
 
       return rv;
+#else
+      if (syscalls != NULL)
+        ++(*syscalls);
+
+      dgrams[0].size = read(dgrams[0].data, dgrams[0].size, &dgrams[0].addr, &dgrams[0].port);
+      return 1;
+#endif
+    }
+
+    void
+    UDPSocket::throwWriteError(const Address& host)
+    {
+      if (errno == EHOSTUNREACH)
+        throw HostUnreachable(host.str());
+      else if (errno == ENETUNREACH)
+        throw NetworkUnreachable(host.str());
+      else
+        throw NetworkError(DTR("error sending data"), DUNE_SOCKET_ERROR);
     }
 
     void
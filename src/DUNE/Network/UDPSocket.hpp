@@ -51,6 +51,22 @@ namespace DUNE
     class UDPSocket: public IO::Handle
     {
     public:
+      //! Maximum number of datagrams transferred by one system call.
+      static const unsigned c_max_batch = 64;
+
+      //! Datagram of a batched read or write.
+      struct Datagram
+      {
+        //! Data buffer.
+        uint8_t* data;
+        //! Data length (or buffer capacity, when reading).
+        size_t size;
+        //! Remote host address.
+        Address addr;
+        //! Remote host port.
+        uint16_t port;
+      };
+
       //! Create an unbound UDP socket.
       UDPSocket(void);
 
@@ -97,6 +113,31 @@ namespace DUNE
       size_t
       read(uint8_t* buffer, size_t size, Address* addr = NULL, uint16_t* port = NULL);
 
+      //! Send a batch of UDP datagrams, using a single system call
+      //! for up to c_max_batch datagrams where the system supports it.
+      //! @param dgrams datagrams to send.
+      //! @param count number of datagrams.
+      //! @param syscalls if not NULL, incremented by the number of
+      //! system calls made.
+      //! @return number of datagrams sent, less than count if
+      //! sending the next datagram failed.
+      //! @throw the exceptions of write() if no datagram was sent.
+      size_t
+      write(const Datagram* dgrams, size_t count, unsigned* syscalls = NULL);
+
+      //! Receive a batch of UDP datagrams. Blocks until one datagram
+      //! is available and then reads all datagrams already queued,
+      //! up to count, with a single system call where the system
+      //! supports it. The size, address and port of each datagram
+      //! are updated.
+      //! @param dgrams datagrams to fill.
+      //! @param count number of datagrams.
+      //! @param syscalls if not NULL, incremented by the number of
+      //! system calls made.
+      //! @return number of datagrams received.
+      size_t
+      read(Datagram* dgrams, size_t count, unsigned* syscalls = NULL);
+
     private:
       //! Platform specific handle.
 #if defined(DUNE_OS_WINDOWS)
@@ -136,6 +177,11 @@ namespace DUNE
       void
       createEventHandle(void);
 
+      //! Throw the exception matching the last send error.
+      //! @param host destination host address.
+      static void
+      throwWriteError(const Address& host);
+
       //! Non - copyable.
       UDPSocket(const UDPSocket&);
 
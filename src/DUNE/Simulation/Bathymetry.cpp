@@ -0,0 +1,393 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+// DUNE headers.
+#include <DUNE/Config.hpp>
+#include <DUNE/FileSystem/Exceptions.hpp>
+#include <DUNE/Math/General.hpp>
+#include <DUNE/Parsers/Config.hpp>
+#include <DUNE/Simulation/Bathymetry.hpp>
+#include <DUNE/Utils/String.hpp>
+
+namespace DUNE
+{
+  namespace Simulation
+  {
+    //! File identifier.
+    static const char c_magic[4] = {'D', 'B', 'T', 'Y'};
+    //! File format version.
+    static const uint32_t c_version = 1;
+    //! Size of the file header.
+    static const size_t c_header_size = 64;
+    //! Maximum number of nodes.
+    static const uint64_t c_max_nodes = 1 << 28;
+
+    //! Copy a value from a little endian buffer.
+    template <typename T>
+    static T
+    readLE(const uint8_t* bfr)
+    {
+      T value;
+#if defined(DUNE_CPU_BIG_ENDIAN)
+      uint8_t* dst = reinterpret_cast<uint8_t*>(&value);
+      for (size_t i = 0; i < sizeof(T); ++i)
+        dst[i] = bfr[sizeof(T) - 1 - i];
+#else
+      std::memcpy(&value, bfr, sizeof(T));
+#endif
+      return value;
+    }
+
+    //! Copy a value to a little endian buffer.
+    template <typename T>
+    static void
+    writeLE(uint8_t* bfr, T value)
+    {
+#if defined(DUNE_CPU_BIG_ENDIAN)
+      const uint8_t* src = reinterpret_cast<const uint8_t*>(&value);
+      for (size_t i = 0; i < sizeof(T); ++i)
+        bfr[i] = src[sizeof(T) - 1 - i];
+#else
+      std::memcpy(bfr, &value, sizeof(T));
+#endif
+    }
+
+    Bathymetry::Bathymetry(void):
+      m_lat(0),
+      m_lon(0),
+      m_x0(0),
+      m_y0(0),
+      m_cell(1),
+      m_rows(0),
+      m_cols(0),
+      m_offset(0),
+      m_default(0),
+      m_depths(NULL)
+    { }
+
+    void
+    Bathymetry::load(const std::string& path)
+    {
+      m_depths = NULL;
+      m_buffer.clear();
+      m_file.open(path);
+
+      const uint8_t* data = m_file.getData();
+      if (m_file.getSize() < c_header_size || std::memcmp(data, c_magic, sizeof(c_magic)) != 0)
+        throw Error(path + ": not a bathymetry grid");
+
+      if (readLE<uint32_t>(data + 4) != c_version)
+        throw Error(path + ": unsupported version");
+
+      m_rows = readLE<uint32_t>(data + 8);
+      m_cols = readLE<uint32_t>(data + 12);
+      m_lat = readLE<double>(data + 16);
+      m_lon = readLE<double>(data + 24);
+      m_x0 = readLE<double>(data + 32);
+      m_y0 = readLE<double>(data + 40);
+      m_cell = readLE<double>(data + 48);
+
+      uint64_t nodes = (uint64_t)m_rows * m_cols;
+      if (m_rows < 2 || m_cols < 2 || nodes > c_max_nodes || !(m_cell > 0))
+        throw Error(path + ": invalid dimensions");
+
+      if (m_file.getSize() < c_header_size + nodes * sizeof(float))
+        throw Error(path + ": truncated");
+
+#if defined(DUNE_CPU_BIG_ENDIAN)
+      m_buffer.resize(nodes);
+      for (size_t i = 0; i < nodes; ++i)
+        m_buffer[i] = readLE<float>(data + c_header_size + i * sizeof(float));
+      m_file.close();
+      m_depths = &m_buffer[0];
+#else
+      // The mapping is page aligned and the header keeps the nodes aligned.
+      m_depths = reinterpret_cast<const float*>(data + c_header_size);
+#endif
+    }
+
+    void
+    Bathymetry::save(const std::string& path) const
+    {
+      if (isEmpty())
+        throw Error("no grid to save");
+
+      uint8_t header[c_header_size];
+      std::memset(header, 0, sizeof(header));
+      std::memcpy(header, c_magic, sizeof(c_magic));
+      writeLE<uint32_t>(header + 4, c_version);
+      writeLE<uint32_t>(header + 8, m_rows);
+      writeLE<uint32_t>(header + 12, m_cols);
+      writeLE<double>(header + 16, m_lat);
+      writeLE<double>(header + 24, m_lon);
+      writeLE<double>(header + 32, m_x0);
+      writeLE<double>(header + 40, m_y0);
+      writeLE<double>(header + 48, m_cell);
+
+      std::ofstream ofs(path.c_str(), std::ios::binary | std::ios::trunc);
+      ofs.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+      size_t nodes = (size_t)m_rows * m_cols;
+#if defined(DUNE_CPU_BIG_ENDIAN)
+      std::vector<uint8_t> bfr(nodes * sizeof(float));
+      for (size_t i = 0; i < nodes; ++i)
+        writeLE<float>(&bfr[i * sizeof(float)], m_depths[i]);
+      ofs.write(reinterpret_cast<const char*>(&bfr[0]), bfr.size());
+#else
+      ofs.write(reinterpret_cast<const char*>(m_depths), nodes * sizeof(float));
+#endif
+
+      ofs.close();
+      if (!ofs)
+        throw FileSystem::FileWriteError(path);
+    }
+
+    void
+    Bathymetry::create(double lat, double lon, const std::vector<Sample>& samples,
+                       double cell, double radius)
+    {
+      if (samples.empty())
+        throw Error("no samples");
+
+      if (!(cell > 0))
+        throw Error("invalid distance between nodes");
+
+      double x_min = samples[0].x;
+      double x_max = samples[0].x;
+      double y_min = samples[0].y;
+      double y_max = samples[0].y;
+      for (size_t i = 1; i < samples.size(); ++i)
+      {
+        x_min = std::min(x_min, samples[i].x);
+        x_max = std::max(x_max, samples[i].x);
+        y_min = std::min(y_min, samples[i].y);
+        y_max = std::max(y_max, samples[i].y);
+      }
+
+      double rows = std::floor((x_max - x_min) / cell) + 2;
+      double cols = std::floor((y_max - y_min) / cell) + 2;
+      if (rows * cols > (double)c_max_nodes)
+        throw Error("grid is too large");
+
+      m_file.close();
+      m_lat = lat;
+      m_lon = lon;
+      m_x0 = x_min;
+      m_y0 = y_min;
+      m_cell = cell;
+      m_rows = (unsigned)rows;
+      m_cols = (unsigned)cols;
+
+      // Sort the samples by the node below and to the left of them.
+      size_t nodes = (size_t)m_rows * m_cols;
+      std::vector<uint32_t> start(nodes + 1, 0);
+      std::vector<uint32_t> order(samples.size());
+      std::vector<uint32_t> node(samples.size());
+      for (size_t i = 0; i < samples.size(); ++i)
+      {
+        size_t r = (size_t)((samples[i].x - m_x0) / m_cell);
+        size_t c = (size_t)((samples[i].y - m_y0) / m_cell);
+        node[i] = (uint32_t)(r * m_cols + c);
+        ++start[node[i] + 1];
+      }
+
+      for (size_t i = 0; i < nodes; ++i)
+        start[i + 1] += start[i];
+
+      std::vector<uint32_t> fill(start.begin(), start.end() - 1);
+      for (size_t i = 0; i < samples.size(); ++i)
+        order[fill[node[i]]++] = (uint32_t)i;
+
+      // Inverse distance weighting of the samples near each node.
+      int reach = (int)std::ceil(radius / m_cell);
+      double radius_sqr = radius * radius;
+      m_buffer.assign(nodes, std::numeric_limits<float>::quiet_NaN());
+
+      for (int r = 0; r < (int)m_rows; ++r)
+      {
+        for (int c = 0; c < (int)m_cols; ++c)
+        {
+          double x = m_x0 + r * m_cell;
+          double y = m_y0 + c * m_cell;
+          double sum = 0;
+          double weights = 0;
+          bool exact = false;
+
+          int r_end = std::min(r + reach, (int)m_rows - 1);
+          int c_end = std::min(c + reach, (int)m_cols - 1);
+          for (int sr = std::max(r - reach - 1, 0); sr <= r_end && !exact; ++sr)
+          {
+            for (int sc = std::max(c - reach - 1, 0); sc <= c_end && !exact; ++sc)
+            {
+              size_t n = (size_t)sr * m_cols + sc;
+              for (uint32_t k = start[n]; k < start[n + 1]; ++k)
+              {
+                const Sample& s = samples[order[k]];
+                double d_sqr = (s.x - x) * (s.x - x) + (s.y - y) * (s.y - y);
+                if (d_sqr > radius_sqr)
+                  continue;
+
+                if (d_sqr < 1e-12)
+                {
+                  sum = s.depth;
+                  weights = 1;
+                  exact = true;
+                  break;
+                }
+
+                sum += s.depth / d_sqr;
+                weights += 1 / d_sqr;
+              }
+            }
+          }
+
+          if (weights > 0)
+            m_buffer[(size_t)r * m_cols + c] = (float)(sum / weights);
+        }
+      }
+
+      m_depths = &m_buffer[0];
+    }
+
+    void
+    Bathymetry::readSamples(const std::string& path, double& lat, double& lon,
+                            std::vector<Sample>& samples)
+    {
+      Parsers::Config cfg(path.c_str());
+      std::vector<std::string> lines;
+      cfg.get("Bathymetry", "Data", "", lines);
+      cfg.get("Bathymetry", "Latitude (degrees)", "0", lat);
+      cfg.get("Bathymetry", "Longitude (degrees)", "0", lon);
+
+      samples.clear();
+      samples.reserve(lines.size());
+      for (size_t i = 0; i < lines.size(); ++i)
+      {
+        std::vector<double> v;
+        Utils::String::split(lines[i], " ", v);
+        if (v.size() < 3)
+          continue;
+
+        Sample s = {v[0], v[1], v[2]};
+        samples.push_back(s);
+      }
+    }
+
+    double
+    Bathymetry::getDepth(double x, double y) const
+    {
+      if (m_depths == NULL)
+        return m_default;
+
+      double fr = (x - m_x0) / m_cell;
+      double fc = (y - m_y0) / m_cell;
+      if (!(fr >= 0 && fc >= 0 && fr <= m_rows - 1 && fc <= m_cols - 1))
+        return m_default;
+
+      unsigned r = std::min((unsigned)fr, m_rows - 2);
+      unsigned c = std::min((unsigned)fc, m_cols - 2);
+      double tr = fr - r;
+      double tc = fc - c;
+
+      const float* p = m_depths + (size_t)r * m_cols + c;
+      double d[4] = {p[0], p[1], p[m_cols], p[m_cols + 1]};
+      double w[4] = {(1 - tr) * (1 - tc), (1 - tr) * tc, tr * (1 - tc), tr * tc};
+
+      double sum = 0;
+      double weights = 0;
+      for (unsigned i = 0; i < 4; ++i)
+      {
+        // Nodes without data do not contribute.
+        if (!Math::isNaN(d[i]))
+        {
+          sum += w[i] * d[i];
+          weights += w[i];
+        }
+      }
+
+      if (weights <= 0)
+        return m_default;
+
+      return sum / weights + m_offset;
+    }
+
+    void
+    Bathymetry::getRanges(double x, double y, double z, const double (*dirs)[3],
+                          unsigned count, double max_range, double* ranges) const
+    {
+      // Height above the bottom at the previous step (negative once the
+      // bottom was reached).
+      std::vector<double> clearance(count, getDepth(x, y) - z);
+      for (unsigned i = 0; i < count; ++i)
+      {
+        ranges[i] = max_range;
+        if (clearance[i] <= 0)
+        {
+          ranges[i] = 0;
+          clearance[i] = -1;
+        }
+      }
+
+      double step = m_cell * 0.5;
+      double range = 0;
+      unsigned active = count;
+      while (active > 0 && range < max_range)
+      {
+        double prev = range;
+        range = std::min(range + step, max_range);
+        active = 0;
+
+        for (unsigned i = 0; i < count; ++i)
+        {
+          if (clearance[i] < 0)
+            continue;
+
+          double h = getDepth(x + range * dirs[i][0], y + range * dirs[i][1])
+          - (z + range * dirs[i][2]);
+          if (h <= 0)
+          {
+            ranges[i] = prev + (range - prev) * clearance[i] / (clearance[i] - h);
+            clearance[i] = -1;
+            continue;
+          }
+
+          clearance[i] = h;
+          ++active;
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,255 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+#ifndef DUNE_SIMULATION_BATHYMETRY_HPP_INCLUDED_
+#define DUNE_SIMULATION_BATHYMETRY_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/Config.hpp>
+#include <DUNE/FileSystem/MappedFile.hpp>
+
+namespace DUNE
+{
+  namespace Simulation
+  {
+    // Export DLL Symbol.
+    class DUNE_DLL_SYM Bathymetry;
+
+    //! Regular grid of depths, in meters, over north/east offsets
+    //! from a WGS-84 reference. Depths between grid nodes are
+    //! bilinearly interpolated.
+    //!
+    //! Grids are stored in a binary file that is memory mapped when
+    //! loaded, so that loading does not depend on the size of the
+    //! surveyed area. The file holds a 64 byte header followed by
+    //! the depth of every node as a 32-bit float, row by row, all in
+    //! little endian byte order. Nodes without data are NaN.
+    //!
+    //! | Offset | Type      | Description                      |
+    //! |--------|-----------|----------------------------------|
+    //! | 0      | char[4]   | "DBTY"                           |
+    //! | 4      | uint32_t  | Version (1)                      |
+    //! | 8      | uint32_t  | Number of rows (north)           |
+    //! | 12     | uint32_t  | Number of columns (east)         |
+    //! | 16     | double    | Reference latitude (degrees)     |
+    //! | 24     | double    | Reference longitude (degrees)    |
+    //! | 32     | double    | North offset of the first node   |
+    //! | 40     | double    | East offset of the first node    |
+    //! | 48     | double    | Distance between nodes (meters)  |
+    //! | 56     | uint8_t[8]| Reserved                         |
+    class Bathymetry
+    {
+    public:
+      //! Bathymetry error.
+      class Error: public std::runtime_error
+      {
+      public:
+        Error(const std::string& msg):
+          std::runtime_error("bathymetry error: " + msg)
+        { }
+      };
+
+      //! Depth sample.
+      struct Sample
+      {
+        //! North offset.
+        double x;
+        //! East offset.
+        double y;
+        //! Depth.
+        double depth;
+      };
+
+      //! Constructor.
+      Bathymetry(void);
+
+      //! Load a grid file.
+      //! @param path file path.
+      //! @throw Error if the file is not a valid grid.
+      void
+      load(const std::string& path);
+
+      //! Save the grid to a file.
+      //! @param path file path.
+      //! @throw FileSystem::FileWriteError if the file cannot be written.
+      void
+      save(const std::string& path) const;
+
+      //! Create a grid from scattered samples. Each node takes the
+      //! inverse distance weighted depth of the samples within a radius.
+      //! @param lat reference latitude (degrees).
+      //! @param lon reference longitude (degrees).
+      //! @param samples depth samples.
+      //! @param cell distance between nodes.
+      //! @param radius interpolation radius.
+      //! @throw Error if there are no samples or the grid is too large.
+      void
+      create(double lat, double lon, const std::vector<Sample>& samples,
+             double cell, double radius);
+
+      //! Read the samples of a bathymetry configuration file, with
+      //! the reference latitude and longitude (degrees) and one
+      //! "north east depth" sample per value of the 'Data' option of
+      //! the 'Bathymetry' section.
+      //! @param path file path.
+      //! @param lat reference latitude (degrees).
+      //! @param lon reference longitude (degrees).
+      //! @param samples depth samples.
+      static void
+      readSamples(const std::string& path, double& lat, double& lon,
+                  std::vector<Sample>& samples);
+
+      //! Set the offset added to every depth (e.g., tide level).
+      //! @param offset depth offset.
+      void
+      setOffset(double offset)
+      {
+        m_offset = offset;
+      }
+
+      //! Set the depth of points without data.
+      //! @param depth depth.
+      void
+      setDefaultDepth(double depth)
+      {
+        m_default = depth;
+      }
+
+      //! Test if the grid holds data.
+      bool
+      isEmpty(void) const
+      {
+        return m_depths == NULL;
+      }
+
+      //! Reference latitude (degrees).
+      double
+      getLatitude(void) const
+      {
+        return m_lat;
+      }
+
+      //! Reference longitude (degrees).
+      double
+      getLongitude(void) const
+      {
+        return m_lon;
+      }
+
+      //! Number of rows (north).
+      unsigned
+      getRows(void) const
+      {
+        return m_rows;
+      }
+
+      //! Number of columns (east).
+      unsigned
+      getColumns(void) const
+      {
+        return m_cols;
+      }
+
+      //! Distance between nodes.
+      double
+      getCellSize(void) const
+      {
+        return m_cell;
+      }
+
+      //! Compute the depth at a point.
+      //! @param x north offset.
+      //! @param y east offset.
+      //! @return depth, or the default depth if there is no data.
+      double
+      getDepth(double x, double y) const;
+
+      //! Compute the range to the bottom along a set of beams. Beams
+      //! are marched together, in steps of half the distance between
+      //! nodes, and the crossing is linearly interpolated.
+      //! @param x north offset of the origin.
+      //! @param y east offset of the origin.
+      //! @param z depth of the origin.
+      //! @param dirs unit direction of each beam (north, east, down).
+      //! @param count number of beams.
+      //! @param max_range maximum range.
+      //! @param ranges range of each beam (maximum range if the
+      //! bottom is not reached).
+      void
+      getRanges(double x, double y, double z, const double (*dirs)[3],
+                unsigned count, double max_range, double* ranges) const;
+
+      //! Compute the range to the bottom along a single beam.
+      //! @param x north offset of the origin.
+      //! @param y east offset of the origin.
+      //! @param z depth of the origin.
+      //! @param dir unit direction (north, east, down).
+      //! @param max_range maximum range.
+      //! @return range to the bottom or maximum range.
+      double
+      getRange(double x, double y, double z, const double dir[3], double max_range) const
+      {
+        double dirs[1][3] = {{dir[0], dir[1], dir[2]}};
+        double range;
+        getRanges(x, y, z, dirs, 1, max_range, &range);
+        return range;
+      }
+
+    private:
+      //! Reference latitude and longitude (degrees).
+      double m_lat;
+      double m_lon;
+      //! North and east offsets of the first node.
+      double m_x0;
+      double m_y0;
+      //! Distance between nodes.
+      double m_cell;
+      //! Number of rows and columns.
+      unsigned m_rows;
+      unsigned m_cols;
+      //! Depth offset.
+      double m_offset;
+      //! Depth of points without data.
+      double m_default;
+      //! Node depths.
+      const float* m_depths;
+      //! Mapped grid file.
+      FileSystem::MappedFile m_file;
+      //! Node depths, when not mapped from a file.
+      std::vector<float> m_buffer;
+    };
+  }
+}
+
+#endif
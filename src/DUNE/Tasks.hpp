@@ -41,7 +41,10 @@ namespace DUNE
 #include <DUNE/Tasks/Exceptions.hpp>
 #include <DUNE/Tasks/Consumer.hpp>
 #include <DUNE/Tasks/Periodic.hpp>
+#include <DUNE/Tasks/Executor.hpp>
+#include <DUNE/Tasks/LogSink.hpp>
 #include <DUNE/Tasks/Profiles.hpp>
+#include <DUNE/Tasks/Report.hpp>
 #include <DUNE/Tasks/Task.hpp>
 #include <DUNE/Tasks/Context.hpp>
 #include <DUNE/Tasks/Manager.hpp>
@@ -37,6 +37,7 @@
 // DUNE headers.
 #include <DUNE/Concurrency/Thread.hpp>
 #include <DUNE/IMC/Message.hpp>
+#include <DUNE/IMC/SharedMessage.hpp>
 
 namespace DUNE
 {
@@ -57,9 +58,24 @@ namespace DUNE
       { }
 
       //! Queue a message for later consumption.
-      //! @param msg message object.
+      //! @param msg shared message handle.
       virtual void
-      receive(const IMC::Message* msg) = 0;
+      receive(const IMC::SharedMessage& msg) = 0;
+
+      //! Queue a message for later consumption without waiting for
+      //! room in the queue.
+      //! @param msg shared message handle.
+      //! @param expired true if the producer stopped waiting, a
+      //! message that does not fit is then dropped.
+      //! @return false if the message did not fit and should be
+      //! offered again later, true otherwise.
+      virtual bool
+      tryReceive(const IMC::SharedMessage& msg, bool expired)
+      {
+        (void)expired;
+        receive(msg);
+        return true;
+      }
 
       //! Retrieve task name.
       //! @return task name.
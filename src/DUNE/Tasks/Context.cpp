@@ -37,7 +37,9 @@ namespace DUNE
 {
   namespace Tasks
   {
-    Context::Context(void)
+    Context::Context(void):
+      executor(NULL),
+      logs(NULL)
     {
       using FileSystem::Path;
 
@@ -40,6 +40,7 @@
 #include <DUNE/Entities/EntityDataBase.hpp>
 #include <DUNE/Utils/ByteBuffer.hpp>
 #include <DUNE/Tasks/Profiles.hpp>
+#include <DUNE/Tasks/Report.hpp>
 #include <DUNE/IMC/Bus.hpp>
 #include <DUNE/IMC/AddressResolver.hpp>
 
@@ -50,6 +51,10 @@ namespace DUNE
     // Export DLL Symbol.
     struct DUNE_DLL_SYM Context;
 
+    // Forward declarations.
+    class Executor;
+    class LogSink;
+
     //! This structure serves the purpose of joining useful objects,
     //! usually shared by a large number of classes (namely Tasks).
     struct Context
@@ -68,6 +73,8 @@ namespace DUNE
       Entities::EntityDataBase entities;
       //! Execution profiles.
       Profiles profiles;
+      //! Latest runtime statistics of tasks.
+      Report report;
       //! DUNE's directory.
       FileSystem::Path dir_app;
       //! Path to configuration directory.
@@ -88,6 +95,12 @@ namespace DUNE
       FileSystem::Path dir_scripts;
       //! UID of this instance.
       uint64_t uid;
+      //! Shared executor of periodic tasks (NULL if each task runs
+      //! in its own thread).
+      Executor* executor;
+      //! Asynchronous sink of log messages (NULL if messages are
+      //! written by the logging thread).
+      LogSink* logs;
     };
   }
 }
@@ -0,0 +1,239 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <algorithm>
+#include <cmath>
+
+// DUNE headers.
+#include <DUNE/Config.hpp>
+#include <DUNE/Concurrency/Thread.hpp>
+#include <DUNE/Tasks/Executor.hpp>
+#include <DUNE/Tasks/Periodic.hpp>
+#include <DUNE/Time/Clock.hpp>
+
+// POSIX headers.
+#if defined(DUNE_OS_LINUX) && defined(DUNE_SYS_HAS_PTHREAD_H)
+#  include <pthread.h>
+#  include <sched.h>
+#endif
+
+namespace DUNE
+{
+  namespace Tasks
+  {
+    //! Longest time a worker sleeps without checking for stop requests (s).
+    static const double c_max_sleep = 1.0;
+
+    class Executor::Worker: public Concurrency::Thread
+    {
+    public:
+      Worker(Executor& executor, int core):
+        m_executor(executor),
+        m_core(core)
+      { }
+
+    private:
+      //! Parent executor.
+      Executor& m_executor;
+      //! Processor core.
+      int m_core;
+
+      void
+      run(void)
+      {
+        m_executor.work(m_core);
+      }
+    };
+
+    Executor::Executor(unsigned threads, const std::vector<unsigned>& cores):
+      m_stopping(false)
+    {
+      for (unsigned i = 0; i < threads; ++i)
+      {
+        int core = cores.empty() ? -1 : (int)cores[i % cores.size()];
+        m_workers.push_back(new Worker(*this, core));
+        m_workers.back()->start();
+      }
+    }
+
+    Executor::~Executor(void)
+    {
+      m_cond.lock();
+      m_stopping = true;
+      m_cond.broadcast();
+      m_cond.unlock();
+
+      for (size_t i = 0; i < m_workers.size(); ++i)
+      {
+        m_workers[i]->stopAndJoin();
+        delete m_workers[i];
+      }
+
+      while (!m_timers.empty())
+      {
+        if (m_timers.top().entry->removed)
+          delete m_timers.top().entry;
+        m_timers.pop();
+      }
+
+      std::map<Periodic*, Entry*>::iterator itr = m_entries.begin();
+      for (; itr != m_entries.end(); ++itr)
+        delete itr->second;
+    }
+
+    void
+    Executor::add(Periodic* task)
+    {
+      Entry* entry = new Entry;
+      entry->task = task;
+      entry->deadline = Time::Clock::get() + 1.0 / task->getFrequency();
+      entry->queued = false;
+      entry->running = false;
+      entry->removed = false;
+
+      m_cond.lock();
+      m_entries[task] = entry;
+      schedule(entry);
+      m_cond.unlock();
+    }
+
+    void
+    Executor::remove(Periodic* task)
+    {
+      m_cond.lock();
+
+      std::map<Periodic*, Entry*>::iterator itr = m_entries.find(task);
+      if (itr != m_entries.end())
+      {
+        Entry* entry = itr->second;
+        m_entries.erase(itr);
+        entry->removed = true;
+
+        while (entry->running)
+          m_cond.wait();
+
+        // Queued entries are released by the worker that pops them.
+        if (!entry->queued)
+          delete entry;
+      }
+
+      m_cond.unlock();
+    }
+
+    void
+    Executor::schedule(Entry* entry)
+    {
+      Timer timer = {entry->deadline, entry};
+      entry->queued = true;
+      m_timers.push(timer);
+
+      // Wake a worker that may be sleeping past the new deadline.
+      m_cond.signal();
+    }
+
+    void
+    Executor::work(int core)
+    {
+#if defined(DUNE_OS_LINUX) && defined(DUNE_SYS_HAS_PTHREAD_H)
+      if (core >= 0)
+      {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(core, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+      }
+#else
+      (void)core;
+#endif
+
+      m_cond.lock();
+
+      while (!m_stopping)
+      {
+        double now = Time::Clock::get();
+
+        if (m_timers.empty())
+        {
+          m_cond.wait(c_max_sleep);
+          continue;
+        }
+
+        if (m_timers.top().deadline > now)
+        {
+          m_cond.wait(std::min(m_timers.top().deadline - now, c_max_sleep));
+          continue;
+        }
+
+        Entry* entry = m_timers.top().entry;
+        m_timers.pop();
+        entry->queued = false;
+
+        if (entry->removed)
+        {
+          delete entry;
+          continue;
+        }
+
+        // Another deadline may be due: let another worker take it.
+        if (!m_timers.empty())
+          m_cond.signal();
+
+        entry->running = true;
+        m_cond.unlock();
+
+        bool again = entry->task->runCycle(entry->deadline);
+
+        m_cond.lock();
+        entry->running = false;
+
+        if (entry->removed)
+        {
+          m_cond.broadcast();
+          continue;
+        }
+
+        if (!again)
+          continue;
+
+        // A deadline missed by less than one period is run right
+        // away; deadlines missed by more than one period are skipped.
+        double period = 1.0 / entry->task->getFrequency();
+        entry->deadline += period;
+        now = Time::Clock::get();
+        if (entry->deadline < now)
+          entry->deadline += std::floor((now - entry->deadline) / period) * period;
+
+        schedule(entry);
+      }
+
+      m_cond.unlock();
+    }
+  }
+}
@@ -0,0 +1,149 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+#ifndef DUNE_TASKS_EXECUTOR_HPP_INCLUDED_
+#define DUNE_TASKS_EXECUTOR_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <map>
+#include <queue>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/Config.hpp>
+#include <DUNE/Concurrency/Condition.hpp>
+
+namespace DUNE
+{
+  namespace Tasks
+  {
+    // Export DLL Symbol.
+    class DUNE_DLL_SYM Executor;
+
+    // Forward declarations.
+    class Periodic;
+
+    //! Runs the cycles of periodic tasks in a shared pool of
+    //! threads. Deadlines are kept in a timer queue ordered by time;
+    //! idle threads sleep until the earliest deadline and run the
+    //! cycle of its task. A task never runs in two threads at once.
+    //! A late cycle runs as soon as possible, but deadlines missed by
+    //! more than one period are skipped instead of being run back to
+    //! back.
+    class Executor
+    {
+    public:
+      //! Constructor.
+      //! @param threads number of threads.
+      //! @param cores processor cores to pin the threads to, in
+      //! turn (empty to let the system choose).
+      Executor(unsigned threads, const std::vector<unsigned>& cores);
+
+      //! Destructor. Stops all threads.
+      ~Executor(void);
+
+      //! Schedule a task, with its first cycle one period from now.
+      //! @param task periodic task.
+      void
+      add(Periodic* task);
+
+      //! Remove a task, waiting for a running cycle to finish.
+      //! @param task periodic task.
+      void
+      remove(Periodic* task);
+
+    private:
+      // Forward declaration.
+      class Worker;
+
+      //! Scheduled task.
+      struct Entry
+      {
+        //! Periodic task.
+        Periodic* task;
+        //! Next deadline.
+        double deadline;
+        //! Entry is in the timer queue.
+        bool queued;
+        //! Task cycle is running.
+        bool running;
+        //! Task was removed.
+        bool removed;
+      };
+
+      //! Timer queue element.
+      struct Timer
+      {
+        //! Deadline.
+        double deadline;
+        //! Scheduled task.
+        Entry* entry;
+
+        //! Order by earliest deadline first.
+        bool
+        operator<(const Timer& other) const
+        {
+          return deadline > other.deadline;
+        }
+      };
+
+      //! Lock and condition protecting the fields below.
+      Concurrency::Condition m_cond;
+      //! Timer queue.
+      std::priority_queue<Timer> m_timers;
+      //! Scheduled tasks.
+      std::map<Periodic*, Entry*> m_entries;
+      //! Executor is stopping.
+      bool m_stopping;
+      //! Worker threads.
+      std::vector<Worker*> m_workers;
+
+      //! Worker thread body.
+      //! @param core processor core to pin the thread to (negative
+      //! for any).
+      void
+      work(int core);
+
+      //! Add an entry to the timer queue. Must be called with the
+      //! condition locked.
+      //! @param entry scheduled task.
+      void
+      schedule(Entry* entry);
+
+      //! Non - copyable.
+      Executor(const Executor&);
+
+      //! Non - assignable.
+      Executor&
+      operator=(const Executor&);
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,461 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+// DUNE headers.
+#include <DUNE/I18N.hpp>
+#include <DUNE/Concurrency/ScopedCondition.hpp>
+#include <DUNE/Concurrency/ScopedMutex.hpp>
+#include <DUNE/Streams/Terminal.hpp>
+#include <DUNE/Tasks/AbstractTask.hpp>
+#include <DUNE/Tasks/Context.hpp>
+#include <DUNE/Tasks/LogSink.hpp>
+#include <DUNE/Time/Clock.hpp>
+
+namespace DUNE
+{
+  namespace Tasks
+  {
+    //! Maximum time between checks for repetition summaries (s).
+    static const double c_idle_period = 1.0;
+    //! Period of repetition summaries (s).
+    static const double c_summary_period = 5.0;
+    //! Context of the sink's own messages.
+    static const char* c_context = "Log Sink";
+
+    //! Token bucket of a call site.
+    struct Bucket
+    {
+      //! Available messages.
+      double tokens;
+      //! Time of the last update (s, negative if never).
+      double last;
+      //! Messages suppressed since the last admitted one.
+      unsigned suppressed;
+
+      Bucket(void):
+        tokens(0),
+        last(-1),
+        suppressed(0)
+      { }
+    };
+
+    struct LogSink::Ring
+    {
+      //! Entries (the size is a power of two).
+      std::vector<Entry> entries;
+      //! Mask of entry indices.
+      unsigned mask;
+      //! Next entry to write (advanced by the logging thread).
+      std::atomic<unsigned> head;
+      //! Next entry to read (advanced by the sink).
+      std::atomic<unsigned> tail;
+      //! Messages dropped because the ring was full.
+      std::atomic<uint64_t> dropped;
+      //! References held by the logging thread and by the sink.
+      std::atomic<unsigned> refs;
+      //! Rate limits per call site (used by the logging thread).
+      std::map<Key, Bucket> buckets;
+
+      Ring(unsigned size):
+        entries(size),
+        mask(size - 1)
+      {
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+        dropped.store(0, std::memory_order_relaxed);
+        refs.store(2, std::memory_order_relaxed);
+      }
+
+      //! Drop a reference, deleting the ring after the last one.
+      void
+      release(void)
+      {
+        if (refs.fetch_sub(1) == 1)
+          delete this;
+      }
+    };
+
+    //! Ring of the calling thread.
+    struct ThreadRing
+    {
+      //! Ring.
+      LogSink::Ring* ring;
+      //! Generation of the sink that owns the ring.
+      unsigned generation;
+
+      ThreadRing(void):
+        ring(NULL),
+        generation(0)
+      { }
+
+      ~ThreadRing(void)
+      {
+        if (ring != NULL)
+          ring->release();
+      }
+    };
+
+    //! Generation counter of sinks.
+    static std::atomic<unsigned> s_generation(0);
+    //! Ring of the calling thread.
+    static thread_local ThreadRing t_ring;
+
+    //! Order entries by time.
+    static bool
+    isEarlier(const LogSink::Entry* a, const LogSink::Entry* b)
+    {
+      return a->htime < b->htime;
+    }
+
+    LogSink::LogSink(Context& ctx, double rate, unsigned burst, unsigned ring_size):
+      m_ctx(ctx),
+      m_rate(rate),
+      m_burst(std::max(burst, 1u)),
+      m_ring_size(2),
+      m_generation(++s_generation)
+    {
+      while (m_ring_size < ring_size && m_ring_size < c_max_ring_size)
+        m_ring_size *= 2;
+
+      m_waiting.store(false);
+      m_written.store(0);
+      m_suppressed.store(0);
+      m_collapsed.store(0);
+      m_dropped.store(0);
+    }
+
+    LogSink::~LogSink(void)
+    {
+      if (isRunning())
+      {
+        stop();
+
+        {
+          Concurrency::ScopedCondition l(m_cond);
+          m_cond.signal();
+        }
+
+        join();
+      }
+
+      drain();
+      summarize(true);
+
+      for (size_t i = 0; i < m_rings.size(); ++i)
+        m_rings[i]->release();
+    }
+
+    LogSink::Ring*
+    LogSink::getRing(void)
+    {
+      if (t_ring.ring != NULL && t_ring.generation == m_generation)
+        return t_ring.ring;
+
+      if (t_ring.ring != NULL)
+        t_ring.ring->release();
+
+      t_ring.ring = new Ring(m_ring_size);
+      t_ring.generation = m_generation;
+
+      Concurrency::ScopedMutex l(m_rings_lock);
+      m_rings.push_back(t_ring.ring);
+      return t_ring.ring;
+    }
+
+    bool
+    LogSink::admit(const AbstractTask* task, const void* site, IMC::LogBookEntry::TypeEnum type,
+                   unsigned& suppressed)
+    {
+      suppressed = 0;
+      if (m_rate <= 0)
+        return true;
+
+      if (!isDroppable(type))
+        return true;
+
+      Bucket& bucket = getRing()->buckets[Key(task, site)];
+      double now = Time::Clock::get();
+
+      if (bucket.last < 0)
+        bucket.tokens = m_burst;
+      else
+        bucket.tokens = std::min(m_burst, bucket.tokens + (now - bucket.last) * m_rate);
+      bucket.last = now;
+
+      if (bucket.tokens < 1.0)
+      {
+        ++bucket.suppressed;
+        m_suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+
+      bucket.tokens -= 1.0;
+      suppressed = bucket.suppressed;
+      bucket.suppressed = 0;
+      return true;
+    }
+
+    LogSink::Entry*
+    LogSink::acquire(IMC::LogBookEntry::TypeEnum type)
+    {
+      Ring* ring = getRing();
+      unsigned head = ring->head.load(std::memory_order_relaxed);
+      if (head - ring->tail.load(std::memory_order_acquire) >= ring->entries.size())
+      {
+        if (isDroppable(type))
+          ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return NULL;
+      }
+
+      return &ring->entries[head & ring->mask];
+    }
+
+    void
+    LogSink::commit(void)
+    {
+      Ring* ring = t_ring.ring;
+      ring->head.store(ring->head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+      // Pairs with the fence in run(): either the sink sees the new
+      // entry or we see it waiting.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (m_waiting.load(std::memory_order_relaxed))
+      {
+        Concurrency::ScopedCondition l(m_cond);
+        m_cond.signal();
+      }
+    }
+
+    void
+    LogSink::getStatistics(Statistics& stats) const
+    {
+      stats.written = m_written.load(std::memory_order_relaxed);
+      stats.suppressed = m_suppressed.load(std::memory_order_relaxed);
+      stats.collapsed = m_collapsed.load(std::memory_order_relaxed);
+      stats.dropped = m_dropped.load(std::memory_order_relaxed);
+    }
+
+    bool
+    LogSink::pending(void)
+    {
+      Concurrency::ScopedMutex l(m_rings_lock);
+      for (size_t i = 0; i < m_rings.size(); ++i)
+      {
+        if (m_rings[i]->head.load(std::memory_order_acquire) != m_rings[i]->tail.load(std::memory_order_relaxed))
+          return true;
+      }
+
+      return false;
+    }
+
+    bool
+    LogSink::drain(void)
+    {
+      std::vector<Ring*> rings;
+      {
+        Concurrency::ScopedMutex l(m_rings_lock);
+        rings = m_rings;
+      }
+
+      std::vector<const Entry*> batch;
+      std::vector<unsigned> heads(rings.size());
+      uint64_t dropped = 0;
+
+      for (size_t i = 0; i < rings.size(); ++i)
+      {
+        unsigned tail = rings[i]->tail.load(std::memory_order_relaxed);
+        heads[i] = rings[i]->head.load(std::memory_order_acquire);
+        for (unsigned j = tail; j != heads[i]; ++j)
+          batch.push_back(&rings[i]->entries[j & rings[i]->mask]);
+
+        dropped += rings[i]->dropped.exchange(0, std::memory_order_relaxed);
+      }
+
+      // Entries of each thread are already in order.
+      std::stable_sort(batch.begin(), batch.end(), isEarlier);
+      for (size_t i = 0; i < batch.size(); ++i)
+        process(*batch[i]);
+
+      for (size_t i = 0; i < rings.size(); ++i)
+        rings[i]->tail.store(heads[i], std::memory_order_release);
+
+      if (dropped > 0)
+      {
+        m_dropped.fetch_add(dropped, std::memory_order_relaxed);
+
+        Entry entry;
+        entry.task = NULL;
+        entry.type = IMC::LogBookEntry::LBET_WARNING;
+        entry.entity = DUNE_IMC_CONST_UNK_EID;
+        entry.htime = Time::Clock::getSinceEpoch();
+        std::strncpy(entry.context, c_context, sizeof(entry.context));
+        std::snprintf(entry.text, sizeof(entry.text), DTR("dropped %llu messages"), (unsigned long long)dropped);
+        write(entry, entry.text);
+      }
+
+      // Forget rings of threads that have exited.
+      {
+        Concurrency::ScopedMutex l(m_rings_lock);
+        for (size_t i = 0; i < m_rings.size(); )
+        {
+          Ring* ring = m_rings[i];
+          if (ring->refs.load() == 1 && ring->head.load() == ring->tail.load())
+          {
+            m_rings.erase(m_rings.begin() + i);
+            ring->release();
+          }
+          else
+          {
+            ++i;
+          }
+        }
+      }
+
+      return !batch.empty();
+    }
+
+    void
+    LogSink::process(const Entry& entry)
+    {
+      Repeat& repeat = m_repeats[Key(entry.task, entry.site)];
+
+      if (repeat.last.site != NULL && entry.suppressed == 0
+          && std::strcmp(repeat.last.text, entry.text) == 0)
+      {
+        if (repeat.count++ == 0)
+          repeat.since = Time::Clock::get();
+        m_collapsed.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+
+      if (repeat.count > 0)
+      {
+        char text[c_text_size];
+        std::snprintf(text, sizeof(text), DTR("last message repeated %u times"), repeat.count);
+        write(repeat.last, text);
+      }
+
+      std::memcpy(&repeat.last, &entry, sizeof(entry));
+      repeat.count = 0;
+
+      if (entry.suppressed == 0)
+      {
+        write(entry, entry.text);
+        return;
+      }
+
+      char text[c_text_size];
+      std::snprintf(text, sizeof(text), DTR("%s (%u messages suppressed at call site %p \"%s\")"),
+                    entry.text, entry.suppressed, entry.site, entry.format);
+      write(entry, text);
+    }
+
+    void
+    LogSink::summarize(bool force)
+    {
+      double now = Time::Clock::get();
+
+      std::map<Key, Repeat>::iterator itr = m_repeats.begin();
+      for (; itr != m_repeats.end(); ++itr)
+      {
+        Repeat& repeat = itr->second;
+        if (repeat.count == 0)
+          continue;
+
+        if (!force && now - repeat.since < c_summary_period)
+          continue;
+
+        char text[c_text_size];
+        std::snprintf(text, sizeof(text), DTR("last message repeated %u times"), repeat.count);
+        write(repeat.last, text);
+        repeat.count = 0;
+      }
+    }
+
+    void
+    LogSink::write(const Entry& entry, const char* text)
+    {
+      IMC::LogBookEntry msg;
+      msg.setSource(m_ctx.resolver.id());
+      msg.setSourceEntity(entry.entity);
+      msg.setTimeStamp(entry.htime);
+      msg.type = entry.type;
+      msg.text = text;
+      msg.context = entry.context;
+      msg.htime = entry.htime;
+      m_ctx.mbus.dispatch(&msg, entry.task);
+
+      switch (entry.type)
+      {
+        case IMC::LogBookEntry::LBET_INFO:
+          DUNE_MSG(entry.context, text);
+          break;
+
+        case IMC::LogBookEntry::LBET_WARNING:
+          DUNE_WRN(entry.context, text);
+          break;
+
+        case IMC::LogBookEntry::LBET_ERROR:
+        case IMC::LogBookEntry::LBET_CRITICAL:
+          DUNE_ERR(entry.context, text);
+          break;
+
+        case IMC::LogBookEntry::LBET_DEBUG:
+          DUNE_DEV(entry.context, text);
+          break;
+      }
+
+      m_written.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void
+    LogSink::run(void)
+    {
+      while (!isStopping())
+      {
+        if (!drain())
+        {
+          Concurrency::ScopedCondition l(m_cond);
+          m_waiting.store(true);
+          std::atomic_thread_fence(std::memory_order_seq_cst);
+          if (!isStopping() && !pending())
+            m_cond.wait(c_idle_period);
+          m_waiting.store(false, std::memory_order_relaxed);
+        }
+
+        summarize(false);
+      }
+    }
+  }
+}
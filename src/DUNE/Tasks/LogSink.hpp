@@ -0,0 +1,257 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+#ifndef DUNE_TASKS_LOG_SINK_HPP_INCLUDED_
+#define DUNE_TASKS_LOG_SINK_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <cstddef>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// ISO C++ 11 headers.
+#include <atomic>
+
+// DUNE headers.
+#include <DUNE/Config.hpp>
+#include <DUNE/IMC/Definitions.hpp>
+#include <DUNE/Concurrency/Thread.hpp>
+#include <DUNE/Concurrency/Condition.hpp>
+#include <DUNE/Concurrency/Mutex.hpp>
+
+namespace DUNE
+{
+  namespace Tasks
+  {
+    // Export DLL Symbol.
+    class DUNE_DLL_SYM LogSink;
+
+    // Forward declarations.
+    class AbstractTask;
+    struct Context;
+
+    //! Writes task log messages in the background. Each logging
+    //! thread formats messages directly into its own ring of entries,
+    //! without taking locks; a single thread drains all rings,
+    //! dispatches LogBookEntry messages and writes to the terminal.
+    //! Optionally, informational and debug messages of a call site
+    //! (task and address of the logging call) are rate limited with
+    //! a token bucket before being formatted; warnings and errors
+    //! are never rate limited. Consecutive identical messages of a
+    //! call site are collapsed into a "last message repeated N
+    //! times" summary. When a ring is full new informational and
+    //! debug messages are dropped instead of blocking, while
+    //! warnings and errors are written by the logging thread itself.
+    class LogSink: public Concurrency::Thread
+    {
+    public:
+      //! Maximum size of a message.
+      static const size_t c_text_size = 1024;
+      //! Maximum size of a context name.
+      static const size_t c_context_size = 64;
+      //! Default number of entries of the ring of each thread.
+      static const unsigned c_default_ring_size = 128;
+      //! Maximum number of entries of the ring of each thread.
+      static const unsigned c_max_ring_size = 65536;
+
+      // Forward declarations.
+      struct Ring;
+
+      //! Log message.
+      struct Entry
+      {
+        //! Originating task (does not receive the message).
+        AbstractTask* task;
+        //! Call site (address of the logging call).
+        const void* site;
+        //! Format string.
+        const char* format;
+        //! Message type.
+        IMC::LogBookEntry::TypeEnum type;
+        //! Source entity.
+        unsigned entity;
+        //! Messages of the call site suppressed before this one.
+        unsigned suppressed;
+        //! Time of the message (s since the epoch).
+        double htime;
+        //! Context (task name).
+        char context[c_context_size];
+        //! Text.
+        char text[c_text_size];
+      };
+
+      //! Sink statistics.
+      struct Statistics
+      {
+        //! Messages written.
+        uint64_t written;
+        //! Messages suppressed by the rate limit.
+        uint64_t suppressed;
+        //! Messages collapsed into repetition summaries.
+        uint64_t collapsed;
+        //! Messages dropped because a ring was full.
+        uint64_t dropped;
+      };
+
+      //! Constructor.
+      //! @param ctx context.
+      //! @param rate sustained number of messages per second of a
+      //! call site (zero to disable rate limiting).
+      //! @param burst number of messages of a call site allowed in a
+      //! burst.
+      //! @param ring_size number of entries of the ring of each
+      //! thread (rounded up to a power of two).
+      LogSink(Context& ctx, double rate = 0, unsigned burst = 1,
+              unsigned ring_size = c_default_ring_size);
+
+      //! Destructor. Writes all pending messages.
+      ~LogSink(void);
+
+      //! Check the rate limit of a call site. Must be called before
+      //! formatting a message. Warnings, errors and critical errors
+      //! are always admitted.
+      //! @param task originating task.
+      //! @param site call site (address of the logging call).
+      //! @param type message type.
+      //! @param[out] suppressed messages of the call site suppressed
+      //! since the last admitted one.
+      //! @return true if the message may be logged, false otherwise.
+      bool
+      admit(const AbstractTask* task, const void* site, IMC::LogBookEntry::TypeEnum type,
+            unsigned& suppressed);
+
+      //! Test if messages of a type may be rate limited or dropped.
+      //! Only informational and debug messages may.
+      //! @param type message type.
+      //! @return true if messages may be dropped, false otherwise.
+      static bool
+      isDroppable(IMC::LogBookEntry::TypeEnum type)
+      {
+        return type == IMC::LogBookEntry::LBET_INFO || type == IMC::LogBookEntry::LBET_DEBUG;
+      }
+
+      //! Reserve an entry in the ring of the calling thread.
+      //! @param type message type.
+      //! @return entry to fill or NULL if the ring is full. Messages
+      //! that cannot be dropped must then be written by the caller.
+      Entry*
+      acquire(IMC::LogBookEntry::TypeEnum type);
+
+      //! Publish the entry returned by the last call to acquire().
+      void
+      commit(void);
+
+      //! Retrieve sink statistics.
+      //! @param[out] stats statistics.
+      void
+      getStatistics(Statistics& stats) const;
+
+    private:
+      //! Repetitions of the last message of a call site.
+      struct Repeat
+      {
+        //! Last message written.
+        Entry last;
+        //! Number of identical messages since.
+        unsigned count;
+        //! Time of the last summary (s).
+        double since;
+      };
+
+      //! Call site key.
+      typedef std::pair<const AbstractTask*, const void*> Key;
+
+      //! Context.
+      Context& m_ctx;
+      //! Sustained rate of a call site (messages per second).
+      double m_rate;
+      //! Burst size of a call site.
+      double m_burst;
+      //! Number of entries of each ring.
+      unsigned m_ring_size;
+      //! Generation of this sink.
+      unsigned m_generation;
+      //! Rings of logging threads.
+      std::vector<Ring*> m_rings;
+      //! Protects m_rings.
+      Concurrency::Mutex m_rings_lock;
+      //! Repetitions per call site.
+      std::map<Key, Repeat> m_repeats;
+      //! Wakes the sink.
+      Concurrency::Condition m_cond;
+      //! True while the sink is waiting for messages.
+      std::atomic<bool> m_waiting;
+      //! Messages written.
+      std::atomic<uint64_t> m_written;
+      //! Messages suppressed.
+      std::atomic<uint64_t> m_suppressed;
+      //! Messages collapsed.
+      std::atomic<uint64_t> m_collapsed;
+      //! Messages dropped.
+      std::atomic<uint64_t> m_dropped;
+
+      //! Retrieve the ring of the calling thread.
+      Ring*
+      getRing(void);
+
+      //! Test if any ring holds messages.
+      bool
+      pending(void);
+
+      //! Write all pending messages.
+      //! @return true if any message was written.
+      bool
+      drain(void);
+
+      //! Collapse or write a message.
+      //! @param entry message.
+      void
+      process(const Entry& entry);
+
+      //! Write repetition summaries.
+      //! @param force true to write all, false to write only
+      //! summaries older than the summary period.
+      void
+      summarize(bool force);
+
+      //! Dispatch and print a message.
+      //! @param entry message header.
+      //! @param text message text.
+      void
+      write(const Entry& entry, const char* text);
+
+      void
+      run(void);
+    };
+  }
+}
+
+#endif
@@ -29,14 +29,19 @@
 
 // ISO C++ 98 headers.
 #include <stdexcept>
+#include <sstream>
 #include <string>
 #include <vector>
 #include <algorithm>
 #include <cstddef>
 
 // DUNE headers.
+#include <DUNE/Time/Clock.hpp>
 #include <DUNE/Time/Delay.hpp>
 #include <DUNE/Tasks/Task.hpp>
+#include <DUNE/Tasks/Periodic.hpp>
+#include <DUNE/Tasks/Executor.hpp>
+#include <DUNE/Tasks/LogSink.hpp>
 #include <DUNE/Tasks/Context.hpp>
 #include <DUNE/Tasks/Factory.hpp>
 #include <DUNE/Tasks/Exceptions.hpp>
@@ -48,6 +53,19 @@ namespace DUNE
   {
     static const int c_high_task_cpu_usage = 10;
 
+    //! Write a histogram as a JSON array.
+    //! @param os output stream.
+    //! @param bins histogram bins.
+    //! @param count number of bins.
+    static void
+    writeHistogram(std::ostream& os, const unsigned* bins, unsigned count)
+    {
+      os << "[";
+      for (unsigned i = 0; i < count; ++i)
+        os << (i > 0 ? ", " : "") << bins[i];
+      os << "]";
+    }
+
     struct TaskCpuUsage
     {
       //! Task name.
@@ -63,8 +81,39 @@ namespace DUNE
     };
 
     Manager::Manager(Context& ctx):
-      m_ctx(ctx)
+      m_ctx(ctx),
+      m_profile_time(Time::Clock::getRT()),
+      m_executor(NULL),
+      m_logs(NULL)
     {
+      // Log messages may be written by a background thread. Rate
+      // limiting of informational and debug messages is opt-in.
+      bool async_logs = true;
+      double log_rate = 0;
+      unsigned log_burst = 0;
+      unsigned log_ring_size = 0;
+      m_ctx.config.get("General", "Logging - Asynchronous", "true", async_logs);
+      m_ctx.config.get("General", "Logging - Rate Limit", "0", log_rate);
+      m_ctx.config.get("General", "Logging - Rate Burst", "20", log_burst);
+      m_ctx.config.get("General", "Logging - Ring Size", "128", log_ring_size);
+      if (async_logs)
+      {
+        m_logs = new LogSink(m_ctx, log_rate, log_burst, log_ring_size);
+        m_logs->start();
+        m_ctx.logs = m_logs;
+      }
+
+      // Periodic tasks may share a pool of threads.
+      unsigned threads = 0;
+      std::vector<unsigned> cores;
+      m_ctx.config.get("General", "Periodic Tasks - Executor Threads", "0", threads);
+      m_ctx.config.get("General", "Periodic Tasks - Executor Cores", "", cores);
+      if (threads > 0)
+      {
+        m_executor = new Executor(threads, cores);
+        m_ctx.executor = m_executor;
+      }
+
       // Get all sections.
       std::vector<std::string> vec = m_ctx.config.sections();
 
@@ -131,9 +180,23 @@ namespace DUNE
 
         if (m_tasks[m_list[i]]->isCreated())
           join(m_list[i]);
+      }
+
+      // Write pending log messages while their tasks still exist.
+      m_ctx.logs = NULL;
+      delete m_logs;
+
+      for (unsigned int i = 0; i < m_list.size(); ++i)
+      {
+        if (m_tasks.find(m_list[i]) == m_tasks.end())
+          continue;
+
         delete m_tasks[m_list[i]];
         m_tasks[m_list[i]] = NULL;
       }
+
+      m_ctx.executor = NULL;
+      delete m_executor;
     }
 
     void
@@ -234,6 +297,133 @@ namespace DUNE
       }
     }
 
+    void
+    Manager::reportQueueStates(void)
+    {
+      std::map<std::string, Task*>::const_iterator itr = m_tasks.begin();
+
+      for ( ; itr != m_tasks.end(); ++itr)
+      {
+        Task* task = itr->second;
+        Recipient::Statistics stats;
+        task->getQueueStatistics(stats);
+
+        std::ostringstream os;
+        os << "{\"capacity\": " << stats.capacity
+           << ", \"depth\": " << stats.depth
+           << ", \"peak\": " << stats.peak
+           << ", \"dropped\": " << stats.dropped
+           << ", \"coalesced\": " << stats.coalesced
+           << "}";
+        m_ctx.report.set(itr->first, "queue", os.str());
+      }
+    }
+
+    void
+    Manager::reportTimingStates(void)
+    {
+      std::map<std::string, Task*>::const_iterator itr = m_tasks.begin();
+
+      for ( ; itr != m_tasks.end(); ++itr)
+      {
+        Periodic* task = dynamic_cast<Periodic*>(itr->second);
+        if (task == NULL)
+          continue;
+
+        Periodic::TimingStatistics stats;
+        task->getTimingStatistics(stats);
+
+        double jitter_mean = stats.runs ? stats.jitter_sum / stats.runs : 0;
+        double exec_mean = stats.runs ? stats.exec_sum / stats.runs : 0;
+
+        std::ostringstream os;
+        os << "{\"period\": " << 1.0 / task->getFrequency()
+           << ", \"runs\": " << stats.runs
+           << ", \"overruns\": " << stats.overruns
+           << ", \"jitter_mean\": " << jitter_mean
+           << ", \"jitter_max\": " << stats.jitter_max
+           << ", \"exec_mean\": " << exec_mean
+           << ", \"exec_max\": " << stats.exec_max
+           << ", \"histogram\": ";
+        writeHistogram(os, stats.exec_hist, Periodic::c_exec_bins);
+        os << "}";
+        m_ctx.report.set(itr->first, "timing", os.str());
+      }
+    }
+
+    void
+    Manager::reportProfiles(void)
+    {
+      double now = Time::Clock::getRT();
+      double period = now - m_profile_time;
+      m_profile_time = now;
+
+      std::map<std::string, Task*>::const_iterator itr = m_tasks.begin();
+
+      for ( ; itr != m_tasks.end(); ++itr)
+      {
+        Task* task = itr->second;
+
+        // CPU time consumed by the task thread since the last report.
+        double cpu_time = task->getCpuTime();
+        double& last_cpu_time = m_cpu_times[itr->first];
+        double cpu_delta = -1;
+        if (cpu_time >= 0)
+        {
+          cpu_delta = cpu_time - last_cpu_time;
+          last_cpu_time = cpu_time;
+        }
+
+        Recipient::Statistics qstats;
+        task->getQueueStatistics(qstats);
+
+        Task::DispatchStatistics dstats;
+        task->getDispatchStatistics(dstats);
+
+        task->getCallbackStatistics(m_callback_stats);
+
+        unsigned callbacks = 0;
+        double callback_time = 0;
+        for (size_t i = 0; i < m_callback_stats.size(); ++i)
+        {
+          callbacks += m_callback_stats[i].calls;
+          callback_time += m_callback_stats[i].time_sum;
+        }
+
+        std::ostringstream os;
+        os << "{\"period\": " << period
+           << ", \"cpu_time\": ";
+        if (cpu_delta < 0)
+          os << "null";
+        else
+          os << cpu_delta;
+        os << ", \"queue_peak\": " << qstats.peak
+           << ", \"dispatched\": " << dstats.dispatched
+           << ", \"deliveries\": " << dstats.deliveries
+           << ", \"fanout_max\": " << dstats.fanout_max
+           << ", \"callbacks\": " << callbacks
+           << ", \"callback_time\": " << callback_time
+           << ", \"messages\": {";
+
+        for (size_t i = 0; i < m_callback_stats.size(); ++i)
+        {
+          const Recipient::CallbackStatistics& cs = m_callback_stats[i];
+          if (i > 0)
+            os << ", ";
+          os << "\"" << IMC::Factory::getAbbrevFromId(cs.id) << "\": {"
+             << "\"calls\": " << cs.calls
+             << ", \"time_mean\": " << cs.time_sum / cs.calls
+             << ", \"time_max\": " << cs.time_max
+             << ", \"histogram\": ";
+          writeHistogram(os, cs.time_hist, Recipient::c_callback_bins);
+          os << "}";
+        }
+
+        os << "}}";
+        m_ctx.report.set(itr->first, "profile", os.str());
+      }
+    }
+
     void
     Manager::adjustPriorities(void)
     {
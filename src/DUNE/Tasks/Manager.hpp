@@ -47,6 +47,8 @@ namespace DUNE
 
     // Forward declarations
     struct Context;
+    class Executor;
+    class LogSink;
     class Task;
 
     class Manager
@@ -110,6 +112,23 @@ namespace DUNE
       void
       adjustPriorities(void);
 
+      //! Publish the state of the incoming message queue of each task
+      //! in the task report.
+      void
+      reportQueueStates(void);
+
+      //! Publish the execution timing statistics of each periodic task
+      //! (mean/maximum jitter and execution time, and the execution
+      //! time histogram) in the task report ("timing" section).
+      void
+      reportTimingStates(void);
+
+      //! Publish the CPU time, dispatch fan-out and per message type
+      //! callback profile of each task in the task report ("profile"
+      //! section).
+      void
+      reportProfiles(void);
+
     private:
       struct TaskCpuUsage
       {
@@ -135,6 +154,16 @@ namespace DUNE
       std::priority_queue<TaskCpuUsage> m_cpu_usage_hogs;
       //! Buffer message to dispatch CPU usage of tasks.
       IMC::CpuUsage m_task_cpu_usage;
+      //! CPU time of each task at the last profile report.
+      std::map<std::string, double> m_cpu_times;
+      //! Time of the last profile report (host clock).
+      double m_profile_time;
+      //! Buffer of callback statistics.
+      std::vector<Recipient::CallbackStatistics> m_callback_stats;
+      //! Shared executor of periodic tasks.
+      Executor* m_executor;
+      //! Asynchronous sink of log messages.
+      LogSink* m_logs;
 
       void
       createTask(const std::string& section);
@@ -28,11 +28,16 @@
 //***************************************************************************
 
 // ISO C++ 98 headers.
+#include <algorithm>
 #include <iomanip>
 #include <cmath>
+#include <cstring>
 
 // DUNE headers.
+#include <DUNE/Concurrency/ScopedCondition.hpp>
+#include <DUNE/Concurrency/ScopedMutex.hpp>
 #include <DUNE/IMC/Bus.hpp>
+#include <DUNE/Tasks/Executor.hpp>
 #include <DUNE/Tasks/Context.hpp>
 #include <DUNE/Tasks/Periodic.hpp>
 #include <DUNE/Time/Clock.hpp>
@@ -47,15 +52,104 @@ namespace DUNE
       m_run_count(0),
       m_run_time(0)
     {
+      std::memset(&m_timing, 0, sizeof(m_timing));
+
       param(DTR_RT("Execution Frequency"), m_frequency)
       .units(Units::Hertz)
       .defaultValue("1.0")
       .description(DTR("Frequency at which task is executed"));
+
+      param(DTR_RT("Dedicated Thread"), m_dedicated)
+      .visibility(Parameter::VISIBILITY_DEVELOPER)
+      .defaultValue("false")
+      .description(DTR("Run the task in its own thread when periodic tasks share an executor"));
+    }
+
+    void
+    Periodic::getTimingStatistics(TimingStatistics& stats)
+    {
+      Concurrency::ScopedMutex l(m_timing_lock);
+      stats = m_timing;
+      std::memset(&m_timing, 0, sizeof(m_timing));
+    }
+
+    void
+    Periodic::updateTiming(double deadline, double start, double end)
+    {
+      double exec = end - start;
+      double jitter = std::fabs(start - deadline);
+
+      unsigned bin = 0;
+      for (double limit = 100e-6; bin < c_exec_bins - 1 && exec >= limit; limit *= 10)
+        ++bin;
+
+      Concurrency::ScopedMutex l(m_timing_lock);
+      ++m_timing.runs;
+      if (end > deadline + 1.0 / m_frequency)
+        ++m_timing.overruns;
+      m_timing.jitter_sum += jitter;
+      m_timing.jitter_max = std::max(m_timing.jitter_max, jitter);
+      m_timing.exec_sum += exec;
+      m_timing.exec_max = std::max(m_timing.exec_max, exec);
+      ++m_timing.exec_hist[bin];
+    }
+
+    bool
+    Periodic::runCycle(double deadline)
+    {
+      if (stopping())
+        return false;
+
+      try
+      {
+        m_run_time = Time::Clock::get();
+        consumeMessages();
+        if (!stopping())
+        {
+          task();
+          ++m_run_count;
+        }
+
+        updateTiming(deadline, m_run_time, Time::Clock::get());
+        return true;
+      }
+      catch (...)
+      {
+        // Hand the exception over to the task thread.
+        Concurrency::ScopedCondition l(m_failure_cond);
+        m_failure = std::current_exception();
+        m_failure_cond.signal();
+        return false;
+      }
+    }
+
+    void
+    Periodic::runInExecutor(void)
+    {
+      m_failure = std::exception_ptr();
+      m_run_time = Time::Clock::get();
+      m_ctx.executor->add(this);
+
+      m_failure_cond.lock();
+      while (!stopping() && !m_failure)
+        m_failure_cond.wait(1.0);
+      m_failure_cond.unlock();
+
+      m_ctx.executor->remove(this);
+
+      if (m_failure)
+        std::rethrow_exception(m_failure);
     }
 
     void
     Periodic::onMain(void)
     {
+      if (m_ctx.executor != NULL && !m_dedicated)
+      {
+        runInExecutor();
+        return;
+      }
+
       double now = Time::Clock::get();
       double delay = (1 / m_frequency);
       double next_inv = now + delay;
@@ -68,6 +162,7 @@ namespace DUNE
         if (next_inv > now)
           Time::Delay::wait(next_inv - now);
 
+        double deadline = next_inv;
         next_inv += delay;
         now = Time::Clock::get();
         m_run_time = now;
@@ -81,6 +176,7 @@ namespace DUNE
         }
 
         now = Time::Clock::get();
+        updateTiming(deadline, m_run_time, now);
       }
     }
   }
@@ -36,7 +36,12 @@
 #include <vector>
 #include <string>
 
+// ISO C++ 11 headers.
+#include <exception>
+
 // Local headers.
+#include <DUNE/Concurrency/Condition.hpp>
+#include <DUNE/Concurrency/Mutex.hpp>
 #include <DUNE/Tasks/Task.hpp>
 
 namespace DUNE
@@ -48,11 +53,35 @@ namespace DUNE
 
     // Forward declarations
     struct Context;
+    class Executor;
 
     //! Periodic task.
     class Periodic: public Task
     {
     public:
+      //! Number of execution time histogram bins. Bin i counts runs
+      //! shorter than 100 us * 10^i, the last bin counts the rest.
+      static const unsigned c_exec_bins = 5;
+
+      //! Execution timing statistics.
+      struct TimingStatistics
+      {
+        //! Number of runs.
+        unsigned runs;
+        //! Number of runs that ended after the next deadline.
+        unsigned overruns;
+        //! Sum of start delays relative to the deadline (s).
+        double jitter_sum;
+        //! Maximum start delay (s).
+        double jitter_max;
+        //! Sum of execution times (s).
+        double exec_sum;
+        //! Maximum execution time (s).
+        double exec_max;
+        //! Execution time histogram.
+        unsigned exec_hist[c_exec_bins];
+      };
+
       //! Constructor.
       Periodic(const std::string& name, Context& ctx);
 
@@ -95,21 +124,58 @@ namespace DUNE
         return m_run_count;
       }
 
+      //! Retrieve and reset execution timing statistics.
+      //! @param stats statistics since the last call.
+      void
+      getTimingStatistics(TimingStatistics& stats);
+
       //! The task to be executed on each cycle.
       virtual void
       task(void) = 0;
 
     private:
+      // The executor runs cycles.
+      friend class Executor;
+
       //! Number of executions thus far.
       unsigned m_run_count;
       //! Time of last run.
       double m_run_time;
       //! Task frequency (Hz).
       double m_frequency;
+      //! Run in a dedicated thread even if there is a shared executor.
+      bool m_dedicated;
+      //! Execution timing statistics.
+      TimingStatistics m_timing;
+      //! Lock protecting m_timing.
+      Concurrency::Mutex m_timing_lock;
+      //! Signals the failure of a cycle run by the executor.
+      Concurrency::Condition m_failure_cond;
+      //! Exception thrown by a cycle run by the executor.
+      std::exception_ptr m_failure;
 
       //! Task entry point.
       void
       onMain(void);
+
+      //! Run cycles in the shared executor until the task stops or a
+      //! cycle fails.
+      void
+      runInExecutor(void);
+
+      //! Run one cycle: consume messages and execute the task.
+      //! Called by the executor.
+      //! @param deadline cycle deadline (monotonic clock).
+      //! @return true to schedule the next cycle, false otherwise.
+      bool
+      runCycle(double deadline);
+
+      //! Update execution timing statistics.
+      //! @param deadline cycle deadline.
+      //! @param start cycle start time.
+      //! @param end cycle end time.
+      void
+      updateTiming(double deadline, double start, double end);
     };
   }
 }
@@ -28,90 +28,418 @@
 //***************************************************************************
 
 // ISO C++ 98 headers.
+#include <algorithm>
 #include <cstddef>
 
 // DUNE headers.
+#include <DUNE/Concurrency/ScopedCondition.hpp>
+#include <DUNE/Concurrency/ScopedMutex.hpp>
 #include <DUNE/IMC/Bus.hpp>
 #include <DUNE/IMC/Factory.hpp>
 #include <DUNE/Tasks/Context.hpp>
 #include <DUNE/Tasks/Recipient.hpp>
+#include <DUNE/Time/Clock.hpp>
 
 namespace DUNE
 {
   namespace Tasks
   {
+    //! Maximum time a producer waits for room in a full queue (s).
+    static const double c_block_timeout = 0.1;
+
     Recipient::Recipient(AbstractTask* task, Context& ctx):
       m_task(task),
-      m_ctx(ctx)
+      m_ctx(ctx),
+      m_mqueue(new Concurrency::LockFreeQueue<Entry>(c_default_capacity)),
+      m_coalesced_size(0),
+      m_policy(OP_DROP_OLDEST),
+      m_waiting(false),
+      m_wake_up(false),
+      m_blocked(0),
+      m_seq(0),
+      m_dropped(0),
+      m_coalesced_count(0),
+      m_peak(0)
     { }
 
     Recipient::~Recipient(void)
     {
       unbindAll();
+      delete m_mqueue;
 
-      while (!m_mqueue.empty())
-      {
-        IMC::Message* msg = m_mqueue.pop();
-        if (msg)
-          delete msg;
-      }
+      std::map<uint32_t, Binding>::iterator itr = m_cbacks.begin();
+      for (; itr != m_cbacks.end(); ++itr)
+        delete itr->second.profile;
     }
 
     void
     Recipient::unbindAll(void)
     {
-      std::map<uint32_t, std::vector<AbstractConsumer*> >::iterator itr = m_cbacks.begin();
+      std::map<uint32_t, Binding>::iterator itr = m_cbacks.begin();
 
       for (; itr != m_cbacks.end(); ++itr)
       {
         m_ctx.mbus.unregisterRecipient(m_task, itr->first);
 
-        for (size_t i = 0; i < itr->second.size(); ++i)
-          delete itr->second[i];
+        for (size_t i = 0; i < itr->second.consumers.size(); ++i)
+          delete itr->second.consumers[i];
 
-        itr->second.clear();
+        itr->second.consumers.clear();
       }
     }
 
     void
     Recipient::bind(uint32_t id, AbstractConsumer* consumer)
     {
-      std::map<uint32_t, std::vector<AbstractConsumer*> >::iterator itr = m_cbacks.find(id);
+      std::map<uint32_t, Binding>::iterator itr = m_cbacks.find(id);
       if (itr == m_cbacks.end())
+      {
         m_ctx.mbus.registerRecipient(m_task, id);
 
-      m_cbacks[id].push_back(consumer);
+        Binding binding;
+        binding.profile = new Profile;
+        binding.profile->calls.store(0, std::memory_order_relaxed);
+        binding.profile->time_sum.store(0, std::memory_order_relaxed);
+        binding.profile->time_max.store(0, std::memory_order_relaxed);
+        for (unsigned i = 0; i < c_callback_bins; ++i)
+          binding.profile->time_hist[i].store(0, std::memory_order_relaxed);
+
+        Concurrency::ScopedMutex l(m_cbacks_lock);
+        itr = m_cbacks.insert(std::make_pair(id, binding)).first;
+      }
+
+      itr->second.consumers.push_back(consumer);
+    }
+
+    void
+    Recipient::setCapacity(unsigned capacity)
+    {
+      if (capacity == 0)
+        return;
+
+      size_t size = 2;
+      while (size < capacity)
+        size <<= 1;
+
+      if (size == m_mqueue->getCapacity())
+        return;
+
+      Concurrency::LockFreeQueue<Entry>* queue = new Concurrency::LockFreeQueue<Entry>(capacity);
+      Entry entry;
+      while (m_mqueue->tryPop(entry))
+      {
+        if (!queue->tryPush(entry))
+          m_dropped.fetch_add(1, std::memory_order_relaxed);
+      }
+
+      delete m_mqueue;
+      m_mqueue = queue;
+    }
+
+    void
+    Recipient::getStatistics(Statistics& stats) const
+    {
+      stats.capacity = m_mqueue->getCapacity();
+      stats.depth = pending();
+      stats.peak = m_peak.load(std::memory_order_relaxed);
+      stats.dropped = m_dropped.load(std::memory_order_relaxed);
+      stats.coalesced = m_coalesced_count.load(std::memory_order_relaxed);
+    }
+
+    void
+    Recipient::getCallbackStatistics(std::vector<CallbackStatistics>& stats)
+    {
+      stats.clear();
+
+      Concurrency::ScopedMutex l(m_cbacks_lock);
+      std::map<uint32_t, Binding>::const_iterator itr = m_cbacks.begin();
+      for (; itr != m_cbacks.end(); ++itr)
+      {
+        Profile* p = itr->second.profile;
+        if (p->calls.load(std::memory_order_relaxed) == 0)
+          continue;
+
+        CallbackStatistics cs;
+        cs.id = itr->first;
+        cs.calls = p->calls.exchange(0, std::memory_order_relaxed);
+        cs.time_sum = p->time_sum.exchange(0, std::memory_order_relaxed) / Time::c_nsec_per_sec_fp;
+        cs.time_max = p->time_max.exchange(0, std::memory_order_relaxed) / Time::c_nsec_per_sec_fp;
+        for (unsigned i = 0; i < c_callback_bins; ++i)
+          cs.time_hist[i] = p->time_hist[i].exchange(0, std::memory_order_relaxed);
+        stats.push_back(cs);
+      }
     }
 
     void
     Recipient::waitForMessages(double timeout)
     {
-      if (m_mqueue.waitForItems(timeout))
+      if (pending() == 0)
+      {
+        Concurrency::ScopedCondition l(m_cond);
+        m_waiting.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (pending() == 0 && !m_wake_up.load(std::memory_order_relaxed))
+          m_cond.wait(timeout);
+        m_waiting.store(false, std::memory_order_relaxed);
+      }
+
+      m_wake_up.store(false, std::memory_order_relaxed);
+
+      if (pending() > 0)
         runCallBacks();
     }
 
     void
-    Recipient::put(const IMC::Message* msg)
+    Recipient::wakeUp(void)
     {
-      m_mqueue.push(msg->clone());
+      m_wake_up.store(true, std::memory_order_relaxed);
+
+      // Pairs with the fence in waitForMessages().
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (m_waiting.load(std::memory_order_relaxed))
+      {
+        Concurrency::ScopedCondition l(m_cond);
+        m_cond.signal();
+      }
+    }
+
+    void
+    Recipient::put(const IMC::SharedMessage& msg)
+    {
+      Entry entry;
+      entry.msg = msg;
+      entry.seq = m_seq.fetch_add(1, std::memory_order_relaxed);
+      if (enqueue(entry))
+        notify();
+    }
+
+    bool
+    Recipient::tryPut(const IMC::SharedMessage& msg, bool expired)
+    {
+      if (getOverflowPolicy() != OP_BLOCK)
+      {
+        put(msg);
+        return true;
+      }
+
+      Entry entry;
+      entry.msg = msg;
+      entry.seq = m_seq.fetch_add(1, std::memory_order_relaxed);
+      if (m_mqueue->tryPush(entry))
+      {
+        notify();
+        return true;
+      }
+
+      if (!expired)
+        return false;
+
+      m_dropped.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+
+    void
+    Recipient::notify(void)
+    {
+      updatePeak();
+
+      // Pairs with the fence in waitForMessages(): either the
+      // consumer sees the new message or we see it waiting.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (m_waiting.load(std::memory_order_relaxed))
+      {
+        Concurrency::ScopedCondition l(m_cond);
+        m_cond.signal();
+      }
+    }
+
+    bool
+    Recipient::enqueue(const Entry& entry)
+    {
+      if (m_mqueue->tryPush(entry))
+        return true;
+
+      switch (getOverflowPolicy())
+      {
+        case OP_DROP_NEWEST:
+          break;
+
+        case OP_BLOCK:
+          if (enqueueBlocking(entry))
+            return true;
+          break;
+
+        case OP_COALESCE:
+          {
+            // The newest message takes the arrival order of the
+            // message it replaces.
+            const IMC::Message* m = entry.msg.get();
+            CoalesceKey key(m->getId(), ((uint32_t)m->getSource() << 8) | m->getSourceEntity());
+
+            Concurrency::ScopedMutex l(m_coalesced_lock);
+            std::map<CoalesceKey, Entry>::iterator itr = m_coalesced.find(key);
+            if (itr == m_coalesced.end())
+            {
+              m_coalesced[key] = entry;
+              m_coalesced_size.fetch_add(1, std::memory_order_relaxed);
+            }
+            else
+            {
+              itr->second.msg = entry.msg;
+              m_coalesced_count.fetch_add(1, std::memory_order_relaxed);
+            }
+          }
+          return true;
+
+        case OP_DROP_OLDEST:
+        default:
+          {
+            Entry old;
+            while (true)
+            {
+              if (m_mqueue->tryPush(entry))
+                break;
+
+              if (m_mqueue->tryPop(old))
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+          }
+          return true;
+      }
+
+      m_dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    bool
+    Recipient::enqueueBlocking(const Entry& entry)
+    {
+      double deadline = Time::Clock::get() + c_block_timeout;
+
+      Concurrency::ScopedCondition l(m_space);
+      m_blocked.fetch_add(1);
+
+      // Pairs with the fence in runCallBacks(): either the consumer
+      // sees us blocked or we see the room it made.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+
+      bool queued = false;
+      while (!(queued = m_mqueue->tryPush(entry)))
+      {
+        double timeout = deadline - Time::Clock::get();
+        if (timeout <= 0)
+          break;
+
+        m_space.wait(timeout);
+      }
+
+      m_blocked.fetch_sub(1, std::memory_order_relaxed);
+      return queued;
+    }
+
+    void
+    Recipient::updatePeak(void)
+    {
+      unsigned depth = pending();
+      unsigned peak = m_peak.load(std::memory_order_relaxed);
+      while (depth > peak && !m_peak.compare_exchange_weak(peak, depth, std::memory_order_relaxed))
+      { }
+    }
+
+    uint64_t
+    Recipient::deliver(const IMC::SharedMessage& shared, uint64_t start)
+    {
+      const IMC::Message* msg = shared.get();
+      if (msg == NULL)
+        return start;
+
+      std::map<uint32_t, Binding>::iterator itr = m_cbacks.find(msg->getId());
+      if (itr == m_cbacks.end())
+        return start;
+
+      const std::vector<AbstractConsumer*>& consumers = itr->second.consumers;
+      for (size_t j = 0; j < consumers.size(); ++j)
+        consumers[j]->consume(msg);
+
+      uint64_t end = Time::Clock::getNsecRT();
+      profile(itr->second.profile, end - start);
+      return end;
+    }
+
+    void
+    Recipient::profile(Profile* p, uint64_t nsec)
+    {
+      p->calls.fetch_add(1, std::memory_order_relaxed);
+      p->time_sum.fetch_add(nsec, std::memory_order_relaxed);
+      if (nsec > p->time_max.load(std::memory_order_relaxed))
+        p->time_max.store(nsec, std::memory_order_relaxed);
+
+      unsigned bin = 0;
+      uint64_t limit = 10 * Time::c_nsec_per_usec;
+      while (bin < c_callback_bins - 1 && nsec >= limit)
+      {
+        ++bin;
+        limit *= 10;
+      }
+
+      p->time_hist[bin].fetch_add(1, std::memory_order_relaxed);
     }
 
     void
     Recipient::runCallBacks(void)
     {
-      unsigned int size = m_mqueue.size();
+      // Take coalesced messages first, so that the messages that
+      // arrived before them are already in the queue.
+      m_coalesced_batch.clear();
+      if (m_coalesced_size.load(std::memory_order_relaxed) > 0)
+      {
+        Concurrency::ScopedMutex l(m_coalesced_lock);
+        std::map<CoalesceKey, Entry>::const_iterator itr = m_coalesced.begin();
+        for (; itr != m_coalesced.end(); ++itr)
+          m_coalesced_batch.push_back(itr->second);
+        m_coalesced.clear();
+        m_coalesced_size.store(0, std::memory_order_relaxed);
+      }
+
+      std::sort(m_coalesced_batch.begin(), m_coalesced_batch.end(), arrivedBefore);
 
-      for (unsigned int i = 0; i < size; ++i)
+      // Only drain what is queued now, so that a fast producer
+      // cannot starve the task.
+      size_t count = m_mqueue->size();
+      m_batch.clear();
+      m_batch.reserve(count);
+
+      Entry entry;
+      for (size_t i = 0; i < count && m_mqueue->tryPop(entry); ++i)
+        m_batch.push_back(entry);
+      entry.msg = IMC::SharedMessage();
+
+      // Wake producers blocked on a full queue.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (m_blocked.load(std::memory_order_relaxed) > 0)
+      {
+        Concurrency::ScopedCondition l(m_space);
+        m_space.broadcast();
+      }
+
+      // Deliver queued and coalesced messages in arrival order. The
+      // end of a delivery is the start of the next one, so the clock
+      // is read once per message. Host time is used, so that profiles
+      // are not distorted by simulated time.
+      uint64_t now = Time::Clock::getNsecRT();
+      size_t i = 0;
+      size_t j = 0;
+      while (i < m_batch.size() || j < m_coalesced_batch.size())
       {
-        const IMC::Message* msg = m_mqueue.pop();
-        if (msg)
-        {
-          uint32_t id = msg->getId();
-          for (size_t j = 0; j < m_cbacks[id].size(); ++j)
-            m_cbacks[id][j]->consume(msg);
-          delete msg;
-        }
+        if (j == m_coalesced_batch.size()
+            || (i < m_batch.size() && arrivedBefore(m_batch[i], m_coalesced_batch[j])))
+          now = deliver(m_batch[i++].msg, now);
+        else
+          now = deliver(m_coalesced_batch[j++].msg, now);
       }
+
+      m_batch.clear();
+      m_coalesced_batch.clear();
     }
   }
 }
@@ -34,8 +34,14 @@
 #include <map>
 #include <vector>
 
+// ISO C++ 11 headers.
+#include <atomic>
+
 // DUNE headers.
-#include <DUNE/Concurrency/TSQueue.hpp>
+#include <DUNE/Concurrency/Condition.hpp>
+#include <DUNE/Concurrency/LockFreeQueue.hpp>
+#include <DUNE/Concurrency/Mutex.hpp>
+#include <DUNE/IMC/SharedMessage.hpp>
 #include <DUNE/Tasks/Consumer.hpp>
 #include <DUNE/Tasks/AbstractTask.hpp>
 
@@ -49,9 +55,63 @@ namespace DUNE
     // Export DLL Symbol.
     class DUNE_DLL_SYM Recipient;
 
+    //! Incoming message queue of a task. Messages are stored in a
+    //! bounded lock-free queue, what happens when the queue is full
+    //! is decided by the configured overflow policy.
     class Recipient
     {
     public:
+      //! Queue overflow policies.
+      enum OverflowPolicy
+      {
+        //! Discard the oldest queued message.
+        OP_DROP_OLDEST,
+        //! Discard the incoming message.
+        OP_DROP_NEWEST,
+        //! Block the producer until there is room (bounded wait,
+        //! the message is dropped on timeout).
+        OP_BLOCK,
+        //! Keep only the latest message of each type and source.
+        OP_COALESCE
+      };
+
+      //! Queue statistics.
+      struct Statistics
+      {
+        //! Queue capacity.
+        unsigned capacity;
+        //! Current number of queued messages.
+        unsigned depth;
+        //! Maximum number of queued messages.
+        unsigned peak;
+        //! Number of discarded messages.
+        unsigned dropped;
+        //! Number of messages replaced by newer ones.
+        unsigned coalesced;
+      };
+
+      //! Number of bins of the callback time histogram (decades,
+      //! starting at 10 us).
+      static const unsigned c_callback_bins = 5;
+
+      //! Callback statistics of a message type.
+      struct CallbackStatistics
+      {
+        //! Message identification number.
+        uint32_t id;
+        //! Number of messages delivered.
+        unsigned calls;
+        //! Total time spent in callbacks (s).
+        double time_sum;
+        //! Longest time spent delivering a message (s).
+        double time_max;
+        //! Histogram of delivery times.
+        unsigned time_hist[c_callback_bins];
+      };
+
+      //! Default queue capacity.
+      static const unsigned c_default_capacity = 8192;
+
       //! Constructor.
       Recipient(AbstractTask* task, Context& ctx);
 
@@ -62,7 +122,17 @@ namespace DUNE
       unbindAll(void);
 
       void
-      put(const IMC::Message*);
+      put(const IMC::SharedMessage& msg);
+
+      //! Queue a message without waiting for room. Only the blocking
+      //! overflow policy makes a difference: a message that does not
+      //! fit is either left to the caller or dropped.
+      //! @param msg message.
+      //! @param expired drop the message if it does not fit.
+      //! @return false if the message did not fit and was not
+      //! dropped, true otherwise.
+      bool
+      tryPut(const IMC::SharedMessage& msg, bool expired);
 
       void
       bind(uint32_t id, AbstractConsumer* c);
@@ -70,18 +140,173 @@ namespace DUNE
       void
       waitForMessages(double timeout);
 
+      //! Make the current or next waitForMessages() return, so that
+      //! the consumer can attend to other sources of work.
+      void
+      wakeUp(void);
+
       void
       runCallBacks(void);
 
+      //! Change queue capacity. Queued messages are preserved, but
+      //! this function must not be called while messages are being
+      //! delivered (i.e., only while the bus is paused).
+      //! @param[in] capacity minimum number of queued messages.
+      void
+      setCapacity(unsigned capacity);
+
+      //! Change queue overflow policy.
+      //! @param[in] policy overflow policy.
+      void
+      setOverflowPolicy(OverflowPolicy policy)
+      {
+        m_policy.store(policy, std::memory_order_relaxed);
+      }
+
+      //! Retrieve queue overflow policy.
+      //! @return overflow policy.
+      OverflowPolicy
+      getOverflowPolicy(void) const
+      {
+        return (OverflowPolicy)m_policy.load(std::memory_order_relaxed);
+      }
+
+      //! Retrieve queue statistics.
+      //! @param[out] stats statistics.
+      void
+      getStatistics(Statistics& stats) const;
+
+      //! Retrieve and reset callback statistics of the message types
+      //! delivered since the last call.
+      //! @param[out] stats statistics.
+      void
+      getCallbackStatistics(std::vector<CallbackStatistics>& stats);
+
     private:
+      //! Key of a coalesced message (identifier, source and source
+      //! entity).
+      typedef std::pair<uint32_t, uint32_t> CoalesceKey;
+
+      //! Queued message.
+      struct Entry
+      {
+        //! Message.
+        IMC::SharedMessage msg;
+        //! Arrival order.
+        uint64_t seq;
+      };
+
+      //! Callback profile of a message type, updated by the task
+      //! thread and reset by getCallbackStatistics().
+      struct Profile
+      {
+        //! Number of messages delivered.
+        std::atomic<unsigned> calls;
+        //! Total delivery time (ns).
+        std::atomic<uint64_t> time_sum;
+        //! Longest delivery time (ns).
+        std::atomic<uint64_t> time_max;
+        //! Histogram of delivery times.
+        std::atomic<unsigned> time_hist[c_callback_bins];
+      };
+
+      //! Callbacks of a message type.
+      struct Binding
+      {
+        //! Consumers.
+        std::vector<AbstractConsumer*> consumers;
+        //! Profile.
+        Profile* profile;
+      };
+
       //! Task.
       AbstractTask* m_task;
       //! Context.
       Context& m_ctx;
       //! Callbacks.
-      std::map<uint32_t, std::vector<AbstractConsumer*> > m_cbacks;
+      std::map<uint32_t, Binding> m_cbacks;
+      //! Serializes changes of m_cbacks with getCallbackStatistics().
+      Concurrency::Mutex m_cbacks_lock;
       //! Message queue.
-      Concurrency::TSQueue<IMC::Message*> m_mqueue;
+      Concurrency::LockFreeQueue<Entry>* m_mqueue;
+      //! Messages that did not fit in the queue (coalesce policy).
+      std::map<CoalesceKey, Entry> m_coalesced;
+      //! Number of entries in m_coalesced.
+      std::atomic<unsigned> m_coalesced_size;
+      //! Lock of m_coalesced.
+      Concurrency::Mutex m_coalesced_lock;
+      //! Overflow policy.
+      std::atomic<int> m_policy;
+      //! True if the consumer is waiting for messages.
+      std::atomic<bool> m_waiting;
+      //! True if the consumer was asked to wake up.
+      std::atomic<bool> m_wake_up;
+      //! Condition used to wake the consumer.
+      Concurrency::Condition m_cond;
+      //! Number of producers waiting for room (block policy).
+      std::atomic<unsigned> m_blocked;
+      //! Condition used to wake blocked producers.
+      Concurrency::Condition m_space;
+      //! Next arrival order.
+      std::atomic<uint64_t> m_seq;
+      //! Number of discarded messages.
+      std::atomic<unsigned> m_dropped;
+      //! Number of coalesced messages.
+      std::atomic<unsigned> m_coalesced_count;
+      //! Maximum queue depth.
+      std::atomic<unsigned> m_peak;
+      //! Scratch buffer used to drain the queue.
+      std::vector<Entry> m_batch;
+      //! Scratch buffer used to drain coalesced messages.
+      std::vector<Entry> m_coalesced_batch;
+
+      //! Insert a message in the queue, applying the overflow policy.
+      //! @param[in] entry message.
+      //! @return true if the message was queued, false otherwise.
+      bool
+      enqueue(const Entry& entry);
+
+      //! Wait for room in the queue (block policy).
+      //! @param[in] entry message.
+      //! @return true if the message was queued, false on timeout.
+      bool
+      enqueueBlocking(const Entry& entry);
+
+      //! Update statistics and wake up the consumer after a message
+      //! was queued.
+      void
+      notify(void);
+
+      //! Deliver a message to the bound consumers.
+      //! @param[in] msg message.
+      //! @param[in] start host time at which delivery started (ns).
+      //! @return host time at which delivery ended (ns).
+      uint64_t
+      deliver(const IMC::SharedMessage& msg, uint64_t start);
+
+      //! Compare arrival order of two messages.
+      static bool
+      arrivedBefore(const Entry& a, const Entry& b)
+      {
+        return a.seq < b.seq;
+      }
+
+      //! Update maximum queue depth.
+      void
+      updatePeak(void);
+
+      //! Account the delivery of a message.
+      //! @param p profile of the message type.
+      //! @param nsec delivery time (ns).
+      static void
+      profile(Profile* p, uint64_t nsec);
+
+      //! Number of messages pending delivery.
+      size_t
+      pending(void) const
+      {
+        return m_mqueue->size() + m_coalesced_size.load(std::memory_order_relaxed);
+      }
     };
   }
 }
@@ -0,0 +1,82 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+
+// ISO C++ 98 headers.
+#include <iomanip>
+#include <sstream>
+
+// DUNE headers.
+#include <DUNE/Concurrency/ScopedMutex.hpp>
+#include <DUNE/Time/Clock.hpp>
+#include <DUNE/Utils/String.hpp>
+#include <DUNE/Tasks/Report.hpp>
+
+namespace DUNE
+{
+  namespace Tasks
+  {
+    void
+    Report::set(const std::string& task, const std::string& section, const std::string& json)
+    {
+      Concurrency::ScopedMutex l(m_lock);
+      m_tasks[task][section] = json;
+    }
+
+    std::string
+    Report::toJSON(void) const
+    {
+      std::ostringstream os;
+      os << "{\"time\": " << std::fixed << std::setprecision(3) << Time::Clock::getSinceEpoch()
+         << ", \"tasks\": {";
+
+      Concurrency::ScopedMutex l(m_lock);
+      std::map<std::string, std::map<std::string, std::string> >::const_iterator titr = m_tasks.begin();
+      for (; titr != m_tasks.end(); ++titr)
+      {
+        if (titr != m_tasks.begin())
+          os << ", ";
+        os << "\"" << Utils::String::escape(titr->first) << "\": {";
+
+        std::map<std::string, std::string>::const_iterator sitr = titr->second.begin();
+        for (; sitr != titr->second.end(); ++sitr)
+        {
+          if (sitr != titr->second.begin())
+            os << ", ";
+          os << "\"" << sitr->first << "\": " << sitr->second;
+        }
+
+        os << "}";
+      }
+
+      os << "}}";
+      return os.str();
+    }
+  }
+}
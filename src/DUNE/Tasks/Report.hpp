@@ -24,59 +24,53 @@
 // https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
 // http://ec.europa.eu/idabc/eupl.html.                                     *
 //***************************************************************************
-// Author: Eduardo Marques                                                  *
+// Author: Eivind Jølsgard                                                 *
 //***************************************************************************
 
-#ifndef SIMULATORS_ENVIRONMENT_POINT_HPP_INCLUDED_
-#define SIMULATORS_ENVIRONMENT_POINT_HPP_INCLUDED_
+
+#ifndef DUNE_TASKS_REPORT_HPP_INCLUDED_
+#define DUNE_TASKS_REPORT_HPP_INCLUDED_
 
 // ISO C++ 98 headers.
-#include <iomanip>
-#include <cmath>
+#include <map>
+#include <string>
 
 // DUNE headers.
 #include <DUNE/Config.hpp>
+#include <DUNE/Concurrency/Mutex.hpp>
 
-namespace Simulators
+namespace DUNE
 {
-  namespace Environment
+  namespace Tasks
   {
-    //! Directions for search/insertion
-    enum
-    {
-      DIR_NW, DIR_NE, DIR_SW, DIR_SE
-    };
+    // Export DLL Symbol.
+    class DUNE_DLL_SYM Report;
 
-    //! Point structure.
-    struct Point
+    //! Latest runtime statistics of tasks. The task manager updates
+    //! them periodically and other tasks (e.g., the HTTP transport)
+    //! publish them. Statistics are kept as JSON objects, grouped by
+    //! task and section.
+    class Report
     {
-      double x, y;
-
-      Point(double x_, double y_):
-        x(x_), y(y_) { }
-
-      double
-      distance(const Point& other) const
-      {
-        double dx = x - other.x;
-        double dy = y - other.y;
-        return std::sqrt(dx * dx + dy * dy);
-      }
-
-      template <typename T>
-      int
-      direction(const T& other) const
-      {
-        double dx = other.x - x;
-        double dy = other.y - y;
-
-        int dir = dx >= 0 ? DIR_NW : DIR_SW;
+    public:
+      //! Set a section of the statistics of a task.
+      //! @param[in] task task name.
+      //! @param[in] section section name.
+      //! @param[in] json section contents (JSON object).
+      void
+      set(const std::string& task, const std::string& section, const std::string& json);
 
-        if (dy > 0)
-          dir++;      // other is East of this
+      //! Retrieve the report as a JSON object of the form
+      //! {"time": t, "tasks": {task: {section: object}}}.
+      //! @return JSON object.
+      std::string
+      toJSON(void) const;
 
-        return dir;
-      }
+    private:
+      //! Sections of each task.
+      std::map<std::string, std::map<std::string, std::string> > m_tasks;
+      //! Protects m_tasks.
+      mutable Concurrency::Mutex m_lock;
     };
   }
 }
@@ -101,20 +101,19 @@ namespace DUNE
     void
     SimpleTransport::handleData(IMC::Parser& parser, const uint8_t* p, unsigned int n)
     {
-      for (const uint8_t* e = p + n; p != e; ++p)
-      {
-        IMC::Message* m = parser.parse(*p);
+      Incoming incoming(this);
+      parser.parse(p, n, incoming);
+    }
 
-        if (m)
-        {
-          dispatch(m, DF_KEEP_TIME | DF_KEEP_SRC_EID);
+    void
+    SimpleTransport::handleMessage(IMC::Message* m)
+    {
+      dispatch(m, DF_KEEP_TIME | DF_KEEP_SRC_EID);
 
-          if (m_gargs.trace_in)
-            inf(DTR("incoming: %s"), m->getName());
+      if (m_gargs.trace_in)
+        inf(DTR("incoming: %s"), m->getName());
 
-          delete m;
-        }
-      }
+      delete m;
     }
   }
 }
@@ -84,9 +84,30 @@ namespace DUNE
         // Trace outgoing messages.
         bool trace_out;
       };
+      //! Parser callback.
+      struct Incoming
+      {
+        Incoming(SimpleTransport* t):
+          task(t)
+        { }
+
+        void
+        operator()(IMC::Message* msg)
+        {
+          task->handleMessage(msg);
+        }
+
+        SimpleTransport* task;
+      };
+
       GArguments m_gargs;
       Utils::ByteBuffer m_buf;
       MessageFilter m_rl;
+
+      //! Dispatch and release a message received from the link.
+      //! @param msg message.
+      void
+      handleMessage(IMC::Message* msg);
     };
   }
 }
@@ -31,6 +31,7 @@
 // ISO C++ 98 headers.
 #include <sstream>
 #include <cstddef>
+#include <cstring>
 
 // DUNE headers.
 #include <DUNE/IMC/Constants.hpp>
@@ -41,6 +42,7 @@
 #include <DUNE/Status/Messages.hpp>
 #include <DUNE/Tasks/Context.hpp>
 #include <DUNE/Tasks/Exceptions.hpp>
+#include <DUNE/Tasks/LogSink.hpp>
 #include <DUNE/Tasks/Task.hpp>
 #include <DUNE/Utils/XML.hpp>
 #include <DUNE/Entities/BasicEntity.hpp>
@@ -50,6 +52,14 @@
 #  include <sys/prctl.h>
 #endif
 
+// Call site of a logging function, used to tell apart call sites
+// that share a format string.
+#if defined(DUNE_CXX_GNU) || defined(DUNE_CXX_CLANG)
+#  define DUNE_LOG_SITE(format) __builtin_return_address(0)
+#else
+#  define DUNE_LOG_SITE(format) static_cast<const void*>(format)
+#endif
+
 namespace DUNE
 {
   namespace Tasks
@@ -63,7 +73,10 @@ namespace DUNE
       m_name(n),
       m_entity(NULL),
       m_debug_level(DEBUG_LEVEL_NONE),
-      m_honours_active(false)
+      m_honours_active(false),
+      m_dispatched(0),
+      m_deliveries(0),
+      m_fanout_max(0)
     {
       m_args.priority = 10;
       m_args.act_time = 0;
@@ -88,6 +101,18 @@ namespace DUNE
       .defaultValue("None")
       .values("None, Debug, Trace, Spew");
 
+      param(DTR_RT("Queue Capacity"), m_args.queue_capacity)
+      .visibility(Parameter::VISIBILITY_DEVELOPER)
+      .defaultValue("8192")
+      .minimumValue("2")
+      .description(DTR("Maximum number of queued incoming messages. Only applied when the task is loaded"));
+
+      param(DTR_RT("Queue Overflow Policy"), m_args.queue_policy)
+      .visibility(Parameter::VISIBILITY_DEVELOPER)
+      .defaultValue("Drop Oldest")
+      .values("Drop Oldest, Drop Newest, Block, Coalesce")
+      .description(DTR("What to do with incoming messages when the queue is full"));
+
       m_recipient = new Recipient(this, ctx);
       m_entity = new Entities::StatefulEntity(this, m_ctx);
       m_entities.push_back(m_entity);
@@ -239,6 +264,15 @@ namespace DUNE
       else
         m_debug_level = DEBUG_LEVEL_NONE;
 
+      if (m_args.queue_policy == "Drop Newest")
+        m_recipient->setOverflowPolicy(Recipient::OP_DROP_NEWEST);
+      else if (m_args.queue_policy == "Block")
+        m_recipient->setOverflowPolicy(Recipient::OP_BLOCK);
+      else if (m_args.queue_policy == "Coalesce")
+        m_recipient->setOverflowPolicy(Recipient::OP_COALESCE);
+      else
+        m_recipient->setOverflowPolicy(Recipient::OP_DROP_OLDEST);
+
       onUpdateParameters();
 
       if (m_honours_active)
@@ -436,10 +470,24 @@ namespace DUNE
           msg->setSourceEntity(getEntityId());
       }
 
+      size_t count = 0;
       if ((flags & DF_LOOP_BACK) == 0)
-        m_ctx.mbus.dispatch(msg, this);
+        count = m_ctx.mbus.dispatch(msg, this);
       else
-        m_ctx.mbus.dispatch(msg);
+        count = m_ctx.mbus.dispatch(msg);
+
+      m_dispatched.fetch_add(1, std::memory_order_relaxed);
+      m_deliveries.fetch_add(count, std::memory_order_relaxed);
+      if (count > m_fanout_max.load(std::memory_order_relaxed))
+        m_fanout_max.store(count, std::memory_order_relaxed);
+    }
+
+    void
+    Task::getDispatchStatistics(DispatchStatistics& stats)
+    {
+      stats.dispatched = m_dispatched.exchange(0, std::memory_order_relaxed);
+      stats.deliveries = m_deliveries.exchange(0, std::memory_order_relaxed);
+      stats.fanout_max = m_fanout_max.exchange(0, std::memory_order_relaxed);
     }
 
     void
@@ -571,7 +619,7 @@ namespace DUNE
     {
       std::va_list ap;
       va_start(ap, format);
-      log(IMC::LogBookEntry::LBET_INFO, format, ap);
+      log(IMC::LogBookEntry::LBET_INFO, DUNE_LOG_SITE(format), format, ap);
       va_end(ap);
     }
 
@@ -580,7 +628,7 @@ namespace DUNE
     {
       std::va_list ap;
       va_start(ap, format);
-      log(IMC::LogBookEntry::LBET_WARNING, format, ap);
+      log(IMC::LogBookEntry::LBET_WARNING, DUNE_LOG_SITE(format), format, ap);
       va_end(ap);
     }
 
@@ -589,7 +637,7 @@ namespace DUNE
     {
       std::va_list ap;
       va_start(ap, format);
-      log(IMC::LogBookEntry::LBET_ERROR, format, ap);
+      log(IMC::LogBookEntry::LBET_ERROR, DUNE_LOG_SITE(format), format, ap);
       va_end(ap);
     }
 
@@ -598,7 +646,7 @@ namespace DUNE
     {
       std::va_list ap;
       va_start(ap, format);
-      log(IMC::LogBookEntry::LBET_CRITICAL, format, ap);
+      log(IMC::LogBookEntry::LBET_CRITICAL, DUNE_LOG_SITE(format), format, ap);
       va_end(ap);
     }
 
@@ -610,7 +658,7 @@ namespace DUNE
 
       std::va_list ap;
       va_start(ap, format);
-      log(IMC::LogBookEntry::LBET_DEBUG, format, ap);
+      log(IMC::LogBookEntry::LBET_DEBUG, DUNE_LOG_SITE(format), format, ap);
       va_end(ap);
     }
 
@@ -622,7 +670,7 @@ namespace DUNE
 
       std::va_list ap;
       va_start(ap, format);
-      log(IMC::LogBookEntry::LBET_DEBUG, format, ap);
+      log(IMC::LogBookEntry::LBET_DEBUG, DUNE_LOG_SITE(format), format, ap);
       va_end(ap);
     }
 
@@ -634,24 +682,67 @@ namespace DUNE
 
       std::va_list ap;
       va_start(ap, format);
-      log(IMC::LogBookEntry::LBET_DEBUG, format, ap);
+      log(IMC::LogBookEntry::LBET_DEBUG, DUNE_LOG_SITE(format), format, ap);
       va_end(ap);
     }
 
-    void
-    Task::log(IMC::LogBookEntry::TypeEnum type, const char* format, std::va_list arg_list)
+    //! Format a log message.
+    //! @param bfr destination buffer.
+    //! @param size size of destination buffer.
+    //! @param format string format.
+    //! @param arg_list arguments.
+    static void
+    formatLog(char* bfr, size_t size, const char* format, std::va_list arg_list)
     {
-      char bfr[c_log_message_max_size] = {0};
-
 #if defined(DUNE_SYS_HAS_VSNPRINTF)
-      vsnprintf(bfr, sizeof(bfr), format, arg_list);
+      vsnprintf(bfr, size, format, arg_list);
 
 #elif defined(DUNE_SYS_HAS_VSNPRINTF_S)
-      vsnprintf_s(bfr, sizeof(bfr), sizeof(bfr) - 1, format, arg_list);
+      vsnprintf_s(bfr, size, size - 1, format, arg_list);
 
 #else
+      (void)size;
       std::vsprintf(bfr, format, arg_list);
 #endif
+    }
+
+    void
+    Task::log(IMC::LogBookEntry::TypeEnum type, const void* site, const char* format,
+              std::va_list arg_list)
+    {
+      LogSink* sink = m_ctx.logs;
+      if (sink != NULL)
+      {
+        // Check the rate limit before spending time formatting.
+        unsigned suppressed = 0;
+        if (!sink->admit(this, site, type, suppressed))
+          return;
+
+        LogSink::Entry* entry = sink->acquire(type);
+        if (entry != NULL)
+        {
+          entry->task = this;
+          entry->site = site;
+          entry->format = format;
+          entry->type = type;
+          entry->entity = getEntityId();
+          entry->suppressed = suppressed;
+          entry->htime = Time::Clock::getSinceEpoch();
+          std::strncpy(entry->context, getName(), sizeof(entry->context) - 1);
+          entry->context[sizeof(entry->context) - 1] = 0;
+          formatLog(entry->text, sizeof(entry->text), format, arg_list);
+          sink->commit();
+          return;
+        }
+
+        // The ring is full: warnings and errors are never dropped,
+        // so they are written by this thread.
+        if (LogSink::isDroppable(type))
+          return;
+      }
+
+      char bfr[c_log_message_max_size] = {0};
+      formatLog(bfr, sizeof(bfr), format, arg_list);
 
       IMC::LogBookEntry log_entry;
       log_entry.setSourceEntity(getEntityId());
@@ -716,6 +807,10 @@ namespace DUNE
       {
         err(DTR("unable to load parameters: %s"), e.getError());
       }
+
+      // The message bus is paused while tasks are being configured,
+      // so this is the only safe place to resize the queue.
+      m_recipient->setCapacity(m_args.queue_capacity);
     }
   }
 }
@@ -36,6 +36,10 @@
 #include <map>
 #include <stack>
 #include <cstdarg>
+#include <vector>
+
+// ISO C++ 11 headers.
+#include <atomic>
 
 // DUNE headers.
 #include <DUNE/Config.hpp>
@@ -110,6 +114,17 @@ namespace DUNE
     class Task: public AbstractTask
     {
     public:
+      //! Dispatch statistics.
+      struct DispatchStatistics
+      {
+        //! Number of dispatched messages.
+        unsigned dispatched;
+        //! Number of recipients reached by dispatched messages.
+        unsigned deliveries;
+        //! Largest number of recipients of a dispatched message.
+        unsigned fanout_max;
+      };
+
       //! Construct a task object.
       //! @param[in] name name of the task.
       //! @param[in] context task context.
@@ -245,6 +260,36 @@ namespace DUNE
         return m_args.priority;
       }
 
+      //! Get statistics of the incoming message queue.
+      //! @param[out] stats queue statistics.
+      void
+      getQueueStatistics(Recipient::Statistics& stats) const
+      {
+        m_recipient->getStatistics(stats);
+      }
+
+      //! Get and reset the callback statistics of each message type
+      //! delivered to the task.
+      //! @param[out] stats callback statistics.
+      void
+      getCallbackStatistics(std::vector<Recipient::CallbackStatistics>& stats)
+      {
+        m_recipient->getCallbackStatistics(stats);
+      }
+
+      //! Get and reset dispatch statistics.
+      //! @param[out] stats dispatch statistics.
+      void
+      getDispatchStatistics(DispatchStatistics& stats);
+
+      //! Get overflow policy of the incoming message queue.
+      //! @return overflow policy.
+      Recipient::OverflowPolicy
+      getQueueOverflowPolicy(void) const
+      {
+        return m_recipient->getOverflowPolicy();
+      }
+
       //! Send an human-readable informational message to all
       //! configured output channels and files.
       //! @param format string format (similar to printf(3)).
@@ -329,11 +374,39 @@ namespace DUNE
       }
 
       //! Queue a message for later consumption.
+      //! @param msg shared message handle.
+      void
+      receive(const IMC::SharedMessage& msg)
+      {
+        m_recipient->put(msg);
+      }
+
+      //! Queue a message for later consumption without waiting for
+      //! room in the queue.
+      //! @param msg shared message handle.
+      //! @param expired true if the producer stopped waiting.
+      //! @return false if the message should be offered again later.
+      bool
+      tryReceive(const IMC::SharedMessage& msg, bool expired)
+      {
+        return m_recipient->tryPut(msg, expired);
+      }
+
+      //! Queue a copy of a message for later consumption.
       //! @param msg message object.
       void
       receive(const IMC::Message* msg)
       {
-        m_recipient->put(msg);
+        m_recipient->put(IMC::SharedMessage::copy(msg));
+      }
+
+      //! Make the current or next call to waitForMessages() return.
+      //! Can be called from any thread, e.g., when another source of
+      //! work becomes ready.
+      void
+      wakeUp(void)
+      {
+        m_recipient->wakeUp();
       }
 
       //! Instruct task to reserve all entity identifiers that it
@@ -785,6 +858,10 @@ namespace DUNE
         std::string active_scope;
         //! Visibility of 'Active' parameter.
         std::string active_visibility;
+        //! Incoming message queue capacity.
+        unsigned queue_capacity;
+        //! Incoming message queue overflow policy.
+        std::string queue_policy;
       };
 
       //! Message recipient (queue).
@@ -807,6 +884,12 @@ namespace DUNE
       bool m_honours_active;
       //! Name of parameter section editor.
       std::string m_param_editor;
+      //! Number of dispatched messages.
+      std::atomic<unsigned> m_dispatched;
+      //! Number of recipients reached by dispatched messages.
+      std::atomic<unsigned> m_deliveries;
+      //! Largest number of recipients of a dispatched message.
+      std::atomic<unsigned> m_fanout_max;
 
       //! Report current entity states by dispatching EntityState
       //! messages. This function will at least report the state of
@@ -814,8 +897,14 @@ namespace DUNE
       void
       reportEntityState(void);
 
+      //! Log a message.
+      //! @param type message type.
+      //! @param site call site (address of the logging call).
+      //! @param format string format (similar to printf(3)).
+      //! @param arg_list arguments.
       void
-      log(IMC::LogBookEntry::TypeEnum type, const char* format, std::va_list arg_list);
+      log(IMC::LogBookEntry::TypeEnum type, const void* site, const char* format,
+          std::va_list arg_list);
 
       void
       run(void);
@@ -36,6 +36,7 @@
 #include <DUNE/Config.hpp>
 #include <DUNE/Time/Constants.hpp>
 #include <DUNE/Time/Clock.hpp>
+#include <DUNE/Time/VirtualClock.hpp>
 #include <DUNE/System/Error.hpp>
 
 // Platform headers.
@@ -62,6 +63,9 @@ namespace DUNE
     uint64_t
     Clock::getNsec(void)
     {
+      if (VirtualClock::isEnabled())
+        return VirtualClock::getNsec();
+
       uint64_t time = getNsecRT();
       if (Clock::s_time_multiplier != 1.0) {
         double ellapsed_time = (time - s_starttime_mono);
@@ -97,6 +101,9 @@ namespace DUNE
     uint64_t
     Clock::getSinceEpochNsec(void)
     {
+      if (VirtualClock::isEnabled())
+        return s_starttime_epoch + (VirtualClock::getNsec() - s_starttime_mono);
+
       uint64_t time = getSinceEpochNsecRT();
       if (Clock::s_time_multiplier != 1.0) {
         double ellapsed_time = (time - s_starttime_epoch);
@@ -108,6 +115,13 @@ namespace DUNE
     void
     Clock::set(double value)
     {
+      if (VirtualClock::isEnabled())
+      {
+        s_starttime_epoch = value * c_nsec_per_sec;
+        s_starttime_mono = VirtualClock::getNsec();
+        return;
+      }
+
       if (Clock::s_time_multiplier != 1.0) {
         s_starttime_epoch = value * c_nsec_per_sec;
         setTimeMultiplier(Clock::s_time_multiplier);
@@ -128,12 +142,26 @@ namespace DUNE
     void
     Clock::setTimeMultiplier(double mul)
     {
+      // Logical time already runs as fast as possible.
+      if (VirtualClock::isEnabled())
+        return;
+
       Clock::s_time_multiplier = 1.0;
       s_starttime_epoch = getSinceEpochNsecRT();
       s_starttime_mono = getNsecRT();
       Clock::s_time_multiplier = mul;
     }
 
+    void
+    Clock::setVirtual(void)
+    {
+      Clock::s_time_multiplier = 1.0;
+      s_starttime_epoch = getSinceEpochNsecRT();
+      s_starttime_mono = getNsecRT();
+      VirtualClock::enable();
+      s_starttime_mono = VirtualClock::getNsec();
+    }
+
     double
     Clock::getTimeMultiplier(void)
     {
@@ -127,6 +127,12 @@ namespace DUNE
       static void
       setTimeMultiplier(double mul);
 
+      //! Switch to logical time for as-fast-as-possible simulations
+      //! (see VirtualClock). Must be called before starting any
+      //! thread. The time multiplier is ignored afterwards.
+      static void
+      setVirtual(void);
+
       //! Return configured time multipler
       //! @return simulation time multiplier (1.0 for real-time)
       static double
@@ -41,6 +41,8 @@
 // DUNE headers.
 #include <DUNE/Time/Constants.hpp>
 #include <DUNE/Time/Clock.hpp>
+#include <DUNE/Time/Delay.hpp>
+#include <DUNE/Time/VirtualClock.hpp>
 
 namespace DUNE
 {
@@ -80,6 +82,12 @@ namespace DUNE
       void
       reset(void)
       {
+        if (VirtualClock::isEnabled())
+        {
+          m_deadline = Clock::getNsec() + m_delay;
+          return;
+        }
+
         // Microsoft Windows.
 #if defined(DUNE_SYS_HAS_GET_SYSTEM_TIME_AS_FILE_TIME)
         FILETIME ft;
@@ -105,6 +113,15 @@ namespace DUNE
       void
       wait(void)
       {
+        if (VirtualClock::isEnabled())
+        {
+          uint64_t now = Clock::getNsec();
+          if (now < m_deadline)
+            Delay::waitNsec(m_deadline - now);
+          m_deadline += m_delay;
+          return;
+        }
+
         // Microsoft Windows.
 #if defined(DUNE_SYS_HAS_CREATE_WAITABLE_TIMER)
         HANDLE th = CreateWaitableTimer(0, TRUE, 0);
@@ -0,0 +1,411 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <cstddef>
+#include <deque>
+#include <set>
+
+// ISO C++ 11 headers.
+#include <atomic>
+
+// DUNE headers.
+#include <DUNE/Config.hpp>
+#include <DUNE/Time/Clock.hpp>
+#include <DUNE/Time/VirtualClock.hpp>
+
+namespace DUNE
+{
+  namespace Time
+  {
+#if defined(DUNE_SYS_HAS_PTHREAD)
+    struct VirtualClock::Waiter
+    {
+      //! Signaled when the waiter is given its turn.
+      pthread_cond_t cond;
+      //! Deadline of a timed wait.
+      uint64_t deadline;
+      //! Arrival order of a timed wait.
+      uint64_t seq;
+      //! True if waiting for a deadline.
+      bool timed;
+      //! True if the deadline was reached.
+      bool expired;
+      //! True if the waiter was given its turn.
+      bool granted;
+      //! List of waiters of a condition.
+      Waiter** list;
+      //! Previous waiter in list.
+      Waiter* prev;
+      //! Next waiter in list.
+      Waiter* next;
+
+      Waiter(void):
+        deadline(0),
+        seq(0),
+        timed(false),
+        expired(false),
+        granted(false),
+        list(NULL),
+        prev(NULL),
+        next(NULL)
+      {
+        pthread_cond_init(&cond, NULL);
+      }
+
+      ~Waiter(void)
+      {
+        pthread_cond_destroy(&cond);
+      }
+    };
+
+    //! Order timed waiters by deadline and arrival.
+    struct Earlier
+    {
+      bool
+      operator()(const VirtualClock::Waiter* a, const VirtualClock::Waiter* b) const;
+    };
+
+    //! Protects all scheduling state.
+    static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+    //! Logical time.
+    static std::atomic<uint64_t> s_now(0);
+    //! True if a thread has the turn.
+    static bool s_busy = false;
+    //! Arrival counter of timed waits.
+    static uint64_t s_seq = 0;
+    //! Waiters ready to run, in turn order.
+    static std::deque<VirtualClock::Waiter*> s_ready;
+    //! Timed waiters.
+    static std::set<VirtualClock::Waiter*, Earlier> s_timers;
+    //! True if the calling thread has the turn.
+    static thread_local bool t_scheduled = false;
+
+    bool
+    Earlier::operator()(const VirtualClock::Waiter* a, const VirtualClock::Waiter* b) const
+    {
+      if (a->deadline != b->deadline)
+        return a->deadline < b->deadline;
+      return a->seq < b->seq;
+    }
+
+    //! Remove a waiter from the list of a condition.
+    static void
+    unlink(VirtualClock::Waiter* w)
+    {
+      if (w->list == NULL)
+        return;
+
+      if (w->prev == NULL)
+        *w->list = w->next;
+      else
+        w->prev->next = w->next;
+
+      if (w->next != NULL)
+        w->next->prev = w->prev;
+
+      w->list = NULL;
+      w->prev = NULL;
+      w->next = NULL;
+    }
+
+    //! Append a waiter to the list of a condition.
+    static void
+    link(VirtualClock::Waiter** list, VirtualClock::Waiter* w)
+    {
+      VirtualClock::Waiter* last = *list;
+      while (last != NULL && last->next != NULL)
+        last = last->next;
+
+      w->list = list;
+      w->prev = last;
+      w->next = NULL;
+
+      if (last == NULL)
+        *list = w;
+      else
+        last->next = w;
+    }
+
+    //! Give the turn to the next ready waiter, advancing logical
+    //! time if nobody is ready. Must be called with s_lock held.
+    static void
+    dispatch(void)
+    {
+      if (s_busy)
+        return;
+
+      if (s_ready.empty() && !s_timers.empty())
+      {
+        uint64_t deadline = (*s_timers.begin())->deadline;
+        if (deadline > s_now.load())
+          s_now.store(deadline);
+
+        while (!s_timers.empty() && (*s_timers.begin())->deadline <= deadline)
+        {
+          VirtualClock::Waiter* w = *s_timers.begin();
+          s_timers.erase(s_timers.begin());
+          unlink(w);
+          w->timed = false;
+          w->expired = true;
+          s_ready.push_back(w);
+        }
+      }
+
+      if (s_ready.empty())
+        return;
+
+      VirtualClock::Waiter* w = s_ready.front();
+      s_ready.pop_front();
+      w->granted = true;
+      s_busy = true;
+      pthread_cond_signal(&w->cond);
+    }
+
+    //! Wait for the turn of a waiter. Must be called with s_lock held.
+    static void
+    await(VirtualClock::Waiter* w)
+    {
+      while (!w->granted)
+        pthread_cond_wait(&w->cond, &s_lock);
+
+      t_scheduled = true;
+    }
+
+    //! Give up the turn of the calling thread. Must be called with
+    //! s_lock held.
+    static void
+    release(void)
+    {
+      if (!t_scheduled)
+        return;
+
+      t_scheduled = false;
+      s_busy = false;
+      dispatch();
+    }
+#endif
+
+    bool VirtualClock::s_enabled = false;
+
+    void
+    VirtualClock::enable(void)
+    {
+#if defined(DUNE_SYS_HAS_PTHREAD)
+      s_now.store(Clock::getNsecRT());
+      s_enabled = true;
+#endif
+    }
+
+    uint64_t
+    VirtualClock::getNsec(void)
+    {
+#if defined(DUNE_SYS_HAS_PTHREAD)
+      return s_now.load();
+#else
+      return 0;
+#endif
+    }
+
+    VirtualClock::Waiter*
+    VirtualClock::spawn(void)
+    {
+#if defined(DUNE_SYS_HAS_PTHREAD)
+      if (!s_enabled)
+        return NULL;
+
+      Waiter* ticket = new Waiter;
+      pthread_mutex_lock(&s_lock);
+
+      // Keep the turn until the creator waits, so that the new
+      // thread cannot race with the creator's next actions.
+      if (!t_scheduled)
+      {
+        Waiter self;
+        s_ready.push_back(&self);
+        dispatch();
+        await(&self);
+      }
+
+      s_ready.push_back(ticket);
+      pthread_mutex_unlock(&s_lock);
+      return ticket;
+#else
+      return NULL;
+#endif
+    }
+
+    void
+    VirtualClock::cancel(Waiter* ticket)
+    {
+#if defined(DUNE_SYS_HAS_PTHREAD)
+      if (ticket == NULL)
+        return;
+
+      pthread_mutex_lock(&s_lock);
+      if (ticket->granted)
+      {
+        s_busy = false;
+      }
+      else
+      {
+        for (std::deque<Waiter*>::iterator itr = s_ready.begin(); itr != s_ready.end(); ++itr)
+        {
+          if (*itr == ticket)
+          {
+            s_ready.erase(itr);
+            break;
+          }
+        }
+      }
+      dispatch();
+      pthread_mutex_unlock(&s_lock);
+      delete ticket;
+#else
+      (void)ticket;
+#endif
+    }
+
+    void
+    VirtualClock::enter(Waiter* ticket)
+    {
+#if defined(DUNE_SYS_HAS_PTHREAD)
+      if (ticket == NULL)
+        return;
+
+      pthread_mutex_lock(&s_lock);
+      await(ticket);
+      pthread_mutex_unlock(&s_lock);
+      delete ticket;
+#else
+      (void)ticket;
+#endif
+    }
+
+    void
+    VirtualClock::leave(void)
+    {
+      suspend();
+    }
+
+    bool
+    VirtualClock::suspend(void)
+    {
+#if defined(DUNE_SYS_HAS_PTHREAD)
+      if (!t_scheduled)
+        return false;
+
+      pthread_mutex_lock(&s_lock);
+      release();
+      pthread_mutex_unlock(&s_lock);
+      return true;
+#else
+      return false;
+#endif
+    }
+
+    void
+    VirtualClock::resume(bool scheduled)
+    {
+#if defined(DUNE_SYS_HAS_PTHREAD)
+      if (!scheduled)
+        return;
+
+      Waiter w;
+      pthread_mutex_lock(&s_lock);
+      s_ready.push_back(&w);
+      dispatch();
+      await(&w);
+      pthread_mutex_unlock(&s_lock);
+#else
+      (void)scheduled;
+#endif
+    }
+
+#if defined(DUNE_SYS_HAS_PTHREAD)
+    bool
+    VirtualClock::wait(Waiter** list, pthread_mutex_t* mutex, int64_t nsec)
+    {
+      Waiter w;
+      pthread_mutex_lock(&s_lock);
+
+      if (nsec >= 0)
+      {
+        w.deadline = s_now.load() + nsec;
+        w.seq = s_seq++;
+        w.timed = true;
+        s_timers.insert(&w);
+      }
+
+      if (list != NULL)
+        link(list, &w);
+
+      if (mutex != NULL)
+        pthread_mutex_unlock(mutex);
+
+      release();
+      dispatch();
+      await(&w);
+      pthread_mutex_unlock(&s_lock);
+
+      if (mutex != NULL)
+        pthread_mutex_lock(mutex);
+
+      return !w.expired;
+    }
+#endif
+
+    void
+    VirtualClock::signal(Waiter** list, bool all)
+    {
+#if defined(DUNE_SYS_HAS_PTHREAD)
+      pthread_mutex_lock(&s_lock);
+      while (*list != NULL)
+      {
+        Waiter* w = *list;
+        unlink(w);
+        if (w->timed)
+        {
+          s_timers.erase(w);
+          w->timed = false;
+        }
+        s_ready.push_back(w);
+
+        if (!all)
+          break;
+      }
+      dispatch();
+      pthread_mutex_unlock(&s_lock);
+#else
+      (void)list;
+      (void)all;
+#endif
+    }
+  }
+}
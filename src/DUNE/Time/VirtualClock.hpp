@@ -0,0 +1,144 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+#ifndef DUNE_TIME_VIRTUAL_CLOCK_HPP_INCLUDED_
+#define DUNE_TIME_VIRTUAL_CLOCK_HPP_INCLUDED_
+
+// DUNE headers.
+#include <DUNE/Config.hpp>
+
+// POSIX headers.
+#if defined(DUNE_SYS_HAS_PTHREAD_H)
+#  include <pthread.h>
+#endif
+
+namespace DUNE
+{
+  namespace Time
+  {
+    // Export DLL Symbol.
+    class DUNE_DLL_SYM VirtualClock;
+
+    //! Discrete-event clock for as-fast-as-possible simulations.
+    //!
+    //! When enabled, the monotonic and epoch clocks no longer follow
+    //! the host clock. Threads take turns: only one thread created
+    //! with Concurrency::Thread runs at any given time and it keeps
+    //! running until it waits for something (Delay, Condition). When
+    //! every thread is waiting, logical time jumps to the earliest
+    //! timed wait, which is then resumed. Waiters are resumed in the
+    //! order they were signaled, or by deadline and arrival for
+    //! timeouts, so that runs with the same inputs are repeatable.
+    //!
+    //! Blocking calls that depend on the outside world (I/O polling,
+    //! joining threads) leave the schedule with suspend() and rejoin
+    //! it with resume(). Code must not sleep while holding a mutex
+    //! that another thread needs to reach its next wait.
+    class VirtualClock
+    {
+    public:
+      //! Waiting thread (opaque).
+      struct Waiter;
+
+      //! Enable the virtual clock. Must be called before starting
+      //! any thread. Logical time starts at the current host time.
+      static void
+      enable(void);
+
+      //! Test if the virtual clock is enabled.
+      //! @return true if enabled, false otherwise.
+      static bool
+      isEnabled(void)
+      {
+        return s_enabled;
+      }
+
+      //! Get current logical time.
+      //! @return time in nanoseconds.
+      static uint64_t
+      getNsec(void);
+
+      //! Reserve a turn for a thread about to be created. Called by
+      //! the creating thread so that the new thread is scheduled in a
+      //! deterministic order. The creating thread joins the schedule
+      //! if it was not part of it.
+      //! @return ticket to be passed to enter() or cancel(), NULL if
+      //! the virtual clock is disabled.
+      static Waiter*
+      spawn(void);
+
+      //! Release a ticket of a thread that could not be created.
+      //! @param ticket ticket returned by spawn().
+      static void
+      cancel(Waiter* ticket);
+
+      //! Wait for the first turn of a newly created thread.
+      //! @param ticket ticket returned by spawn().
+      static void
+      enter(Waiter* ticket);
+
+      //! Leave the schedule when the calling thread exits.
+      static void
+      leave(void);
+
+      //! Leave the schedule before a call that blocks on the outside
+      //! world.
+      //! @return value to be passed to resume().
+      static bool
+      suspend(void);
+
+      //! Rejoin the schedule after suspend().
+      //! @param scheduled value returned by suspend().
+      static void
+      resume(bool scheduled);
+
+#if defined(DUNE_SYS_HAS_PTHREAD)
+      //! Wait for a signal or for an amount of logical time.
+      //! @param list list of waiters of a condition or NULL.
+      //! @param mutex mutex to release while waiting or NULL.
+      //! @param nsec amount of time to wait, negative to wait forever.
+      //! @return false if the wait timed out, true otherwise.
+      static bool
+      wait(Waiter** list, pthread_mutex_t* mutex, int64_t nsec);
+#endif
+
+      //! Wake waiters of a condition.
+      //! @param list list of waiters of the condition.
+      //! @param all true to wake all waiters, false to wake the oldest.
+      static void
+      signal(Waiter** list, bool all);
+
+    private:
+      //! True if the virtual clock is enabled.
+      static bool s_enabled;
+    };
+  }
+}
+
+#endif
@@ -28,15 +28,20 @@
 //***************************************************************************
 
 // ISO C++ 98 headers.
+#include <algorithm>
 #include <cstring>
 #include <string>
 #include <cmath>
+#include <utility>
 #include <vector>
 
 // DUNE headers.
 #include <DUNE/DUNE.hpp>
 #include <DUNE/Simulation/UAV.hpp>
 
+// Local headers.
+#include "Team.hpp"
+
 #define vel_lim 0.5
 
 namespace Maneuver
@@ -75,6 +80,8 @@ namespace Maneuver
         double safe_dist;
         double deconfliction_offset;
         double acc_safety_marg;
+        //! Neighbour search radius
+        double neighbour_radius;
         //! Control constraints
         double speed_max;
         double speed_min;
@@ -324,6 +331,12 @@ namespace Maneuver
         std::vector<std::string> m_formation_systems;
         unsigned int m_formation_frame;
         Matrix m_formation_pos;
+        //! Team state arrays, refreshed from the team state matrices
+        TeamState m_team;
+        //! Team neighbour search grid
+        NeighbourGrid m_grid;
+        //! Neighbour search results
+        std::vector<unsigned> m_neighbours;
         IMC::PlanControl m_current_plan;
 
         //! Process logic control variables
@@ -498,6 +511,14 @@ namespace Maneuver
           .defaultValue("0.3")
           .description("Acceleration safety margin");
 
+          param("Neighbour Radius", m_args.neighbour_radius)
+          .defaultValue("0.0")
+          .units(Units::Meter)
+          .minimumValue("0.0")
+          .description("Only team vehicles within this distance contribute to the formation"
+                       " and collision avoidance terms. It is never shorter than twice the deconfliction"
+                       " distance (safety distance plus deconfliction offset). Zero uses the whole team.");
+
           param("Maximum Airspeed", m_args.speed_max)
           .defaultValue("22.0")
           .units(Units::MeterPerSecond)
@@ -2170,54 +2191,43 @@ namespace Maneuver
           spew("Starting periodic update");
           //! Variables initialization
           double d_sim_time;
-          Matrix vi_sim_time = Matrix(m_uav_n+1, 1);
+          std::vector<std::pair<double, unsigned int> > vt_estim_time(m_uav_n+1);
+          std::vector<unsigned int> vi_sim_time;
           unsigned int ind_time;
-          unsigned int i_time_n = m_uav_n;
+          unsigned int i_time_n;
           Matrix vd_cmd = Matrix(3, 1);
           Matrix tmp_last_state_estim = m_last_state_estim;
 
           spew("Periodic update 1");
-          //! Order the update times as an increasing sequence
+          //! Order the update times as an increasing sequence, without repeated times
           for (unsigned int ind_uav = 0; ind_uav <= m_uav_n; ++ind_uav)
-            vi_sim_time(ind_uav) = ind_uav;
+            vt_estim_time[ind_uav] = std::make_pair(m_last_state_estim(ind_uav), ind_uav);
+          std::sort(vt_estim_time.begin(), vt_estim_time.end());
 
           // ToDo - Limit the maximum difference between the current time and the last estimate time
           // for example with the time-out duration
           spew("Update state estimate up to: %1.2f", d_time);
-          for (unsigned int ind_uav = 0; ind_uav < i_time_n; ++ind_uav)
+          for (unsigned int ind_uav = 0; ind_uav <= m_uav_n; ++ind_uav)
           {
-            for (unsigned int ind_uav2 = ind_uav + 1; ind_uav2 <= i_time_n; ++ind_uav2)
-            {
-              if (m_last_state_estim(vi_sim_time(ind_uav)) > m_last_state_estim(vi_sim_time(ind_uav2)))
-              {
-                ind_time = vi_sim_time(ind_uav);
-                vi_sim_time(ind_uav) = vi_sim_time(ind_uav2);
-                vi_sim_time(ind_uav2) = ind_time;
-              }
-              else if (m_last_state_estim(vi_sim_time(ind_uav)) == m_last_state_estim(vi_sim_time(ind_uav2)))
-              {
-                --i_time_n;
-                for (ind_time = ind_uav2; ind_time <= i_time_n; ++ind_time)
-                  vi_sim_time(ind_time) = vi_sim_time(ind_time + 1);
-              }
-            }
-            spew("UAV %1.0f last state estimate: %1.2f",
-                vi_sim_time(ind_uav), m_last_state_estim(vi_sim_time(ind_uav)));
+            if (ind_uav > 0 && vt_estim_time[ind_uav].first == vt_estim_time[ind_uav-1].first)
+              continue;
+            vi_sim_time.push_back(vt_estim_time[ind_uav].second);
+            spew("UAV %u last state estimate: %1.2f",
+                vt_estim_time[ind_uav].second, vt_estim_time[ind_uav].first);
           }
-          spew("UAV %1.0f last state estimate: %1.2f",
-              vi_sim_time(i_time_n), m_last_state_estim(vi_sim_time(i_time_n)));
+          i_time_n = vi_sim_time.size() - 1;
 
           spew("Periodic update 2");
           //! Select the oldest prediction time reference
           ind_time = 0;
-          d_sim_time = m_last_state_estim(vi_sim_time(ind_time));
+          d_sim_time = m_last_state_estim(vi_sim_time[ind_time]);
           // Reset state estimation time, if it is negative
           while (d_sim_time <= 0.0 && ind_time <= i_time_n)
           {
-            m_last_state_estim(vi_sim_time(ind_time)) = d_time;
+            m_last_state_estim(vi_sim_time[ind_time]) = d_time;
             if (ind_time < i_time_n)
               ++ind_time;
-            d_sim_time = m_last_state_estim(vi_sim_time(ind_time));
+            d_sim_time = m_last_state_estim(vi_sim_time[ind_time]);
           }
 
           spew("Periodic update 3");
@@ -2321,6 +2331,9 @@ namespace Maneuver
 
             spew("Periodic update 3.4");
             //! Team control prediction - Update the simulated vehicles commands
+            //! Only the last commanded vehicle changes between control computations
+            bool b_team_updated = false;
+            int i_cmd_changed = -1;
             for (unsigned int ind_uav = 0; ind_uav < m_uav_n; ++ind_uav)
             {
               //! Commands update - At control frequency
@@ -2330,7 +2343,16 @@ namespace Maneuver
               {
                 //spew("Periodic update 3.4.1");
                 //! Asynchronous update team simulated state
-                teamUnevenUpdate(d_sim_time + m_timestep_sim);
+                if (!b_team_updated)
+                {
+                  teamUnevenUpdate(d_sim_time + m_timestep_sim);
+                  b_team_updated = true;
+                }
+                else if (i_cmd_changed >= 0)
+                {
+                  vehicleUnevenUpdate(d_sim_time + m_timestep_sim, i_cmd_changed);
+                  i_cmd_changed = -1;
+                }
 
                 //spew("Periodic update 3.4.2");
                 //! Compute simulated vehicle formation controls
@@ -2351,6 +2373,7 @@ namespace Maneuver
                   //spew("Periodic update 3.4.4");
                   //! Update the control prediction time
                   m_last_simctrl_update(ind_uav) = d_sim_time + m_timestep_sim;
+                  i_cmd_changed = ind_uav;
                 }
                 else
                   war("Simulated control is computing invalid commands");
@@ -2366,7 +2389,7 @@ namespace Maneuver
               ++ind_time;
             else
               ind_time = 0;
-            d_sim_time = m_last_state_estim(vi_sim_time(ind_time));
+            d_sim_time = m_last_state_estim(vi_sim_time[ind_time]);
           }
           spew("Ending periodic update");
         }
@@ -2378,7 +2401,6 @@ namespace Maneuver
           //! Temporary prediction variables initialization
           Matrix vd_pos(6, 1, 0.0);
           Matrix vd_vel(6, 1, 0.0);
-          UAVSimulation model;
           double mt_vehicle_accel[3] = {0, 0, 0};
           double d_cos_psi;
           double d_sin_psi;
@@ -2390,7 +2412,7 @@ namespace Maneuver
           //! - Leader state prediction - Update the simulated vehicle state
           if (m_team_leader_init)
           {
-            model = *m_model;
+            UAVSimulation model = *m_model;
             model.update(d_time - m_last_state_estim(0));
             vd_pos = model.getPosition();
             vd_vel = model.getVelocity();
@@ -2414,38 +2436,71 @@ namespace Maneuver
           //! - Team state prediction - Update the simulated vehicles state
           for (unsigned int ind_uav = 0; ind_uav < m_uav_n; ++ind_uav)
             if (m_vehicle_state_flag[ind_uav])
-            {
-              //spew("Assynchronous update 2.1");
-              //!  * Retrieve current vehicle model
-              model = *m_models[ind_uav];
-
-              //spew("Assynchronous update 2.2");
-              //!  * State update
-              model.update(d_time - m_last_state_estim(ind_uav+1));
-              vd_pos = model.getPosition();
-              vd_vel = model.getVelocity();
-              m_vehicle_state.set(0, 11, ind_uav+1, ind_uav+1,
-                              vd_pos.get(0, 2, 0, 0).
-                              vertCat(vd_vel.get(0, 2, 0, 0).
-                                      vertCat(vd_pos.get(3, 5, 0, 0).
-                                              vertCat(vd_vel.get(3, 5, 0, 0)))));
-              //spew("Assynchronous update 2.3");
-              if (ind_uav != m_uav_ind)
-              {
-                mt_vehicle_accel[1] = m_g*std::tan(vd_pos(3));
-                d_cos_psi = std::cos(vd_pos(5));
-                d_sin_psi = std::sin(vd_pos(5));
-                t_rot[0] = d_cos_psi;
-                t_rot[1] = -d_sin_psi;
-                t_rot[3] = d_sin_psi;
-                t_rot[4] = d_cos_psi;
-                md_rot = Matrix(t_rot, 3, 3);
-                m_vehicle_accel.set(0, 2, ind_uav+1, ind_uav+1, md_rot*Matrix(mt_vehicle_accel, 3, 1));
-              }
-            }
+              predictVehicleState(d_time, ind_uav);
+
+          //! - Team state arrays and neighbour grid
+          m_team.resize(m_uav_n);
+          for (unsigned int ind_uav = 0; ind_uav < m_uav_n; ++ind_uav)
+            m_team.set(ind_uav, m_vehicle_state, m_vehicle_accel, m_formation_pos);
+          if (m_args.neighbour_radius > 0)
+            m_grid.build(m_team, getNeighbourRadius());
           spew("Assynchronous update - End");
         }
 
+        //! Update the simulated state of a single team vehicle for uneven time periods,
+        //! after a full team update to the same time (only its commands changed since)
+        void
+        vehicleUnevenUpdate(const double& d_time, const unsigned int& ind_uav)
+        {
+          predictVehicleState(d_time, ind_uav);
+
+          m_team.set(ind_uav, m_vehicle_state, m_vehicle_accel, m_formation_pos);
+          if (m_args.neighbour_radius > 0)
+            m_grid.update(m_team, ind_uav);
+        }
+
+        //! Predict a team vehicle state from its simulation model
+        void
+        predictVehicleState(const double& d_time, const unsigned int& ind_uav)
+        {
+          Matrix vd_pos(6, 1, 0.0);
+          Matrix vd_vel(6, 1, 0.0);
+          double mt_vehicle_accel[3] = {0, 0, 0};
+          double t_rot[9] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+          //!  * Retrieve current vehicle model
+          UAVSimulation model = *m_models[ind_uav];
+
+          //!  * State update
+          model.update(d_time - m_last_state_estim(ind_uav+1));
+          vd_pos = model.getPosition();
+          vd_vel = model.getVelocity();
+          m_vehicle_state.set(0, 11, ind_uav+1, ind_uav+1,
+                          vd_pos.get(0, 2, 0, 0).
+                          vertCat(vd_vel.get(0, 2, 0, 0).
+                                  vertCat(vd_pos.get(3, 5, 0, 0).
+                                          vertCat(vd_vel.get(3, 5, 0, 0)))));
+          if (ind_uav != m_uav_ind)
+          {
+            mt_vehicle_accel[1] = m_g*std::tan(vd_pos(3));
+            double d_cos_psi = std::cos(vd_pos(5));
+            double d_sin_psi = std::sin(vd_pos(5));
+            t_rot[0] = d_cos_psi;
+            t_rot[1] = -d_sin_psi;
+            t_rot[3] = d_sin_psi;
+            t_rot[4] = d_cos_psi;
+            m_vehicle_accel.set(0, 2, ind_uav+1, ind_uav+1,
+                                Matrix(t_rot, 3, 3)*Matrix(mt_vehicle_accel, 3, 1));
+          }
+        }
+
+        //! Neighbour search radius
+        double
+        getNeighbourRadius(void) const
+        {
+          return std::max(m_args.neighbour_radius, 2 * (m_safe_dist + m_deconfliction_offset));
+        }
+
         void
         formationControl(const Matrix& md_uav_state, const Matrix& md_vehicle_accel,
             const unsigned int& ind_uav, const double& d_time_step, Matrix* vd_cmd,
@@ -2472,7 +2527,6 @@ namespace Maneuver
           double k_deconfliction_dist = m_k_deconfliction*k_form_ref;
           double k_long_dist1 = 1.5;
           double k_long_dist2 = 4;
-          double k_long_dist3 = k_long_dist2-k_long_dist1;
 
           // Reference frame and axes rotation (Ground to Yaw)
           double d_cos_heading = std::cos(md_uav_state(8, ind_uav+1));
@@ -2493,7 +2547,6 @@ namespace Maneuver
           double t_sin_gamma;
           double vt_form_dir[2];
           Matrix vd_form_pos1 = Matrix(2, 1, 0.0);
-          double t_dist_gain;
 
           Matrix vd_inter_uav_state = Matrix(6, 1);
           Matrix vd_inter_uav_pos = Matrix(2, 1);
@@ -2506,26 +2559,17 @@ namespace Maneuver
           Matrix vd_inter_uav_x = Matrix(2, 1);
           Matrix vd_inter_uav_y = Matrix(2, 1);
 
-          double vt_form_pos2[2] = {0, 0};
-          Matrix vd_form_pos2 = Matrix(2, 1, 0.0);
           Matrix vd_inter_uav_des_pos = Matrix(2, 1, 0.0);
           Matrix vd_inter_uav_des_vel = Matrix(2, 1, 0.0);
           Matrix vd_inter_uav_des_acc = Matrix(2, 1, 0.0);
 
           Matrix vd_err = Matrix(2, 1);
-          Matrix vd_orig_err = Matrix(2, 1);
-          double t_err_y;
           double d_err_x;
           double d_err_y;
-          double d_err_x_s_conv;
-          // double d_err_y_s_conv;
-          int int_Max;
           Matrix vd_deriv_err = Matrix(2, 1);
           double d_deriv_err_x;
           double d_deriv_err_y;
 
-          double d_vel_proj_x;
-          double d_vel_proj_y;
           double d_accel_max_proj_x;
           double d_accel_max_proj_y;
 
@@ -2533,21 +2577,10 @@ namespace Maneuver
           double d_c2;
           double d_c3;
           double d_c4;
-          double t_ctrl_marg_mult;
-
-          double d_des_dist;
-          double d_dist2confl;
-          double d_predicted_dist;
-
-          double t_surf_x;
-          double t_surf_y;
 
-          double d_inter_uav_angle_dot;
-          Matrix vt_surf_deriv =  Matrix(2, 1, 0.0);
-
-          Matrix vd_surf_uav = Matrix(2, m_uav_n+1, 0.0);
-          Matrix vt_virt_err_uav = Matrix(2, m_uav_n+1, 0.0);
-          Matrix vd_weight_gain = Matrix(m_uav_n+1, 1, 0.0);
+          //! Leader terms
+          Matrix vd_surf_uav = Matrix(2, 1, 0.0);
+          Matrix vt_virt_err_uav = Matrix(2, 1, 0.0);
 
           //double d_time = Clock::get();
 
@@ -2647,305 +2680,111 @@ namespace Maneuver
           //! Formation UAV sweep
           //-------------------------------------------
 
-          // ToDo - check - verificar inclusão do líder como elemento 0 dos vectores e matrizes
-          // da formação, em vez de elemento m_uav_n em apenas algumas
-          for (unsigned int ind_uav2 = 0; ind_uav2 < m_uav_n; ind_uav2++)
+          //! Pair independent parameters
+          PairParameters pair_params;
+          pair_params.earth_fixed = (m_formation_frame == IMC::Formation::OP_EARTH_FIXED);
+          pair_params.curved = (m_formation_frame == IMC::Formation::OP_PATH_CURVED) &&
+              (md_uav_state(6, 0) != 0);
+          pair_params.turnrate = d_form_turnrate;
+          pair_params.turnrad = d_form_turnrad;
+          pair_params.form_cos = d_cos_form_course;
+          pair_params.form_sin = d_sin_form_course;
+          pair_params.form_pos[0] = vd_form_pos1(0);
+          pair_params.form_pos[1] = vd_form_pos1(1);
+          pair_params.accel_lim_x[0] = vd_body_accel_lim_x(0);
+          pair_params.accel_lim_x[1] = vd_body_accel_lim_x(1);
+          pair_params.accel_lim_y[0] = vd_body_accel_lim_y(0);
+          pair_params.accel_lim_y[1] = vd_body_accel_lim_y(1);
+          pair_params.wind[0] = m_wind(0);
+          pair_params.wind[1] = m_wind(1);
+          pair_params.deconfliction_dist = d_deconfliction_dist;
+          pair_params.deconfliction_offset = m_deconfliction_offset;
+          pair_params.k_deconfliction_dist = k_deconfliction_dist;
+          pair_params.k_long_dist1 = k_long_dist1;
+          pair_params.k_long_dist2 = k_long_dist2;
+          pair_params.speed_max = m_speed_max;
+          pair_params.acc_safety_marg = m_acc_safety_marg;
+          pair_params.speed_rel_min = vel_lim;
+
+          //! Vehicles swept - Whole team or, if a search radius is set, the neighbours
+          //! (the monitored vehicle always sweeps the whole team)
+          bool b_neighbours = m_args.neighbour_radius > 0 && !b_debug;
+          if (b_neighbours)
+            m_grid.query(m_team, ind_uav, getNeighbourRadius(), m_neighbours);
+          unsigned int i_pair_n = b_neighbours ? m_neighbours.size() : m_uav_n;
+
+          //! Weighted sums of the pair terms
+          double d_weight_sum = 0;
+          double vt_surf_sum[2] = {0, 0};
+          double vt_virt_err_sum[2] = {0, 0};
+          double vt_surf_unit_sum[2] = {0, 0};
+          double t_SurfSqr;
+          PairTerms pair;
+
+          for (unsigned int ind_pair = 0; ind_pair < i_pair_n; ind_pair++)
           {
+            unsigned int ind_uav2 = b_neighbours ? m_neighbours[ind_pair] : ind_pair;
+
             // Skipping the current UAV index
             if (ind_uav == ind_uav2)
               continue;
 
-            //debug("formationControl - 2.1");
-            //! Computing relative state, from current UAV to "ind_uav2" UAV
-            vd_inter_uav_state = md_uav_state.get(0, 5, ind_uav2+1, ind_uav2+1) -
-                md_uav_state.get(0, 5, ind_uav+1, ind_uav+1);
-            vd_inter_uav_pos = vd_inter_uav_state.get(0, 1, 0, 0);
-            d_inter_uav_dist = vd_inter_uav_pos.norm_2();
-            //! Computing the rotation matrix - From inter-UAV frame to ground frame
-            d_inter_uav_angle = std::atan2(vd_inter_uav_pos(1),
-                vd_inter_uav_pos(0));
-            d_cos_inter_uav_angle = std::cos(d_inter_uav_angle);
-            d_sin_inter_uav_angle = std::sin(d_inter_uav_angle);
-            mt_rot[0] = d_cos_inter_uav_angle;
-            mt_rot[1] = -d_sin_inter_uav_angle;
-            mt_rot[2] = d_sin_inter_uav_angle;
-            mt_rot[3] = d_cos_inter_uav_angle;
-            md_rot = Matrix(mt_rot, 2, 2);
-            vd_inter_uav_x = md_rot.column(0);
-            vd_inter_uav_y = md_rot.column(1);
-
-            //debug("formationControl - 2.2");
-            //! Computation of the desired formation state:
-            //! - Position vector
-            //! - Velocity vector
-            //! - Acceleration vector
-            if (m_formation_frame == IMC::Formation::OP_EARTH_FIXED)
-            {
-              //! Ground reference frame
-              //! - Position
-              vd_inter_uav_des_pos = m_formation_pos.get(0, 1, ind_uav, ind_uav) -
-                  m_formation_pos.get(0, 1, ind_uav2, ind_uav2);
-              //! - Velocity
-              vd_inter_uav_des_vel = Matrix(2, 1, 0.0);
-              //! - Acceleration
-              vd_inter_uav_des_acc = Matrix(2, 1, 0.0);
-              /* Alternative computation
-            vd_err = -vd_inter_uav_state.get(0, 1, 0, 0) - vd_inter_uav_des_pos;
-            //! - Velocity
-            vd_inter_uav_des_vel = [-vd_err(1); vd_err(0)] * d_form_turnrate;
-            //! - Acceleration
-            vd_inter_uav_des_acc = -vd_err * d_form_turnrate*d_form_turnrate;
-               */
-            }
-            else
-            {
-              //! Path reference frame
-              if ((m_formation_frame == IMC::Formation::OP_PATH_CURVED) &&
-                  (md_uav_state(6, 0) != 0))
-              {
-                //! Curved shape - Formation shape adjustment to path curvature
-                t_uav_turnrad = d_form_turnrad - m_formation_pos(1, ind_uav2);
-                t_cos_gamma = std::cos(m_formation_pos(0, ind_uav2)/d_form_turnrad);
-                t_sin_gamma = std::sin(m_formation_pos(0, ind_uav2)/d_form_turnrad);
-                // - Position
-                vt_form_dir[0] = t_sin_gamma;
-                vt_form_dir[1] = 1 - t_cos_gamma;
-                vt_form_pos2[0] = 0;
-                vt_form_pos2[1] = m_formation_pos(1, ind_uav);
-                vd_form_pos2 = t_uav_turnrad * Matrix(vt_form_dir, 2, 1) +
-                    Matrix(vt_form_pos2, 2, 1);
-                /*
-              //! - Velocity
-              vd_form_vel2 = [-vd_form_pos2(2); vd_form_pos2(1)] * d_form_turnrate;
-              //! - Acceleration
-              vd_form_acc2 = -vd_form_pos2 * d_form_turnrate*d_form_turnrate;
-                 */
-              }
-              else
-              {
-                //! Original shape - Simpler formation shape rotation (below)
-                vd_form_pos2 = m_formation_pos.get(0, 1, ind_uav2, ind_uav2);
-                /*
-              vd_form_vel2 = [-vd_form_pos2(2); vd_form_pos2(1)] * d_form_turnrate;
-              vd_form_acc2 = -vd_form_pos2 * d_form_turnrate*d_form_turnrate;
-                 */
-              }
-
-              vd_inter_uav_des_pos = md_rot_formation * (vd_form_pos1 - vd_form_pos2);
-              //vd_err = -vd_inter_uav_state.get(0, 1, 0, 0) - vd_inter_uav_des_pos;
-              //! - Velocity
-              vd_inter_uav_des_vel(0) = vd_inter_uav_state(1) * d_form_turnrate;
-              vd_inter_uav_des_vel(1) = -vd_inter_uav_state(0) * d_form_turnrate;
-              //vd_inter_uav_des_vel = md_rot_formation * (vd_form_vel1 - vd_form_vel2);
-              //! - Acceleration
-              vd_inter_uav_des_acc = vd_inter_uav_state.get(0, 1, 0, 0)  * d_form_turnrate*d_form_turnrate;
-              //vd_inter_uav_des_acc = md_rot_formation * (vd_form_acc1 - vd_form_acc2);
-            }
-
-            //debug("formationControl - 2.3");
-            //! Relative position error vector
-            vd_err = -vd_inter_uav_state.get(0, 1, 0, 0) - vd_inter_uav_des_pos;
-            d_err_y = Matrix::dot(vd_err, vd_inter_uav_y);
-            d_err_x = Matrix::dot(vd_err, vd_inter_uav_x);
-            // verificar uso de "Booleano" como alternativa a "int_Max",
-            // para optimização do código e da facilidade de interpretação deste
-            if (d_err_x < d_deconfliction_dist - d_inter_uav_dist)
-            {
-              int_Max = 2;
-              d_err_x = d_deconfliction_dist - d_inter_uav_dist;
-            }
-            else
-            {
-              int_Max = 1;
-            }
-            // Original positional error vector, only used for controller performance evaluation
-            vd_orig_err = vd_err;
-
-            //debug("formationControl - 2.4");
-            //! Relative velocity error vector
-            vd_deriv_err = -vd_inter_uav_state.get(3, 4, 0, 0) - vd_inter_uav_des_vel;
-            d_deriv_err_x = Matrix::dot(vd_deriv_err, vd_inter_uav_x);
-            d_deriv_err_y = Matrix::dot(vd_deriv_err, vd_inter_uav_y);
-
-            //! Maneuvering constrains - Projection onto the inter-UAV reference frame
-            d_vel_proj_x = Matrix::dot((md_uav_state.get(3, 4, ind_uav2+1, ind_uav2+1) - m_wind.get(0, 1, 0, 0)),
-                vd_inter_uav_x);
-            //debug("formationControl - 2.4.1");
-            d_accel_max_proj_x = std::abs(Matrix::dot(vd_body_accel_lim_x, vd_inter_uav_x)) +
-                std::abs(Matrix::dot(vd_body_accel_lim_y, vd_inter_uav_x));
-            //debug("formationControl - 2.4.2");
-            d_vel_proj_y = Matrix::dot((md_uav_state.get(3, 4, ind_uav2+1, ind_uav2+1) - m_wind.get(0, 1, 0, 0)),
-                vd_inter_uav_y);
-            //debug("formationControl - 2.4.3");
-            d_accel_max_proj_y = std::abs(Matrix::dot(vd_body_accel_lim_x, vd_inter_uav_y)) +
-                std::abs(Matrix::dot(vd_body_accel_lim_y, vd_inter_uav_y));
-
-            //debug("formationControl - 2.5");
-            //! Sliding Surface parameters - Inter-UAV X axis
-            //! Avoid negative maximum relative velocities - Minimum is hard-coded with "vel_lim"
-            d_c1 = std::max(m_speed_max - d_vel_proj_x, vel_lim);
-            t_ctrl_marg_mult = 2 * m_speed_max/(m_speed_max + d_vel_proj_x);
-            d_c2 = m_deconfliction_offset * t_ctrl_marg_mult;
-            if (d_err_x < 0)
-            {
-              d_c2 = std::max(4 * (1+m_acc_safety_marg) * d_c1*d_c1/(27 * d_accel_max_proj_x), d_c2);
-              /*
-            t_CtrlMarg = d_c2/t_ctrl_marg_mult;
-            d_deconfliction_dist = m_safe_dist + t_CtrlMarg;
-            if (t_CtrlMarg > m_deconfliction_offset*1.1)
-              spew('Control margin: %1.1f m; UAV%d & UAV%d\n', t_CtrlMarg, ind_uav, ind_uav2);
-               */
-            }
-
-            //debug("formationControl - 2.6");
-            //! Limitation of the sliding surface (before reaching negative infinite)
-            if (d_inter_uav_dist < d_deconfliction_dist)
-            {
-              d_err_x = std::min(d_err_x, d_c2*0.5);
-              if (d_deriv_err_x > 0)
-                d_err_x_s_conv = d_err_x;
-              else
-                d_err_x_s_conv = std::min(d_err_x, 0.0);
-            }
-            else
-            {
-              d_err_x = std::min(d_err_x, d_c2*0.5);
-              d_err_x_s_conv = d_err_x;
-            }
-            // d_err_x = std::min(d_err_x, d_c2*0.5);
-
-            //debug("formationControl - 2.7");
-            //! Y projection adjustment, if target is beyond the other UAV
-            if (int_Max == 2)
-            {
-              //! Target point across another UAV position - Define a point
-              //! on the safety rim of the other UAV to follow
-              t_err_y = 2 * d_deconfliction_dist;
-              /*
-            if (d_err_x > 0)
-              t_err_y = 2 * d_deconfliction_dist;
-            else
-              t_err_y = 0.5 * d_deconfliction_dist;
-               */
-              if (t_err_y > std::abs(d_err_y))
-              {
-                if (d_err_y < 0)
-                  d_err_y = -t_err_y;
-                else
-                  d_err_y = t_err_y;
-              }
-            }
-            vd_err(0) = d_err_x;
-            vd_err(1) = d_err_y;
-            vd_err = md_rot*vd_err;
-
-            //debug("formationControl - 2.8");
-            //! UAV-pair - Regulation of control importance
-            d_des_dist = vd_inter_uav_des_pos.norm_2();
-            // Inter-UAV distance compensated for the current inter-UAV velocity
-            // Takes into account the vehicle acceleration limitations
-            d_predicted_dist = d_inter_uav_dist + std::min(0.0, d_deriv_err_x*std::abs(d_deriv_err_x)*
-                (1+m_acc_safety_marg)/d_accel_max_proj_x);
-            d_dist2confl = d_predicted_dist-d_deconfliction_dist;
-            if (d_dist2confl < 0)
-              // Control weight increment if the predicted distance is shorter than the deconfliction distance
-              vd_weight_gain(ind_uav2+1) = 1 + d_dist2confl/m_deconfliction_offset *
-                  d_dist2confl/m_deconfliction_offset * k_deconfliction_dist;
-            else if (d_predicted_dist <= d_des_dist*k_long_dist1)
-              vd_weight_gain(ind_uav2+1) = 1;
-            else if (d_predicted_dist < d_des_dist*k_long_dist2)
-            {
-              // Control weight reduction if the predicted distance is larger than
-              // the desired distance by "k_long_dist1"
-              t_dist_gain = (d_predicted_dist-d_des_dist*k_long_dist1)/(d_des_dist*k_long_dist3);
-              vd_weight_gain(ind_uav2+1) = 1 - t_dist_gain*t_dist_gain;
-            }
-            else
-              // Control weight anulation if the predicted distance is larger than
-              // the desired distance multiplied by "k_long_dist2"
-              vd_weight_gain(ind_uav2+1) = 0;
-
-            //debug("formationControl - 2.9");
-            //! Sliding Surface parameters - Inter-UAV Y axis
-            if (d_err_y < 0)
-            {
-              //! Avoid negative maximum relative velocities - Minimum is hard-coded with "vel_lim" m/s
-              d_c3 = std::max(m_speed_max - d_vel_proj_y, vel_lim);
-              d_c4 = 4 * (1+m_acc_safety_marg) * d_c3*d_c3/(27 * d_accel_max_proj_y);
-            }
-            else
-            {
-              //! Avoid positive minimum relative velocities - Maximum is hard-coded with -"vel_lim" m/s
-              d_c3 = std::min(- m_speed_max - d_vel_proj_y, -vel_lim);
-              d_c4 = - 4 * (1+m_acc_safety_marg) * d_c3*d_c3/(27 * d_accel_max_proj_y);
-            }
-
-            //! ======= Sliding surface ==============
-
-            //debug("formationControl - 2.10");
-            t_surf_x = d_c1 * d_err_x/(d_err_x - d_c2);
-            t_surf_y = d_c3 * d_err_y/(d_err_y - d_c4);
-            //! Sliding surface deviation
-            vd_surf_uav.set(0, 1, ind_uav2+1, ind_uav2+1,
-                            vd_deriv_err - t_surf_x * vd_inter_uav_x - t_surf_y * vd_inter_uav_y);
-
-            //! ======= Virtual error and feedback linearization ================
-            d_inter_uav_angle_dot = Matrix::dot(vd_inter_uav_state.get(3, 4, 0, 0),
-                vd_inter_uav_y/d_inter_uav_dist);
-            // d_inter_uav_angle_dot = 0;
-            vt_surf_deriv(0) = d_c1*d_c2*d_deriv_err_x/((d_err_x_s_conv - d_c2)*(d_err_x_s_conv - d_c2)) +
-                t_surf_y * d_inter_uav_angle_dot;
-            vt_surf_deriv(1) = d_c3 * d_c4 * d_deriv_err_y/((d_err_y - d_c4)*(d_err_y - d_c4)) -
-                t_surf_x * d_inter_uav_angle_dot;
-            vt_virt_err_uav.set(0, 1, ind_uav2+1, ind_uav2+1,
-                                md_vehicle_accel.get(0, 1, ind_uav2+1, ind_uav2+1) +
-                                vd_inter_uav_des_acc - md_rot * vt_surf_deriv);
+            //! Pair terms, skipped if the pair has no weight in the control
+            if (!computePairTerms(m_team, ind_uav, ind_uav2, pair_params, b_debug, pair))
+              continue;
 
             //debug("formationControl - 2.11");
             //! Tracking output
             if (b_debug)
             {
+              double vt_inter_uav_x[2] = {pair.dir_cos, pair.dir_sin};
+              double vt_inter_uav_y[2] = {-pair.dir_sin, pair.dir_cos};
+
               rel_state = form_monitor->rel_state[ind_uav2+1];
               //! Vehicle identifier;
               rel_state->s_id = m_formation_systems[ind_uav2];
               //! Distance between vehicles
-              rel_state->dist = d_inter_uav_dist;
-              // // ======== Formation perturbation test - Mesh stability =======
-              // if (ind_uav == 1)
-              //   vd_orig_err += vd_Pert;
-              // end
-              // // ======== Formation perturbation test - Mesh stability =======
+              rel_state->dist = pair.dist;
               //! Relative position error norm
-              rel_state->err =  vd_orig_err.norm_2();
+              rel_state->err = pair.err_norm;
+              //! Weight in the control (normalized below)
+              rel_state->ctrl_imp = pair.weight;
               //! Inter-vehicle direction vector
-              rel_state->rel_dir_x = vd_inter_uav_x(0);
-              rel_state->rel_dir_y = vd_inter_uav_x(1);
-              //rel_state->rel_dir_z = vd_inter_uav_x(2);
+              rel_state->rel_dir_x = vt_inter_uav_x[0];
+              rel_state->rel_dir_y = vt_inter_uav_x[1];
               //! Relative position error - Ground reference frame
-              // // ======== Formation perturbation test - Mesh stability =======
-              // if ind_UAV == 1
-              //   vd_err = vd_err + vd_Pert;
-              // end
-              // // ======== Formation perturbation test - Mesh stability =======
-              rel_state->err_x = vd_err(0);
-              rel_state->err_y = vd_err(1);
-              //rel_state->err_z = vd_err(2);
+              rel_state->err_x = pair.err[0];
+              rel_state->err_y = pair.err[1];
               //! Relative position error - Inter-vehicle reference frame
-              rel_state->rf_err_x = Matrix::dot(vd_err ,vd_inter_uav_x);
-              rel_state->rf_err_y = Matrix::dot(vd_err, vd_inter_uav_y);
-              //rel_state->rf_err_z = Matrix::dot(vd_err, vd_inter_uav_z);
+              rel_state->rf_err_x = pair.err[0]*vt_inter_uav_x[0] + pair.err[1]*vt_inter_uav_x[1];
+              rel_state->rf_err_y = pair.err[0]*vt_inter_uav_y[0] + pair.err[1]*vt_inter_uav_y[1];
               //! Relative velocity error - Inter-vehicle reference frame
-              rel_state->rf_err_vx = Matrix::dot(vd_deriv_err, vd_inter_uav_x);
-              rel_state->rf_err_vy = Matrix::dot(vd_deriv_err, vd_inter_uav_y);
-              //rel_state->rf_err_vz = Matrix::dot(vd_deriv_err, vd_inter_uav_z);
+              rel_state->rf_err_vx = pair.deriv_err[0]*vt_inter_uav_x[0] + pair.deriv_err[1]*vt_inter_uav_x[1];
+              rel_state->rf_err_vy = pair.deriv_err[0]*vt_inter_uav_y[0] + pair.deriv_err[1]*vt_inter_uav_y[1];
               //! Deviation from convergence (sliding surface) - Inter-vehicle reference frame
-              rel_state->ss_x = Matrix::dot(vd_surf_uav.get(0, 1, ind_uav2+1, ind_uav2+1), vd_inter_uav_x);
-              rel_state->ss_y = Matrix::dot(vd_surf_uav.get(0, 1, ind_uav2+1, ind_uav2+1), vd_inter_uav_y);
-              //rel_state->ss_z = Matrix::dot(vd_surf_uav.get(0, 1, ind_uav2+1, ind_uav2+1), vd_inter_uav_z);
+              rel_state->ss_x = pair.surf[0]*vt_inter_uav_x[0] + pair.surf[1]*vt_inter_uav_x[1];
+              rel_state->ss_y = pair.surf[0]*vt_inter_uav_y[0] + pair.surf[1]*vt_inter_uav_y[1];
               //! Inter-vehicle virtual error - Ground reference frame
-              rel_state->virt_err_x = vt_virt_err_uav(0, ind_uav2+1);
-              rel_state->virt_err_y = vt_virt_err_uav(1, ind_uav2+1);
-              //rel_state->virt_err_z = vt_virt_err_uav(2, ind_uav2+1);
+              rel_state->virt_err_x = pair.virt_err[0];
+              rel_state->virt_err_y = pair.virt_err[1];
+            }
+
+            if (pair.weight == 0)
+              continue;
+
+            //! Sliding surface and virtual error mixing
+            d_weight_sum += pair.weight;
+            vt_surf_sum[0] += pair.weight*pair.surf[0];
+            vt_surf_sum[1] += pair.weight*pair.surf[1];
+            vt_virt_err_sum[0] += pair.weight*pair.virt_err[0];
+            vt_virt_err_sum[1] += pair.weight*pair.virt_err[1];
+
+            //! UAVs Uncertainty compensation
+            t_SurfSqr = pair.surf[0]*pair.surf[0] + pair.surf[1]*pair.surf[1];
+            if (t_SurfSqr > 0)
+            {
+              vt_surf_unit_sum[0] += 2*pair.surf[0]*pair.weight/std::sqrt(t_SurfSqr);
+              vt_surf_unit_sum[1] += 2*pair.surf[1]*pair.weight/std::sqrt(t_SurfSqr);
             }
           }
 
@@ -2955,8 +2794,6 @@ namespace Maneuver
           //!---------------------------------------------------------------
 
           int ind_uav_lead = 0;
-          //! Regulation of control importance
-          vd_weight_gain(ind_uav_lead) = 1;
 
           //! Computing relative state, from current UAV to leader
           vd_inter_uav_state = md_uav_state.get(0, 5, ind_uav_lead, ind_uav_lead) -
@@ -3164,12 +3001,9 @@ namespace Maneuver
           //! Control influence merging
           //!-------------------------------------------
 
-          //! UAV weight on control strategy
-          Matrix vd_ctrl_weight = Matrix(m_uav_n+1, 1, 1.0);
-          vd_ctrl_weight(0) = k_form_ref;
-          vd_ctrl_weight(ind_uav+1) = 0;
-          vd_ctrl_weight &= vd_weight_gain;
-          vd_ctrl_weight /= sum(vd_ctrl_weight);
+          //! UAV weight on control strategy - Leader weight and normalization
+          double d_lead_weight = k_form_ref;
+          d_weight_sum += d_lead_weight;
 
           //! Tracking output
           if (b_debug)
@@ -3178,13 +3012,20 @@ namespace Maneuver
             {
               if (ind_uav+1 == ind_uav2)
                 continue;
-              form_monitor->rel_state[ind_uav2]->ctrl_imp = vd_ctrl_weight(ind_uav2);
+              if (ind_uav2 == 0)
+                form_monitor->rel_state[ind_uav2]->ctrl_imp = d_lead_weight/d_weight_sum;
+              else
+                form_monitor->rel_state[ind_uav2]->ctrl_imp /= d_weight_sum;
             }
           }
 
           //! Sliding surface data mixing
-          Matrix vd_surf = vd_surf_uav * vd_ctrl_weight;
-          Matrix vt_virt_err = vt_virt_err_uav * vd_ctrl_weight;
+          double vt_surf[2] = {(vt_surf_sum[0] + d_lead_weight*vd_surf_uav(0, ind_uav_lead))/d_weight_sum,
+              (vt_surf_sum[1] + d_lead_weight*vd_surf_uav(1, ind_uav_lead))/d_weight_sum};
+          double vt_virt_err_mix[2] = {(vt_virt_err_sum[0] + d_lead_weight*vt_virt_err_uav(0, ind_uav_lead))/d_weight_sum,
+              (vt_virt_err_sum[1] + d_lead_weight*vt_virt_err_uav(1, ind_uav_lead))/d_weight_sum};
+          Matrix vd_surf = Matrix(vt_surf, 2, 1);
+          Matrix vt_virt_err = Matrix(vt_virt_err_mix, 2, 1);
 
           /*
           // Debug
@@ -3224,26 +3065,12 @@ namespace Maneuver
           // vd_surf_unkn1 = ((m_uav_n-1)/(m_uav_n-1+k_form_ref)+1)*...
           //     m_flow_accel_max*vd_surf_unit;
 
-          vd_surf_unit = Matrix(2, 1);
-
           //! UAVs Uncertainty compensation
-          double t_SurfSqr;
-          for (unsigned int ind_uav2 = 0; ind_uav2 < m_uav_n; ind_uav2++)
-          {
-            // Skipping the current UAV index
-            if (ind_uav == ind_uav2)
-              continue;
-
-            t_SurfSqr = vd_surf_uav(0, ind_uav2+1)*vd_surf_uav(0, ind_uav2+1) +
-                vd_surf_uav(1, ind_uav2+1)*vd_surf_uav(1, ind_uav2+1);
-            if (t_SurfSqr > 0)
-              vd_surf_unit += 2*vd_surf_uav.get(0, 1, ind_uav2+1, ind_uav2+1)*
-                  vd_ctrl_weight(ind_uav2+1)/std::sqrt(t_SurfSqr);
-          }
+          vd_surf_unit = Matrix(vt_surf_unit_sum, 2, 1)/d_weight_sum;
           //! Leader - Uncertainty compensation
           t_SurfSqr = vd_surf_uav(0, 0)*vd_surf_uav(0, 0) + vd_surf_uav(1, 0)*vd_surf_uav(1, 0);
           if (t_SurfSqr)
-            vd_surf_unit += k_form_ref*vd_surf_uav.get(0, 1, 0, 0)*vd_ctrl_weight(0)/std::sqrt(t_SurfSqr);
+            vd_surf_unit += k_form_ref*vd_surf_uav.get(0, 1, 0, 0)*d_lead_weight/d_weight_sum/std::sqrt(t_SurfSqr);
           //! Formation - Uncertainty compensation
           Matrix vd_surf_unkn = vd_surf_unit*m_flow_accel_max/(m_uav_n-1+k_form_ref);
           /*
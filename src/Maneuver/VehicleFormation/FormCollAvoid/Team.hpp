@@ -0,0 +1,482 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+#ifndef MANEUVER_VEHICLE_FORMATION_FORM_COLL_AVOID_TEAM_HPP_INCLUDED_
+#define MANEUVER_VEHICLE_FORMATION_FORM_COLL_AVOID_TEAM_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/Math/Matrix.hpp>
+
+namespace Maneuver
+{
+  namespace VehicleFormation
+  {
+    namespace FormCollAvoid
+    {
+      //! Horizontal state of the formation vehicles (leader excluded),
+      //! stored as one contiguous array per quantity and indexed by
+      //! vehicle.
+      struct TeamState
+      {
+        //! Position.
+        std::vector<double> x;
+        std::vector<double> y;
+        //! Velocity.
+        std::vector<double> vx;
+        std::vector<double> vy;
+        //! Acceleration.
+        std::vector<double> ax;
+        std::vector<double> ay;
+        //! Position in the formation shape.
+        std::vector<double> form_x;
+        std::vector<double> form_y;
+
+        //! Number of vehicles.
+        unsigned
+        size(void) const
+        {
+          return x.size();
+        }
+
+        //! Resize the team.
+        //! @param[in] n number of vehicles.
+        void
+        resize(unsigned n)
+        {
+          x.resize(n);
+          y.resize(n);
+          vx.resize(n);
+          vy.resize(n);
+          ax.resize(n);
+          ay.resize(n);
+          form_x.resize(n);
+          form_y.resize(n);
+        }
+
+        //! Copy the state of one vehicle from the task matrices, where
+        //! column zero of the state and acceleration belongs to the leader.
+        //! @param[in] i vehicle index.
+        //! @param[in] state team state (12 x number of vehicles + 1).
+        //! @param[in] accel team acceleration (3 x number of vehicles + 1).
+        //! @param[in] form formation shape (3 x number of vehicles).
+        void
+        set(unsigned i, const DUNE::Math::Matrix& state,
+            const DUNE::Math::Matrix& accel, const DUNE::Math::Matrix& form)
+        {
+          x[i] = state(0, i + 1);
+          y[i] = state(1, i + 1);
+          vx[i] = state(3, i + 1);
+          vy[i] = state(4, i + 1);
+          ax[i] = accel(0, i + 1);
+          ay[i] = accel(1, i + 1);
+          form_x[i] = form(0, i);
+          form_y[i] = form(1, i);
+        }
+      };
+
+      //! Parameters of the inter-vehicle control terms that do not
+      //! depend on the pair of vehicles.
+      struct PairParameters
+      {
+        //! Formation shape defined in the earth fixed frame.
+        bool earth_fixed;
+        //! Formation shape bent to the path curvature.
+        bool curved;
+        //! Formation turn rate and turn radius.
+        double turnrate;
+        double turnrad;
+        //! Formation course rotation (cosine and sine).
+        double form_cos;
+        double form_sin;
+        //! Position of the controlled vehicle in the formation shape.
+        double form_pos[2];
+        //! Controlled vehicle acceleration limits in the ground frame.
+        double accel_lim_x[2];
+        double accel_lim_y[2];
+        //! Wind velocity.
+        double wind[2];
+        //! Deconfliction distance and offset.
+        double deconfliction_dist;
+        double deconfliction_offset;
+        //! Control weight gain below the deconfliction distance.
+        double k_deconfliction_dist;
+        //! Distance multipliers (of the desired distance) where the control
+        //! weight starts decreasing and where it reaches zero.
+        double k_long_dist1;
+        double k_long_dist2;
+        //! Maximum speed.
+        double speed_max;
+        //! Acceleration safety margin.
+        double acc_safety_marg;
+        //! Minimum relative speed in the sliding surface.
+        double speed_rel_min;
+      };
+
+      //! Control terms of a pair of vehicles.
+      struct PairTerms
+      {
+        //! Distance between vehicles.
+        double dist;
+        //! Inter-vehicle direction (cosine and sine).
+        double dir_cos;
+        double dir_sin;
+        //! Relative position error norm (before limitation).
+        double err_norm;
+        //! Relative position error - Ground reference frame.
+        double err[2];
+        //! Relative velocity error - Ground reference frame.
+        double deriv_err[2];
+        //! Deviation from convergence (sliding surface).
+        double surf[2];
+        //! Virtual error.
+        double virt_err[2];
+        //! Control weight gain.
+        double weight;
+      };
+
+      //! Compute the control terms of vehicle 'i' relative to vehicle 'j'.
+      //! The control weight is computed first and, unless 'complete' is
+      //! set, the remaining terms are skipped when it is zero.
+      //! @param[in] team team state.
+      //! @param[in] i controlled vehicle.
+      //! @param[in] j other vehicle.
+      //! @param[in] p pair parameters.
+      //! @param[in] complete compute every term regardless of the weight.
+      //! @param[out] t pair control terms.
+      //! @return false if the pair has no weight and was skipped, true otherwise.
+      inline bool
+      computePairTerms(const TeamState& team, unsigned i, unsigned j,
+                       const PairParameters& p, bool complete, PairTerms& t)
+      {
+        //! Relative state, from vehicle 'i' to vehicle 'j'.
+        double rx = team.x[j] - team.x[i];
+        double ry = team.y[j] - team.y[i];
+        double rvx = team.vx[j] - team.vx[i];
+        double rvy = team.vy[j] - team.vy[i];
+        double dist = std::sqrt(rx * rx + ry * ry);
+
+        //! Inter-vehicle reference frame (x axis towards the other vehicle).
+        double c = 1.0;
+        double s = 0.0;
+        if (dist > 0)
+        {
+          c = rx / dist;
+          s = ry / dist;
+        }
+
+        //! Desired relative position, velocity and acceleration.
+        double des_pos[2];
+        double des_vel[2] = {0.0, 0.0};
+        double des_acc[2] = {0.0, 0.0};
+        if (p.earth_fixed)
+        {
+          des_pos[0] = team.form_x[i] - team.form_x[j];
+          des_pos[1] = team.form_y[i] - team.form_y[j];
+        }
+        else
+        {
+          double form_pos2[2];
+          if (p.curved)
+          {
+            //! Curved shape - Formation shape adjustment to path curvature.
+            double turnrad = p.turnrad - team.form_y[j];
+            double gamma = team.form_x[j] / p.turnrad;
+            form_pos2[0] = turnrad * std::sin(gamma);
+            form_pos2[1] = turnrad * (1 - std::cos(gamma)) + team.form_y[i];
+          }
+          else
+          {
+            form_pos2[0] = team.form_x[j];
+            form_pos2[1] = team.form_y[j];
+          }
+
+          double dx = p.form_pos[0] - form_pos2[0];
+          double dy = p.form_pos[1] - form_pos2[1];
+          des_pos[0] = p.form_cos * dx - p.form_sin * dy;
+          des_pos[1] = p.form_sin * dx + p.form_cos * dy;
+          des_vel[0] = ry * p.turnrate;
+          des_vel[1] = -rx * p.turnrate;
+          des_acc[0] = rx * p.turnrate * p.turnrate;
+          des_acc[1] = ry * p.turnrate * p.turnrate;
+        }
+
+        //! Relative position error.
+        double ex = -rx - des_pos[0];
+        double ey = -ry - des_pos[1];
+        double err_x = ex * c + ey * s;
+        double err_y = -ex * s + ey * c;
+        bool across = false;
+        if (err_x < p.deconfliction_dist - dist)
+        {
+          across = true;
+          err_x = p.deconfliction_dist - dist;
+        }
+
+        //! Relative velocity error.
+        double gx = -rvx - des_vel[0];
+        double gy = -rvy - des_vel[1];
+        double deriv_err_x = gx * c + gy * s;
+        double deriv_err_y = -gx * s + gy * c;
+
+        //! Maneuvering constrains - Projection onto the inter-vehicle frame.
+        double wvx = team.vx[j] - p.wind[0];
+        double wvy = team.vy[j] - p.wind[1];
+        double vel_proj_x = wvx * c + wvy * s;
+        double vel_proj_y = -wvx * s + wvy * c;
+        double accel_max_proj_x = std::abs(p.accel_lim_x[0] * c + p.accel_lim_x[1] * s)
+        + std::abs(p.accel_lim_y[0] * c + p.accel_lim_y[1] * s);
+        double accel_max_proj_y = std::abs(-p.accel_lim_x[0] * s + p.accel_lim_x[1] * c)
+        + std::abs(-p.accel_lim_y[0] * s + p.accel_lim_y[1] * c);
+
+        //! Regulation of control importance, from the inter-vehicle distance
+        //! compensated for the current inter-vehicle velocity.
+        double des_dist = std::sqrt(des_pos[0] * des_pos[0] + des_pos[1] * des_pos[1]);
+        double predicted_dist = dist + std::min(0.0, deriv_err_x * std::abs(deriv_err_x)
+                                                * (1 + p.acc_safety_marg) / accel_max_proj_x);
+        double dist2confl = predicted_dist - p.deconfliction_dist;
+        if (dist2confl < 0)
+        {
+          double r = dist2confl / p.deconfliction_offset;
+          t.weight = 1 + r * r * p.k_deconfliction_dist;
+        }
+        else if (predicted_dist <= des_dist * p.k_long_dist1)
+        {
+          t.weight = 1;
+        }
+        else if (predicted_dist < des_dist * p.k_long_dist2)
+        {
+          double r = (predicted_dist - des_dist * p.k_long_dist1)
+          / (des_dist * (p.k_long_dist2 - p.k_long_dist1));
+          t.weight = 1 - r * r;
+        }
+        else
+        {
+          t.weight = 0;
+        }
+
+        if (t.weight == 0 && !complete)
+          return false;
+
+        //! Sliding surface parameters - Inter-vehicle x axis.
+        double c1 = std::max(p.speed_max - vel_proj_x, p.speed_rel_min);
+        double c2 = p.deconfliction_offset * 2 * p.speed_max / (p.speed_max + vel_proj_x);
+        if (err_x < 0)
+          c2 = std::max(4 * (1 + p.acc_safety_marg) * c1 * c1 / (27 * accel_max_proj_x), c2);
+
+        //! Limitation of the sliding surface (before reaching negative infinite).
+        err_x = std::min(err_x, c2 * 0.5);
+        double err_x_s_conv = err_x;
+        if (dist < p.deconfliction_dist && deriv_err_x <= 0)
+          err_x_s_conv = std::min(err_x, 0.0);
+
+        //! Target point across the other vehicle - Follow a point on its safety rim.
+        if (across)
+        {
+          double rim = 2 * p.deconfliction_dist;
+          if (rim > std::abs(err_y))
+            err_y = (err_y < 0) ? -rim : rim;
+        }
+
+        //! Sliding surface parameters - Inter-vehicle y axis.
+        double c3;
+        double c4;
+        if (err_y < 0)
+        {
+          c3 = std::max(p.speed_max - vel_proj_y, p.speed_rel_min);
+          c4 = 4 * (1 + p.acc_safety_marg) * c3 * c3 / (27 * accel_max_proj_y);
+        }
+        else
+        {
+          c3 = std::min(-p.speed_max - vel_proj_y, -p.speed_rel_min);
+          c4 = -4 * (1 + p.acc_safety_marg) * c3 * c3 / (27 * accel_max_proj_y);
+        }
+
+        //! Sliding surface deviation.
+        double surf_x = c1 * err_x / (err_x - c2);
+        double surf_y = c3 * err_y / (err_y - c4);
+        t.surf[0] = gx - surf_x * c + surf_y * s;
+        t.surf[1] = gy - surf_x * s - surf_y * c;
+
+        //! Virtual error and feedback linearization.
+        double angle_dot = (-rvx * s + rvy * c) / dist;
+        double sd_x = c1 * c2 * deriv_err_x / ((err_x_s_conv - c2) * (err_x_s_conv - c2))
+        + surf_y * angle_dot;
+        double sd_y = c3 * c4 * deriv_err_y / ((err_y - c4) * (err_y - c4))
+        - surf_x * angle_dot;
+        t.virt_err[0] = team.ax[j] + des_acc[0] - (c * sd_x - s * sd_y);
+        t.virt_err[1] = team.ay[j] + des_acc[1] - (s * sd_x + c * sd_y);
+
+        //! Monitoring data.
+        t.dist = dist;
+        t.dir_cos = c;
+        t.dir_sin = s;
+        t.err_norm = std::sqrt(ex * ex + ey * ey);
+        t.err[0] = c * err_x - s * err_y;
+        t.err[1] = s * err_x + c * err_y;
+        t.deriv_err[0] = gx;
+        t.deriv_err[1] = gy;
+        return true;
+      }
+
+      //! Uniform grid over the horizontal positions of the team, used to
+      //! find the vehicles within a given radius without sweeping the
+      //! whole team. Cells are hashed into a table of buckets sized to
+      //! the team, so the grid needs no bounds.
+      class NeighbourGrid
+      {
+      public:
+        //! Constructor.
+        NeighbourGrid(void):
+          m_cell(0.0),
+          m_mask(0)
+        { }
+
+        //! Place the team vehicles in cells.
+        //! @param[in] team team state.
+        //! @param[in] cell cell size (largest query radius).
+        void
+        build(const TeamState& team, double cell)
+        {
+          unsigned n = team.size();
+          unsigned buckets = 1;
+          while (buckets < 2 * n)
+            buckets *= 2;
+
+          m_cell = cell;
+          m_mask = buckets - 1;
+          m_cx.resize(n);
+          m_cy.resize(n);
+          m_items.resize(n);
+          m_start.assign(buckets + 1, 0);
+
+          for (unsigned i = 0; i < n; ++i)
+          {
+            m_cx[i] = cellOf(team.x[i]);
+            m_cy[i] = cellOf(team.y[i]);
+            ++m_start[bucket(m_cx[i], m_cy[i]) + 1];
+          }
+
+          for (unsigned b = 0; b < buckets; ++b)
+            m_start[b + 1] += m_start[b];
+
+          m_fill.assign(m_start.begin(), m_start.end() - 1);
+          for (unsigned i = 0; i < n; ++i)
+            m_items[m_fill[bucket(m_cx[i], m_cy[i])]++] = i;
+        }
+
+        //! Update the cell of one vehicle after its position changed.
+        //! @param[in] team team state.
+        //! @param[in] i vehicle index.
+        void
+        update(const TeamState& team, unsigned i)
+        {
+          if (cellOf(team.x[i]) != m_cx[i] || cellOf(team.y[i]) != m_cy[i])
+            build(team, m_cell);
+        }
+
+        //! Find the vehicles closer to a given vehicle than a radius no
+        //! larger than the cell size.
+        //! @param[in] team team state.
+        //! @param[in] i vehicle index.
+        //! @param[in] radius search radius.
+        //! @param[out] neighbours neighbour indices (vehicle 'i' excluded).
+        void
+        query(const TeamState& team, unsigned i, double radius,
+              std::vector<unsigned>& neighbours) const
+        {
+          neighbours.clear();
+          double radius_sqr = radius * radius;
+
+          for (int dx = -1; dx <= 1; ++dx)
+          {
+            for (int dy = -1; dy <= 1; ++dy)
+            {
+              int cx = m_cx[i] + dx;
+              int cy = m_cy[i] + dy;
+              unsigned b = bucket(cx, cy);
+
+              for (unsigned k = m_start[b]; k < m_start[b + 1]; ++k)
+              {
+                unsigned j = m_items[k];
+                // Skip other cells sharing the bucket.
+                if (j == i || m_cx[j] != cx || m_cy[j] != cy)
+                  continue;
+
+                double rx = team.x[j] - team.x[i];
+                double ry = team.y[j] - team.y[i];
+                if (rx * rx + ry * ry <= radius_sqr)
+                  neighbours.push_back(j);
+              }
+            }
+          }
+        }
+
+      private:
+        //! Cell size.
+        double m_cell;
+        //! Bucket index mask.
+        unsigned m_mask;
+        //! Cell coordinates of each vehicle.
+        std::vector<int> m_cx;
+        std::vector<int> m_cy;
+        //! First item of each bucket.
+        std::vector<unsigned> m_start;
+        //! Vehicle indices sorted by bucket.
+        std::vector<unsigned> m_items;
+        //! Bucket fill cursors.
+        std::vector<unsigned> m_fill;
+
+        //! Cell coordinate of a position.
+        int
+        cellOf(double v) const
+        {
+          double c = std::floor(v / m_cell);
+          // Non-finite or out of range positions share a single cell.
+          if (!(std::abs(c) < 1e9))
+            return 0;
+          return static_cast<int>(c);
+        }
+
+        //! Bucket of a cell.
+        unsigned
+        bucket(int cx, int cy) const
+        {
+          return ((static_cast<unsigned>(cx) * 73856093u) ^ (static_cast<unsigned>(cy) * 19349663u)) & m_mask;
+        }
+      };
+    }
+  }
+}
+
+#endif
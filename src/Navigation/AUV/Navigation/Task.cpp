@@ -292,6 +292,7 @@ namespace Navigation
 
           // Extended Kalman Filter initialization.
           m_kal.reset(NUM_STATE, NUM_OUT);
+          m_kal.setSequentialUpdates(true);
           resetKalman();
           m_heading_buffer=0;
 
@@ -568,8 +569,7 @@ namespace Navigation
           Matrix a(NUM_STATE, NUM_STATE, 0.0);
           setTransition(a);
 
-          Matrix x(NUM_STATE, 1, 0.0);
-          x = m_kal.getState();
+          const Matrix& x = m_kal.getState();
 
           m_kal.setStateTransition((a * tstep).expmts());
 
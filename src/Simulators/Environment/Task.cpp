@@ -29,13 +29,12 @@
 //***************************************************************************
 
 // ISO C++ 98 headers.
-#include <iomanip>
+#include <algorithm>
+#include <vector>
 
 // DUNE headers.
 #include <DUNE/DUNE.hpp>
-
-// Local headers.
-#include "QuadTree.hpp"
+#include <DUNE/Simulation/Bathymetry.hpp>
 
 namespace Simulators
 {
@@ -49,8 +48,8 @@ namespace Simulators
     using std::sin;
     using std::cos;
 
-    //! Number of points in the forward direction for bottom intersection
-    static const unsigned c_forward_points = 10;
+    //! Number of beams simulated per echo sounder (beam axis and edges).
+    static const unsigned c_beams = 5;
 
     class PencilBeam
     {
@@ -143,6 +142,8 @@ namespace Simulators
       double oob_depth;
       //! Interpolation radius.
       double interp_radius;
+      //! Distance between bathymetry grid nodes.
+      double grid_cell;
       // Forward distance arguments
       //! Standard deviation of the forward distance estimates
       double fd_std_dev;
@@ -195,8 +196,8 @@ namespace Simulators
       double m_a_n, m_a_e, m_b_n, m_b_e;
       //! PRNG handle.
       Random::Generator* m_prng;
-      //! The tree.
-      QuadTree* m_qtree;
+      //! Bathymetry grid.
+      Simulation::Bathymetry m_bathy;
       //! Reference latitude and longitude for data points.
       double m_ref_lat, m_ref_lon;
       //! NE offsets in regard to navigational reference.
@@ -209,7 +210,6 @@ namespace Simulators
       Task(const std::string& name, Tasks::Context& ctx):
         Tasks::Periodic(name, ctx),
         m_prng(NULL),
-        m_qtree(NULL),
         m_pb(NULL)
       {
         param("Simulate - Bottom Distance", m_args.simulate_bd)
@@ -248,7 +248,16 @@ namespace Simulators
 
         param("Interpolation Radius", m_args.interp_radius)
         .units(Units::Meter)
-        .defaultValue("10.0");
+        .defaultValue("10.0")
+        .description("Radius of the bathymetry samples used to compute the depth of each"
+                     " grid node, when the grid is created from the bathymetry samples");
+
+        param("Grid Cell Size", m_args.grid_cell)
+        .units(Units::Meter)
+        .defaultValue("5.0")
+        .minimumValue("0.1")
+        .description("Distance between bathymetry grid nodes, when the grid is created"
+                     " from the bathymetry samples");
 
         param("Simulate Pier", m_args.simulate_pier)
         .defaultValue("false")
@@ -354,7 +363,6 @@ namespace Simulators
       onResourceRelease(void)
       {
         Memory::clear(m_prng);
-        Memory::clear(m_qtree);
         Memory::clear(m_pb);
       }
 
@@ -393,6 +401,9 @@ namespace Simulators
           m_pb = new PencilBeam(&m_args.pb);
         }
 
+        m_bathy.setOffset(m_args.tide);
+        m_bathy.setDefaultDepth(m_args.oob_depth);
+
         debug("pier point A lat: %0.6f, lon: %0.6f", m_args.pier[0], m_args.pier[1]);
         debug("pier point B lat: %0.6f, lon: %0.6f", m_args.pier[2], m_args.pier[3]);
       }
@@ -401,50 +412,35 @@ namespace Simulators
       onResourceInitialization(void)
       {
         Utils::String::toLowerCase(m_args.location);
-        Path path = m_ctx.dir_cfg / "simulation" / ("bathymetry-" + m_args.location + ".ini");
-        DUNE::Parsers::Config cfg(path.c_str());
-        std::vector<std::string> lines;
-        cfg.get("Bathymetry", "Data", "", lines);
-        cfg.get("Bathymetry", "Latitude (degrees)", "", m_ref_lat);
-        cfg.get("Bathymetry", "Longitude (degrees)", "", m_ref_lon);
-
-        debug("%s | %0.6f, %0.6f", m_args.location.c_str(), m_ref_lat, m_ref_lon);
-        debug("%s | %s", m_args.location.c_str(), path.c_str());
-        debug("%s | %lu %s", m_args.location.c_str(), (long unsigned int)lines.size(), "bathymetry values");
+        Path base = m_ctx.dir_cfg / "simulation" / ("bathymetry-" + m_args.location);
+        Path grid = base + ".bin";
 
-        m_ref_lat = Angles::radians(m_ref_lat);
-        m_ref_lon = Angles::radians(m_ref_lon);
-
-        std::vector<QuadTree::Item> data;
-        QuadTree::Item item;
-        Bounds* bounds = 0;
-
-        for (unsigned i = 0; i < lines.size(); ++i)
+        if (grid.exists())
         {
-          std::vector<double> v;
-          DUNE::Utils::String::split(lines[i], " ", v);
-          if (!bounds)
-            bounds = new Bounds(Point(v[0], v[1]));
-          else
-            bounds->cover(Point(v[0], v[1]));
-          item.x = v[0]; item.y = v[1]; item.value = v[2];
-          data.push_back(item);
+          m_bathy.load(grid.str());
+          debug("%s | %s", m_args.location.c_str(), grid.c_str());
+        }
+        else
+        {
+          Path path = base + ".ini";
+          double lat = 0;
+          double lon = 0;
+          std::vector<Simulation::Bathymetry::Sample> samples;
+          Simulation::Bathymetry::readSamples(path.str(), lat, lon, samples);
+
+          debug("%s | %s", m_args.location.c_str(), path.c_str());
+          debug("%s | %lu %s", m_args.location.c_str(), (long unsigned int)samples.size(), "bathymetry values");
+
+          m_bathy.create(lat, lon, samples, m_args.grid_cell, m_args.interp_radius);
+          inf(DTR("bathymetry grid created from %s, convert it with dune-bathymetry for faster startup"),
+              path.c_str());
         }
 
-        std::stringstream ss;
-        ss << *bounds;
-        trace("bounds: %s", ss.str().c_str());
-
-        // Fill the tree
-        m_qtree = new QuadTree(*bounds);
-        delete bounds;
-
-        for (unsigned i = 0; i < data.size(); ++i)
-          m_qtree->insert(data[i]);
+        debug("%s | %0.6f, %0.6f", m_args.location.c_str(), m_bathy.getLatitude(), m_bathy.getLongitude());
+        trace("grid nodes: %u x %u", m_bathy.getRows(), m_bathy.getColumns());
 
-        ss.clear();
-        ss << *m_qtree;
-        trace("tree elements: %s", ss.str().c_str());
+        m_ref_lat = Angles::radians(m_bathy.getLatitude());
+        m_ref_lon = Angles::radians(m_bathy.getLongitude());
 
         m_bd.beam_config.clear();
         m_bd.location.clear();
@@ -542,9 +538,11 @@ namespace Simulators
       inline void
       updateBottomDistance(void)
       {
-        double depth = depthAt(m_sstate.x + m_off_n, m_sstate.y + m_off_e);
+        double depth = m_bathy.getDepth(m_sstate.x + m_off_n, m_sstate.y + m_off_e);
+        double max_range = 2.0 * std::max(depth, m_args.oob_depth);
+        double range = bottomRange(m_args.bottom_orientation, m_args.bottom_width, 0.0, max_range);
         double error = m_prng->gaussian() * m_args.bd_std_dev;
-        m_bd.value = std::max(0.0, depth - m_sstate.z + error);
+        m_bd.value = std::max(0.0, range + error);
         m_bd.validity = IMC::Distance::DV_VALID;
         dispatch(m_bd);
 
@@ -554,45 +552,6 @@ namespace Simulators
               m_bd.value, error);
       }
 
-      //! Compute depth at a certian (x, y) position
-      //! @param[in] x coordinate of position
-      //! @param[in] y coordinate of position
-      //! @return depth at specified point
-      double
-      depthAt(double x, double y)
-      {
-        Point p(x, y);
-        Bounds search_area(p, m_args.interp_radius);
-
-        std::vector<QuadTree::Item> items;
-
-        m_qtree->search(search_area, items);
-
-        if (items.size() == 0)
-        {
-          trace("out of bounds");
-          return m_args.oob_depth;
-        }
-
-        trace("found %lu close data values", (long unsigned int)items.size());
-
-        // @todo interpolate rather than picking closest one
-        double dmin = p.distance(Point(items[0].x, items[0].y));
-        double depth = items[0].value;
-
-        for (unsigned int i = 1; i < items.size(); ++i)
-        {
-          double d = p.distance(Point(items[i].x, items[i].y));
-          if (d < dmin)
-          {
-            dmin = d;
-            depth = items[i].value;
-          }
-        }
-
-        return depth + m_args.tide;
-      }
-
       //! Update forward distance value taking into account
       //! obstacles and the bottom
       inline void
@@ -651,7 +610,8 @@ namespace Simulators
 
           if (m_args.intersect_method)
           {
-            range = std::min(range, bottomIntersection());
+            range = std::min(range, bottomRange(m_args.forward_orientation, m_args.forward_width,
+                                                psi_offset, m_args.max_range));
           }
           else
           {
@@ -699,57 +659,58 @@ namespace Simulators
         return range;
       }
 
-      //! Compute the depths of c_forward_points in front of the vehicle
-      //! Use connections between these points as line segments
-      //! and intersect them with lower beam part of the echo sounder.
-      //! @return range after intersection
-      double
-      bottomIntersection(void)
+      //! Compute the directions of the beams of an echo sounder in the
+      //! navigation frame: the beam axis and, if the beam has width,
+      //! the four edges of the beam.
+      //! @param[in] orientation echo sounder orientation in the body frame.
+      //! @param[in] width beam width.
+      //! @param[in] psi_offset echo sounder yaw offset.
+      //! @param[out] dirs beam directions (north, east, down).
+      //! @return number of beams.
+      unsigned
+      getBeams(const std::vector<float>& orientation, double width, double psi_offset,
+               double dirs[c_beams][3])
       {
-        double intersect_range = m_args.max_range;
-
-        double x_step = m_args.max_range / (double)c_forward_points;
-
-        std::vector<float> fwd_depths(c_forward_points);
-
-        fwd_depths[0] = depthAt(m_sstate.x + m_off_n, m_sstate.y + m_off_e);
-
-        // x and z coordinates of the end of the forward beam
-        double x_target, z_target;
+        static const double c_edges[c_beams][2] = {{0, 0}, {1, 0}, {-1, 0}, {0, 1}, {0, -1}};
 
-        x_target = m_args.max_range * cos(m_sstate.theta - m_args.forward_width / 2.0);
-        z_target = - m_args.max_range * sin(m_sstate.theta - m_args.forward_width / 2.0);
-        z_target += m_sstate.z; // SHOULD NOT BE Z BUT DEPTH
-
-        for (unsigned i = 1; i < c_forward_points; i++)
+        unsigned count = (width > 0) ? c_beams : 1;
+        for (unsigned i = 0; i < count; ++i)
         {
-          double xe = (double)i * x_step * cos(m_sstate.psi);
-          double ye = (double)i * x_step * sin(m_sstate.psi);
-
-          fwd_depths[i] = depthAt(m_sstate.x + m_off_n + xe, m_sstate.y + m_off_e + ye);
-
-          double bottom_x_1 = (double)(i - 1) * x_step;
-          double bottom_z_1 = fwd_depths[i - 1];
-
-          double bottom_x_2 = (double)i * x_step;
-          double bottom_z_2 = fwd_depths[i];
+          double elevation = c_edges[i][0] * width / 2.0;
+          double azimuth = c_edges[i][1] * width / 2.0;
+          double bx, by, bz;
+
+          BodyFixedFrame::toInertialFrame((double)orientation[0], (double)orientation[1],
+                                          orientation[2] + psi_offset,
+                                          cos(elevation) * cos(azimuth),
+                                          cos(elevation) * sin(azimuth),
+                                          -sin(elevation), &bx, &by, &bz);
+          BodyFixedFrame::toInertialFrame((double)m_sstate.phi, (double)m_sstate.theta, (double)m_sstate.psi,
+                                          bx, by, bz, &dirs[i][0], &dirs[i][1], &dirs[i][2]);
+        }
 
-          double x, z;
+        return count;
+      }
 
-          bool test_int = lineSegmentIntersect(LineSegParam<double>(0.0, m_sstate.z,
-                                                                    x_target, z_target,
-                                                                    bottom_x_1, bottom_z_1,
-                                                                    bottom_x_2, bottom_z_2),
-                                               &x, &z); // SHOULD NOT BE STATE.Z BUT DEPTH
+      //! Compute the range to the bottom seen by an echo sounder, as the
+      //! nearest bottom return of its beams.
+      //! @param[in] orientation echo sounder orientation in the body frame.
+      //! @param[in] width beam width.
+      //! @param[in] psi_offset echo sounder yaw offset.
+      //! @param[in] max_range maximum range.
+      //! @return range to the bottom or maximum range.
+      double
+      bottomRange(const std::vector<float>& orientation, double width, double psi_offset,
+                  double max_range)
+      {
+        double dirs[c_beams][3];
+        double ranges[c_beams];
 
-          if (test_int)
-          {
-            intersect_range = Math::norm(x, z - m_sstate.z); // SHOULD NOT BE Z BUT DEPTH
-            break;
-          }
-        }
+        unsigned count = getBeams(orientation, width, psi_offset, dirs);
+        m_bathy.getRanges(m_sstate.x + m_off_n, m_sstate.y + m_off_e, m_sstate.z,
+                          dirs, count, max_range, ranges);
 
-        return intersect_range;
+        return *std::min_element(ranges, ranges + count);
       }
     };
   }
@@ -0,0 +1,450 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+#ifndef TRANSPORTS_CACHE_STORE_HPP_INCLUDED_
+#define TRANSPORTS_CACHE_STORE_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+#if defined(DUNE_SYS_HAS_FCNTL_H)
+#  include <fcntl.h>
+#endif
+
+#if defined(DUNE_SYS_HAS_UNISTD_H)
+#  include <unistd.h>
+#endif
+
+namespace Transports
+{
+  namespace Cache
+  {
+    using DUNE_NAMESPACES;
+
+    //! Minimum number of stale bytes before compacting the store.
+    static const uint64_t c_compaction_minimum = 64 * 1024;
+
+    //! Log-structured store of cached messages. Messages are appended
+    //! to a single segment file as IMC packets, so that the segment
+    //! is itself a valid LSF file and every record is protected by
+    //! the packet CRC. An in-memory index maps each message (by
+    //! identification number and sub identification number) to its
+    //! most recent record. Records made stale by newer versions are
+    //! reclaimed by rewriting the live records in loading order once
+    //! they outweigh them. Records that fail to parse when the store
+    //! is opened (e.g., a write interrupted by a power loss) are
+    //! discarded along with everything after them. Every record is
+    //! synchronized to disk before it is indexed.
+    class Store
+    {
+    public:
+      //! Constructor.
+      //! @param[in] path path to segment file.
+      Store(const Path& path):
+        m_path(path),
+        m_fd(NULL),
+        m_live(0),
+        m_dead(0),
+        m_end(0)
+      { }
+
+      //! Destructor.
+      ~Store(void)
+      {
+        closeSegment();
+      }
+
+      //! Set the loading order.
+      //! @param[in] order abbreviations of messages to load first.
+      void
+      setOrder(const std::vector<std::string>& order)
+      {
+        m_order.clear();
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+          try
+          {
+            m_order.push_back(IMC::Factory::getIdFromAbbrev(order[i]));
+          }
+          catch (...)
+          { }
+        }
+      }
+
+      //! Open the store, recovering from interrupted writes.
+      //! @return number of bytes discarded.
+      uint64_t
+      open(void)
+      {
+        closeSegment();
+        m_records.clear();
+        m_live = 0;
+        m_dead = 0;
+        m_end = 0;
+
+        uint64_t discarded = 0;
+        if (m_path.isFile())
+        {
+          FileSystem::MappedFile file(m_path.str());
+          m_end = scan(file);
+          discarded = file.getSize() - m_end;
+        }
+
+        // Compaction truncates the discarded data.
+        if (discarded > 0 || needsCompaction())
+          compact();
+        else
+          openSegment("ab");
+
+        return discarded;
+      }
+
+      //! Store a message, replacing the previous version.
+      //! @param[in] msg message.
+      void
+      put(const IMC::Message* msg)
+      {
+        IMC::Packet::serialize(msg, m_buffer);
+
+        size_t rv = std::fwrite(m_buffer.getBuffer(), 1, m_buffer.getSize(), m_fd);
+        if (rv != m_buffer.getSize() || !sync(m_fd))
+        {
+          // Rewrite the segment to drop a partial record.
+          compact();
+          throw FileSystem::FileWriteError(m_path.str(), "failed to append record");
+        }
+
+        index(msg->getId(), msg->getSubId(), m_end, m_buffer.getSize());
+        m_end += m_buffer.getSize();
+
+        if (needsCompaction())
+          compact();
+      }
+
+      //! Remove all messages.
+      void
+      clear(void)
+      {
+        m_records.clear();
+        m_live = 0;
+        m_dead = 0;
+        m_end = 0;
+        openSegment("wb");
+        syncDirectory();
+      }
+
+      //! Retrieve all messages in loading order.
+      //! @param[out] msgs messages, to be deleted by the caller.
+      void
+      get(std::vector<IMC::Message*>& msgs)
+      {
+        if (m_records.empty())
+          return;
+
+        FileSystem::MappedFile file(m_path.str());
+
+        std::vector<Record*> records;
+        sort(records);
+
+        for (size_t i = 0; i < records.size(); ++i)
+        {
+          const Record* r = records[i];
+          msgs.push_back(IMC::Packet::deserialize(file.getData() + r->offset, r->size));
+        }
+      }
+
+      //! Write an LSF file with all messages, in loading order.
+      //! @param[in] destination destination file.
+      //! @return false if the store is empty, true otherwise.
+      bool
+      copy(const Path& destination)
+      {
+        if (m_records.empty())
+          return false;
+
+        if (m_dead > 0)
+          compact();
+
+        FileSystem::MappedFile file(m_path.str());
+
+        std::ofstream ofs(destination.c_str(), std::ios::binary | std::ios::trunc);
+        ofs.write(reinterpret_cast<const char*>(file.getData()), m_end);
+        ofs.close();
+        if (ofs.fail())
+          throw FileSystem::FileWriteError(destination.str());
+
+        return true;
+      }
+
+      //! Retrieve number of bytes used by current records.
+      uint64_t
+      getLiveBytes(void) const
+      {
+        return m_live;
+      }
+
+      //! Retrieve number of bytes used by stale records.
+      uint64_t
+      getStaleBytes(void) const
+      {
+        return m_dead;
+      }
+
+    private:
+      //! Location of the current record of a message.
+      struct Record
+      {
+        //! Offset in the segment.
+        uint64_t offset;
+        //! Size of the packet.
+        uint16_t size;
+      };
+
+      //! Records indexed by identification number and sub
+      //! identification number.
+      typedef std::map<uint32_t, Record> RecordMap;
+
+      //! Path to segment file.
+      Path m_path;
+      //! Segment file.
+      std::FILE* m_fd;
+      //! Current records.
+      RecordMap m_records;
+      //! Loading order.
+      std::vector<uint16_t> m_order;
+      //! Serialization buffer.
+      ByteBuffer m_buffer;
+      //! Bytes used by current records.
+      uint64_t m_live;
+      //! Bytes used by stale records.
+      uint64_t m_dead;
+      //! End of the last record.
+      uint64_t m_end;
+
+      //! Index a record.
+      void
+      index(uint16_t id, uint16_t sub_id, uint64_t offset, uint16_t size)
+      {
+        Record& r = m_records[((uint32_t)id << 16) | sub_id];
+        if (r.size > 0)
+        {
+          m_live -= r.size;
+          m_dead += r.size;
+        }
+
+        r.offset = offset;
+        r.size = size;
+        m_live += size;
+      }
+
+      //! Index all valid records of a segment.
+      //! @param[in] file segment contents.
+      //! @return end of the last valid record.
+      uint64_t
+      scan(const FileSystem::MappedFile& file)
+      {
+        const uint8_t* data = file.getData();
+        size_t size = file.getSize();
+        size_t pos = 0;
+
+        while (pos + DUNE_IMC_CONST_HEADER_SIZE <= size)
+        {
+          try
+          {
+            IMC::Header hdr;
+            IMC::Packet::deserializeHeader(hdr, data + pos, DUNE_IMC_CONST_HEADER_SIZE);
+
+            size_t len = DUNE_IMC_CONST_HEADER_SIZE + hdr.size + DUNE_IMC_CONST_FOOTER_SIZE;
+            if (pos + len > size || len > 0xffff)
+              break;
+
+            // Deserialization verifies the CRC.
+            IMC::Message* msg = IMC::Packet::deserialize(data + pos, len);
+            index(msg->getId(), msg->getSubId(), pos, len);
+            delete msg;
+            pos += len;
+          }
+          catch (std::exception&)
+          {
+            break;
+          }
+        }
+
+        return pos;
+      }
+
+      //! Sort records in loading order.
+      //! @param[out] records records.
+      void
+      sort(std::vector<Record*>& records)
+      {
+        records.reserve(m_records.size());
+
+        for (size_t i = 0; i < m_order.size(); ++i)
+        {
+          RecordMap::iterator itr = m_records.lower_bound((uint32_t)m_order[i] << 16);
+          for (; itr != m_records.end() && (itr->first >> 16) == m_order[i]; ++itr)
+            records.push_back(&itr->second);
+        }
+
+        for (RecordMap::iterator itr = m_records.begin(); itr != m_records.end(); ++itr)
+        {
+          if (std::find(m_order.begin(), m_order.end(), itr->first >> 16) == m_order.end())
+            records.push_back(&itr->second);
+        }
+      }
+
+      //! Test if stale records should be reclaimed.
+      bool
+      needsCompaction(void) const
+      {
+        return m_dead >= c_compaction_minimum && m_dead > m_live;
+      }
+
+      //! Rewrite the segment with current records only, in loading
+      //! order. The new segment replaces the old one atomically.
+      void
+      compact(void)
+      {
+        closeSegment();
+
+        std::string tmp = m_path.str() + ".tmp";
+        std::vector<Record*> records;
+        sort(records);
+
+        {
+          FileSystem::MappedFile file;
+          if (!m_records.empty())
+            file.open(m_path.str());
+
+          std::FILE* fd = std::fopen(tmp.c_str(), "wb");
+          bool ok = (fd != NULL);
+          for (size_t i = 0; ok && i < records.size(); ++i)
+            ok = std::fwrite(file.getData() + records[i]->offset, 1, records[i]->size, fd) == records[i]->size;
+
+          // Make sure the data is on disk before it replaces the segment.
+          ok = ok && sync(fd);
+          if (fd != NULL)
+            ok = (std::fclose(fd) == 0) && ok;
+
+          if (!ok)
+          {
+            std::remove(tmp.c_str());
+            openSegment("ab");
+            throw FileSystem::FileWriteError(tmp, "failed to compact");
+          }
+        }
+
+        if (std::rename(tmp.c_str(), m_path.c_str()) != 0)
+        {
+          std::remove(tmp.c_str());
+          openSegment("ab");
+          throw FileSystem::FileWriteError(m_path.str());
+        }
+
+        syncDirectory();
+
+        uint64_t end = 0;
+        for (size_t i = 0; i < records.size(); ++i)
+        {
+          records[i]->offset = end;
+          end += records[i]->size;
+        }
+
+        m_end = end;
+        m_dead = 0;
+        openSegment("ab");
+      }
+
+      //! Open the segment.
+      //! @param[in] mode open mode ("ab" to append, "wb" to truncate).
+      void
+      openSegment(const char* mode)
+      {
+        closeSegment();
+        m_fd = std::fopen(m_path.c_str(), mode);
+        if (m_fd == NULL)
+          throw FileSystem::FileWriteError(m_path.str());
+      }
+
+      //! Close the segment.
+      void
+      closeSegment(void)
+      {
+        if (m_fd == NULL)
+          return;
+
+        std::fclose(m_fd);
+        m_fd = NULL;
+      }
+
+      //! Flush a file and synchronize it to disk.
+      //! @param[in] fd file.
+      //! @return true on success, false otherwise.
+      static bool
+      sync(std::FILE* fd)
+      {
+        if (std::fflush(fd) != 0)
+          return false;
+
+#if defined(DUNE_SYS_HAS_UNISTD_H)
+        return fsync(fileno(fd)) == 0;
+#else
+        return true;
+#endif
+      }
+
+      //! Synchronize the directory of the segment to disk, so that a
+      //! renamed or created segment survives a power loss.
+      void
+      syncDirectory(void)
+      {
+#if defined(DUNE_SYS_HAS_FCNTL_H) && defined(DUNE_SYS_HAS_UNISTD_H)
+        std::string dir = m_path.dirname().str();
+        int fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY);
+        if (fd < 0)
+          return;
+
+        fsync(fd);
+        ::close(fd);
+#endif
+      }
+    };
+  }
+}
+
+#endif
@@ -29,13 +29,14 @@
 
 // ISO C++ 98 headers.
 #include <string>
-#include <fstream>
-#include <iostream>
-#include <algorithm>
+#include <vector>
 
 // DUNE headers.
 #include <DUNE/DUNE.hpp>
 
+// Local headers.
+#include "Store.hpp"
+
 namespace Transports
 {
   namespace Cache
@@ -52,41 +53,32 @@ namespace Transports
     {
       // Cache directory path.
       Path m_path;
-      // Path to snapshot file.
-      Path m_snapshot;
-      // Internal buffer.
-      uint8_t* m_buffer;
-      // Internal buffer size.
-      uint16_t m_buffer_size;
+      // Message store.
+      Store m_store;
       // Task arguments.
       Arguments m_args;
 
       Task(const std::string& name, Tasks::Context& ctx):
-        DUNE::Tasks::Task(name, ctx)
+        DUNE::Tasks::Task(name, ctx),
+        m_path(m_ctx.dir_db / "Cache"),
+        m_store(m_path / (std::string(DUNE_IMC_CONST_MD5) + ".lsf"))
       {
         // Define configuration parameters.
         param("Loading Order", m_args.order)
         .defaultValue("")
         .description("List of messages ordered by loading order");
 
-        // Initialize internal buffer.
-        m_buffer_size = 128;
-        m_buffer = new uint8_t[m_buffer_size];
-
         // Create cache directory.
-        m_path = m_ctx.dir_db / "Cache";
         m_path.create();
 
-        // Set snapshot file path.
-        m_snapshot = m_path / (std::string(DUNE_IMC_CONST_MD5) + ".lsf");
-
         // Bind messages.
         bind<IMC::CacheControl>(this);
       }
 
-      ~Task(void)
+      void
+      onUpdateParameters(void)
       {
-        delete [] m_buffer;
+        m_store.setOrder(m_args.order);
       }
 
       void
@@ -119,143 +111,80 @@ namespace Transports
       }
 
       void
-      getMessageFiles(std::vector<std::string>& files)
+      store(const IMC::Message* msg)
       {
-        std::vector<std::string> msgs = m_args.order;
-        const char* fname = 0;
-
-        // Retrieve the name of all cached messages that are not in the
-        // loading order list.
         try
         {
-          Directory dir(m_path);
-
-          while ((fname = dir.readEntry(Directory::RD_FILE_NAME)))
-          {
-            if (std::find(msgs.begin(), msgs.end(), fname) == msgs.end()
-                && ((m_path / fname).type() == Path::PT_DIRECTORY))
-            {
-              msgs.push_back(fname);
-            }
-          }
-        }
-        catch (...)
-        { }
-
-        // Load cached messages.
-        for (unsigned int i = 0; i < msgs.size(); ++i)
-        {
-          try
-          {
-            Directory md(m_path / msgs[i]);
-            while ((fname = md.readEntry(Directory::RD_FULL_NAME)))
-              files.push_back(fname);
-          }
-          catch (...)
-          { }
+          m_store.put(msg);
         }
-      }
-
-      void
-      growBuffer(int size)
-      {
-        if (size > m_buffer_size)
+        catch (std::exception& e)
         {
-          delete [] m_buffer;
-          m_buffer_size = size;
-          m_buffer = new uint8_t[m_buffer_size];
+          err(DTR("failed to store message: %s"), e.what());
         }
       }
 
       void
-      store(const IMC::Message* msg)
+      removeLegacyFiles(void)
       {
-        std::string id = String::str(msg->getSubId());
-        uint16_t size = msg->getSerializationSize();
-
-        // Create destination directory.
-        Path path = m_path / msg->getName();
-        path.create();
-
-        // Open file for writing.
-        path = path / id;
-        std::ofstream ofs(path.c_str(), std::ios::binary);
-
-        growBuffer(size);
+        // Older versions kept one file per message in a directory per
+        // message name. Their contents are also in the store.
+        std::vector<std::string> dirs;
+        const char* fname = 0;
 
-        // Write message to file.
-        IMC::Packet::serialize(msg, m_buffer, size);
-        ofs.write((char*)m_buffer, size);
-        ofs.close();
+        try
+        {
+          Directory dir(m_path);
+          while ((fname = dir.readEntry(Directory::RD_FULL_NAME)))
+          {
+            if (Path(fname).type() == Path::PT_DIRECTORY)
+              dirs.push_back(fname);
+          }
 
-        storeSnapshot();
+          for (unsigned i = 0; i < dirs.size(); ++i)
+            Path(dirs[i]).remove(Path::MODE_RECURSIVE);
+        }
+        catch (std::exception& e)
+        {
+          war(DTR("failed to remove old cache files: %s"), e.what());
+        }
       }
 
       void
       loadSnapshot(void)
       {
-        if (m_snapshot.type() != Path::PT_FILE)
+        try
         {
-          clear();
-          return;
+          uint64_t discarded = m_store.open();
+          if (discarded > 0)
+            war(DTR("discarded %llu bytes of incomplete or corrupted records"),
+                (unsigned long long)discarded);
         }
-
-        std::ifstream ifs(m_snapshot.c_str(), std::ios::binary);
-
-        if (!ifs.is_open())
-          return;
-
-        while (!ifs.eof())
+        catch (std::exception& e)
         {
-          IMC::Message* msg = IMC::Packet::deserialize(ifs);
-          if (msg)
-          {
-            dispatch(msg, DF_KEEP_TIME);
-            delete msg;
-          }
+          err(DTR("failed to open cache, clearing: %s"), e.what());
+          clear();
         }
-      }
 
-      void
-      storeSnapshot(void)
-      {
-        // Retrieve file list.
-        std::vector<std::string> files;
-        getMessageFiles(files);
-
-        std::ofstream ofs(m_snapshot.c_str(), std::ios::binary);
-
-        // Copy all cached messages to a single file.
-        for (unsigned int i = 0; i < files.size(); ++i)
-        {
-          int64_t size = Path(files[i]).size();
-
-          if (size < 0)
-            continue;
+        removeLegacyFiles();
+        load();
 
-          growBuffer(size);
-
-          std::ifstream ifs(files[i].c_str(), std::ios::binary);
-          ifs.read((char*)m_buffer, size);
-          ofs.write((char*)m_buffer, size);
-        }
+        debug("%llu bytes cached", (unsigned long long)m_store.getLiveBytes());
       }
 
       void
       copySnapshot(Path destination)
       {
-        if (!Path(m_snapshot).exists())
-          return;
-
         try
         {
-          Path(m_snapshot).copy(destination);
+          if (!m_store.copy(destination))
+            return;
+
           IMC::CacheControl cc;
           cc.op = IMC::CacheControl::COP_COPY_COMPLETE;
           cc.snapshot = destination.str();
           dispatch(cc);
         }
-        catch (System::Error& e)
+        catch (std::exception& e)
         {
           err(DTR("failed to copy cache snapshot: %s"), e.what());
         }
@@ -264,27 +193,35 @@ namespace Transports
       void
       load(void)
       {
-        std::vector<std::string> files;
-        getMessageFiles(files);
+        std::vector<IMC::Message*> msgs;
 
-        for (unsigned int i = 0; i < files.size(); ++i)
+        try
         {
-          std::ifstream ifs(files[i].c_str(), std::ios::binary);
-          IMC::Message* msg = IMC::Packet::deserialize(ifs);
-          if (msg)
-          {
-            dispatch(msg, DF_KEEP_TIME);
-            delete msg;
-          }
+          m_store.get(msgs);
+        }
+        catch (std::exception& e)
+        {
+          err(DTR("failed to load cache: %s"), e.what());
+        }
+
+        for (unsigned int i = 0; i < msgs.size(); ++i)
+        {
+          dispatch(msgs[i], DF_KEEP_TIME);
+          delete msgs[i];
         }
       }
 
       void
       clear(void)
       {
-        // Remove cache directory and create a new one.
-        m_path.remove(Path::MODE_RECURSIVE);
-        m_path.create();
+        try
+        {
+          m_store.clear();
+        }
+        catch (std::exception& e)
+        {
+          err(DTR("failed to clear cache: %s"), e.what());
+        }
       }
 
       void
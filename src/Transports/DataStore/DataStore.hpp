@@ -32,11 +32,21 @@
 #define MINIMUM_SAMPLE_SIZE 15
 
 // ISO C++ 98 headers.
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <set>
 #include <string>
+#include <vector>
 
 // DUNE headers.
 #include <DUNE/DUNE.hpp>
 
+#if defined(DUNE_SYS_HAS_UNISTD_H)
+#  include <unistd.h>
+#endif
+
 namespace Transports
 {
   namespace DataStore
@@ -80,20 +90,69 @@ namespace Transports
       }
     };
 
-    class CompareSamples
+    //! Sample kept by the store. The message is kept serialized,
+    //! which takes a fraction of the memory of a message object.
+    struct StoredSample
     {
-    public:
-      bool operator()(const DataSample* p1, const DataSample* p2) const
+      //! Sample global coordinates.
+      double latDegs, lonDegs, zMeters, timestamp;
+      //! Priority of the sample.
+      int priority;
+      //! The system that generated this sample.
+      int source;
+      //! Message identification number.
+      uint16_t id;
+      //! Insertion order, used to break ties.
+      uint64_t seq;
+      //! Serialized message fields.
+      std::vector<uint8_t> payload;
+
+      int
+      serializationSize(void) const
       {
-        return p1->priority <= p2->priority && p1->timestamp < p2->timestamp;
+        return (int)payload.size() + MINIMUM_SAMPLE_SIZE;
+      }
+    };
+
+    //! Transmission order: higher priority first, newer first.
+    //! Samples are evicted from the end.
+    struct RankOrder
+    {
+      bool
+      operator()(const StoredSample* a, const StoredSample* b) const
+      {
+        if (a->priority != b->priority)
+          return a->priority > b->priority;
+        if (a->timestamp != b->timestamp)
+          return a->timestamp > b->timestamp;
+        return a->seq < b->seq;
+      }
+    };
+
+    //! Chronological order.
+    struct TimeOrder
+    {
+      bool
+      operator()(const StoredSample* a, const StoredSample* b) const
+      {
+        if (a->timestamp != b->timestamp)
+          return a->timestamp < b->timestamp;
+        return a->seq < b->seq;
       }
     };
 
     //! Translate a (global coordinates) Data Sample into an IMC HistoricSample message
-    HistoricSample*
-    parse(DataSample* sample, double base_lat, double base_lon, long base_time)
+    //! @return false if the message type is unknown.
+    bool
+    parse(const StoredSample* sample, double base_lat, double base_lon, double base_time,
+          HistoricSample& s)
     {
-      HistoricSample* s = new HistoricSample();
+      IMC::Message* msg = IMC::Factory::produce(sample->id);
+      if (msg == NULL)
+        return false;
+
+      if (!sample->payload.empty())
+        msg->deserializeFields(&sample->payload[0], sample->payload.size());
 
       double lat1 = Angles::radians(base_lat);
       double lat2 = Angles::radians(sample->latDegs);
@@ -103,16 +162,17 @@ namespace Transports
 
       // compute displacement to used relative to base coordinates
       WGS84::displacement(lat1, lon1, 0, lat2, lon2, 0, &x, &y, &z);
-      s->x = (int16_t) x;
-      s->y = (int16_t) y;
-      s->z = (int16_t) (sample->zMeters * 10);
-      s->t = (int16_t) (sample->timestamp - base_time);
+      s.x = (int16_t) x;
+      s.y = (int16_t) y;
+      s.z = (int16_t) trimValue(sample->zMeters * 10, -32768.0, 32767.0);
+      s.t = (int16_t) (sample->timestamp - base_time);
 
       // other fields are copied from original
-      s->sys_id = sample->source;
-      s->sample.set(sample->sample);
-      s->priority = sample->priority;
-      return s;
+      s.sys_id = sample->source;
+      s.sample.set(msg);
+      s.priority = (int8_t) trimValue(sample->priority, -128, 127);
+      delete msg;
+      return true;
     }
 
     //! Given an HistoricData message, extract all samples
@@ -140,37 +200,89 @@ namespace Transports
           s->source = (sample)->sys_id;
           s->timestamp = data->base_time + (sample)->t;
           s->zMeters = (sample)->z / 10.0;
+          s->priority = (sample)->priority;
           s->sample = (sample)->sample.get()->clone();
           samples.push_back(s);
         }
       }
     }
 
-    //! This class is used to store samples locally until they are forwarded to other node
+    //! This class is used to store samples locally until they are forwarded to other node.
+    //! The store is bounded in size and age: when it is full the
+    //! samples with lowest priority (oldest first) are evicted.
     class DataStore
     {
     public:
       DataStore(Task* task):
-        m_task(task)
-    { }
+        m_task(task),
+        m_capacity(0),
+        m_max_age(0),
+        m_dedup_interval(0),
+        m_dedup_distance(0),
+        m_size(0),
+        m_seq(0),
+        m_evicted(0),
+        m_duplicates(0),
+        m_dirty(false)
+      { }
 
       ~DataStore(void)
       {
-        Concurrency::ScopedRWLock(m_lock, true);
-        while (!m_samples.empty())
-        {
-          delete m_samples.top();
-          m_samples.pop();
-        }
+        Concurrency::ScopedRWLock l(m_lock, true);
+        while (!m_rank.empty())
+          remove(*m_rank.begin());
+
+        for (size_t i = 0; i < m_commands.size(); ++i)
+          delete m_commands[i];
+      }
+
+      //! Set the limits of the store.
+      //! @param[in] capacity maximum size of stored samples in bytes (0 for unlimited).
+      //! @param[in] max_age maximum age of a sample in seconds (0 to keep forever).
+      void
+      setLimits(unsigned capacity, double max_age)
+      {
+        Concurrency::ScopedRWLock l(m_lock, true);
+        m_capacity = capacity;
+        m_max_age = max_age;
+        evict(Clock::getSinceEpoch());
+      }
+
+      //! Set deduplication of samples. A sample is a duplicate of a
+      //! stored one if both are of the same type and source, and are
+      //! close in time and space. Only the one with highest priority
+      //! is kept.
+      //! @param[in] interval maximum time between duplicates in seconds (0 to disable).
+      //! @param[in] distance maximum distance between duplicates in meters (0 for any).
+      void
+      setDeduplication(double interval, double distance)
+      {
+        Concurrency::ScopedRWLock l(m_lock, true);
+        m_dedup_interval = interval;
+        m_dedup_distance = distance;
       }
 
       //! Add sample to this store
       void
       addSample(DataSample* sample)
       {
-        Concurrency::ScopedRWLock(m_lock, true);
         m_task->debug("Adding sample %d/%f", sample->sample->getId(), sample->timestamp);
-        m_samples.push(sample);
+
+        StoredSample* s = new StoredSample;
+        s->latDegs = sample->latDegs;
+        s->lonDegs = sample->lonDegs;
+        s->zMeters = sample->zMeters;
+        s->timestamp = sample->timestamp;
+        s->priority = sample->priority;
+        s->source = sample->source;
+        s->id = sample->sample->getId();
+        s->payload.resize(sample->sample->getPayloadSerializationSize());
+        if (!s->payload.empty())
+          sample->sample->serializeFields(&s->payload[0]);
+        delete sample;
+
+        Concurrency::ScopedRWLock l(m_lock, true);
+        insert(s, Clock::getSinceEpoch());
       }
 
       //! Add a series of historic samples packed as an HistoricData message
@@ -193,6 +305,7 @@ namespace Transports
           if (Clock::getSinceEpoch() > timeout)
           {
             m_task->debug("Dropping expired remote command.");
+            delete *cmd;
             continue;
           }
 
@@ -207,6 +320,7 @@ namespace Transports
                           m_task->resolveSystemId((*cmd)->original_source));
 
             m_task->dispatch(msg, DF_KEEP_SRC_EID);
+            delete *cmd;
           }
           else
           {
@@ -234,6 +348,7 @@ namespace Transports
             {
               size -= ser_size;
               ret->data.push_back(*cmd_it);
+              delete *cmd_it;
               cmd_it = m_commands.erase(cmd_it);
               continue;
             }
@@ -242,72 +357,493 @@ namespace Transports
         }
 
         if (ret->data.size() == 0)
+        {
+          delete ret;
           return NULL;
+        }
         else
           return ret;
       }
 
-      //! Retrieve a series of sample that take up to 'size'
+      //! Retrieve a series of sample that take up to 'size'. The
+      //! samples are chosen to maximize the sum of priority times
+      //! size of the samples sent.
       IMC::HistoricData*
       pollSamples(int size)
       {
-
         size -= BASE_HISTORY_SIZE; // base fields from HistoricData
-        IMC::HistoricData* ret = new IMC::HistoricData();
 
-        std::vector<DataSample*> added, rejected;
+        std::vector<StoredSample*> added;
+
+        Concurrency::ScopedRWLock l(m_lock, true);
+        evict(Clock::getSinceEpoch());
+        pack(size, added);
+
+        // no data can be added
+        if (added.empty())
+          return NULL;
+
+        IMC::HistoricData* ret = new IMC::HistoricData();
+        ret->base_lat = added.at(0)->latDegs;
+        ret->base_lon = added.at(0)->lonDegs;
+        ret->base_time = added.at(0)->timestamp;
 
-        Concurrency::ScopedRWLock(m_lock, true);
-        while (!m_samples.empty() && size > MINIMUM_SAMPLE_SIZE)
+        HistoricSample hs;
+        for (size_t i = 0; i < added.size(); ++i)
         {
-          // pop next sample
-          DataSample* sample = m_samples.top();
-          m_samples.pop();
+          if (parse(added[i], ret->base_lat, ret->base_lon, ret->base_time, hs))
+            ret->data.push_back(hs);
+          remove(added[i]);
+        }
 
-          // check if there is space left for this sample
-          int sample_size = sample->serializationSize();
-          if (sample_size > size)
-          {
-            rejected.push_back(sample);
-          }
-          else
+        return ret;
+      }
+
+      //! Get number of stored samples.
+      size_t
+      getCount(void)
+      {
+        Concurrency::ScopedRWLock l(m_lock);
+        return m_rank.size();
+      }
+
+      //! Get size of stored samples in bytes.
+      size_t
+      getSize(void)
+      {
+        Concurrency::ScopedRWLock l(m_lock);
+        return m_size;
+      }
+
+      //! Get and reset the number of samples evicted and dropped as
+      //! duplicates.
+      void
+      getDiscarded(unsigned& evicted, unsigned& duplicates)
+      {
+        Concurrency::ScopedRWLock l(m_lock, true);
+        evicted = m_evicted;
+        duplicates = m_duplicates;
+        m_evicted = 0;
+        m_duplicates = 0;
+      }
+
+      //! Test if the store changed since it was last loaded or saved.
+      bool
+      isDirty(void)
+      {
+        Concurrency::ScopedRWLock l(m_lock);
+        return m_dirty;
+      }
+
+      //! Save stored samples to a file. The snapshot is written and
+      //! synchronized to a temporary file first and then renamed over
+      //! the target, so that the target is always a complete snapshot.
+      //! @param[in] path snapshot file.
+      //! @return true on success, false otherwise.
+      bool
+      save(const Path& path)
+      {
+        std::string tmp = path.str() + ".tmp";
+        std::FILE* fd = std::fopen(tmp.c_str(), "wb");
+        if (fd == NULL)
+          return false;
+
+        Concurrency::ScopedRWLock l(m_lock, true);
+
+        uint8_t bfr[c_record_size];
+        uint8_t* ptr = bfr;
+        ptr += IMC::serialize(c_magic, ptr);
+        ptr += IMC::serialize((uint32_t)m_time.size(), ptr);
+        bool ok = write(fd, bfr, ptr - bfr);
+
+        uint16_t crc = 0;
+        for (TimeIndex::const_iterator itr = m_time.begin(); ok && itr != m_time.end(); ++itr)
+        {
+          const StoredSample* s = *itr;
+          ptr = bfr;
+          ptr += IMC::serialize((fp64_t)s->latDegs, ptr);
+          ptr += IMC::serialize((fp64_t)s->lonDegs, ptr);
+          ptr += IMC::serialize((fp64_t)s->zMeters, ptr);
+          ptr += IMC::serialize((fp64_t)s->timestamp, ptr);
+          ptr += IMC::serialize((int32_t)s->priority, ptr);
+          ptr += IMC::serialize((int32_t)s->source, ptr);
+          ptr += IMC::serialize(s->id, ptr);
+          ptr += IMC::serialize((uint16_t)s->payload.size(), ptr);
+          crc = Algorithms::CRC16::compute(bfr, c_record_size, crc);
+          ok = write(fd, bfr, c_record_size);
+
+          if (ok && !s->payload.empty())
           {
-            size -= sample_size;
-            added.push_back(sample);
+            crc = Algorithms::CRC16::compute(&s->payload[0], s->payload.size(), crc);
+            ok = write(fd, &s->payload[0], s->payload.size());
           }
         }
 
-        // add back samples that didn't fit on the message
-        std::vector<DataSample *>::iterator it;
-        for (it = rejected.begin(); it != rejected.end(); it++)
+        IMC::serialize(crc, bfr);
+        ok = ok && write(fd, bfr, sizeof(crc));
+        ok = ok && std::fflush(fd) == 0;
+
+#if defined(DUNE_SYS_HAS_UNISTD_H)
+        // Make sure the data is on disk before it replaces the target.
+        ok = ok && fsync(fileno(fd)) == 0;
+#endif
+
+        ok = (std::fclose(fd) == 0) && ok;
+
+        if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0)
         {
-          m_samples.push(*it);
+          std::remove(tmp.c_str());
+          return false;
         }
 
-        // no data can be added
-        if (added.empty())
-          return NULL;
+        m_dirty = false;
+        return true;
+      }
 
-        ret->base_lat = added.at(0)->latDegs;
-        ret->base_lon = added.at(0)->lonDegs;
-        ret->base_time = added.at(0)->timestamp;
+      //! Load samples from a file. Limits and deduplication apply to
+      //! the loaded samples as if they were added.
+      //! @param[in] path snapshot file.
+      //! @return number of loaded samples or -1 if the snapshot is
+      //! missing or invalid.
+      int
+      load(const Path& path)
+      {
+        std::ifstream ifs(path.c_str(), std::ios::binary);
+        if (!ifs.is_open())
+          return -1;
+
+        uint8_t bfr[c_record_size];
+        uint16_t len = 8;
+        uint32_t magic = 0;
+        uint32_t count = 0;
 
-        for (it = added.begin(); it != added.end(); it++)
+        if (!ifs.read((char*)bfr, len))
+          return -1;
+
+        const uint8_t* ptr = bfr;
+        ptr += IMC::deserialize(magic, ptr, len);
+        IMC::deserialize(count, ptr, len);
+        if (magic != c_magic)
+          return -1;
+
+        std::vector<StoredSample*> records;
+        uint16_t crc = 0;
+        bool valid = true;
+
+        for (uint32_t i = 0; valid && i < count; ++i)
         {
-          DataSample * sample = *it;
-          ret->data.push_back(
-              parse(sample, ret->base_lat, ret->base_lon, ret->base_time));
-          delete sample;
+          if (!ifs.read((char*)bfr, c_record_size))
+          {
+            valid = false;
+            break;
+          }
+
+          crc = Algorithms::CRC16::compute(bfr, c_record_size, crc);
+
+          StoredSample* s = new StoredSample;
+          fp64_t lat = 0, lon = 0, z = 0, timestamp = 0;
+          int32_t priority = 0, source = 0;
+          uint16_t size = 0;
+
+          len = c_record_size;
+          ptr = bfr;
+          ptr += IMC::deserialize(lat, ptr, len);
+          ptr += IMC::deserialize(lon, ptr, len);
+          ptr += IMC::deserialize(z, ptr, len);
+          ptr += IMC::deserialize(timestamp, ptr, len);
+          ptr += IMC::deserialize(priority, ptr, len);
+          ptr += IMC::deserialize(source, ptr, len);
+          ptr += IMC::deserialize(s->id, ptr, len);
+          IMC::deserialize(size, ptr, len);
+
+          s->latDegs = lat;
+          s->lonDegs = lon;
+          s->zMeters = z;
+          s->timestamp = timestamp;
+          s->priority = priority;
+          s->source = source;
+          s->payload.resize(size);
+          records.push_back(s);
+
+          if (size > 0)
+          {
+            if (!ifs.read((char*)&s->payload[0], size))
+              valid = false;
+            else
+              crc = Algorithms::CRC16::compute(&s->payload[0], size, crc);
+          }
         }
 
-        return ret;
+        uint16_t stored_crc = 0;
+        len = sizeof(stored_crc);
+        if (valid && ifs.read((char*)bfr, len))
+          IMC::deserialize(stored_crc, bfr, len);
+        else
+          valid = false;
+
+        if (!valid || stored_crc != crc)
+        {
+          for (size_t i = 0; i < records.size(); ++i)
+            delete records[i];
+          return -1;
+        }
+
+        Concurrency::ScopedRWLock l(m_lock, true);
+        double now = Clock::getSinceEpoch();
+        for (size_t i = 0; i < records.size(); ++i)
+          insert(records[i], now);
+
+        m_dirty = false;
+        return m_rank.size();
       }
 
     private:
-      std::priority_queue<DataSample *, std::vector<DataSample *> , CompareSamples> m_samples;
+      //! Samples in transmission order.
+      typedef std::set<StoredSample*, RankOrder> RankIndex;
+      //! Samples in chronological order.
+      typedef std::set<StoredSample*, TimeOrder> TimeIndex;
+      //! Snapshot file magic ("DSTR").
+      static const uint32_t c_magic = 0x52545344;
+      //! Size of a serialized record (without message fields).
+      static const uint16_t c_record_size = 44;
+      //! Largest offset (time and position) of a sample relative to
+      //! the base of an HistoricData message.
+      static const int c_max_offset = 32767;
+      //! Maximum number of samples considered to fill the space left
+      //! after the highest priority samples.
+      static const size_t c_pack_candidates = 64;
+      //! Maximum number of size units used to fill the space left.
+      static const int c_pack_resolution = 1024;
+
+      RankIndex m_rank;
+      TimeIndex m_time;
       std::vector<RemoteCommand* > m_commands;
       Concurrency::RWLock m_lock;
       Task* m_task;
+      //! Maximum size of stored samples in bytes.
+      unsigned m_capacity;
+      //! Maximum age of a sample in seconds.
+      double m_max_age;
+      //! Maximum time between duplicate samples.
+      double m_dedup_interval;
+      //! Maximum distance between duplicate samples.
+      double m_dedup_distance;
+      //! Size of stored samples in bytes.
+      size_t m_size;
+      //! Next insertion order.
+      uint64_t m_seq;
+      //! Number of samples evicted.
+      unsigned m_evicted;
+      //! Number of duplicate samples dropped.
+      unsigned m_duplicates;
+      //! True if samples changed since last load/save.
+      bool m_dirty;
+
+      //! Insert a sample and enforce limits. Must be called with the
+      //! lock held.
+      void
+      insert(StoredSample* s, double now)
+      {
+        s->seq = m_seq++;
+
+        if (m_dedup_interval > 0)
+        {
+          StoredSample* dup = findDuplicate(s);
+          if (dup != NULL)
+          {
+            ++m_duplicates;
+            if (dup->priority >= s->priority)
+            {
+              delete s;
+              return;
+            }
+
+            remove(dup);
+          }
+        }
+
+        m_rank.insert(s);
+        m_time.insert(s);
+        m_size += s->serializationSize();
+        m_dirty = true;
+        evict(now);
+      }
+
+      //! Remove and delete a sample. Must be called with the lock held.
+      void
+      remove(StoredSample* s)
+      {
+        m_rank.erase(s);
+        m_time.erase(s);
+        m_size -= s->serializationSize();
+        m_dirty = true;
+        delete s;
+      }
+
+      //! Evict samples that are too old and, while the store is
+      //! full, the samples with lowest priority. Must be called with
+      //! the lock held.
+      void
+      evict(double now)
+      {
+        while (m_max_age > 0 && !m_time.empty()
+               && now - (*m_time.begin())->timestamp > m_max_age)
+        {
+          remove(*m_time.begin());
+          ++m_evicted;
+        }
+
+        while (m_capacity > 0 && m_size > m_capacity)
+        {
+          remove(*m_rank.rbegin());
+          ++m_evicted;
+        }
+      }
+
+      //! Find a stored duplicate of a sample.
+      //! @return duplicate or NULL.
+      StoredSample*
+      findDuplicate(const StoredSample* s)
+      {
+        StoredSample first;
+        first.timestamp = s->timestamp - m_dedup_interval;
+        first.seq = 0;
+
+        TimeIndex::iterator itr = m_time.lower_bound(&first);
+        for (; itr != m_time.end() && (*itr)->timestamp <= s->timestamp + m_dedup_interval; ++itr)
+        {
+          StoredSample* other = *itr;
+          if (other->id != s->id || other->source != s->source)
+            continue;
+
+          if (m_dedup_distance <= 0)
+            return other;
+
+          double dist = WGS84::distance(Angles::radians(s->latDegs), Angles::radians(s->lonDegs), 0.0,
+                                        Angles::radians(other->latDegs), Angles::radians(other->lonDegs), 0.0);
+          if (dist <= m_dedup_distance)
+            return other;
+        }
+
+        return NULL;
+      }
+
+      //! Write a buffer to a snapshot file.
+      //! @return true if the whole buffer was written.
+      static bool
+      write(std::FILE* fd, const uint8_t* data, size_t size)
+      {
+        return std::fwrite(data, 1, size, fd) == size;
+      }
+
+      //! Test if a sample can be sent relative to the base of an
+      //! HistoricData message (offsets are 16 bit).
+      static bool
+      isCompatible(const StoredSample* base, const StoredSample* s)
+      {
+        // base time is sent as a single precision number.
+        double base_time = (fp32_t)base->timestamp;
+        if (std::fabs(s->timestamp - base_time) > c_max_offset)
+          return false;
+
+        double x, y, z;
+        WGS84::displacement(Angles::radians((fp32_t)base->latDegs), Angles::radians((fp32_t)base->lonDegs), 0,
+                            Angles::radians(s->latDegs), Angles::radians(s->lonDegs), 0,
+                            &x, &y, &z);
+        return std::fabs(x) <= c_max_offset && std::fabs(y) <= c_max_offset;
+      }
+
+      //! Choose the samples to send in a message. Samples are taken
+      //! in transmission order while they fit. The last of these and
+      //! the next candidates are then replaced by the subset that
+      //! maximizes the sum of priority times size (0/1 knapsack).
+      //! @param[in] size space available in bytes.
+      //! @param[out] chosen chosen samples, the first is the base.
+      void
+      pack(int size, std::vector<StoredSample*>& chosen)
+      {
+        const StoredSample* base = NULL;
+        RankIndex::iterator itr = m_rank.begin();
+
+        for (; itr != m_rank.end(); ++itr)
+        {
+          StoredSample* s = *itr;
+          if (base != NULL && !isCompatible(base, s))
+            continue;
+
+          int sample_size = s->serializationSize();
+          if (sample_size > size)
+          {
+            // no sample fits yet.
+            if (base == NULL)
+              continue;
+            break;
+          }
+
+          if (base == NULL)
+            base = s;
+
+          chosen.push_back(s);
+          size -= sample_size;
+        }
+
+        // all samples fit.
+        if (base == NULL || itr == m_rank.end())
+          return;
+
+        // release the last samples taken (but not the base).
+        std::vector<StoredSample*> candidates;
+        while (chosen.size() > 1 && candidates.size() < c_pack_candidates / 2)
+        {
+          candidates.push_back(chosen.back());
+          size += chosen.back()->serializationSize();
+          chosen.pop_back();
+        }
+
+        for (; itr != m_rank.end() && candidates.size() < c_pack_candidates; ++itr)
+        {
+          StoredSample* s = *itr;
+          if (s->serializationSize() <= size && isCompatible(base, s))
+            candidates.push_back(s);
+        }
+
+        if (candidates.empty())
+          return;
+
+        // sizes are rounded up to units, so that chosen samples fit.
+        int unit = size / c_pack_resolution + 1;
+        int capacity = size / unit;
+        size_t count = candidates.size();
+        std::vector<double> best(capacity + 1, 0.0);
+        std::vector<std::vector<bool> > take(count, std::vector<bool>(capacity + 1, false));
+        std::vector<int> weights(count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+          int sample_size = candidates[i]->serializationSize();
+          double value = (double)sample_size * std::max(candidates[i]->priority, 1);
+          weights[i] = (sample_size + unit - 1) / unit;
+
+          for (int c = capacity; c >= weights[i]; --c)
+          {
+            if (best[c - weights[i]] + value > best[c])
+            {
+              best[c] = best[c - weights[i]] + value;
+              take[i][c] = true;
+            }
+          }
+        }
+
+        int c = capacity;
+        for (size_t i = count; i > 0; --i)
+        {
+          if (take[i - 1][c])
+          {
+            chosen.push_back(candidates[i - 1]);
+            c -= weights[i - 1];
+          }
+        }
+      }
     };
   }
 }
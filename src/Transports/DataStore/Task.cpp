@@ -71,6 +71,21 @@ namespace Transports
       //! Variable priorities will result in older
       //! data being sent through low bandwidth connections
       bool variable_priorities;
+
+      //! Maximum size of stored samples, in bytes
+      unsigned capacity;
+
+      //! Maximum age of stored samples, in seconds
+      double max_age;
+
+      //! Maximum time between duplicate samples, in seconds
+      double dedup_interval;
+
+      //! Maximum distance between duplicate samples, in meters
+      double dedup_distance;
+
+      //! Period, in seconds, between saves of stored samples
+      double snapshot_period;
     };
 
     struct Task: public DUNE::Tasks::Task
@@ -111,6 +126,12 @@ namespace Transports
       typedef std::map<uint16_t, IMC::TransmissionRequest*> MessagesQueued;
       MessagesQueued m_transmission_requests;
 
+      //! Path to stored samples snapshot.
+      Path m_store_file;
+
+      //! Timer used for saving stored samples
+      Time::Counter<double> m_snapshot_timer;
+
       Task(const std::string& name, Tasks::Context& ctx):
         DUNE::Tasks::Task(name, ctx),
         m_store(this),
@@ -156,6 +177,33 @@ namespace Transports
         .description("Apply variable priorities to local samples")
         .defaultValue("true");
 
+        param("Storage Capacity", m_args.capacity)
+        .defaultValue("1048576")
+        .units(Units::Byte)
+        .description("Maximum size of stored samples, lowest priority samples are evicted first (0 for unlimited)");
+
+        param("Maximum Sample Age", m_args.max_age)
+        .defaultValue("0")
+        .units(Units::Second)
+        .description("Age after which a stored sample is discarded (0 to keep forever)");
+
+        param("Deduplication Interval", m_args.dedup_interval)
+        .defaultValue("0")
+        .units(Units::Second)
+        .description("Samples of the same type and source closer in time are duplicates (0 disables deduplication)");
+
+        param("Deduplication Distance", m_args.dedup_distance)
+        .defaultValue("0")
+        .units(Units::Meter)
+        .description("Samples of the same type and source are duplicates only if closer than this distance (0 for any distance)");
+
+        param("Snapshot Period", m_args.snapshot_period)
+        .defaultValue("60")
+        .units(Units::Second)
+        .description("Period between saves of stored samples to disk (0 disables persistence)");
+
+        m_store_file = m_ctx.dir_db / (getName() + std::string(".dat"));
+
         m_wifi_forward_timer.setTop(m_args.wifi_forward_period);
         m_acoustic_forward_timer.setTop(m_args.acoustic_forward_period);
         m_any_forward_timer.setTop(m_args.any_forward_period);
@@ -206,14 +254,55 @@ namespace Transports
         m_acoustic_forward_timer.setTop(m_args.acoustic_forward_period);
         m_any_forward_timer.setTop(m_args.any_forward_period);
         m_iridium_upload_timer.setTop(m_args.iridium_upload_period);
+        m_snapshot_timer.setTop(m_args.snapshot_period);
+
+        m_store.setLimits(m_args.capacity, m_args.max_age);
+        m_store.setDeduplication(m_args.dedup_interval, m_args.dedup_distance);
       }
 
       void
       onResourceInitialization(void)
       {
+        loadSamples();
         setEntityState(IMC::EntityState::ESTA_NORMAL, Status::CODE_IDLE);
       }
 
+      void
+      onResourceRelease(void)
+      {
+        saveSamples();
+      }
+
+      //! Restore stored samples from the last snapshot.
+      void
+      loadSamples(void)
+      {
+        if (m_args.snapshot_period <= 0)
+          return;
+
+        int count = m_store.load(m_store_file);
+        if (count >= 0)
+          inf(DTR("restored %d samples"), count);
+      }
+
+      //! Save stored samples if they changed.
+      void
+      saveSamples(void)
+      {
+        unsigned evicted = 0;
+        unsigned duplicates = 0;
+        m_store.getDiscarded(evicted, duplicates);
+        if (evicted > 0 || duplicates > 0)
+          debug("discarded %u evicted and %u duplicate samples, %u samples (%u bytes) stored",
+                evicted, duplicates, (unsigned)m_store.getCount(), (unsigned)m_store.getSize());
+
+        if (m_args.snapshot_period <= 0 || !m_store.isDirty())
+          return;
+
+        if (!m_store.save(m_store_file))
+          war(DTR("failed to save samples to %s"), m_store_file.c_str());
+      }
+
       void
       consume(const IMC::Message* msg)
       {
@@ -489,6 +578,12 @@ namespace Transports
         {
           waitForMessages(1.0);
 
+          if (m_snapshot_timer.overflow())
+          {
+            m_snapshot_timer.reset();
+            saveSamples();
+          }
+
           std::stringstream ss;
 
           if (m_args.any_forward_period > 0 && m_any_forward_timer.overflow())
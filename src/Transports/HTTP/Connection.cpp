@@ -0,0 +1,288 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// POSIX headers.
+#if defined(DUNE_SYS_HAS_SYS_TYPES_H)
+#  include <sys/types.h>
+#endif
+
+#if defined(DUNE_SYS_HAS_SYS_SOCKET_H)
+#  include <sys/socket.h>
+#endif
+
+#if defined(DUNE_SYS_HAS_FCNTL_H)
+#  include <fcntl.h>
+#endif
+
+#if defined(DUNE_SYS_HAS_UNISTD_H)
+#  include <unistd.h>
+#endif
+
+#if defined(DUNE_SYS_HAS_SYS_SENDFILE_H)
+#  include <sys/sendfile.h>
+#endif
+
+// Local headers.
+#include "Connection.hpp"
+
+namespace Transports
+{
+  namespace HTTP
+  {
+    //! Maximum size of a request header.
+    static const size_t c_max_header_size = 2048;
+    //! Maximum size of a request body.
+    static const size_t c_max_body_size = 128 * 1024;
+    //! Size of receive and file buffers.
+    static const size_t c_block_size = 16 * 1024;
+
+    Connection::Connection(TCPSocket* sock):
+      m_sock(sock),
+      m_handle(sock->getNative()),
+      m_pending(0),
+      m_keep_alive(true),
+      m_streaming(false),
+      m_closed(false),
+      m_activity(Clock::get())
+    {
+      int flags = fcntl(m_handle, F_GETFL, 0);
+      fcntl(m_handle, F_SETFL, flags | O_NONBLOCK);
+      m_sock->setNoDelay(true);
+    }
+
+    Connection::~Connection(void)
+    {
+      while (!m_out.empty())
+      {
+        release(m_out.front());
+        m_out.pop_front();
+      }
+
+      delete m_sock;
+    }
+
+    void
+    Connection::write(const char* data, size_t size)
+    {
+      if (size == 0)
+        return;
+
+      // Coalesce small writes (headers and bodies, stream events).
+      if (!m_out.empty() && m_out.back().fd == -1 && m_out.back().data.size() < c_block_size)
+      {
+        m_out.back().data.append(data, size);
+        m_out.back().end += size;
+      }
+      else
+      {
+        Chunk chunk;
+        chunk.data.assign(data, size);
+        chunk.fd = -1;
+        chunk.offset = 0;
+        chunk.end = size;
+        m_out.push_back(chunk);
+      }
+
+      m_pending += size;
+    }
+
+    bool
+    Connection::writeFile(const std::string& file, int64_t off_beg, int64_t off_end)
+    {
+      if (off_end < off_beg)
+        return true;
+
+      int fd = ::open(file.c_str(), O_RDONLY);
+      if (fd == -1)
+        return false;
+
+      Chunk chunk;
+      chunk.fd = fd;
+      chunk.offset = off_beg;
+      chunk.end = off_end + 1;
+      m_out.push_back(chunk);
+      m_pending += chunk.end - chunk.offset;
+      return true;
+    }
+
+    bool
+    Connection::receive(void)
+    {
+      char bfr[c_block_size];
+
+      while (true)
+      {
+        ssize_t rv = ::recv(m_handle, bfr, sizeof(bfr), 0);
+        if (rv > 0)
+        {
+          // Event streams do not take requests.
+          if (!m_streaming)
+            m_in.append(bfr, rv);
+          m_activity = Clock::get();
+          continue;
+        }
+
+        if (rv == 0)
+        {
+          m_closed = true;
+          return true;
+        }
+
+        if (errno == EINTR)
+          continue;
+
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+      }
+    }
+
+    int
+    Connection::nextRequest(std::string& header)
+    {
+      if (m_streaming)
+        return 0;
+
+      size_t eoh = m_in.find("\r\n\r\n");
+      if (eoh == std::string::npos)
+        return (m_in.size() > c_max_header_size) ? -1 : 0;
+
+      if (eoh > c_max_header_size)
+        return -1;
+
+      // Find body length.
+      std::string lower(m_in, 0, eoh);
+      std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+
+      size_t length = 0;
+      size_t pos = lower.find("\r\ncontent-length:");
+      if (pos != std::string::npos)
+      {
+        length = std::strtoul(lower.c_str() + pos + 17, NULL, 10);
+        if (length > c_max_body_size)
+          return -1;
+      }
+
+      if (m_in.size() < eoh + 4 + length)
+        return 0;
+
+      header.assign(m_in, 0, eoh);
+      m_body.assign(m_in, eoh + 4, length);
+      m_in.erase(0, eoh + 4 + length);
+      return 1;
+    }
+
+    bool
+    Connection::send(void)
+    {
+      while (!m_out.empty())
+      {
+        Chunk& chunk = m_out.front();
+        int64_t rv = sendChunk(chunk);
+        if (rv < 0)
+          return false;
+
+        if (rv == 0)
+          return true;
+
+        chunk.offset += rv;
+        m_pending -= rv;
+        m_activity = Clock::get();
+
+        if (chunk.offset >= chunk.end)
+        {
+          release(chunk);
+          m_out.pop_front();
+        }
+      }
+
+      return true;
+    }
+
+    int64_t
+    Connection::sendChunk(Chunk& chunk)
+    {
+      int flags = 0;
+#if defined(MSG_NOSIGNAL)
+      flags = MSG_NOSIGNAL;
+#endif
+
+      ssize_t rv = 0;
+      size_t size = chunk.end - chunk.offset;
+
+      if (chunk.fd == -1)
+      {
+        rv = ::send(m_handle, chunk.data.data() + chunk.offset, size, flags);
+      }
+      else
+      {
+        size = std::min(size, c_block_size);
+
+#if defined(DUNE_SYS_HAS_LINUX_SENDFILE)
+        off_t offset = chunk.offset;
+        rv = ::sendfile(m_handle, chunk.fd, &offset, size);
+#else
+        char bfr[c_block_size];
+        ssize_t n = ::pread(chunk.fd, bfr, size, chunk.offset);
+        if (n <= 0)
+          return -1;
+        rv = ::send(m_handle, bfr, n, flags);
+#endif
+      }
+
+      if (rv >= 0)
+      {
+        // A file that shrank while being sent.
+        if (rv == 0 && chunk.fd != -1)
+          return -1;
+        return rv;
+      }
+
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+        return 0;
+
+      return -1;
+    }
+
+    void
+    Connection::release(Chunk& chunk)
+    {
+      if (chunk.fd != -1)
+        ::close(chunk.fd);
+      chunk.fd = -1;
+    }
+  }
+}
@@ -0,0 +1,240 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+#ifndef TRANSPORTS_HTTP_CONNECTION_HPP_INCLUDED_
+#define TRANSPORTS_HTTP_CONNECTION_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <deque>
+#include <string>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+namespace Transports
+{
+  namespace HTTP
+  {
+    using DUNE_NAMESPACES;
+
+    //! Non-blocking HTTP connection. Incoming data is buffered until
+    //! a complete request (header and body) is available; responses
+    //! are queued and sent as the socket becomes writable, so that a
+    //! slow client never blocks the server.
+    class Connection
+    {
+    public:
+      //! Constructor.
+      //! @param sock connected socket (owned by the connection).
+      Connection(TCPSocket* sock);
+
+      //! Destructor.
+      ~Connection(void);
+
+      //! Retrieve native socket handle.
+      //! @return socket handle.
+      int
+      getHandle(void) const
+      {
+        return m_handle;
+      }
+
+      //! Queue data to be sent.
+      //! @param data data.
+      //! @param size number of bytes.
+      void
+      write(const char* data, size_t size);
+
+      //! Queue data to be sent.
+      //! @param data data.
+      void
+      write(const std::string& data)
+      {
+        write(data.c_str(), data.size());
+      }
+
+      //! Queue a region of a file to be sent.
+      //! @param file file path.
+      //! @param off_beg offset of first byte.
+      //! @param off_end offset of last byte.
+      //! @return false if the file cannot be opened.
+      bool
+      writeFile(const std::string& file, int64_t off_beg, int64_t off_end);
+
+      //! Retrieve body of the current request.
+      //! @return request body.
+      const std::string&
+      getBody(void) const
+      {
+        return m_body;
+      }
+
+      //! Retrieve number of bytes waiting to be sent.
+      //! @return number of bytes.
+      uint64_t
+      getPendingSize(void) const
+      {
+        return m_pending;
+      }
+
+      //! Set whether the connection is kept open after the current
+      //! response.
+      //! @param enabled true to keep the connection open.
+      void
+      setKeepAlive(bool enabled)
+      {
+        m_keep_alive = enabled;
+      }
+
+      //! Test if the connection is kept open after the current
+      //! response.
+      //! @return true if kept open, false otherwise.
+      bool
+      getKeepAlive(void) const
+      {
+        return m_keep_alive;
+      }
+
+      //! Turn the connection into an event stream. Further requests
+      //! are ignored and the connection is not subject to the idle
+      //! timeout.
+      void
+      setStreaming(void)
+      {
+        m_streaming = true;
+      }
+
+      //! Test if the connection is an event stream.
+      //! @return true if streaming, false otherwise.
+      bool
+      isStreaming(void) const
+      {
+        return m_streaming;
+      }
+
+      //! Test if the peer closed its side of the connection.
+      //! @return true if no more data will be received.
+      bool
+      isClosed(void) const
+      {
+        return m_closed;
+      }
+
+      //! Retrieve time of last activity.
+      //! @return time of last activity.
+      double
+      getLastActivity(void) const
+      {
+        return m_activity;
+      }
+
+      //! Read available data.
+      //! @return false if the connection failed.
+      bool
+      receive(void);
+
+      //! Extract the next complete request.
+      //! @param header request header.
+      //! @return 1 if a request is available, 0 if more data is
+      //! needed, -1 if the request is invalid.
+      int
+      nextRequest(std::string& header);
+
+      //! Send queued data until the socket would block.
+      //! @return false if the connection failed.
+      bool
+      send(void);
+
+      //! Test if the connection can be closed.
+      //! @return true if the last response was sent and the
+      //! connection is not persistent.
+      bool
+      isDone(void) const
+      {
+        return !m_keep_alive && m_pending == 0;
+      }
+
+    private:
+      //! Queued response data.
+      struct Chunk
+      {
+        //! Data (unused for files).
+        std::string data;
+        //! File descriptor or -1.
+        int fd;
+        //! Next byte to send.
+        int64_t offset;
+        //! End of data.
+        int64_t end;
+      };
+
+      //! Socket.
+      TCPSocket* m_sock;
+      //! Native socket handle.
+      int m_handle;
+      //! Received data not yet processed.
+      std::string m_in;
+      //! Current request body.
+      std::string m_body;
+      //! Response queue.
+      std::deque<Chunk> m_out;
+      //! Number of bytes in the response queue.
+      uint64_t m_pending;
+      //! Keep connection open after response.
+      bool m_keep_alive;
+      //! Connection is an event stream.
+      bool m_streaming;
+      //! Peer closed its side of the connection.
+      bool m_closed;
+      //! Time of last activity.
+      double m_activity;
+
+      //! Send part of a chunk.
+      //! @param chunk chunk.
+      //! @return number of bytes sent, 0 if the socket would block,
+      //! -1 on error.
+      int64_t
+      sendChunk(Chunk& chunk);
+
+      //! Release resources of a chunk.
+      //! @param chunk chunk.
+      static void
+      release(Chunk& chunk);
+
+      //! Non-copyable.
+      Connection(const Connection&);
+
+      //! Non-assignable.
+      Connection&
+      operator=(const Connection&);
+    };
+  }
+}
+
+#endif
@@ -40,6 +40,7 @@ namespace Transports
     using DUNE_NAMESPACES;
 
     MessageMonitor::MessageMonitor(const std::string& system, uint64_t uid):
+      m_seq(0),
       m_uid(uid),
       m_last_msgs_json(0),
       m_last_logbook_json(0),
@@ -59,17 +60,6 @@ namespace Transports
     {
       ScopedMutex l(m_mutex);
 
-      {
-        std::map<unsigned, IMC::Message*>::iterator itr = m_msgs.begin();
-        for (; itr != m_msgs.end(); ++itr)
-          delete itr->second;
-      }
-
-      {
-        for (PowerChannelMap::iterator itr = m_power_channels.begin(); itr != m_power_channels.end(); ++itr)
-          delete itr->second;
-      }
-
       {
         for(unsigned int itr = 0; itr < m_logbook.size(); ++itr)
           delete m_logbook[itr];
@@ -86,53 +76,53 @@ namespace Transports
     ByteBuffer*
     MessageMonitor::messagesJSON(void)
     {
-      ScopedMutex l(m_mutex);
+      EntityMap entities;
 
-      uint64_t now = Clock::getMsec();
+      {
+        ScopedMutex l(m_mutex);
 
-      if ((now - m_last_msgs_json) > 2000)
-        m_last_msgs_json = now;
-      else
-        return &m_msgs_json;
+        uint64_t now = Clock::getMsec();
+
+        if ((now - m_last_msgs_json) > 2000)
+          m_last_msgs_json = now;
+        else
+          return &m_msgs_json;
+
+        if (m_msgs.empty())
+          return &m_msgs_json;
+
+        entities = m_entities;
+      }
 
-      if (m_msgs.empty())
-        return &m_msgs_json;
+      std::vector<Fragment> frags;
+      collect(0, frags);
 
       std::ostringstream os;
       os << m_meta
          << "  'dune_time_current': '" << std::setprecision(12) << Clock::getSinceEpoch() << "',\n";
 
-      if (m_entities.empty())
+      if (entities.empty())
       {
         os << "  'dune_entities': { },\n";
       }
       else
       {
         os << "  'dune_entities': {\n";
-        EntityMap::iterator itr = m_entities.begin();
+        EntityMap::iterator itr = entities.begin();
         os << itr->first << " : {" << "\"label\": \"" << itr->second << "\"}";
         ++itr;
-        for (; itr != m_entities.end(); ++itr)
+        for (; itr != entities.end(); ++itr)
           os << ",\n" << itr->first << " : {" << "\"label\": \"" << itr->second << "\"}";
         os << "\n},";
       }
 
       os << "  'dune_messages': [\n";
 
-      std::map<unsigned, IMC::Message*>::iterator itr = m_msgs.begin();
-      itr->second->toJSON(os);
-      ++itr;
-
-      for (; itr != m_msgs.end(); ++itr)
-      {
-        os << ",\n";
-        itr->second->toJSON(os);
-      }
-
-      for (PowerChannelMap::iterator pitr = m_power_channels.begin(); pitr != m_power_channels.end(); ++pitr)
+      for (size_t i = 0; i < frags.size(); ++i)
       {
-        os << ",\n";
-        pitr->second->toJSON(os);
+        if (i > 0)
+          os << ",\n";
+        os << *frags[i].json;
       }
 
       os << "\n]"
@@ -148,18 +138,121 @@ namespace Transports
     void
     MessageMonitor::updateMessage(const IMC::Message* msg)
     {
+      // Copy before locking: consumers only wait for the table update.
+      SharedMessage shared = SharedMessage::copy(msg);
+      unsigned key = msg->getId() << 24 | msg->getSubId() << 8 | msg->getSourceEntity();
+
       ScopedMutex l(m_mutex);
 
       if (msg->getId() == DUNE_IMC_POWERCHANNELSTATE)
-        updatePowerChannel(static_cast<const IMC::PowerChannelState*>(msg));
+        updatePowerChannel(static_cast<const IMC::PowerChannelState*>(msg), shared);
+
+      Slot& slot = m_msgs[key];
+      if (slot.key.empty())
+        slot.key = String::str(key);
+
+      slot.msg = shared;
+      slot.seq = ++m_seq;
+    }
+
+    uint64_t
+    MessageMonitor::collect(uint64_t since, std::vector<Fragment>& frags)
+    {
+      //! Fragment waiting to be rendered.
+      struct Rendering
+      {
+        Slot* slot;
+        uint64_t seq;
+        SharedMessage msg;
+        std::shared_ptr<const std::string> json;
+      };
+
+      std::vector<Rendering> pending;
+      uint64_t seq = 0;
 
-      IMC::Message* tmsg = msg->clone();
-      unsigned key = tmsg->getId() << 24 | tmsg->getSubId() << 8 | tmsg->getSourceEntity();
+      {
+        ScopedMutex l(m_mutex);
+        seq = m_seq;
+
+        for (MessageMap::iterator itr = m_msgs.begin(); itr != m_msgs.end(); ++itr)
+        {
+          Slot& slot = itr->second;
+          if (slot.json_seq != slot.seq)
+            pending.push_back(Rendering{&slot, slot.seq, slot.msg});
+        }
+
+        for (PowerChannelMap::iterator itr = m_power_channels.begin(); itr != m_power_channels.end(); ++itr)
+        {
+          Slot& slot = itr->second;
+          if (slot.json_seq != slot.seq)
+            pending.push_back(Rendering{&slot, slot.seq, slot.msg});
+        }
+      }
+
+      // Render outside of the lock. Slots are never removed, so their
+      // addresses stay valid.
+      for (size_t i = 0; i < pending.size(); ++i)
+      {
+        std::ostringstream os;
+        pending[i].msg->toJSON(os);
+        pending[i].json = std::make_shared<const std::string>(os.str());
+      }
+
+      ScopedMutex l(m_mutex);
+
+      for (size_t i = 0; i < pending.size(); ++i)
+      {
+        Slot* slot = pending[i].slot;
+        if (slot->json_seq < pending[i].seq)
+        {
+          slot->json = pending[i].json;
+          slot->json_seq = pending[i].seq;
+        }
+      }
+
+      frags.clear();
+
+      for (MessageMap::iterator itr = m_msgs.begin(); itr != m_msgs.end(); ++itr)
+      {
+        if (itr->second.json && itr->second.json_seq > since)
+          frags.push_back(Fragment{itr->second.key, itr->second.json});
+      }
 
-      if (m_msgs[key])
-        delete m_msgs[key];
+      for (PowerChannelMap::iterator itr = m_power_channels.begin(); itr != m_power_channels.end(); ++itr)
+      {
+        if (itr->second.json && itr->second.json_seq > since)
+          frags.push_back(Fragment{itr->second.key, itr->second.json});
+      }
 
-      m_msgs[key] = tmsg;
+      return seq;
+    }
+
+    uint64_t
+    MessageMonitor::messagesSince(uint64_t since, std::string& json)
+    {
+      json.clear();
+
+      std::vector<Fragment> frags;
+      uint64_t seq = collect(since, frags);
+      if (frags.empty())
+        return seq;
+
+      size_t size = 2;
+      for (size_t i = 0; i < frags.size(); ++i)
+        size += frags[i].key.size() + frags[i].json->size() + 6;
+      json.reserve(size);
+
+      json.append("{\n");
+      for (size_t i = 0; i < frags.size(); ++i)
+      {
+        if (i > 0)
+          json.append(",\n");
+        json.append("\"").append(frags[i].key).append("\": ");
+        json.append(*frags[i].json);
+      }
+      json.append("}");
+
+      return seq;
     }
 
     ByteBuffer*
@@ -215,13 +308,14 @@ namespace Transports
     }
 
     void
-    MessageMonitor::updatePowerChannel(const IMC::PowerChannelState* msg)
+    MessageMonitor::updatePowerChannel(const IMC::PowerChannelState* msg, const SharedMessage& shared)
     {
-      std::map<std::string, IMC::PowerChannelState*>::iterator itr = m_power_channels.find(msg->name);
-      if (itr != m_power_channels.end())
-        *itr->second = *msg;
-      else
-        m_power_channels[msg->name] = new IMC::PowerChannelState(*msg);
+      Slot& slot = m_power_channels[msg->name];
+      if (slot.key.empty())
+        slot.key = "power:" + msg->name;
+
+      slot.msg = shared;
+      slot.seq = ++m_seq;
     }
   }
 }
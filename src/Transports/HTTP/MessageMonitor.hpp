@@ -33,6 +33,10 @@
 // ISO C++ 98 headers.
 #include <map>
 #include <string>
+#include <vector>
+
+// ISO C++ 11 headers.
+#include <memory>
 
 // DUNE headers.
 #include <DUNE/DUNE.hpp>
@@ -57,6 +61,14 @@ namespace Transports
       DUNE::Utils::ByteBuffer*
       logbookJSON(void);
 
+      //! Retrieve messages updated after a given update.
+      //! @param since last update already seen (0 for all messages).
+      //! @param json JSON object of updated messages, keyed by message
+      //! instance, or empty if there are none.
+      //! @return last update.
+      uint64_t
+      messagesSince(uint64_t since, std::string& json);
+
       void
       addLogEntry(const DUNE::IMC::LogBookEntry* msg);
 
@@ -76,14 +88,51 @@ namespace Transports
       }
 
     private:
+      //! Latest state of a monitored message and its JSON rendering.
+      //! Fragments are rendered lazily, outside of the lock, and
+      //! only when the message changed since the last rendering.
+      struct Slot
+      {
+        //! Key of the slot in message update documents.
+        std::string key;
+        //! Latest message.
+        DUNE::IMC::SharedMessage msg;
+        //! Update number of the latest message.
+        uint64_t seq;
+        //! JSON fragment.
+        std::shared_ptr<const std::string> json;
+        //! Update number of the JSON fragment.
+        uint64_t json_seq;
+
+        Slot(void):
+          seq(0),
+          json_seq(0)
+        { }
+      };
+
+      //! Rendered JSON fragment.
+      struct Fragment
+      {
+        //! Key of the slot.
+        std::string key;
+        //! JSON fragment.
+        std::shared_ptr<const std::string> json;
+      };
+
+      //! Convenience type definition for a table of messages.
+      typedef std::map<unsigned, Slot> MessageMap;
       //! Convenience type definition for a map of power channels.
-      typedef std::map<std::string, DUNE::IMC::PowerChannelState*> PowerChannelMap;
+      typedef std::map<std::string, Slot> PowerChannelMap;
       // Convenience type definition for a map of entity labels.
       typedef std::map<unsigned, std::string> EntityMap;
       // Software meta information.
       std::string m_meta;
       // Table of messages.
-      std::map<unsigned, DUNE::IMC::Message*> m_msgs;
+      MessageMap m_msgs;
+      //! Power channels.
+      PowerChannelMap m_power_channels;
+      // Last update number.
+      uint64_t m_seq;
       // Entity map.
       EntityMap m_entities;
       // Concurrency mutex.
@@ -94,8 +143,6 @@ namespace Transports
       DUNE::Utils::ByteBuffer m_msgs_json;
       // Last JSON messages refresh.
       uint64_t m_last_msgs_json;
-      //! Power channels.
-      PowerChannelMap m_power_channels;
       // Logbook messages.
       std::vector<DUNE::IMC::LogBookEntry*> m_logbook;
       // Logbook messages' JSON.
@@ -105,8 +152,20 @@ namespace Transports
       // Number of logbook messages to show.
       unsigned int m_log_entry;
 
+      //! Render the JSON fragments of messages that changed and
+      //! retrieve the fragments updated after a given update.
+      //! @param since last update already seen (0 for all fragments).
+      //! @param frags fragments of messages followed by fragments of
+      //! power channels.
+      //! @return last update covered by the fragments.
+      uint64_t
+      collect(uint64_t since, std::vector<Fragment>& frags);
+
+      //! Update the state of a power channel.
+      //! @param msg power channel state.
+      //! @param shared handle to a copy of the message.
       void
-      updatePowerChannel(const DUNE::IMC::PowerChannelState* msg);
+      updatePowerChannel(const DUNE::IMC::PowerChannelState* msg, const DUNE::IMC::SharedMessage& shared);
     };
   }
 }
@@ -38,6 +38,9 @@
 // DUNE headers.
 #include <DUNE/DUNE.hpp>
 
+// Local headers.
+#include "Connection.hpp"
+
 namespace Transports
 {
   namespace HTTP
@@ -57,61 +60,84 @@ namespace Transports
       { }
 
       virtual void
-      handleGET(TCPSocket* sock, Utils::TupleList& headers, const char* uri);
+      handleGET(Connection* conn, Utils::TupleList& headers, const char* uri);
 
       virtual void
-      handlePOST(TCPSocket* sock, Utils::TupleList& headers, const char* uri);
+      handlePOST(Connection* conn, Utils::TupleList& headers, const char* uri);
 
       virtual void
-      handlePUT(TCPSocket* sock, Utils::TupleList& headers, const char* uri);
+      handlePUT(Connection* conn, Utils::TupleList& headers, const char* uri);
+
+      void
+      sendHeader(Connection* conn, const char* status_line, int64_t length, HeaderFieldsMap* hdr_fields = 0);
 
       void
-      sendHeader(TCPSocket* sock, const char* status_line, int64_t length, HeaderFieldsMap* hdr_fields = 0);
+      sendResponse100(Connection* conn);
 
       void
-      sendResponse100(TCPSocket* sock);
+      sendResponse201(Connection* conn);
 
       void
-      sendResponse201(TCPSocket* sock);
+      sendResponse200(Connection* conn);
 
       void
-      sendResponse200(TCPSocket* sock);
+      sendResponse400(Connection* conn);
 
       void
-      sendResponse403(TCPSocket* sock);
+      sendResponse403(Connection* conn);
 
       void
-      sendResponse404(TCPSocket* sock, const std::string& message);
+      sendResponse404(Connection* conn, const std::string& message);
 
       inline void
-      sendResponse404(TCPSocket* sock)
+      sendResponse404(Connection* conn)
       {
-        sendResponse404(sock, "Not Found");
+        sendResponse404(conn, "Not Found");
       }
 
       void
-      sendResponse416(TCPSocket* sock);
+      sendResponse416(Connection* conn);
 
       void
-      sendResponse500(TCPSocket* sock);
+      sendResponse500(Connection* conn);
 
       void
-      sendResponse503(TCPSocket* sock);
+      sendResponse503(Connection* conn);
 
       void
-      sendData(TCPSocket* sock, const char* data, int size, HeaderFieldsMap* hdr_fields = 0);
+      sendData(Connection* conn, const char* data, int size, HeaderFieldsMap* hdr_fields = 0);
 
       inline void
-      sendData(TCPSocket* sock, const std::string& data, HeaderFieldsMap* hdr_fields = 0)
+      sendData(Connection* conn, const std::string& data, HeaderFieldsMap* hdr_fields = 0)
       {
-        sendData(sock, data.c_str(), (int)data.size(), hdr_fields);
+        sendData(conn, data.c_str(), (int)data.size(), hdr_fields);
       }
 
+      //! Start an event stream (Server-Sent Events) response.
+      //! @param conn connection.
+      void
+      sendEventStream(Connection* conn);
+
+      //! Send an event to an event stream.
+      //! @param conn connection.
+      //! @param event event name.
+      //! @param data event payload.
       void
-      sendFile(TCPSocket* sock, const std::string& file, HeaderFieldsMap& hdr_fields, int64_t off_beg = -1, int64_t off_end = -1);
+      sendEvent(Connection* conn, const char* event, const std::string& data);
 
       void
-      handleRequest(TCPSocket* sock);
+      sendFile(Connection* conn, const std::string& file, HeaderFieldsMap& hdr_fields, int64_t off_beg = -1, int64_t off_end = -1);
+
+      //! Handle a complete request.
+      //! @param conn connection.
+      //! @param header request line and header fields.
+      void
+      handleRequest(Connection* conn, const std::string& header);
+
+      //! Called before a connection is closed.
+      //! @param conn connection.
+      virtual void
+      handleClose(Connection* conn);
     };
   }
 }
@@ -28,17 +28,21 @@
 //***************************************************************************
 
 // ISO C++ 98 headers.
-#include <sstream>
-#include <fstream>
-#include <queue>
-#include <iostream>
+#include <vector>
 
 // DUNE headers.
-#include <DUNE/Streams/Terminal.hpp>
-#include <DUNE/Concurrency/TSQueue.hpp>
-#include <DUNE/Concurrency/Condition.hpp>
-#include <DUNE/Concurrency/Mutex.hpp>
-#include <DUNE/Network.hpp>
+#include <DUNE/DUNE.hpp>
+
+// POSIX headers.
+#if defined(DUNE_SYS_HAS_SYS_EPOLL_H)
+#  include <sys/epoll.h>
+#elif defined(DUNE_SYS_HAS_POLL_H)
+#  include <poll.h>
+#endif
+
+#if defined(DUNE_SYS_HAS_UNISTD_H)
+#  include <unistd.h>
+#endif
 
 // Local headers.
 #include "Server.hpp"
@@ -47,102 +51,250 @@ namespace Transports
 {
   namespace HTTP
   {
-    class Handler: public Concurrency::Thread
+    //! Maximum number of open connections.
+    static const size_t c_max_connections = 128;
+    //! Maximum number of events handled per poll.
+    static const int c_max_events = 64;
+
+    Server::Server(int port, RequestHandler& handler, double idle_timeout):
+      m_handler(handler),
+      m_idle_timeout(idle_timeout),
+      m_epoll(-1)
+    {
+      m_sock.bind(port);
+      m_sock.listen(1024);
+
+#if defined(DUNE_SYS_HAS_SYS_EPOLL_H)
+      m_epoll = epoll_create1(EPOLL_CLOEXEC);
+      if (m_epoll == -1)
+        throw std::runtime_error(System::Error::getLastMessage());
+#endif
+
+      watch(m_sock.getNative(), true, false, true);
+    }
+
+    Server::~Server(void)
+    {
+      while (!m_conns.empty())
+        close(m_conns.begin());
+
+#if defined(DUNE_SYS_HAS_SYS_EPOLL_H)
+      ::close(m_epoll);
+#endif
+    }
+
+    void
+    Server::watch(int handle, bool readable, bool writable, bool add)
     {
-    public:
-      Handler(RequestHandler& hdler, Concurrency::TSQueue<TCPSocket*>& queue):
-        m_handler(hdler),
-        m_queue(queue)
-      { }
-
-    private:
-      RequestHandler& m_handler;
-      Concurrency::TSQueue<TCPSocket*>& m_queue;
-
-      void
-      run(void)
+#if defined(DUNE_SYS_HAS_SYS_EPOLL_H)
+      epoll_event ev;
+      ev.events = 0;
+      if (readable)
+        ev.events |= EPOLLIN;
+      if (writable)
+        ev.events |= EPOLLOUT;
+      ev.data.fd = handle;
+      epoll_ctl(m_epoll, add ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, handle, &ev);
+#else
+      // Interest is rebuilt on every poll.
+      (void)handle;
+      (void)readable;
+      (void)writable;
+      (void)add;
+#endif
+    }
+
+    void
+    Server::poll(double timeout)
+    {
+      // Send data queued outside of request handling (event streams).
+      for (ConnectionMap::iterator itr = m_conns.begin(); itr != m_conns.end(); )
+      {
+        ConnectionMap::iterator next = itr;
+        ++next;
+        if (itr->second.conn->getPendingSize() > 0 && !itr->second.writing)
+          handle(itr, false, true);
+        itr = next;
+      }
+
+      int timeout_ms = (int)(timeout * 1000.0);
+
+#if defined(DUNE_SYS_HAS_SYS_EPOLL_H)
+      epoll_event events[c_max_events];
+      int count = epoll_wait(m_epoll, events, c_max_events, timeout_ms);
+
+      for (int i = 0; i < count; ++i)
       {
-        while (!isStopping())
+        int fd = events[i].data.fd;
+        if (fd == m_sock.getNative())
         {
-          if (!m_queue.waitForItems(1.0))
-            continue;
+          accept();
+          continue;
+        }
 
-          if (m_queue.closed())
-            break;
+        ConnectionMap::iterator itr = m_conns.find(fd);
+        if (itr != m_conns.end())
+        {
+          handle(itr, (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0,
+                 (events[i].events & EPOLLOUT) != 0);
+        }
+      }
+#else
+      std::vector<pollfd> fds;
+      fds.reserve(m_conns.size() + 1);
 
-          TCPSocket* sock = m_queue.pop();
-          if (!sock)
-            continue;
+      pollfd pfd;
+      pfd.fd = m_sock.getNative();
+      pfd.events = POLLIN;
+      pfd.revents = 0;
+      fds.push_back(pfd);
 
-          try
-          {
-            m_handler.handleRequest(sock);
-          }
-          catch (...)
-          { }
+      for (ConnectionMap::iterator itr = m_conns.begin(); itr != m_conns.end(); ++itr)
+      {
+        pfd.fd = itr->first;
+        pfd.events = (itr->second.reading ? POLLIN : 0) | (itr->second.writing ? POLLOUT : 0);
+        fds.push_back(pfd);
+      }
+
+      int count = ::poll(&fds[0], fds.size(), timeout_ms);
+
+      for (size_t i = 1; count > 0 && i < fds.size(); ++i)
+      {
+        if (fds[i].revents == 0)
+          continue;
 
-          delete sock;
+        ConnectionMap::iterator itr = m_conns.find(fds[i].fd);
+        if (itr != m_conns.end())
+        {
+          handle(itr, (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) != 0,
+                 (fds[i].revents & POLLOUT) != 0);
         }
       }
-    };
 
-    Server::Server(int port, unsigned threads, RequestHandler& handler):
-      m_handler(handler)
+      if (count > 0 && fds[0].revents != 0)
+        accept();
+#endif
+
+      // Close idle connections.
+      double now = Clock::get();
+      for (ConnectionMap::iterator itr = m_conns.begin(); itr != m_conns.end(); )
+      {
+        ConnectionMap::iterator next = itr;
+        ++next;
+
+        Connection* conn = itr->second.conn;
+        if (!conn->isStreaming() && (now - conn->getLastActivity()) > m_idle_timeout)
+          close(itr);
+
+        itr = next;
+      }
+    }
+
+    void
+    Server::accept(void)
     {
-      m_sock.bind(port);
-      m_sock.listen(1024);
-      m_poll.add(m_sock);
+      TCPSocket* sock = NULL;
 
-      for (unsigned int i = 0; i < threads; ++i)
+      try
       {
-        Concurrency::Thread* t = new Handler(handler, m_queue);
-        m_pool.push_back(t);
-        t->start();
+        sock = m_sock.accept();
       }
+      catch (std::runtime_error& e)
+      {
+        DUNE_ERR("Server", e.what());
+        return;
+      }
+
+      if (m_conns.size() >= c_max_connections)
+      {
+        delete sock;
+        return;
+      }
+
+      Entry entry;
+      entry.conn = new Connection(sock);
+      entry.reading = true;
+      entry.writing = false;
+      m_conns[entry.conn->getHandle()] = entry;
+      watch(entry.conn->getHandle(), true, false, true);
     }
 
-    Server::~Server(void)
+    void
+    Server::handle(ConnectionMap::iterator itr, bool readable, bool writable)
     {
-      m_queue.close();
+      Connection* conn = itr->second.conn;
+      bool ok = true;
 
-      for (unsigned i = 0; i < m_pool.size(); ++i)
+      if (readable)
       {
-        try
-        {
-          m_pool[i]->stopAndJoin();
-        }
-        catch (...)
-        { }
+        ok = conn->receive() && process(conn);
+
+        // The peer will not send more requests: answer the ones it
+        // sent and close the connection.
+        if (ok && conn->isClosed())
+          conn->setKeepAlive(false);
+      }
+
+      if (ok && (writable || conn->getPendingSize() > 0))
+        ok = conn->send();
 
-        delete m_pool[i];
+      if (!ok || conn->isDone())
+      {
+        close(itr);
+        return;
       }
 
-      while (!m_queue.empty())
+      // A closed input would be reported as readable forever.
+      bool reading = !conn->isClosed();
+      bool writing = conn->getPendingSize() > 0;
+      if (reading != itr->second.reading || writing != itr->second.writing)
       {
-        TCPSocket* sock = m_queue.pop();
-        if (sock)
-          delete sock;
+        itr->second.reading = reading;
+        itr->second.writing = writing;
+        watch(itr->first, reading, writing, false);
       }
     }
 
-    void
-    Server::poll(double timeout)
+    bool
+    Server::process(Connection* conn)
     {
-      if (m_poll.poll(timeout))
+      std::string header;
+      int rv = 0;
+
+      while (conn->getKeepAlive() && (rv = conn->nextRequest(header)) == 1)
       {
-        if (m_poll.wasTriggered(m_sock))
+        try
         {
-          try
-          {
-            TCPSocket* nc = m_sock.accept();
-            m_queue.push(nc);
-          }
-          catch (std::runtime_error& e)
-          {
-            DUNE_ERR("Server", e.what());
-          }
+          m_handler.handleRequest(conn, header);
+        }
+        catch (std::exception& e)
+        {
+          DUNE_ERR("Server", e.what());
+          return false;
         }
       }
+
+      if (rv < 0)
+      {
+        conn->setKeepAlive(false);
+        m_handler.sendResponse400(conn);
+      }
+
+      return true;
+    }
+
+    void
+    Server::close(ConnectionMap::iterator itr)
+    {
+      Connection* conn = itr->second.conn;
+      m_handler.handleClose(conn);
+
+#if defined(DUNE_SYS_HAS_SYS_EPOLL_H)
+      epoll_ctl(m_epoll, EPOLL_CTL_DEL, itr->first, NULL);
+#endif
+
+      m_conns.erase(itr);
+      delete conn;
     }
   }
 }
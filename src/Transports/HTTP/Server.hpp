@@ -31,44 +31,113 @@
 #define TRANSPORTS_HTTP_SERVER_HPP_INCLUDED_
 
 // ISO C++ 98 headers.
+#include <map>
 #include <vector>
 
 // DUNE headers.
 #include <DUNE/DUNE.hpp>
 
 // Local headers.
+#include "Connection.hpp"
 #include "RequestHandler.hpp"
 
 namespace Transports
 {
   namespace HTTP
   {
+    //! Single-threaded, event-driven HTTP server. Connections are
+    //! non-blocking and persistent: requests are handled as soon as
+    //! they are complete and responses are sent as the sockets
+    //! become writable. The readiness of sockets is obtained with
+    //! epoll where available and poll() otherwise.
     class Server
     {
     public:
       //! Constructor.
       //! @param port listening port.
-      //! @param threads number of worker threads.
       //! @param handler HTTP request handler.
-      Server(int port, unsigned threads, RequestHandler& handler);
+      //! @param idle_timeout time after which idle connections are
+      //! closed.
+      Server(int port, RequestHandler& handler, double idle_timeout);
 
       //! Destructor.
       ~Server(void);
 
+      //! Send pending data, wait for network events and handle them.
+      //! @param timeout maximum amount of time to wait.
       void
       poll(double timeout);
 
+      //! Retrieve number of open connections.
+      //! @return number of connections.
+      size_t
+      getConnectionCount(void) const
+      {
+        return m_conns.size();
+      }
+
     private:
+      //! Registered connection.
+      struct Entry
+      {
+        //! Connection.
+        Connection* conn;
+        //! Waiting for the socket to become readable.
+        bool reading;
+        //! Waiting for the socket to become writable.
+        bool writing;
+      };
+
+      //! Map of connections by socket handle.
+      typedef std::map<int, Entry> ConnectionMap;
+
       //! HTTP request handler.
       RequestHandler& m_handler;
       //! Server socket.
       TCPSocket m_sock;
-      //! Worker threads pool.
-      std::vector<Concurrency::Thread*> m_pool;
-      //! Socket queue.
-      Concurrency::TSQueue<TCPSocket*> m_queue;
-      //! I/O multiplexing.
-      IO::Poll m_poll;
+      //! Idle timeout.
+      double m_idle_timeout;
+      //! Open connections.
+      ConnectionMap m_conns;
+      //! Event polling handle (epoll only).
+      int m_epoll;
+
+      //! Accept a new connection.
+      void
+      accept(void);
+
+      //! Handle socket events of a connection.
+      //! @param itr connection.
+      //! @param readable socket is readable.
+      //! @param writable socket is writable.
+      void
+      handle(ConnectionMap::iterator itr, bool readable, bool writable);
+
+      //! Handle all complete requests of a connection.
+      //! @param conn connection.
+      //! @return false if the connection must be closed.
+      bool
+      process(Connection* conn);
+
+      //! Register interest in socket events.
+      //! @param handle socket handle.
+      //! @param readable wait for the socket to become readable.
+      //! @param writable wait for the socket to become writable.
+      //! @param add true for a new socket.
+      void
+      watch(int handle, bool readable, bool writable, bool add);
+
+      //! Close a connection.
+      //! @param itr connection.
+      void
+      close(ConnectionMap::iterator itr);
+
+      //! Non-copyable.
+      Server(const Server&);
+
+      //! Non-assignable.
+      Server&
+      operator=(const Server&);
     };
   }
 }
@@ -35,11 +35,14 @@
 #include <cstdlib>
 #include <algorithm>
 #include <cstddef>
+#include <map>
+#include <utility>
 
 // DUNE headers.
 #include <DUNE/DUNE.hpp>
 
 // Local headers.
+#include "Connection.hpp"
 #include "MessageMonitor.hpp"
 #include "RequestHandler.hpp"
 #include "Server.hpp"
@@ -57,8 +60,10 @@ namespace Transports
     {
       //! Start port.
       unsigned port;
-      //! Number of worker threads.
-      unsigned threads;
+      //! Idle connection timeout.
+      double idle_timeout;
+      //! Period of event stream updates.
+      double stream_period;
       //! List of messages to transport.
       std::vector<std::string> messages;
     };
@@ -67,6 +72,10 @@ namespace Transports
     static const unsigned c_buffer_len = 4096;
     //! Maximum number of ports to try before giving up.
     static const int c_max_port_tries = 10;
+    //! Event streams with more data pending are not updated.
+    static const uint64_t c_stream_backlog = 16 * 1024;
+    //! Period of event stream keep-alive comments.
+    static const double c_stream_keep_alive = 15.0;
 
     struct Task: public Tasks::Task, public RequestHandler
     {
@@ -78,6 +87,12 @@ namespace Transports
       std::string m_agent;
       //! Message Monitor.
       MessageMonitor m_msg_mon;
+      //! Event streams and last update sent to each.
+      std::map<Connection*, uint64_t> m_streams;
+      //! Event stream update timer.
+      Time::Counter<double> m_stream_timer;
+      //! Event stream keep-alive timer.
+      Time::Counter<double> m_keep_alive_timer;
       //! Task arguments.
       Arguments m_args;
 
@@ -92,9 +107,18 @@ namespace Transports
         .defaultValue("8080")
         .description("TCP port to listen on");
 
-        param("Threads", m_args.threads)
-        .defaultValue("5")
-        .description("Number of worker threads");
+        param("Idle Timeout", m_args.idle_timeout)
+        .defaultValue("30.0")
+        .units(Units::Second)
+        .minimumValue("1.0")
+        .description("Time after which idle persistent connections are closed");
+
+        param("Stream Period", m_args.stream_period)
+        .defaultValue("1.0")
+        .units(Units::Second)
+        .minimumValue("0.1")
+        .description("Period of message updates sent to event streams."
+                     " Updates of the same message within a period are coalesced");
 
         param("Transports", m_args.messages)
         .defaultValue("")
@@ -106,6 +130,13 @@ namespace Transports
         bind<IMC::LogBookEntry>(this);
       }
 
+      void
+      onUpdateParameters(void)
+      {
+        m_stream_timer.setTop(m_args.stream_period);
+        m_keep_alive_timer.setTop(c_stream_keep_alive);
+      }
+
       void
       onResourceAcquisition(void)
       {
@@ -118,7 +149,7 @@ namespace Transports
           try
           {
             inf(DTR("listening on %s:%u"), Address(Address::Any).c_str(), port);
-            m_server = new Server(port, m_args.threads, *this);
+            m_server = new Server(port, *this, m_args.idle_timeout);
 
             // Initialize and dispatch AnnounceService.
             std::vector<Interface> itfs = Interface::get();
@@ -152,6 +183,7 @@ namespace Transports
       onResourceRelease(void)
       {
         Memory::clear(m_server);
+        m_streams.clear();
       }
 
       void
@@ -192,26 +224,32 @@ namespace Transports
       }
 
       void
-      handleGET(TCPSocket* sock, TupleList& headers, const char* uri)
+      handleGET(Connection* conn, TupleList& headers, const char* uri)
       {
         debug("GET request: %s", uri);
 
         if (isSpecialURI(uri))
         {
           if (matchURL(uri, "/dune/time/set", true))
-            setTime(sock, headers, uri);
+            setTime(conn, headers, uri);
           else if (matchURL(uri, "/dune/version.js"))
-            sendVersionJSON(sock, headers, uri);
+            sendVersionJSON(conn, headers, uri);
           else if (matchURL(uri, "/dune/agent.js"))
-            sendAgentJSON(sock, headers, uri);
+            sendAgentJSON(conn, headers, uri);
           else if (matchURL(uri, "/dune/state/messages.js"))
-            showMessages(sock, headers, uri);
+            showMessages(conn, headers, uri);
+          else if (matchURL(uri, "/dune/state/messages/since/", true))
+            showMessagesSince(conn, headers, uri);
+          else if (matchURL(uri, "/dune/state/stream"))
+            startStream(conn, headers, uri);
           else if (matchURL(uri, "/dune/power/channel/", true))
-            handlePowerChannel(sock, headers, uri);
+            handlePowerChannel(conn, headers, uri);
           else if (matchURL(uri, "/dune/state/logbook.js", true))
-            showLogBook(sock, headers, uri);
+            showLogBook(conn, headers, uri);
+          else if (matchURL(uri, "/dune/state/tasks.json"))
+            showTaskReport(conn, headers, uri);
           else
-            sendResponse404(sock);
+            sendResponse404(conn);
         }
         else
         {
@@ -221,30 +259,30 @@ namespace Transports
           else
             path = m_ctx.dir_www / uri;
 
-          sendStaticFile(sock, headers, path);
+          sendStaticFile(conn, headers, path);
         }
       }
 
       void
-      handlePOST(TCPSocket* sock, TupleList& headers, const char* uri)
+      handlePOST(Connection* conn, TupleList& headers, const char* uri)
       {
         debug("POST request: %s", uri);
 
         if (isSpecialURI(uri))
         {
           if (matchURL(uri, "/dune/messages/imc/", true))
-            getMessage(sock, headers, uri);
+            getMessage(conn, headers, uri);
           else
-            sendResponse403(sock);
+            sendResponse403(conn);
         }
         else
         {
-          sendResponse403(sock);
+          sendResponse403(conn);
         }
       }
 
       void
-      handlePUT(TCPSocket* sock, TupleList& headers, const char* uri)
+      handlePUT(Connection* conn, TupleList& headers, const char* uri)
       {
         debug("PUT request: %s", uri);
 
@@ -252,16 +290,16 @@ namespace Transports
 
         if (isSpecialURI(uri))
         {
-          sendResponse403(sock);
+          sendResponse403(conn);
         }
         else
         {
-          sendResponse403(sock);
+          sendResponse403(conn);
         }
       }
 
       void
-      sendStaticFile(TCPSocket* sock, TupleList& headers, const Path& file)
+      sendStaticFile(Connection* conn, TupleList& headers, const Path& file)
       {
         int64_t beg = -1;
         int64_t end = -1;
@@ -288,26 +326,39 @@ namespace Transports
         else if (ext == "js")
           hdr["Content-Type"] = "text/javascript";
 
-        sendFile(sock, file.str(), hdr, beg, end);
+        sendFile(conn, file.str(), hdr, beg, end);
       }
 
       void
-      getMessage(TCPSocket* sock, TupleList& headers, const char* uri)
+      getMessage(Connection* conn, TupleList& headers, const char* uri)
       {
         (void)uri;
 
-        unsigned int size = headers.get("content-length", 0);
-        char* bfr = new char[size];
-        sock->read(bfr, size);
-        IMC::Message* msg = IMC::Packet::deserialize((uint8_t*)bfr, size);
+        (void)headers;
+
+        const std::string& body = conn->getBody();
+        IMC::Message* msg = NULL;
+
+        try
+        {
+          msg = IMC::Packet::deserialize((const uint8_t*)body.data(), body.size());
+        }
+        catch (std::exception& e)
+        {
+          debug("invalid message: %s", e.what());
+          sendResponse400(conn);
+          return;
+        }
+
         dispatch(msg, DF_KEEP_TIME);
         std::ostringstream ss;
         msg->toText(ss);
-        sendData(sock, ss.str());
+        delete msg;
+        sendData(conn, ss.str());
       }
 
       void
-      setTime(TCPSocket* sock, TupleList& headers, const char* uri)
+      setTime(Connection* conn, TupleList& headers, const char* uri)
       {
         (void)headers;
 
@@ -318,16 +369,16 @@ namespace Transports
         ss >> secs;
         if (ss.fail())
         {
-          sendResponse500(sock);
+          sendResponse500(conn);
           return;
         }
 
-        sendResponse200(sock);
+        sendResponse200(conn);
         Clock::set(secs);
       }
 
       void
-      showMessages(TCPSocket* sock, TupleList& headers, const char* uri)
+      showMessages(Connection* conn, TupleList& headers, const char* uri)
       {
         (void)headers;
         (void)uri;
@@ -337,11 +388,105 @@ namespace Transports
         hdr["Content-Encoding"] = "gzip";
 
         ByteBuffer* bfr = m_msg_mon.messagesJSON();
-        sendData(sock, bfr->getBufferSigned(), bfr->getSize(), &hdr);
+        sendData(conn, bfr->getBufferSigned(), bfr->getSize(), &hdr);
+      }
+
+      void
+      showMessagesSince(Connection* conn, TupleList& headers, const char* uri)
+      {
+        (void)headers;
+
+        std::string arg = String::getRemaining("/dune/state/messages/since/", uri);
+        std::istringstream ss(arg);
+
+        uint64_t since = 0;
+        ss >> since;
+        if (ss.fail())
+        {
+          sendResponse400(conn);
+          return;
+        }
+
+        std::string json;
+        uint64_t seq = m_msg_mon.messagesSince(since, json);
+
+        RequestHandler::HeaderFieldsMap hdr;
+        hdr["Content-Type"] = "application/json";
+        hdr["Cache-Control"] = "no-cache";
+
+        std::ostringstream os;
+        os << "{\"seq\": " << seq << ", \"messages\": " << (json.empty() ? "{}" : json) << "}";
+        sendData(conn, os.str(), &hdr);
       }
 
       void
-      showLogBook(TCPSocket* sock, TupleList& headers, const char* uri)
+      startStream(Connection* conn, TupleList& headers, const char* uri)
+      {
+        (void)headers;
+        (void)uri;
+
+        sendEventStream(conn);
+
+        // Entity labels come with messages.js, which the client
+        // requests when the stream opens. The first update carries
+        // every message.
+        std::string json;
+        m_streams[conn] = m_msg_mon.messagesSince(0, json);
+        if (!json.empty())
+          sendEvent(conn, "messages", json);
+
+        debug("%u event streams", (unsigned)m_streams.size());
+      }
+
+      void
+      handleClose(Connection* conn)
+      {
+        m_streams.erase(conn);
+      }
+
+      void
+      updateStreams(void)
+      {
+        // Streams at the same update share the same event.
+        std::map<uint64_t, std::pair<uint64_t, std::string> > events;
+
+        std::map<Connection*, uint64_t>::iterator itr = m_streams.begin();
+        for (; itr != m_streams.end(); ++itr)
+        {
+          // Clients that are not keeping up get the latest state of
+          // all messages that changed once they catch up.
+          if (itr->first->getPendingSize() > c_stream_backlog)
+            continue;
+
+          std::map<uint64_t, std::pair<uint64_t, std::string> >::iterator eitr = events.find(itr->second);
+          if (eitr == events.end())
+          {
+            std::pair<uint64_t, std::string> event;
+            event.first = m_msg_mon.messagesSince(itr->second, event.second);
+            eitr = events.insert(std::make_pair(itr->second, event)).first;
+          }
+
+          if (eitr->second.second.empty())
+            continue;
+
+          sendEvent(itr->first, "messages", eitr->second.second);
+          itr->second = eitr->second.first;
+        }
+      }
+
+      void
+      keepStreamsAlive(void)
+      {
+        std::map<Connection*, uint64_t>::iterator itr = m_streams.begin();
+        for (; itr != m_streams.end(); ++itr)
+        {
+          if (itr->first->getPendingSize() == 0)
+            itr->first->write(": keep-alive\n\n");
+        }
+      }
+
+      void
+      showLogBook(Connection* conn, TupleList& headers, const char* uri)
       {
         (void)headers;
         (void)uri;
@@ -351,11 +496,24 @@ namespace Transports
         hdr["Content-Encoding"] = "gzip";
 
         ByteBuffer* bfr = m_msg_mon.logbookJSON();
-        sendData(sock, bfr->getBufferSigned(), bfr->getSize(), &hdr);
+        sendData(conn, bfr->getBufferSigned(), bfr->getSize(), &hdr);
+      }
+
+      //! Send the latest runtime statistics of tasks.
+      void
+      showTaskReport(Connection* conn, TupleList& headers, const char* uri)
+      {
+        (void)headers;
+        (void)uri;
+
+        RequestHandler::HeaderFieldsMap hdr;
+        hdr["Content-Type"] = "application/json";
+        hdr["Cache-Control"] = "no-cache";
+        sendData(conn, m_ctx.report.toJSON(), &hdr);
       }
 
       void
-      sendVersionJSON(TCPSocket* sock, TupleList& headers, const char* uri)
+      sendVersionJSON(Connection* conn, TupleList& headers, const char* uri)
       {
         (void)headers;
         (void)uri;
@@ -364,11 +522,11 @@ namespace Transports
         os << "var systemVersion = '" << getFullVersion() << " - " << getCompileDate() << "';";
         RequestHandler::HeaderFieldsMap hdr;
         hdr["Content-Type"] = "text/javascript";
-        sendData(sock, os.str(), &hdr);
+        sendData(conn, os.str(), &hdr);
       }
 
       void
-      sendAgentJSON(TCPSocket* sock, TupleList& headers, const char* uri)
+      sendAgentJSON(Connection* conn, TupleList& headers, const char* uri)
       {
         (void)headers;
         (void)uri;
@@ -377,11 +535,11 @@ namespace Transports
         os << "var systemName = '" << m_agent << "';";
         RequestHandler::HeaderFieldsMap hdr;
         hdr["Content-Type"] = "text/javascript";
-        sendData(sock, os.str(), &hdr);
+        sendData(conn, os.str(), &hdr);
       }
 
       void
-      handlePowerChannel(TCPSocket* sock, TupleList& headers, const char* uri)
+      handlePowerChannel(Connection* conn, TupleList& headers, const char* uri)
       {
         (void)headers;
 
@@ -391,7 +549,7 @@ namespace Transports
 
         if (parts.size() != 2 && parts.size() != 5)
         {
-          sendResponse500(sock);
+          sendResponse500(conn);
           return;
         }
 
@@ -401,7 +559,7 @@ namespace Transports
           unsigned t = 0;
           if (!castLexical(parts[2], t))
           {
-            sendResponse500(sock);
+            sendResponse500(conn);
             return;
           }
           else
@@ -409,7 +567,7 @@ namespace Transports
 
           if (!castLexical(parts[3], t))
           {
-            sendResponse500(sock);
+            sendResponse500(conn);
             return;
           }
           else
@@ -417,7 +575,7 @@ namespace Transports
 
           if (!castLexical(parts[4], t))
           {
-            sendResponse500(sock);
+            sendResponse500(conn);
             return;
           }
           else
@@ -444,7 +602,7 @@ namespace Transports
           pcc.sched_time = sched_time;
         }
 
-        sendResponse200(sock);
+        sendResponse200(conn);
         dispatch(pcc);
       }
 
@@ -454,8 +612,20 @@ namespace Transports
         while (!stopping())
         {
           setEntityState(IMC::EntityState::ESTA_NORMAL, Status::CODE_ACTIVE);
-          m_server->poll(1.0);
+          m_server->poll(std::min(1.0, m_args.stream_period));
           consumeMessages();
+
+          if (m_stream_timer.overflow())
+          {
+            m_stream_timer.reset();
+            updateStreams();
+          }
+
+          if (m_keep_alive_timer.overflow())
+          {
+            m_keep_alive_timer.reset();
+            keepStreamsAlive();
+          }
         }
       }
     };
@@ -33,10 +33,15 @@
 #include <fstream>
 #include <algorithm>
 #include <cstddef>
+#include <cstring>
+#include <stdexcept>
 
 // DUNE headers.
 #include <DUNE/DUNE.hpp>
 
+// Local headers.
+#include "Writer.hpp"
+
 namespace Transports
 {
   namespace Logging
@@ -58,6 +63,10 @@ namespace Transports
       unsigned lsf_volume_size;
       // Compression method.
       std::string lsf_compression;
+      // Size of each write buffer.
+      unsigned buffer_size;
+      // Number of write buffers.
+      unsigned buffer_count;
     };
 
     struct Task: public Tasks::Task
@@ -72,10 +81,16 @@ namespace Transports
       std::string m_volume_dir;
       // Compression format.
       Compression::Methods m_compression;
-      // Output file stream for LSF/LSF_GZ formats.
-      std::ostream* m_lsf;
+      // Asynchronous writer for LSF/LSF_GZ formats.
+      Writer* m_writer;
+      // Writer statistics at last report.
+      WriterStatistics m_writer_stats;
       // Path to LSF file.
       Path m_lsf_file;
+      // Index of uncompressed LSF files.
+      IMC::LogIndex m_index;
+      // Number of bytes appended to the LSF file.
+      uint64_t m_lsf_offset;
       // Serialization buffer.
       ByteBuffer m_buffer;
       // Logging control message.
@@ -88,7 +103,8 @@ namespace Transports
       Task(const std::string& name, Tasks::Context& ctx):
         Tasks::Task(name, ctx),
         m_last_flush(0),
-        m_lsf(NULL),
+        m_writer(NULL),
+        m_lsf_offset(0),
         m_active(true)
       {
         // Define configuration parameters.
@@ -108,6 +124,18 @@ namespace Transports
         param("LSF Volume Directories", m_args.lsf_volumes)
         .defaultValue("");
 
+        param("Write Buffer Size", m_args.buffer_size)
+        .units(Units::Kibibyte)
+        .defaultValue("256")
+        .minimumValue("4")
+        .description("Size of each buffer handed to the writer thread");
+
+        param("Write Buffer Count", m_args.buffer_count)
+        .defaultValue("3")
+        .minimumValue("2")
+        .description("Number of buffers. When all buffers are waiting to be"
+                     " written, incoming messages are dropped");
+
         param("Transports", m_args.messages)
         .defaultValue("");
 
@@ -124,6 +152,14 @@ namespace Transports
         onResourceRelease();
       }
 
+      void
+      onResourceAcquisition(void)
+      {
+        std::memset(&m_writer_stats, 0, sizeof(m_writer_stats));
+        m_writer = new Writer(m_args.buffer_size * 1024, m_args.buffer_count);
+        m_writer->start();
+      }
+
       void
       onResourceInitialization(void)
       {
@@ -136,7 +172,49 @@ namespace Transports
       void
       onResourceRelease(void)
       {
-        Memory::clear(m_lsf);
+        // Pending buffers are written before the writer stops.
+        Memory::clear(m_writer);
+      }
+
+      void
+      closeLog(void)
+      {
+        if (m_writer != NULL)
+          m_writer->close();
+
+        m_index.close();
+      }
+
+      bool
+      isLogOpen(void) const
+      {
+        return m_writer != NULL && m_writer->isOpen();
+      }
+
+      void
+      reportWriter(void)
+      {
+        if (m_writer == NULL)
+          return;
+
+        if (m_writer->hasFailed())
+          throw std::runtime_error(DTR("failed to write log"));
+
+        WriterStatistics stats;
+        m_writer->getStatistics(stats);
+
+        if (stats.dropped != m_writer_stats.dropped)
+        {
+          war(DTR("storage is not keeping up: dropped %llu bytes (%u overruns)"),
+              (unsigned long long)(stats.dropped - m_writer_stats.dropped),
+              stats.overruns - m_writer_stats.overruns);
+        }
+
+        debug("written %llu bytes, %llu dropped, %u overruns, %u buffers peak",
+              (unsigned long long)stats.written, (unsigned long long)stats.dropped,
+              stats.overruns, stats.peak);
+
+        m_writer_stats = stats;
       }
 
       void
@@ -288,11 +366,32 @@ namespace Transports
         if (!ifs.is_open())
           return;
 
-        char bfr[16 * 1024];
-        while (!ifs.eof())
+        // Copy packet by packet, so that they can be indexed.
+        while (true)
         {
-          ifs.read(bfr, sizeof(bfr));
-          m_lsf->write(bfr, ifs.gcount());
+          m_buffer.setSize(DUNE_IMC_CONST_HEADER_SIZE);
+          ifs.read(m_buffer.getBufferSigned(), DUNE_IMC_CONST_HEADER_SIZE);
+          if (ifs.gcount() < DUNE_IMC_CONST_HEADER_SIZE)
+            break;
+
+          IMC::Header hdr;
+          try
+          {
+            IMC::Packet::deserializeHeader(hdr, m_buffer.getBuffer(), DUNE_IMC_CONST_HEADER_SIZE);
+          }
+          catch (std::exception& e)
+          {
+            war(DTR("invalid cache snapshot: %s"), e.what());
+            break;
+          }
+
+          size_t size = DUNE_IMC_CONST_HEADER_SIZE + hdr.size + DUNE_IMC_CONST_FOOTER_SIZE;
+          m_buffer.setSize(size);
+          ifs.read(m_buffer.getBufferSigned() + DUNE_IMC_CONST_HEADER_SIZE, size - DUNE_IMC_CONST_HEADER_SIZE);
+          if ((size_t)ifs.gcount() < size - DUNE_IMC_CONST_HEADER_SIZE)
+            break;
+
+          logPacket(true);
         }
       }
 
@@ -303,7 +402,7 @@ namespace Transports
         if (!m_active)
           return;
 
-        if (m_lsf == NULL)
+        if (!isLogOpen())
           return;
 
         m_active = keep_logging;
@@ -320,7 +419,7 @@ namespace Transports
         inf(DTR("log stopped '%s'"), m_log_ctl.name.c_str());
         m_log_ctl.name.clear();
 
-        onResourceRelease();
+        closeLog();
       }
 
       void
@@ -349,11 +448,29 @@ namespace Transports
         stopLog();
 
         m_lsf_file = m_dir / "Data.lsf" + Compression::Factory::extension(m_compression);
+        m_lsf_offset = 0;
 
         if (m_compression == METHOD_UNKNOWN)
-          m_lsf = new std::ofstream(m_lsf_file.c_str(), std::ios::binary);
+        {
+          // Buffers are already large, write them straight through.
+          std::ofstream* ofs = new std::ofstream;
+          ofs->rdbuf()->pubsetbuf(0, 0);
+          ofs->open(m_lsf_file.c_str(), std::ios::binary);
+          m_writer->open(ofs);
+
+          try
+          {
+            m_index.open(IMC::LogIndex::getPath(m_lsf_file.str()));
+          }
+          catch (std::exception& e)
+          {
+            war(DTR("failed to create log index: %s"), e.what());
+          }
+        }
         else
-          m_lsf = new Compression::FileOutput(m_lsf_file.c_str(), m_compression);
+        {
+          m_writer->open(new Compression::FileOutput(m_lsf_file.c_str(), m_compression));
+        }
 
         // Log LoggingControl to facilitate posterior conversion to LLF.
         m_log_ctl.op = IMC::LoggingControl::COP_STARTED;
@@ -377,6 +494,7 @@ namespace Transports
         if (now > (m_last_flush + m_args.flush_interval))
         {
           tryRotate();
+          reportWriter();
           m_last_flush = now;
         }
       }
@@ -384,13 +502,14 @@ namespace Transports
       void
       tryRotate(void)
       {
-        if (m_lsf == NULL)
+        if (!isLogOpen())
           return;
 
         int64_t mib = Path(m_lsf_file).size();
         mib /= c_bytes_per_mib;
 
-        m_lsf->flush();
+        m_writer->flush();
+        m_index.flush();
 
         if ((m_args.lsf_volume_size > 0) && (mib >= m_args.lsf_volume_size))
           tryStartLog(m_label);
@@ -421,11 +540,23 @@ namespace Transports
       void
       logMessage(const IMC::Message* msg)
       {
-        if (m_lsf == NULL)
+        if (!isLogOpen())
           return;
 
         IMC::Packet::serialize(msg, m_buffer);
-        m_lsf->write(m_buffer.getBufferSigned(), m_buffer.getSize());
+        logPacket(false);
+      }
+
+      void
+      logPacket(bool wait)
+      {
+        if (!m_writer->append(m_buffer.getBufferSigned(), m_buffer.getSize(), wait))
+          return;
+
+        if (m_index.isOpen())
+          m_index.add(m_buffer.getBuffer(), m_buffer.getSize(), m_lsf_offset);
+
+        m_lsf_offset += m_buffer.getSize();
       }
 
       void
@@ -0,0 +1,456 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+#ifndef TRANSPORTS_LOGGING_WRITER_HPP_INCLUDED_
+#define TRANSPORTS_LOGGING_WRITER_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <ostream>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+namespace Transports
+{
+  namespace Logging
+  {
+    using DUNE_NAMESPACES;
+
+    //! Writer statistics.
+    struct WriterStatistics
+    {
+      //! Number of bytes written to storage.
+      uint64_t written;
+      //! Number of bytes dropped because all buffers were full.
+      uint64_t dropped;
+      //! Number of times the task found no free buffer.
+      unsigned overruns;
+      //! Maximum number of buffers waiting to be written.
+      unsigned peak;
+    };
+
+    //! Asynchronous LSF writer. Serialized packets are appended to an
+    //! in-memory buffer; full buffers are handed to a writer thread
+    //! that pushes them through the (possibly compressing) output
+    //! stream, so that compression and storage latency never stall
+    //! the logging task. If every buffer is waiting to be written the
+    //! incoming data is dropped and accounted for.
+    class Writer: public Concurrency::Thread
+    {
+    public:
+      //! Constructor.
+      //! @param[in] buffer_size size of each buffer (bytes).
+      //! @param[in] buffer_count number of buffers.
+      Writer(size_t buffer_size, unsigned buffer_count):
+        m_size(alignSize(buffer_size)),
+        m_stream(NULL),
+        m_current(NULL),
+        m_failed(false),
+        m_output(NULL)
+      {
+        std::memset(&m_stats, 0, sizeof(m_stats));
+
+        for (unsigned i = 0; i < std::max(buffer_count, 2U); ++i)
+        {
+          Buffer* bfr = new Buffer;
+          bfr->data = allocate(m_size);
+          bfr->used = 0;
+          m_free.push_back(bfr);
+        }
+
+        m_current = m_free.back();
+        m_free.pop_back();
+      }
+
+      //! Destructor. Pending buffers are written before the thread
+      //! stops.
+      ~Writer(void)
+      {
+        close();
+
+        if (!isCreated())
+        {
+          runCommands();
+        }
+        else
+        {
+          stop();
+          {
+            Concurrency::ScopedCondition l(m_cond);
+            m_cond.broadcast();
+          }
+          join();
+        }
+
+        if (m_current != NULL)
+          m_free.push_back(m_current);
+
+        for (size_t i = 0; i < m_free.size(); ++i)
+        {
+          std::free(m_free[i]->data);
+          delete m_free[i];
+        }
+      }
+
+      //! Start writing to a new stream. Data appended after this call
+      //! goes to the new stream, which is deleted by the writer when
+      //! it is closed.
+      //! @param[in] stream output stream.
+      void
+      open(std::ostream* stream)
+      {
+        close();
+        m_stream = stream;
+        submit(Command(CMD_OPEN, NULL, stream));
+      }
+
+      //! Write pending data and close the current stream.
+      void
+      close(void)
+      {
+        if (m_stream == NULL)
+          return;
+
+        submitCurrent();
+        submit(Command(CMD_CLOSE, NULL, NULL));
+        m_stream = NULL;
+      }
+
+      //! Check if a stream is open.
+      //! @return true if a stream is open, false otherwise.
+      bool
+      isOpen(void) const
+      {
+        return m_stream != NULL;
+      }
+
+      //! Write pending data and flush the output stream.
+      void
+      flush(void)
+      {
+        if (m_stream == NULL)
+          return;
+
+        submitCurrent();
+        submit(Command(CMD_FLUSH, NULL, NULL));
+      }
+
+      //! Append data to the current buffer.
+      //! @param[in] data data.
+      //! @param[in] size number of bytes.
+      //! @param[in] wait if true and there are no free buffers, wait
+      //! for one instead of dropping data.
+      //! @return true if data was appended, false if it was dropped.
+      bool
+      append(const char* data, size_t size, bool wait = false)
+      {
+        if (m_stream == NULL)
+          return false;
+
+        // Never write part of a packet.
+        if (!wait && !hasRoom(size))
+        {
+          Concurrency::ScopedCondition l(m_cond);
+          ++m_stats.overruns;
+          m_stats.dropped += size;
+          return false;
+        }
+
+        while (size > 0)
+        {
+          if (m_current == NULL)
+            acquire();
+
+          size_t n = std::min(size, m_size - m_current->used);
+          std::memcpy(m_current->data + m_current->used, data, n);
+          m_current->used += n;
+          data += n;
+          size -= n;
+
+          if (m_current->used == m_size)
+            submitCurrent();
+        }
+
+        return true;
+      }
+
+      //! Retrieve statistics.
+      //! @param[out] stats statistics.
+      void
+      getStatistics(WriterStatistics& stats)
+      {
+        Concurrency::ScopedCondition l(m_cond);
+        stats = m_stats;
+      }
+
+      //! Check if writing to the output stream failed.
+      //! @return true if writing failed, false otherwise.
+      bool
+      hasFailed(void)
+      {
+        Concurrency::ScopedCondition l(m_cond);
+        return m_failed;
+      }
+
+    private:
+      //! Alignment of buffers and writes.
+      static const size_t c_alignment = 4096;
+
+      //! Memory buffer.
+      struct Buffer
+      {
+        //! Data.
+        char* data;
+        //! Number of bytes used.
+        size_t used;
+      };
+
+      //! Writer thread commands.
+      enum CommandType
+      {
+        CMD_OPEN,
+        CMD_WRITE,
+        CMD_FLUSH,
+        CMD_CLOSE
+      };
+
+      //! Writer thread command.
+      struct Command
+      {
+        Command(CommandType t, Buffer* b, std::ostream* s):
+          type(t),
+          buffer(b),
+          stream(s)
+        { }
+
+        //! Command type.
+        CommandType type;
+        //! Buffer to write (CMD_WRITE).
+        Buffer* buffer;
+        //! Stream to open (CMD_OPEN).
+        std::ostream* stream;
+      };
+
+      //! Size of each buffer.
+      size_t m_size;
+      //! Stream owned by the task side (NULL if closed).
+      std::ostream* m_stream;
+      //! Buffer being filled by the task.
+      Buffer* m_current;
+      //! Free buffers.
+      std::vector<Buffer*> m_free;
+      //! Pending commands.
+      std::deque<Command> m_commands;
+      //! Lock and condition for the fields above and below.
+      Concurrency::Condition m_cond;
+      //! Statistics.
+      WriterStatistics m_stats;
+      //! True if writing failed.
+      bool m_failed;
+      //! Stream used by the writer thread.
+      std::ostream* m_output;
+
+      static size_t
+      alignSize(size_t size)
+      {
+        if (size < c_alignment)
+          return c_alignment;
+
+        return (size + c_alignment - 1) / c_alignment * c_alignment;
+      }
+
+      static char*
+      allocate(size_t size)
+      {
+        void* ptr = NULL;
+        if (posix_memalign(&ptr, c_alignment, size) != 0)
+          throw std::bad_alloc();
+        return static_cast<char*>(ptr);
+      }
+
+      //! Check if data fits in the current and free buffers.
+      //! @param[in] size number of bytes.
+      //! @return true if data fits, false otherwise.
+      bool
+      hasRoom(size_t size)
+      {
+        size_t room = (m_current == NULL) ? 0 : (m_size - m_current->used);
+        if (size <= room)
+          return true;
+
+        Concurrency::ScopedCondition l(m_cond);
+        return (size - room) <= m_free.size() * m_size;
+      }
+
+      //! Get a free buffer, waiting for one if needed.
+      void
+      acquire(void)
+      {
+        Concurrency::ScopedCondition l(m_cond);
+
+        if (m_free.empty())
+        {
+          ++m_stats.overruns;
+          while (m_free.empty())
+            m_cond.wait();
+        }
+
+        m_current = m_free.back();
+        m_free.pop_back();
+        m_current->used = 0;
+      }
+
+      //! Hand the current buffer to the writer thread.
+      void
+      submitCurrent(void)
+      {
+        if (m_current == NULL || m_current->used == 0)
+          return;
+
+        submit(Command(CMD_WRITE, m_current, NULL));
+        m_current = NULL;
+
+        // Take a free buffer right away if there is one, so that a
+        // short burst does not count as an overrun.
+        Concurrency::ScopedCondition l(m_cond);
+        if (!m_free.empty())
+        {
+          m_current = m_free.back();
+          m_free.pop_back();
+          m_current->used = 0;
+        }
+      }
+
+      void
+      submit(const Command& cmd)
+      {
+        Concurrency::ScopedCondition l(m_cond);
+        m_commands.push_back(cmd);
+        if (cmd.type == CMD_WRITE)
+        {
+          unsigned pending = 0;
+          for (size_t i = 0; i < m_commands.size(); ++i)
+            pending += (m_commands[i].type == CMD_WRITE);
+          m_stats.peak = std::max(m_stats.peak, pending);
+        }
+
+        m_cond.broadcast();
+      }
+
+      //! Execute queued commands.
+      //! @return false if there were no commands.
+      bool
+      runCommands(void)
+      {
+        std::deque<Command> cmds;
+        {
+          Concurrency::ScopedCondition l(m_cond);
+          cmds.swap(m_commands);
+        }
+
+        if (cmds.empty())
+          return false;
+
+        for (size_t i = 0; i < cmds.size(); ++i)
+          execute(cmds[i]);
+
+        return true;
+      }
+
+      void
+      execute(const Command& cmd)
+      {
+        switch (cmd.type)
+        {
+          case CMD_OPEN:
+            m_output = cmd.stream;
+            break;
+
+          case CMD_WRITE:
+            if (m_output != NULL)
+            {
+              m_output->write(cmd.buffer->data, cmd.buffer->used);
+              if (m_output->bad())
+                setFailed();
+            }
+
+            {
+              Concurrency::ScopedCondition l(m_cond);
+              if (m_output != NULL)
+                m_stats.written += cmd.buffer->used;
+              cmd.buffer->used = 0;
+              m_free.push_back(cmd.buffer);
+              m_cond.broadcast();
+            }
+            break;
+
+          case CMD_FLUSH:
+            if (m_output != NULL)
+              m_output->flush();
+            break;
+
+          case CMD_CLOSE:
+            Memory::clear(m_output);
+            break;
+        }
+      }
+
+      void
+      setFailed(void)
+      {
+        Concurrency::ScopedCondition l(m_cond);
+        m_failed = true;
+      }
+
+      void
+      run(void)
+      {
+        while (true)
+        {
+          {
+            Concurrency::ScopedCondition l(m_cond);
+            while (m_commands.empty() && !isStopping())
+              m_cond.wait(1.0);
+
+            if (m_commands.empty() && isStopping())
+              break;
+          }
+
+          runCommands();
+        }
+      }
+    };
+  }
+}
+
+#endif
@@ -43,6 +43,9 @@
 #include <atomic>
 #include <mqtt/async_client.h>
 
+// Local headers.
+#include <Transports/MQTT/Receiver.hpp>
+
 
 
 namespace Transports
@@ -68,6 +71,9 @@ namespace Transports
         std::string client_id;
         std::string lwt_payload; //Last will testament payload
         int  QOS; //Quality of service
+        unsigned int rx_capacity; //Maximum number of queued MQTT messages
+        unsigned int rx_high_water; //Queue depth considered congested
+        double rx_delay; //Queueing delay considered late
       };
 
       struct Task: public Tasks::SimpleTransport
@@ -78,10 +84,15 @@ namespace Transports
         TCPSocket* m_sock;
         // Parser handle.
         IMC::Parser m_parser;
+        // Paho callback and queue of received MQTT messages.
+        Receiver m_receiver;
+        // Messages drained from the receive queue.
+        std::vector<Arrival> m_rx_batch;
 
         Task(const std::string& name, Tasks::Context& ctx):
           Tasks::SimpleTransport(name, ctx),
-          m_sock(NULL)
+          m_sock(NULL),
+          m_receiver(*this)
         {
           param("Address", m_args.address)
           .defaultValue("tcp://localhost")
@@ -111,6 +122,25 @@ namespace Transports
           .defaultValue("1")
           .description("MQTT Quality of service");
 
+          param("Receive Queue Capacity", m_args.rx_capacity)
+          .defaultValue("1024")
+          .minimumValue("1")
+          .description("Maximum number of received MQTT messages waiting to be parsed. Oldest messages are dropped when full");
+
+          param("Receive Queue High-Water Mark", m_args.rx_high_water)
+          .defaultValue("256")
+          .description("Number of queued MQTT messages above which the link is reported as congested");
+
+          param("Receive Delay Threshold", m_args.rx_delay)
+          .defaultValue("1.0")
+          .units(Units::Second)
+          .description("Queueing time above which a received MQTT message is counted as delayed");
+        }
+
+        void
+        onUpdateParameters(void)
+        {
+          m_receiver.setLimits(m_args.rx_capacity, m_args.rx_high_water, m_args.rx_delay);
         }
 
         ~Task(void)
@@ -131,6 +161,7 @@ namespace Transports
 
           //Create mqtt_client instance
           mqtt_client = new mqtt::async_client(adr_string, m_args.client_id);
+          mqtt_client->set_callback(m_receiver);
 
           conn_opts.set_keep_alive_interval(200); 
 	        conn_opts.set_clean_session(true);     
@@ -138,7 +169,6 @@ namespace Transports
           {
             //Connect and subscribe to topic
             mqtt_client->connect(conn_opts)->wait();
-		        mqtt_client->start_consuming();
 		        mqtt_client->subscribe(m_args.subscribe_topic, m_args.QOS)->wait();
 
             inf(DTR("connected to MQTT broker"));
@@ -163,7 +193,6 @@ namespace Transports
                 err(DTR("Error: There are pending MQTT delivery tokens!" ));
                 
                 mqtt_client->unsubscribe(m_args.subscribe_topic)->wait();
-                mqtt_client->stop_consuming();
                 mqtt_client->disconnect()->wait();
                 delete mqtt_client;
               }
@@ -198,36 +227,31 @@ namespace Transports
         void
         onDataReception(uint8_t* p, unsigned int n, double timeout)
         {
-          (void) timeout;
+          (void)p;
+          (void)n;
+
+          m_receiver.report();
+
+          if (!m_receiver.waitForItems(timeout))
+            return;
 
-          auto msg = mqtt_client->consume_message();
-			    if (!msg) return;
-			    inf(DTR("Receiving message" ));
-          unsigned int n_r;
-           
+          m_receiver.drain(m_rx_batch);
 
           try
           {
-            if(msg->get_topic() == m_args.subscribe_topic){
+            for (size_t i = 0; i < m_rx_batch.size(); ++i)
+            {
+              const mqtt::const_message_ptr& msg = m_rx_batch[i].msg;
 
-              //Print topic
-              std::string topic_inf = "Topic is ";
-              topic_inf.append(msg->get_topic());
-              inf(topic_inf.c_str());
-            
-              p = (uint8_t*) msg->get_payload().data();
-              n_r = msg->get_payload().size();
-
-              if (n_r > n)
+              if (msg->get_topic() != m_args.subscribe_topic)
               {
-                err("MQTT Message length is longer than data reception buffer"); 
+                debug("topic of no interest: %s", msg->get_topic().c_str());
+                continue;
               }
 
-            }
-            else{
-              inf(DTR("Topic of no interrest" ));
-              
-              return; 
+              const mqtt::binary_ref& payload = msg->get_payload();
+              if (payload.size() > 0)
+                handleData(m_parser, (const uint8_t*)payload.data(), payload.size());
             }
           }
           catch (std::exception& e)
@@ -235,8 +259,8 @@ namespace Transports
             throw RestartNeeded(e.what(), 5);
           }
 
-          if (n_r > 0)
-            handleData(m_parser, (uint8_t*)p, n_r);
+          // Release payloads.
+          m_rx_batch.clear();
         }
       };
     }
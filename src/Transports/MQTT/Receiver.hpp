@@ -0,0 +1,166 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+
+#ifndef TRANSPORTS_MQTT_RECEIVER_HPP_INCLUDED_
+#define TRANSPORTS_MQTT_RECEIVER_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Paho headers.
+#include <mqtt/async_client.h>
+
+namespace Transports
+{
+  namespace MQTT
+  {
+    using DUNE_NAMESPACES;
+
+    //! MQTT message waiting to be processed by the task.
+    struct Arrival
+    {
+      //! Received message.
+      mqtt::const_message_ptr msg;
+      //! Time of arrival.
+      double time;
+    };
+
+    //! Paho callback that moves received messages to a bounded queue
+    //! drained by the task thread. The task is woken up on every
+    //! arrival, so that it can wait for IMC and MQTT messages at the
+    //! same time with waitForMessages().
+    class Receiver: public mqtt::callback
+    {
+    public:
+      //! Constructor.
+      //! @param[in] task task that drains the queue.
+      Receiver(Tasks::Task& task):
+        m_task(task),
+        m_delay(1.0),
+        m_delayed(0),
+        m_dropped_rep(0),
+        m_delayed_rep(0),
+        m_report_timer(10.0)
+      { }
+
+      //! Set queue limits.
+      //! @param[in] capacity maximum number of queued messages.
+      //! @param[in] high_water queue depth considered congested.
+      //! @param[in] delay queueing delay considered late (s).
+      void
+      setLimits(unsigned capacity, unsigned high_water, double delay)
+      {
+        m_queue.setCapacity(capacity);
+        m_queue.setHighWaterMark(high_water);
+        m_delay = delay;
+      }
+
+      void
+      message_arrived(mqtt::const_message_ptr msg) override
+      {
+        Arrival arrival = {msg, Clock::get()};
+        m_queue.push(arrival);
+        m_task.wakeUp();
+      }
+
+      //! Wait for messages to be queued.
+      //! @param[in] timeout timeout in seconds.
+      //! @return true if messages are queued, false otherwise.
+      bool
+      waitForItems(double timeout)
+      {
+        return m_queue.waitForItems(timeout);
+      }
+
+      //! Move queued messages to a batch, counting the ones that
+      //! waited longer than the delay threshold.
+      //! @param[out] batch destination vector (cleared first).
+      //! @return number of messages.
+      size_t
+      drain(std::vector<Arrival>& batch)
+      {
+        batch.clear();
+        m_queue.popAll(batch);
+
+        double now = Clock::get();
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+          if (now - batch[i].time > m_delay)
+            ++m_delayed;
+        }
+
+        return batch.size();
+      }
+
+      //! Warn about dropped and delayed messages, at most once per
+      //! report period.
+      void
+      report(void)
+      {
+        if (!m_report_timer.overflow())
+          return;
+
+        m_report_timer.reset();
+
+        uint64_t dropped = m_queue.getDropped();
+        if (dropped != m_dropped_rep || m_delayed != m_delayed_rep)
+        {
+          m_task.war(DTR("receive queue: %llu dropped, %llu delayed, peak depth %u, %llu high-water events"),
+                     (unsigned long long)dropped, (unsigned long long)m_delayed,
+                     (unsigned)m_queue.getPeak(), (unsigned long long)m_queue.getHighWaterCrossings());
+
+          m_dropped_rep = dropped;
+          m_delayed_rep = m_delayed;
+        }
+      }
+
+    private:
+      //! Task that drains the queue.
+      Tasks::Task& m_task;
+      //! Received messages.
+      BoundedQueue<Arrival> m_queue;
+      //! Queueing delay considered late.
+      double m_delay;
+      //! Number of messages that waited longer than the delay threshold.
+      uint64_t m_delayed;
+      //! Last reported number of dropped messages.
+      uint64_t m_dropped_rep;
+      //! Last reported number of delayed messages.
+      uint64_t m_delayed_rep;
+      //! Timer to report queue statistics.
+      Time::Counter<double> m_report_timer;
+    };
+  }
+}
+
+#endif
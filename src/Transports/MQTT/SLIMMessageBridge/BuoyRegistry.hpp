@@ -0,0 +1,423 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+#ifndef TRANSPORTS_MQTT_SLIM_MESSAGE_BRIDGE_BUOY_REGISTRY_HPP_INCLUDED_
+#define TRANSPORTS_MQTT_SLIM_MESSAGE_BRIDGE_BUOY_REGISTRY_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// ISO C++ 11 headers.
+#include <unordered_map>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+#if defined(DUNE_SYS_HAS_FCNTL_H)
+#  include <fcntl.h>
+#endif
+
+#if defined(DUNE_SYS_HAS_UNISTD_H)
+#  include <unistd.h>
+#endif
+
+namespace Transports
+{
+  namespace MQTT
+  {
+    namespace SLIMMessageBridge
+    {
+      using DUNE_NAMESPACES;
+
+      //! Last known position of a SLIM buoy.
+      struct BuoyPosition
+      {
+        //! Latitude as reported in the SLIM status frame.
+        int latitude;
+        //! Longitude as reported in the SLIM status frame.
+        int longitude;
+        //! Time of last update (seconds since epoch).
+        double timestamp;
+      };
+
+      //! Registry of SLIM buoy positions indexed by TBR serial
+      //! number. Entries older than a configurable age are evicted
+      //! and the whole table can be saved to / restored from disk so
+      //! that positions survive task restarts.
+      class BuoyRegistry
+      {
+      public:
+        //! Constructor.
+        //! @param[in] capacity maximum number of buoys.
+        //! @param[in] max_age maximum age of an entry in seconds
+        //! (zero disables eviction by age).
+        BuoyRegistry(size_t capacity = 1000, double max_age = 0.0):
+          m_capacity(capacity),
+          m_max_age(max_age),
+          m_dirty(false)
+        { }
+
+        //! Set the maximum number of buoys.
+        //! @param[in] capacity maximum number of buoys.
+        void
+        setCapacity(size_t capacity)
+        {
+          m_capacity = capacity;
+          m_table.reserve(capacity);
+        }
+
+        //! Set the maximum age of an entry.
+        //! @param[in] max_age maximum age in seconds (zero disables).
+        void
+        setMaxAge(double max_age)
+        {
+          m_max_age = max_age;
+        }
+
+        //! Insert or update the position of a buoy. If the registry is
+        //! full, stale entries are evicted first and then the least
+        //! recently updated buoy.
+        //! @param[in] serial TBR serial number.
+        //! @param[in] lat latitude.
+        //! @param[in] lon longitude.
+        //! @param[in] now current time (seconds since epoch).
+        //! @return true if the buoy was not known before, false otherwise.
+        bool
+        update(uint16_t serial, int lat, int lon, double now)
+        {
+          Table::iterator itr = m_table.find(serial);
+          bool fresh = (itr == m_table.end());
+
+          if (fresh)
+          {
+            if (m_capacity == 0)
+              return false;
+
+            if (m_table.size() >= m_capacity)
+            {
+              evict(now);
+
+              if (m_table.size() >= m_capacity)
+                evictOldest();
+            }
+
+            itr = m_table.insert(Entry(serial, BuoyPosition())).first;
+          }
+
+          itr->second.latitude = lat;
+          itr->second.longitude = lon;
+          itr->second.timestamp = now;
+          m_dirty = true;
+
+          return fresh;
+        }
+
+        //! Retrieve the position of a buoy.
+        //! @param[in] serial TBR serial number.
+        //! @return pointer to the buoy position or null if unknown.
+        const BuoyPosition*
+        find(uint16_t serial) const
+        {
+          Table::const_iterator itr = m_table.find(serial);
+          if (itr == m_table.end())
+            return NULL;
+
+          return &itr->second;
+        }
+
+        //! Remove entries older than the maximum age.
+        //! @param[in] now current time (seconds since epoch).
+        //! @return number of evicted entries.
+        size_t
+        evict(double now)
+        {
+          if (m_max_age <= 0.0)
+            return 0;
+
+          size_t count = 0;
+          Table::iterator itr = m_table.begin();
+          while (itr != m_table.end())
+          {
+            if (now - itr->second.timestamp > m_max_age)
+            {
+              itr = m_table.erase(itr);
+              ++count;
+            }
+            else
+            {
+              ++itr;
+            }
+          }
+
+          if (count > 0)
+            m_dirty = true;
+
+          return count;
+        }
+
+        //! Number of known buoys.
+        size_t
+        size(void) const
+        {
+          return m_table.size();
+        }
+
+        //! Test if the registry changed since it was last loaded or saved.
+        bool
+        isDirty(void) const
+        {
+          return m_dirty;
+        }
+
+        //! Save registry to a file. The snapshot is written to a
+        //! temporary file, synchronized to disk and then renamed over
+        //! the target.
+        //! @param[in] path snapshot file.
+        //! @return true on success, false otherwise.
+        bool
+        save(const Path& path)
+        {
+          std::string tmp = path.str() + ".tmp";
+          std::FILE* fd = std::fopen(tmp.c_str(), "wb");
+          if (fd == NULL)
+            return false;
+
+          uint8_t bfr[c_record_size];
+          uint8_t* ptr = bfr;
+          ptr += IMC::serialize(c_magic, ptr);
+          ptr += IMC::serialize((uint32_t)m_table.size(), ptr);
+          bool ok = write(fd, bfr, ptr - bfr);
+
+          uint16_t crc = 0;
+          for (Table::const_iterator itr = m_table.begin(); ok && itr != m_table.end(); ++itr)
+          {
+            ptr = bfr;
+            ptr += IMC::serialize(itr->first, ptr);
+            ptr += IMC::serialize((int32_t)itr->second.latitude, ptr);
+            ptr += IMC::serialize((int32_t)itr->second.longitude, ptr);
+            ptr += IMC::serialize((fp64_t)itr->second.timestamp, ptr);
+            crc = Algorithms::CRC16::compute(bfr, c_record_size, crc);
+            ok = write(fd, bfr, c_record_size);
+          }
+
+          IMC::serialize(crc, bfr);
+          ok = ok && write(fd, bfr, sizeof(crc));
+
+          // The snapshot must be on disk before it replaces the old one.
+          ok = ok && sync(fd);
+          ok = (std::fclose(fd) == 0) && ok;
+
+          if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0)
+          {
+            std::remove(tmp.c_str());
+            return false;
+          }
+
+          syncDirectory(path);
+          m_dirty = false;
+          return true;
+        }
+
+        //! Load registry from a file. Entries already present are
+        //! kept unless the snapshot holds a more recent position.
+        //! @param[in] path snapshot file.
+        //! @param[in] now current time (seconds since epoch).
+        //! @return number of loaded entries or -1 if the snapshot is
+        //! missing or invalid.
+        int
+        load(const Path& path, double now)
+        {
+          std::ifstream ifs(path.c_str(), std::ios::binary);
+          if (!ifs.is_open())
+            return -1;
+
+          uint8_t bfr[c_record_size];
+          uint16_t len = 8;
+          uint32_t magic = 0;
+          uint32_t count = 0;
+
+          if (!ifs.read((char*)bfr, len))
+            return -1;
+
+          const uint8_t* ptr = bfr;
+          ptr += IMC::deserialize(magic, ptr, len);
+          IMC::deserialize(count, ptr, len);
+          if (magic != c_magic)
+            return -1;
+
+          // Do not trust the header count: the records and the CRC
+          // must fit in the rest of the file.
+          std::streampos start = ifs.tellg();
+          ifs.seekg(0, std::ios::end);
+          std::streamoff available = ifs.tellg() - start;
+          ifs.seekg(start);
+          if (!ifs || (uint64_t)count * c_record_size + sizeof(uint16_t) > (uint64_t)available)
+            return -1;
+
+          std::vector<std::pair<uint16_t, BuoyPosition> > records;
+          records.reserve(count);
+          uint16_t crc = 0;
+
+          for (uint32_t i = 0; i < count; ++i)
+          {
+            if (!ifs.read((char*)bfr, c_record_size))
+              return -1;
+
+            crc = Algorithms::CRC16::compute(bfr, c_record_size, crc);
+
+            uint16_t serial = 0;
+            int32_t lat = 0;
+            int32_t lon = 0;
+            fp64_t timestamp = 0;
+
+            len = c_record_size;
+            ptr = bfr;
+            ptr += IMC::deserialize(serial, ptr, len);
+            ptr += IMC::deserialize(lat, ptr, len);
+            ptr += IMC::deserialize(lon, ptr, len);
+            IMC::deserialize(timestamp, ptr, len);
+
+            BuoyPosition pos = {lat, lon, timestamp};
+            records.push_back(std::make_pair(serial, pos));
+          }
+
+          uint16_t stored_crc = 0;
+          len = sizeof(stored_crc);
+          if (!ifs.read((char*)bfr, len))
+            return -1;
+          IMC::deserialize(stored_crc, bfr, len);
+          if (stored_crc != crc)
+            return -1;
+
+          int loaded = 0;
+          for (size_t i = 0; i < records.size(); ++i)
+          {
+            const BuoyPosition& pos = records[i].second;
+            if (m_max_age > 0.0 && now - pos.timestamp > m_max_age)
+              continue;
+
+            const BuoyPosition* known = find(records[i].first);
+            if (known != NULL && known->timestamp >= pos.timestamp)
+              continue;
+
+            update(records[i].first, pos.latitude, pos.longitude, pos.timestamp);
+            ++loaded;
+          }
+
+          m_dirty = false;
+          return loaded;
+        }
+
+      private:
+        //! Write a buffer to a file.
+        //! @param[in] fd file.
+        //! @param[in] data buffer.
+        //! @param[in] size buffer size.
+        //! @return true on success, false otherwise.
+        static bool
+        write(std::FILE* fd, const uint8_t* data, size_t size)
+        {
+          return std::fwrite(data, 1, size, fd) == size;
+        }
+
+        //! Flush a file and synchronize it to disk.
+        //! @param[in] fd file.
+        //! @return true on success, false otherwise.
+        static bool
+        sync(std::FILE* fd)
+        {
+          if (std::fflush(fd) != 0)
+            return false;
+
+#if defined(DUNE_SYS_HAS_UNISTD_H)
+          return fsync(fileno(fd)) == 0;
+#else
+          return true;
+#endif
+        }
+
+        //! Synchronize the directory of a snapshot to disk, so that
+        //! the rename survives a power loss.
+        //! @param[in] path snapshot file.
+        static void
+        syncDirectory(const Path& path)
+        {
+#if defined(DUNE_SYS_HAS_FCNTL_H) && defined(DUNE_SYS_HAS_UNISTD_H)
+          std::string dir = path.dirname().str();
+          int fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY);
+          if (fd < 0)
+            return;
+
+          fsync(fd);
+          ::close(fd);
+#else
+          (void)path;
+#endif
+        }
+
+        //! Table type.
+        typedef std::unordered_map<uint16_t, BuoyPosition> Table;
+        //! Table entry.
+        typedef std::pair<uint16_t, BuoyPosition> Entry;
+        //! Snapshot file magic ("SLMB").
+        static const uint32_t c_magic = 0x424d4c53;
+        //! Size of a serialized record.
+        static const uint16_t c_record_size = 18;
+        //! Buoy table.
+        Table m_table;
+        //! Maximum number of buoys.
+        size_t m_capacity;
+        //! Maximum age of an entry.
+        double m_max_age;
+        //! True if table changed since last load/save.
+        bool m_dirty;
+
+        //! Remove the least recently updated entry.
+        void
+        evictOldest(void)
+        {
+          Table::iterator oldest = m_table.begin();
+          for (Table::iterator itr = m_table.begin(); itr != m_table.end(); ++itr)
+          {
+            if (itr->second.timestamp < oldest->second.timestamp)
+              oldest = itr;
+          }
+
+          if (oldest != m_table.end())
+            m_table.erase(oldest);
+        }
+      };
+    }
+  }
+}
+
+#endif
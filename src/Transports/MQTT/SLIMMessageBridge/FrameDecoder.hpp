@@ -0,0 +1,385 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+#ifndef TRANSPORTS_MQTT_SLIM_MESSAGE_BRIDGE_FRAME_DECODER_HPP_INCLUDED_
+#define TRANSPORTS_MQTT_SLIM_MESSAGE_BRIDGE_FRAME_DECODER_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <cstddef>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+namespace Transports
+{
+  namespace MQTT
+  {
+    namespace SLIMMessageBridge
+    {
+      using DUNE_NAMESPACES;
+
+      //! Decoder of SLIM payloads. Frames are decoded in place from
+      //! the received buffer and accumulated in a batch of TBRSensor
+      //! and TBRFishTag messages that is reused between payloads. The
+      //! batch keeps the order of the frames in the payload.
+      class FrameDecoder
+      {
+      public:
+        //! Header flags.
+        enum HeaderFlag
+        {
+          //! TBR detection/sensor frames.
+          HF_TBR = 0,
+          //! SLIM buoy status.
+          HF_STATUS = 1
+        };
+
+        //! SLIM payload header.
+        struct Header
+        {
+          //! TBR serial number.
+          uint16_t serial;
+          //! Reference timestamp of all frames in the payload.
+          uint32_t timestamp;
+          //! Header flag.
+          unsigned flag;
+        };
+
+        //! Size of the SLIM header.
+        static const size_t c_header_size = 6;
+        //! Minimum size of a SLIM status payload.
+        static const size_t c_status_size = 9;
+        //! Size of a TBR sensor frame.
+        static const size_t c_sensor_size = 8;
+        //! Marker of a TBR sensor frame (second byte of frame).
+        static const uint8_t c_sensor_marker = 255;
+
+        FrameDecoder(void):
+          m_sensor_count(0),
+          m_tag_count(0)
+        { }
+
+        //! Decode payload header.
+        //! @param[in] data payload.
+        //! @param[in] len payload length.
+        //! @param[out] hdr decoded header.
+        //! @return true if header is valid, false otherwise.
+        static bool
+        decodeHeader(const uint8_t* data, size_t len, Header& hdr)
+        {
+          if (len <= c_header_size)
+            return false;
+
+          hdr.serial = (data[0] << 6) | (data[1] >> 2);
+          hdr.timestamp = (uint32_t)data[2] << 24 | data[3] << 16 | data[4] << 8 | data[5];
+          hdr.flag = data[1] & 0x03;
+          return true;
+        }
+
+        //! Decode position of a SLIM status payload.
+        //! @param[in] data payload.
+        //! @param[in] len payload length.
+        //! @param[out] lat latitude.
+        //! @param[out] lon longitude.
+        //! @return true if payload is long enough, false otherwise.
+        static bool
+        decodeStatus(const uint8_t* data, size_t len, int& lat, int& lon)
+        {
+          if (len < c_status_size)
+            return false;
+
+          lat = (data[5] & 0x01) << 24 | data[6] << 16 | data[7] << 8 | data[8];
+          lon = (data[1] & 0x03) << 24 | data[2] << 16 | data[3] << 8 | data[4];
+          return true;
+        }
+
+        //! Decode all TBR frames of a payload into the batch. Frame
+        //! lengths are validated before any field is read; decoding
+        //! stops at the first unknown or truncated frame. Trailing
+        //! zero bytes are padding and are consumed without producing
+        //! frames.
+        //! @param[in] data payload (including header).
+        //! @param[in] len payload length.
+        //! @param[in] hdr decoded header.
+        //! @param[in] lat latitude of the buoy.
+        //! @param[in] lon longitude of the buoy.
+        //! @return number of bytes decoded, including the header and
+        //! padding.
+        size_t
+        decodeFrames(const uint8_t* data, size_t len, const Header& hdr, int lat, int lon)
+        {
+          m_sensor_count = 0;
+          m_tag_count = 0;
+          m_records.clear();
+
+          size_t index = c_header_size;
+          while (index < len)
+          {
+            if (isPadding(data + index, len - index))
+              return len;
+
+            const uint8_t* frame = data + index;
+            size_t size = frameSize(frame, len - index);
+            if (size == 0)
+              break;
+
+            Record record;
+            record.sensor = (frame[1] == c_sensor_marker);
+            if (record.sensor)
+            {
+              record.index = m_sensor_count;
+              fillSensor(nextSensor(), frame, hdr);
+            }
+            else
+            {
+              record.index = m_tag_count;
+              fillTag(nextTag(), frame, hdr, lat, lon);
+            }
+
+            m_records.push_back(record);
+            index += size;
+          }
+
+          return index;
+        }
+
+        //! Number of messages in the batch.
+        size_t
+        getCount(void) const
+        {
+          return m_records.size();
+        }
+
+        //! Get a message of the batch, in payload order.
+        //! @param[in] i message number.
+        //! @return TBRSensor or TBRFishTag message.
+        IMC::Message&
+        getMessage(size_t i)
+        {
+          const Record& record = m_records[i];
+          if (record.sensor)
+            return m_sensors[record.index];
+          return m_tags[record.index];
+        }
+
+        //! Number of TBRSensor messages in the batch.
+        size_t
+        getSensorCount(void) const
+        {
+          return m_sensor_count;
+        }
+
+        //! Get a TBRSensor message of the batch.
+        IMC::TBRSensor&
+        getSensor(size_t i)
+        {
+          return m_sensors[i];
+        }
+
+        //! Number of TBRFishTag messages in the batch.
+        size_t
+        getTagCount(void) const
+        {
+          return m_tag_count;
+        }
+
+        //! Get a TBRFishTag message of the batch.
+        IMC::TBRFishTag&
+        getTag(size_t i)
+        {
+          return m_tags[i];
+        }
+
+      private:
+        //! Layout of a detection frame for a given transmitter protocol.
+        struct TagLayout
+        {
+          //! Corresponding IMC protocol.
+          uint8_t protocol;
+          //! Frame size.
+          uint8_t size;
+          //! Number of bytes of transmitter id.
+          uint8_t id_bytes;
+          //! Number of bytes of transmitter data.
+          uint8_t data_bytes;
+        };
+
+        //! Position of a message in the batch.
+        struct Record
+        {
+          //! True for a TBRSensor, false for a TBRFishTag.
+          bool sensor;
+          //! Index in the sensor or fish tag batch.
+          size_t index;
+        };
+
+        //! Number of known transmitter protocols.
+        static const unsigned c_protocols = 8;
+        //! Batch of sensor messages.
+        std::vector<IMC::TBRSensor> m_sensors;
+        //! Number of valid sensor messages.
+        size_t m_sensor_count;
+        //! Batch of fish tag messages.
+        std::vector<IMC::TBRFishTag> m_tags;
+        //! Number of valid fish tag messages.
+        size_t m_tag_count;
+        //! Messages in payload order.
+        std::vector<Record> m_records;
+
+        //! Retrieve layout of a transmitter protocol.
+        //! @param[in] protocol SLIM transmitter protocol.
+        //! @return layout or null if protocol is unknown.
+        static const TagLayout*
+        getLayout(uint8_t protocol)
+        {
+          static const TagLayout c_layouts[c_protocols] =
+          {
+            {IMC::TBRFishTag::TBR_R256, 5, 1, 0},
+            {IMC::TBRFishTag::TBR_R04K, 6, 2, 0},
+            {IMC::TBRFishTag::TBR_R64K, 6, 2, 0},
+            {IMC::TBRFishTag::TBR_S256, 6, 1, 1},
+            {IMC::TBRFishTag::TBR_R01M, 7, 2, 1},
+            {IMC::TBRFishTag::TBR_S64K, 7, 2, 1},
+            {IMC::TBRFishTag::TBR_HS256, 7, 1, 2},
+            {IMC::TBRFishTag::TBR_DS256, 7, 1, 2}
+          };
+
+          if (protocol >= c_protocols)
+            return NULL;
+
+          return &c_layouts[protocol];
+        }
+
+        //! Compute size of the frame at the given position.
+        //! @param[in] frame start of frame.
+        //! @param[in] avail number of bytes available.
+        //! @return frame size or zero if frame is unknown or truncated.
+        static size_t
+        frameSize(const uint8_t* frame, size_t avail)
+        {
+          if (avail < 2)
+            return 0;
+
+          size_t size = 0;
+          if (frame[1] == c_sensor_marker)
+          {
+            size = c_sensor_size;
+          }
+          else
+          {
+            const TagLayout* layout = getLayout(frame[1]);
+            if (layout == NULL)
+              return 0;
+            size = layout->size;
+          }
+
+          return (size <= avail) ? size : 0;
+        }
+
+        //! Test if the rest of a payload is padding.
+        //! @param[in] ptr first byte.
+        //! @param[in] avail number of bytes available.
+        //! @return true if all bytes are zero, false otherwise.
+        static bool
+        isPadding(const uint8_t* ptr, size_t avail)
+        {
+          for (size_t i = 0; i < avail; ++i)
+          {
+            if (ptr[i] != 0)
+              return false;
+          }
+
+          return true;
+        }
+
+        //! Read a big-endian field.
+        static unsigned
+        readField(const uint8_t* ptr, unsigned bytes)
+        {
+          unsigned value = 0;
+          for (unsigned i = 0; i < bytes; ++i)
+            value = (value << 8) | ptr[i];
+          return value;
+        }
+
+        IMC::TBRSensor&
+        nextSensor(void)
+        {
+          if (m_sensor_count == m_sensors.size())
+            m_sensors.push_back(IMC::TBRSensor());
+          return m_sensors[m_sensor_count++];
+        }
+
+        IMC::TBRFishTag&
+        nextTag(void)
+        {
+          if (m_tag_count == m_tags.size())
+            m_tags.push_back(IMC::TBRFishTag());
+          return m_tags[m_tag_count++];
+        }
+
+        static void
+        fillSensor(IMC::TBRSensor& msg, const uint8_t* frame, const Header& hdr)
+        {
+          msg.serial_no = hdr.serial;
+          msg.unix_timestamp = hdr.timestamp + frame[0];
+          msg.temperature = fp32_t((frame[2] << 8) | frame[3]);
+          msg.avg_noise_level = frame[4];
+          msg.peak_noise_level = frame[5];
+          msg.recv_listen_freq = frame[6];
+          msg.recv_mem_addr = frame[7];
+        }
+
+        static void
+        fillTag(IMC::TBRFishTag& msg, const uint8_t* frame, const Header& hdr, int lat, int lon)
+        {
+          const TagLayout* layout = getLayout(frame[1]);
+          const uint8_t* tail = frame + layout->size - 2;
+
+          msg.serial_no = hdr.serial;
+          msg.unix_timestamp = hdr.timestamp + frame[0];
+          msg.trans_protocol = layout->protocol;
+          msg.trans_id = readField(frame + 2, layout->id_bytes);
+          msg.trans_data = readField(frame + 2 + layout->id_bytes, layout->data_bytes);
+          msg.snr = tail[0] >> 2;
+          msg.millis = (tail[0] & 0x03) << 8 | tail[1];
+          // Frequency and memory address are not part of the SLIM
+          // message format.
+          msg.trans_freq = 0;
+          msg.recv_mem_addr = 0;
+          msg.lat = lat;
+          msg.lon = lon;
+        }
+      };
+    }
+  }
+}
+
+#endif
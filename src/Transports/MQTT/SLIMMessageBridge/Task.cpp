@@ -33,6 +33,11 @@
 #include <DUNE/DUNE.hpp>
 #include <mqtt/async_client.h>
 
+// Local headers.
+#include <Transports/MQTT/Receiver.hpp>
+#include "BuoyRegistry.hpp"
+#include "FrameDecoder.hpp"
+
 
 
 namespace Transports
@@ -50,17 +55,6 @@ namespace Transports
 	    mqtt::connect_options conn_opts;
       mqtt::async_client* mqtt_client;
       auto timeout = std::chrono::seconds(10);
-      
-      //TODO could be made more C++ styled
-      typedef struct slim_bouy_status {
-        uint16_t  tbr_sensor_id;
-        int  latitude;
-        int  longitude;
-      } slim_bouy_status_t;
-
-      
-      slim_bouy_status_t *slim_bouys;
-      int number_of_detected_slim_bouys = 0;
 
        struct Arguments
       {
@@ -80,6 +74,11 @@ namespace Transports
         std::string planId; //IMC Plan ID
         unsigned int planOp; //IMC Plan Op
         unsigned int max_number_of_slim_bouys; 
+        double bouy_timeout; //Time after which a silent bouy is forgotten
+        double snapshot_period; //Period between bouy registry snapshots
+        unsigned int rx_capacity; //Maximum number of queued MQTT messages
+        unsigned int rx_high_water; //Queue depth considered congested
+        double rx_delay; //Queueing delay considered late
       };
 
       struct Task: public DUNE::Tasks::Task
@@ -92,12 +91,25 @@ namespace Transports
         //Buffers
         DUNE::Utils::ByteBuffer m_buf;
         DUNE::Utils::ByteBuffer m_buf_receive;
+        // Known bouy positions.
+        BuoyRegistry m_bouys;
+        // Path to bouy registry snapshot.
+        Path m_bouys_file;
+        // Timer to evict and save bouy registry.
+        Time::Counter<double> m_snapshot_timer;
+        // SLIM payload decoder.
+        FrameDecoder m_decoder;
+        // Paho callback and queue of received MQTT messages.
+        Receiver m_receiver;
+        // Messages drained from the receive queue.
+        std::vector<Arrival> m_rx_batch;
 
         //! Constructor.
         //! @param[in] name task name.
         //! @param[in] ctx context.
         Task(const std::string& name, Tasks::Context& ctx):
-          DUNE::Tasks::Task(name, ctx)
+          DUNE::Tasks::Task(name, ctx),
+          m_receiver(*this)
         {
 
           param("MQTT Broker Address", m_args.address)
@@ -167,12 +179,42 @@ namespace Transports
           param("Max Number Of Bouys", m_args.max_number_of_slim_bouys)
           .defaultValue("1000")
           .description("Number of SLIM Bouys");
+
+          param("Bouy Timeout", m_args.bouy_timeout)
+          .defaultValue("86400")
+          .units(Units::Second)
+          .description("Time without status after which a bouy position is discarded (0 to keep forever)");
+
+          param("Bouy Snapshot Period", m_args.snapshot_period)
+          .defaultValue("60")
+          .units(Units::Second)
+          .description("Period between saves of known bouy positions to disk");
+
+          param("Receive Queue Capacity", m_args.rx_capacity)
+          .defaultValue("4096")
+          .minimumValue("1")
+          .description("Maximum number of received MQTT messages waiting to be decoded. Oldest messages are dropped when full");
+
+          param("Receive Queue High-Water Mark", m_args.rx_high_water)
+          .defaultValue("1024")
+          .description("Number of queued MQTT messages above which the link is reported as congested");
+
+          param("Receive Delay Threshold", m_args.rx_delay)
+          .defaultValue("1.0")
+          .units(Units::Second)
+          .description("Queueing time above which a received MQTT message is counted as delayed");
+
+          m_bouys_file = m_ctx.dir_db / "SLIMBouys.dat";
         }
 
         //! Update internal state with new parameter values.
         void
         onUpdateParameters(void)
         {
+          m_bouys.setCapacity(m_args.max_number_of_slim_bouys);
+          m_bouys.setMaxAge(m_args.bouy_timeout);
+          m_snapshot_timer.setTop(m_args.snapshot_period);
+          m_receiver.setLimits(m_args.rx_capacity, m_args.rx_high_water, m_args.rx_delay);
         }
 
         //! Reserve entity identifiers.
@@ -200,10 +242,11 @@ namespace Transports
 
           //inf(adr_string.c_str());
 
-          slim_bouys = new slim_bouy_status_t[m_args.max_number_of_slim_bouys];
+          loadBouys();
 
 
           mqtt_client = new mqtt::async_client(adr_string, m_args.client_id);
+          mqtt_client->set_callback(m_receiver);
 
           conn_opts.set_keep_alive_interval(200); 
 	        conn_opts.set_clean_session(true); 
@@ -215,7 +258,6 @@ namespace Transports
           {
             mqtt_client->connect(conn_opts)->wait();
             inf(DTR("connected to MQTT broker"));
-		        mqtt_client->start_consuming();
             std::string subscribe_str(m_args.subscribe_topic.c_str());
             
             char lastChar = subscribe_str.back();
@@ -248,8 +290,8 @@ namespace Transports
         onResourceRelease(void)
         {
           inf(DTR("onResourceRelease"));
-          
-          delete slim_bouys;
+
+          saveBouys();
 
           try{
               if (mqtt_client)
@@ -259,7 +301,6 @@ namespace Transports
                // inf(DTR("Error: There are pending MQTT delivery tokens!" ));
                 
                 mqtt_client->unsubscribe(m_args.subscribe_topic)->wait();
-                mqtt_client->stop_consuming();
                 mqtt_client->disconnect()->wait();
                 delete mqtt_client;
               }
@@ -273,291 +314,166 @@ namespace Transports
 
 
 
+        //! Restore known bouy positions from the last snapshot.
+        void
+        loadBouys(void)
+        {
+          int count = m_bouys.load(m_bouys_file, Clock::getSinceEpoch());
+          if (count >= 0)
+            inf(DTR("restored %d bouy positions"), count);
+        }
+
+        //! Evict stale bouys and save known positions if they changed.
+        void
+        saveBouys(void)
+        {
+          m_bouys.evict(Clock::getSinceEpoch());
+          if (!m_bouys.isDirty())
+            return;
+
+          if (!m_bouys.save(m_bouys_file))
+            war(DTR("failed to save bouy positions to %s"), m_bouys_file.c_str());
+        }
+
         int setTBRlocation(int tbr_sensor, int latitude, int longitude)
         {
-          int sensor_index = -1; 
-          for(int i = 0; i < number_of_detected_slim_bouys; i++)
-          {
-            if(slim_bouys[i].tbr_sensor_id == tbr_sensor)
-            {
-              sensor_index = i;
-              break;
-            }
-          }
-          if(sensor_index == -1) //New sensor
-          {
-            inf(DTR("adding sensor" ));
-            sensor_index = number_of_detected_slim_bouys;
-            number_of_detected_slim_bouys++;
-          }
-          slim_bouys[sensor_index].longitude = longitude;
-          slim_bouys[sensor_index].latitude = latitude;
-          slim_bouys[sensor_index].tbr_sensor_id = tbr_sensor;
+          if (m_bouys.update(tbr_sensor, latitude, longitude, Clock::getSinceEpoch()))
+            debug("adding sensor %d", tbr_sensor);
+
           return 0; 
         }
 
         int getTBRlocation(int tbr_sensor, int* latitude, int* longitude)
         {
-          int sensor_index = -1; 
-          for(int i = 0; i < number_of_detected_slim_bouys; i++)
-          {
-            if(slim_bouys[i].tbr_sensor_id == tbr_sensor)
-            {
-              sensor_index = i;
-              break;
-            }
-          }
-          if(sensor_index == -1) //New sensor
+          const BuoyPosition* pos = m_bouys.find(tbr_sensor);
+          if (pos == NULL)
           {
-             err(DTR("Sensor not found" ));
+            err(DTR("Sensor not found" ));
             return -1;
           }
-          *longitude = slim_bouys[sensor_index].longitude;
-          *latitude  = slim_bouys[sensor_index].latitude ;
+          *longitude = pos->longitude;
+          *latitude  = pos->latitude;
           return 0; 
         }
 
 
-        int fillTBRSensorMessage(IMC::TBRSensor* sensor_msg, uint8_t* message, uint32_t base_timestamp)
-        { 
-          int message_size = 8;
-          sensor_msg->unix_timestamp = base_timestamp + message[0];
-          sensor_msg->temperature = fp32_t((message[2] << 8) | message[3]);
-          sensor_msg->avg_noise_level = message[4];
-          sensor_msg->peak_noise_level = message[5];
-          sensor_msg->recv_listen_freq = message[6];
-          sensor_msg->recv_mem_addr = message[7];
+        //! Decode a SLIM payload and dispatch the resulting messages.
+        //! @param[in] data payload.
+        //! @param[in] len payload length.
+        void
+        handlePayload(const uint8_t* data, size_t len)
+        {
+          FrameDecoder::Header hdr;
+          if (!FrameDecoder::decodeHeader(data, len, hdr)) //Message must at least contain SLIM header
+          {
+            debug("discarding short payload (%u bytes)", (unsigned)len);
+            return;
+          }
 
-          return message_size;
-        }
+          if (hdr.flag == FrameDecoder::HF_TBR) //TBR message
+          {
+            //get position 
+            int latitude = 0; 
+            int longitude = 0; 
+            getTBRlocation(hdr.serial, &latitude, &longitude);  //assume bouy is located at same position as last status message, else use (0,0)
+            if(latitude == 0 && longitude == 0)
+            {
+              err(DTR("Location of TBR sensor not known, sending with coordinates (lat:0, long:0)" )); 
+            }
 
-        int fillTBRFishTagMessage(IMC::TBRFishTag* tag_msg, uint8_t* message, uint32_t base_timestamp)
-        {
-          int message_size = -1;
-          tag_msg->unix_timestamp = base_timestamp + message[0];
-          tag_msg->trans_protocol = message[1];
+            size_t decoded = m_decoder.decodeFrames(data, len, hdr, latitude, longitude);
+            if (decoded < len)
+              war(DTR("TBR %u: discarding %u bytes of malformed frames"), hdr.serial, (unsigned)(len - decoded));
 
+            // Detections and sensor readings are dispatched in the
+            // order the receiver recorded them.
+            for (size_t i = 0; i < m_decoder.getCount(); ++i)
+            {
+              IMC::Message& msg = m_decoder.getMessage(i);
+              if (getDebugLevel() >= DEBUG_LEVEL_SPEW)
+                msg.toText(std::cerr);
+              dispatch(msg, DF_KEEP_TIME | DF_KEEP_SRC_EID);
+            }
 
-        switch (tag_msg->trans_protocol)
+            debug("TBR %u: dispatched %u sensor and %u fish tag messages", hdr.serial,
+                  (unsigned)m_decoder.getSensorCount(), (unsigned)m_decoder.getTagCount());
+          }
+          else if (hdr.flag == FrameDecoder::HF_STATUS) //SLIM status message
+          {
+            //extract TBR sensor and position and store such that it can be retrieved when handling TBR messages
+            int latitude = 0;
+            int longitude = 0;
+            if (!FrameDecoder::decodeStatus(data, len, latitude, longitude))
+            {
+              debug("discarding short status payload (%u bytes)", (unsigned)len);
+              return;
+            }
+
+            debug("TBR %u: status lat %d lon %d", hdr.serial, latitude, longitude);
+            setTBRlocation(hdr.serial, latitude, longitude);
+          }
+        }
+
+        //! Process a received MQTT message.
+        //! @param[in] msg MQTT message.
+        void
+        handleMessage(const mqtt::const_message_ptr& msg)
         {
-        case 0: //R256
-          tag_msg->trans_protocol = IMC::TBRFishTag::TBR_R256;
-          tag_msg->trans_id       = message[2];
-          tag_msg->trans_data     = 0;
-          message_size            = 5;
-          break;
-        case 1://R04K
-          tag_msg->trans_protocol = IMC::TBRFishTag::TBR_R04K;
-          tag_msg->trans_id       = message[2] << 8 | message[3];
-          tag_msg->trans_data     = 0;
-          message_size            = 6;
-          break;
-        case 2://R64K
-          tag_msg->trans_protocol = IMC::TBRFishTag::TBR_R64K;
-          tag_msg->trans_id       = message[2] << 8 | message[3];
-          tag_msg->trans_data     = 0;
-          message_size            = 6;
-          
-          break;
-        case 3: //S256
-          tag_msg->trans_protocol = IMC::TBRFishTag::TBR_S256;
-          tag_msg->trans_id       = message[2];
-          tag_msg->trans_data     = message[3];
-          message_size            = 6;
-          
-          break;
-        case 4: //R01M
-          tag_msg->trans_protocol = IMC::TBRFishTag::TBR_R01M;
-          tag_msg->trans_id       = message[2] << 8 | message[3];
-          tag_msg->trans_data     = message[4];
-          message_size            = 7;
-          
-          break;
-        case 5: //S64K
-          tag_msg->trans_protocol = IMC::TBRFishTag::TBR_S64K;
-          tag_msg->trans_id       = message[2] << 8 | message[3];
-          tag_msg->trans_data     = message[4];
-          message_size            = 7;
-          break;
-        case 6: //HS256
-          tag_msg->trans_protocol = IMC::TBRFishTag::TBR_HS256;
-          tag_msg->trans_id       = message[2];
-          tag_msg->trans_data     = message[3] << 8 | message[4];
-          message_size            = 7;
-          break;
-        case 7: //DS256
-          tag_msg->trans_protocol = IMC::TBRFishTag::TBR_DS256;
-          tag_msg->trans_id       = message[2];
-          tag_msg->trans_data     = message[3] << 8 | message[4];
-          message_size            = 7;
-          break;
-        default: 
-          //Unknown protocol
-          return -1;
-          break;
+          //Make sure the topic is the requested topic
+          const std::string& topic = msg->get_topic();
+          std::string part_of_topic_to_compare = topic.substr(0, m_args.subscribe_topic.size() - 1);
+
+          if(part_of_topic_to_compare.compare(m_args.subscribe_topic))
+          {
+            const mqtt::binary_ref& payload = msg->get_payload();
+            handlePayload((const uint8_t*)payload.data(), payload.size());
+          }
+          else
+          {
+            debug("topic of no interest: %s", topic.c_str());
+          }
         }
 
-          tag_msg->snr            = message[message_size -2] >>2;
-          tag_msg->millis         = (message[message_size -2] & 0b11) << 8 | message[message_size -1];
-          tag_msg->trans_freq     = 0; //Not part of SLIM message format, this has to be adapted if detection frequency
-          tag_msg->recv_mem_addr  = 0; // and recv_mem_addr is to be added.
+        //! Decode all queued MQTT messages.
+        void
+        drainMessages(void)
+        {
+          m_receiver.drain(m_rx_batch);
+          for (size_t i = 0; i < m_rx_batch.size(); ++i)
+            handleMessage(m_rx_batch[i].msg);
 
-          return message_size;
+          // Release payloads.
+          m_rx_batch.clear();
         }
-        
 
         //! Main loop.
         void
         onMain(void)
         {
-            //Variable declarations
-            uint8_t* p_receive;
-            unsigned int n_r_receive = 0;
-
           while (!stopping())
           {
-            
-            waitForMessages(1.0);
-
-            //Extract new message
-            auto msg = mqtt_client->consume_message();
-			      if (msg)
+            if (m_snapshot_timer.overflow())
             {
-            inf(DTR("Receiving message" ));
-              
-                
-
-              try
-              {
-                //Make sure the topic is the requested topic
-                std::string topic = msg->get_topic();
-                std::string part_of_topic_to_compare = topic.substr(0, m_args.subscribe_topic.size() - 1);
-
-                if(part_of_topic_to_compare.compare(m_args.subscribe_topic))
-                {
-
-                  n_r_receive = msg->get_payload().size();
-                  
-                  p_receive = (uint8_t*) msg->get_payload().data();
-
-
-                  
-                  if (n_r_receive > 6) //Message must at least contain SLIM header
-                  //extract message
-                  {
-                    inf(DTR("Extract header" ));
-                    //extract header
-                    int tbr_serial_number = (p_receive[0] << 6) | (p_receive[1] >> 2);
-                    int reference_timestamp = p_receive[2]  << 24 |
-                                                p_receive[3]  << 16 |
-                                                p_receive[4]  <<  8 |
-                                                p_receive[5]; 
-                    int header_flag = p_receive[1] & 0b11;
-
-                    if(header_flag == 0) //TBR message
-                    {              
-                      inf(DTR("Got TBR message" )); 
-                      //get position 
-                      int latitude = 0; 
-                      int longitude = 0; 
-                      getTBRlocation(tbr_serial_number, &latitude, &longitude);  //assume bouy is located at same position as last status message, else use (0,0)
-                      if(latitude == 0 && longitude == 0)
-                      {
-                        err(DTR("Location of TBR sensor not known, sending with coordinates (lat:0, long:0)" )); 
-                      }
-                      
-                      //extract messages
-                      unsigned int message_index = 6;
-                      IMC::TBRSensor sensor_msg;
-                      sensor_msg.serial_no = tbr_serial_number;
-
-
-                      IMC::TBRFishTag fish_tag_msg;
-                      fish_tag_msg.serial_no = tbr_serial_number;
-                      fish_tag_msg.lat = latitude; 
-                      fish_tag_msg.lon = longitude;
-
-
-                      int frame_size = 0;
-                      while(message_index + 5 <= n_r_receive)
-                      {
-                        inf(DTR("Extracting message" )); 
-                        if(p_receive[message_index + 1] == 255) //sensor data frame
-                        {
-                          frame_size = fillTBRSensorMessage(&sensor_msg, &(p_receive[message_index]), reference_timestamp);
- 
-                          if(frame_size > 0)
-                          {
-                            message_index += frame_size;
-                            inf(DTR("Dispatch sensor msg" ));
-                            dispatch(sensor_msg, DF_KEEP_TIME | DF_KEEP_SRC_EID);
-                          }
-                          else
-                          {
-                            //error unpacking message
-                            break;
-                          }
-                          
-                        }
-                        else
-                        {
-                          frame_size = fillTBRFishTagMessage(&fish_tag_msg, &(p_receive[message_index]), reference_timestamp);
-
-                          if(frame_size > 0)
-                          {
-                            message_index += frame_size;
-                            fish_tag_msg.toText(std::cout);
-                            inf(DTR("Dispatch fish tag msg" ));
-                            dispatch(fish_tag_msg, DF_KEEP_TIME | DF_KEEP_SRC_EID);
-                          }
-                          else
-                          {
-                            //error unpacking message
-                            break;
-                          }
-                        }
-                        
-                      }
-
-
-                    }
-                    else if(header_flag == 1) //SLIM status message
-                    {
-                      inf(DTR("Got SLIM Status message" )); 
-                      //extract TBR sensor and position and store such that it can be retrieved when handling TBR messages
-                      int latitude = (p_receive[5] & 0b1)<<24 |
-                                      p_receive[6] << 16 |
-                                      p_receive[7] <<  8 | 
-                                      p_receive[8]; 
-                      int longitude =(p_receive[1] & 0b11)<<24 |
-                                      p_receive[2] << 16 |
-                                      p_receive[3] <<  8 | 
-                                      p_receive[4]; 
-                      setTBRlocation(tbr_serial_number, latitude, longitude);
-
-                    
-                    }
-                
-
-                  }     
-
-
-                }
-                else{
-                    inf(DTR("Topic of no interrest" ));
-                }
-              }
-              catch (std::exception& e)
-              {
-                  throw RestartNeeded(e.what(), 5);
-              }
+              saveBouys();
+              m_snapshot_timer.reset();
+            }
 
-              
+            m_receiver.report();
 
+            try
+            {
+              drainMessages();
             }
-			    
-          }
+            catch (std::exception& e)
+            {
+              throw RestartNeeded(e.what(), 5);
+            }
+
+            // Consumes IMC messages, MQTT arrivals wake the task up as
+            // well.
+            waitForMessages(1.0);
           }
+        }
       };
     }
   }
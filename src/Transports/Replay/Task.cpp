@@ -72,8 +72,12 @@ namespace Transports
       double m_ts_delta;
       double m_start_time;
 
-      // Replay file handle
+      // Replay file handle (compressed logs).
       std::istream* m_is;
+      // Indexed reader (uncompressed logs).
+      IMC::LogReader* m_reader;
+      // Next packet of the indexed reader.
+      size_t m_cursor;
       // last state from replay file
       IMC::EstimatedState m_estate;
 
@@ -98,7 +102,9 @@ namespace Transports
 
       Task(const std::string& name, Tasks::Context& ctx):
         Tasks::Task(name, ctx),
-        m_is(0)
+        m_is(0),
+        m_reader(0),
+        m_cursor(0)
       {
         param("Load At Start", m_args.startup_file)
         .defaultValue("")
@@ -242,9 +248,15 @@ namespace Transports
         {
           Compression::Methods method = Compression::Factory::detect(file.c_str());
           if (method == Compression::METHOD_UNKNOWN)
-            m_is = new std::ifstream(file.c_str(), std::ios::binary);
+          {
+            m_reader = new IMC::LogReader(file);
+            if (m_reader->isIndexRebuilt())
+              inf(DTR("indexed %u messages"), (unsigned)m_reader->getCount());
+          }
           else
+          {
             m_is = new Compression::FileInput(file.c_str(), method);
+          }
         }
         catch (std::exception& e)
         {
@@ -256,7 +268,7 @@ namespace Transports
 
         try
         {
-          m = IMC::Packet::deserialize(*m_is);
+          m = readMessage();
         }
         catch (std::exception& e)
         {
@@ -315,12 +327,42 @@ namespace Transports
         war("%s '%s'", DTR("started replay of"), file.c_str());
       }
 
+      IMC::Message*
+      readMessage(void)
+      {
+        if (m_reader == 0)
+          return IMC::Packet::deserialize(*m_is);
+
+        if (m_cursor >= m_reader->getCount())
+          return 0;
+
+        return m_reader->getMessage(m_cursor++);
+      }
+
       IMC::Message*
       getFirstMessageAfterSkip(double time_to_skip)
       {
         IMC::Message* m = 0;
         double time_origin = m_ts_delta;
-        m = IMC::Packet::deserialize(*m_is);
+
+        if (m_reader != 0)
+        {
+          size_t first = m_reader->seek(time_origin + time_to_skip);
+
+          // Do not miss information from EntityInfo
+          for (size_t i = m_reader->find(DUNE_IMC_ENTITYINFO, m_cursor); i < first;
+               i = m_reader->find(DUNE_IMC_ENTITYINFO, i + 1))
+          {
+            m = m_reader->getMessage(i);
+            updateEntityMap(m);
+            delete m;
+          }
+
+          m_cursor = first;
+          return readMessage();
+        }
+
+        m = readMessage();
         while (m)
         {
           if (m->getTimeStamp() - time_origin >= time_to_skip)
@@ -332,8 +374,8 @@ namespace Transports
           }
 
           delete m;
-          m = IMC::Packet::deserialize(*m_is);
-          if(getDebugLevel() >= DEBUG_LEVEL_SPEW)
+          m = readMessage();
+          if (m && getDebugLevel() >= DEBUG_LEVEL_SPEW)
             m->toText(std::cout);
         }
         return NULL;
@@ -389,6 +431,14 @@ namespace Transports
           delete m_is;
           m_is = 0;
         }
+
+        if (m_reader)
+        {
+          delete m_reader;
+          m_reader = 0;
+        }
+
+        m_cursor = 0;
         m_eid2eid.clear();
         m_tstats.clear();
         m_tgstats = Stats();
@@ -465,7 +515,7 @@ namespace Transports
 
           IMC::Message* m = 0;
 
-          while (!stopping() && (m = DUNE::IMC::Packet::deserialize(*m_is)) != 0 && !m_is->eof())
+          while (!stopping() && (m = readMessage()) != 0)
           {
             consumeMessages();
 
@@ -486,6 +536,9 @@ namespace Transports
             {
               dispatchWithNewTime(m);
             }
+
+            delete m;
+            m = 0;
           }
 
           stopReplay();
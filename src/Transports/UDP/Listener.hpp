@@ -31,7 +31,10 @@
 #define TRANSPORTS_UDP_LISTENER_HPP_INCLUDED_
 
 // ISO C++ 98 headers.
+#include <algorithm>
+#include <cstring>
 #include <map>
+#include <utility>
 #include <vector>
 
 // DUNE headers.
@@ -50,14 +53,48 @@ namespace Transports
     class Listener: public Concurrency::Thread
     {
     public:
+      //! Reception statistics.
+      struct Statistics
+      {
+        //! Number of datagrams received.
+        uint64_t datagrams;
+        //! Number of receive system calls (including poll).
+        uint64_t syscalls;
+        //! Largest batch (datagrams).
+        unsigned batch_max;
+        //! Number of datagrams dropped because a worker was busy.
+        uint64_t dropped;
+      };
+
+      //! Constructor.
+      //! @param[in] task parent task.
+      //! @param[in] sock socket to read from.
+      //! @param[in] lcomms limited communications object.
+      //! @param[in] contact_timeout contact timeout.
+      //! @param[in] trace true to print incoming messages.
+      //! @param[in] workers number of worker threads that decode and
+      //! dispatch messages, zero to do it in the listener thread.
       Listener(Tasks::Task& task, UDPSocket& sock, LimitedComms* lcomms,
-               float contact_timeout, bool trace = false):
+               float contact_timeout, bool trace = false, unsigned workers = 0):
         m_task(task),
         m_sock(sock),
         m_trace(trace),
         m_contacts(contact_timeout),
-        m_lcomms(lcomms)
-      {  }
+        m_lcomms(lcomms),
+        m_worker_count(workers)
+      {
+        std::memset(&m_stats, 0, sizeof(m_stats));
+      }
+
+      //! Get and reset reception statistics.
+      //! @param[out] stats statistics since the last call.
+      void
+      getStatistics(Statistics& stats)
+      {
+        ScopedMutex l(m_stats_lock);
+        stats = m_stats;
+        std::memset(&m_stats, 0, sizeof(m_stats));
+      }
 
       void
       getContacts(std::vector<Contact>& list)
@@ -78,8 +115,100 @@ namespace Transports
       }
 
     private:
+      //! Received datagram waiting to be decoded.
+      struct Packet
+      {
+        //! Datagram data.
+        std::vector<uint8_t> data;
+        //! Source address.
+        Address addr;
+      };
+
+      //! Contact table update (system id and address).
+      typedef std::pair<unsigned, Address> ContactUpdate;
+
+      //! Worker thread that decodes and dispatches the packets of a
+      //! subset of the sources. All packets of a source are handled
+      //! by the same worker, in order of arrival.
+      class Worker: public Concurrency::Thread
+      {
+      public:
+        //! Constructor.
+        //! @param[in] listener parent listener.
+        Worker(Listener& listener):
+          m_listener(listener)
+        { }
+
+        //! Queue a packet.
+        //! @param[in] pkt packet.
+        //! @return true if the packet was queued, false if the queue
+        //! is full.
+        bool
+        push(Packet* pkt)
+        {
+          ScopedCondition l(m_cond);
+          if (m_queue.size() >= c_queue_size)
+            return false;
+
+          m_queue.push_back(pkt);
+          m_cond.signal();
+          return true;
+        }
+
+        //! Stop the thread and wait for it to finish.
+        void
+        shutdown(void)
+        {
+          stop();
+          m_cond.lock();
+          m_cond.broadcast();
+          m_cond.unlock();
+          join();
+        }
+
+      private:
+        //! Maximum number of queued packets.
+        static const size_t c_queue_size = 1024;
+        //! Parent listener.
+        Listener& m_listener;
+        //! Queued packets.
+        std::vector<Packet*> m_queue;
+        //! Condition to signal queued packets.
+        Condition m_cond;
+
+        void
+        run(void)
+        {
+          std::vector<Packet*> batch;
+          std::vector<ContactUpdate> updates;
+
+          while (!isStopping())
+          {
+            m_cond.lock();
+            if (m_queue.empty())
+              m_cond.wait(1.0);
+            batch.swap(m_queue);
+            m_cond.unlock();
+
+            for (size_t i = 0; i < batch.size(); ++i)
+            {
+              if (!batch[i]->data.empty())
+                m_listener.handle(&batch[i]->data[0], batch[i]->data.size(),
+                                  batch[i]->addr, updates);
+            }
+
+            m_listener.updateContacts(updates);
+            m_listener.release(batch);
+          }
+
+          m_listener.release(m_queue);
+        }
+      };
+
       // Buffer capacity.
       static const int c_bfr_size = 65535;
+      // Maximum number of datagrams read at once.
+      static const unsigned c_batch_size = 16;
       // Poll timeout in milliseconds.
       static const int c_poll_tout = 1000;
       // Parent task.
@@ -94,56 +223,197 @@ namespace Transports
       RWLock m_contacts_lock;
       // LimitedComms object
       LimitedComms* m_lcomms;
+      // Reception statistics.
+      Statistics m_stats;
+      // Lock to serialize access to m_stats.
+      Mutex m_stats_lock;
+      // Number of worker threads.
+      unsigned m_worker_count;
+      // Worker threads.
+      std::vector<Worker*> m_workers;
+      // Unused packets.
+      std::vector<Packet*> m_free;
+      // Lock to serialize access to m_free.
+      Mutex m_free_lock;
+
+      //! Decode and dispatch a datagram.
+      //! @param[in] data datagram data.
+      //! @param[in] size datagram length.
+      //! @param[in] addr source address.
+      //! @param[in,out] updates pending contact table updates.
+      void
+      handle(const uint8_t* data, size_t size, const Address& addr,
+             std::vector<ContactUpdate>& updates)
+      {
+        try
+        {
+          IMC::Message* msg = IMC::Packet::deserialize(data, size);
+
+          if (m_lcomms->isActive())
+          {
+            if (msg->getId() == DUNE_IMC_ANNOUNCE)
+            {
+              m_lcomms->setAnnounce(static_cast<IMC::Announce*>(msg));
+            }
+
+            if (!m_lcomms->isNodeWithinRange(msg->getSource(), msg->getId()))
+            {
+              delete msg;
+              return;
+            }
+          }
+
+          if (updates.empty() || updates.back().first != msg->getSource()
+              || updates.back().second != addr)
+          {
+            updates.push_back(ContactUpdate(msg->getSource(), addr));
+          }
+
+          m_task.dispatch(msg, DF_KEEP_TIME | DF_KEEP_SRC_EID);
+
+          if (m_trace)
+            msg->toText(std::cerr);
+
+          delete msg;
+        }
+        catch (std::exception & e)
+        {
+          m_task.debug("error while unpacking message: %s",e.what());
+        }
+      }
+
+      //! Apply pending contact table updates under a single lock.
+      //! @param[in,out] updates pending updates, cleared on return.
+      void
+      updateContacts(std::vector<ContactUpdate>& updates)
+      {
+        if (updates.empty())
+          return;
+
+        m_contacts_lock.lockWrite();
+        for (size_t i = 0; i < updates.size(); ++i)
+          m_contacts.update(updates[i].first, updates[i].second);
+        m_contacts_lock.unlock();
+
+        updates.clear();
+      }
+
+      //! Get an unused packet.
+      //! @return packet.
+      Packet*
+      acquire(void)
+      {
+        ScopedMutex l(m_free_lock);
+        if (m_free.empty())
+          return new Packet;
+
+        Packet* pkt = m_free.back();
+        m_free.pop_back();
+        return pkt;
+      }
+
+      //! Return packets to the list of unused packets.
+      //! @param[in,out] pkts packets, cleared on return.
+      void
+      release(std::vector<Packet*>& pkts)
+      {
+        ScopedMutex l(m_free_lock);
+        m_free.insert(m_free.end(), pkts.begin(), pkts.end());
+        pkts.clear();
+      }
+
+      //! Hand a datagram to the worker of its source.
+      //! @param[in] dgram datagram.
+      //! @return true if the datagram was queued, false if it was dropped.
+      bool
+      distribute(const UDPSocket::Datagram& dgram)
+      {
+        uint32_t key = dgram.addr.toInteger() ^ ((uint32_t)dgram.port * 2654435761u);
+        Worker* worker = m_workers[(key ^ (key >> 16)) % m_workers.size()];
+
+        Packet* pkt = acquire();
+        pkt->data.assign(dgram.data, dgram.data + dgram.size);
+        pkt->addr = dgram.addr;
+        if (worker->push(pkt))
+          return true;
+
+        std::vector<Packet*> dropped(1, pkt);
+        release(dropped);
+        return false;
+      }
 
       void
       run(void)
       {
-        Address addr;
-        uint8_t* bfr = new uint8_t[c_bfr_size];
+        std::vector<uint8_t> bfr(c_batch_size * c_bfr_size);
+        UDPSocket::Datagram dgrams[c_batch_size];
+        std::vector<ContactUpdate> updates;
         double poll_tout = c_poll_tout / 1000.0;
 
+        for (unsigned i = 0; i < m_worker_count; ++i)
+        {
+          m_workers.push_back(new Worker(*this));
+          m_workers.back()->start();
+        }
+
         while (!isStopping())
         {
+          size_t count = 0;
+          // poll() is a system call too.
+          unsigned syscalls = 1;
+
           try
           {
-            if (!Poll::poll(m_sock, poll_tout))
-              continue;
-
-            uint16_t rv = m_sock.read(bfr, c_bfr_size, &addr);
-            IMC::Message* msg = IMC::Packet::deserialize(bfr, rv);
-
-            if (m_lcomms->isActive())
+            if (Poll::poll(m_sock, poll_tout))
             {
-              if (msg->getId() == DUNE_IMC_ANNOUNCE)
+              for (unsigned i = 0; i < c_batch_size; ++i)
               {
-                m_lcomms->setAnnounce(static_cast<IMC::Announce*>(msg));
+                dgrams[i].data = &bfr[i * c_bfr_size];
+                dgrams[i].size = c_bfr_size;
               }
 
-              if (!m_lcomms->isNodeWithinRange(msg->getSource(), msg->getId()))
-              {
-                delete msg;
-                continue;
-              }
+              count = m_sock.read(dgrams, c_batch_size, &syscalls);
             }
-
-            m_contacts_lock.lockWrite();
-            m_contacts.update(msg->getSource(), addr);
-            m_contacts_lock.unlock();
-
-            m_task.dispatch(msg, DF_KEEP_TIME | DF_KEEP_SRC_EID);
-
-            if (m_trace)
-              msg->toText(std::cerr);
-
-            delete msg;
           }
           catch (std::exception & e)
           {
-            m_task.debug("error while unpacking message: %s",e.what());
+            m_task.debug("error while receiving datagrams: %s", e.what());
+          }
+
+          unsigned dropped = 0;
+          if (m_workers.empty())
+          {
+            for (size_t i = 0; i < count; ++i)
+              handle(dgrams[i].data, dgrams[i].size, dgrams[i].addr, updates);
+            updateContacts(updates);
+          }
+          else
+          {
+            for (size_t i = 0; i < count; ++i)
+            {
+              if (!distribute(dgrams[i]))
+                ++dropped;
+            }
           }
+
+          m_stats_lock.lock();
+          m_stats.datagrams += count;
+          m_stats.syscalls += syscalls;
+          m_stats.batch_max = std::max(m_stats.batch_max, (unsigned)count);
+          m_stats.dropped += dropped;
+          m_stats_lock.unlock();
+        }
+
+        for (size_t i = 0; i < m_workers.size(); ++i)
+        {
+          m_workers[i]->shutdown();
+          delete m_workers[i];
         }
+        m_workers.clear();
 
-        delete [] bfr;
+        for (size_t i = 0; i < m_free.size(); ++i)
+          delete m_free[i];
+        m_free.clear();
       }
     };
   }
@@ -39,6 +39,9 @@
 // DUNE headers.
 #include <DUNE/DUNE.hpp>
 
+// Local headers.
+#include "Sender.hpp"
+
 namespace Transports
 {
   namespace UDP
@@ -137,22 +140,16 @@ namespace Transports
         return true;
       }
 
-      //! Send data to node.
-      //! @param[in] sock UDP destination socket.
-      //! @param[in] data data to be transmitted.
-      //! @param[in] data_len length of data to be transmitted.
+      //! Add the active address of the node to the destinations
+      //! of the last message queued for sending.
+      //! @param[in] sender datagram sender.
       void
-      send(UDPSocket& sock, const uint8_t* data, unsigned data_len)
+      send(Sender& sender)
       {
         if (m_active == m_addrs.end())
           return;
 
-        try
-        {
-          sock.write(data, data_len, m_active->first, m_active->second);
-        }
-        catch (...)
-        { }
+        sender.add(m_active->first, m_active->second);
       }
 
     private:
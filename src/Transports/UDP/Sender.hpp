@@ -0,0 +1,256 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Eivind Jølsgard                                                 *
+//***************************************************************************
+
+#ifndef TRANSPORTS_UDP_SENDER_HPP_INCLUDED_
+#define TRANSPORTS_UDP_SENDER_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+namespace Transports
+{
+  namespace UDP
+  {
+    using DUNE_NAMESPACES;
+
+    //! Shortest time to wait for messages before a flush (s).
+    static const double c_min_wait = 0.001;
+
+    //! Coalesces outgoing datagrams and sends them in batches.
+    class Sender
+    {
+    public:
+      //! Transmission statistics.
+      struct Statistics
+      {
+        //! Number of queued messages.
+        uint64_t messages;
+        //! Number of datagrams sent.
+        uint64_t datagrams;
+        //! Number of send system calls.
+        uint64_t syscalls;
+        //! Number of flushed batches.
+        uint64_t batches;
+        //! Largest batch (datagrams).
+        unsigned batch_max;
+      };
+
+      //! Constructor.
+      //! @param[in] sock UDP socket.
+      Sender(UDPSocket& sock):
+        m_sock(sock),
+        m_offset(0),
+        m_size(0),
+        m_flush_time(-1.0)
+      {
+        resetStatistics();
+      }
+
+      //! Queue a message. Subsequent calls to add() select its
+      //! destinations.
+      //! @param[in] data serialized message.
+      //! @param[in] size message length.
+      void
+      queue(const uint8_t* data, size_t size)
+      {
+        m_offset = m_data.size();
+        m_size = size;
+        m_data.insert(m_data.end(), data, data + size);
+        ++m_stats.messages;
+      }
+
+      //! Add a destination of the last queued message.
+      //! @param[in] addr destination address.
+      //! @param[in] port destination port.
+      void
+      add(const Address& addr, uint16_t port)
+      {
+        Pending pending = {m_offset, m_size, addr, port};
+        m_pending.push_back(pending);
+      }
+
+      //! Get the number of datagrams waiting to be sent.
+      //! @return number of datagrams.
+      size_t
+      getPending(void) const
+      {
+        return m_pending.size();
+      }
+
+      //! Get the number of bytes of queued messages.
+      //! @return number of bytes.
+      size_t
+      getQueuedBytes(void) const
+      {
+        return m_data.size();
+      }
+
+      //! Schedule a flush of the queued datagrams, unless one is
+      //! already scheduled.
+      //! @param[in] window maximum time a datagram waits to be sent (s).
+      void
+      schedule(double window)
+      {
+        if (m_flush_time < 0)
+          m_flush_time = Clock::get() + window;
+      }
+
+      //! Send the queued datagrams if their scheduled flush is due.
+      //! @return true if datagrams were sent, false otherwise.
+      bool
+      flushIfDue(void)
+      {
+        if (m_flush_time < 0 || Clock::get() < m_flush_time)
+          return false;
+
+        flush();
+        return true;
+      }
+
+      //! Get the time to wait for messages before the scheduled
+      //! flush. Never zero, as a zero timeout waits forever.
+      //! @param[in] max maximum time to wait (s).
+      //! @return time to wait (s).
+      double
+      getWaitTime(double max) const
+      {
+        if (m_flush_time < 0)
+          return max;
+
+        return trimValue(m_flush_time - Clock::get(), c_min_wait, max);
+      }
+
+      //! Send all queued datagrams. Datagrams that cannot be sent are
+      //! dropped.
+      void
+      flush(void)
+      {
+        m_flush_time = -1.0;
+
+        if (m_pending.empty())
+        {
+          m_data.clear();
+          return;
+        }
+
+        m_dgrams.resize(m_pending.size());
+        for (size_t i = 0; i < m_pending.size(); ++i)
+        {
+          m_dgrams[i].data = &m_data[m_pending[i].offset];
+          m_dgrams[i].size = m_pending[i].size;
+          m_dgrams[i].addr = m_pending[i].addr;
+          m_dgrams[i].port = m_pending[i].port;
+        }
+
+        size_t count = m_dgrams.size();
+        size_t sent = 0;
+        while (sent < count)
+        {
+          unsigned syscalls = 0;
+
+          try
+          {
+            size_t rv = m_sock.write(&m_dgrams[sent], count - sent, &syscalls);
+            m_stats.datagrams += rv;
+            sent += rv;
+
+            // Skip the datagram that could not be sent.
+            if (sent < count)
+              ++sent;
+          }
+          catch (...)
+          {
+            ++sent;
+          }
+
+          m_stats.syscalls += syscalls;
+        }
+
+        ++m_stats.batches;
+        m_stats.batch_max = std::max(m_stats.batch_max, (unsigned)count);
+
+        m_pending.clear();
+        m_data.clear();
+      }
+
+      //! Get transmission statistics.
+      //! @return statistics.
+      const Statistics&
+      getStatistics(void) const
+      {
+        return m_stats;
+      }
+
+      //! Reset transmission statistics.
+      void
+      resetStatistics(void)
+      {
+        std::memset(&m_stats, 0, sizeof(m_stats));
+      }
+
+    private:
+      //! Datagram waiting to be sent.
+      struct Pending
+      {
+        //! Offset of the message in the data buffer.
+        size_t offset;
+        //! Message length.
+        size_t size;
+        //! Destination address.
+        Address addr;
+        //! Destination port.
+        uint16_t port;
+      };
+
+      //! UDP socket.
+      UDPSocket& m_sock;
+      //! Queued messages.
+      std::vector<uint8_t> m_data;
+      //! Datagrams waiting to be sent.
+      std::vector<Pending> m_pending;
+      //! Datagrams of the batch being sent.
+      std::vector<UDPSocket::Datagram> m_dgrams;
+      //! Offset of the last queued message.
+      size_t m_offset;
+      //! Length of the last queued message.
+      size_t m_size;
+      //! Transmission statistics.
+      Statistics m_stats;
+      //! Time of the scheduled flush (negative if none).
+      double m_flush_time;
+    };
+  }
+}
+
+#endif
@@ -42,6 +42,7 @@
 #include "NodeTable.hpp"
 #include "Listener.hpp"
 #include "LimitedComms.hpp"
+#include "Sender.hpp"
 
 namespace Transports
 {
@@ -84,12 +85,20 @@ namespace Transports
       bool only_local;
       // Optional custom service type
       std::string custom_service;
+      // Outgoing message coalescing window.
+      double coalescing_window;
+      // Statistics report period.
+      float stats_per;
+      // Number of receive worker threads.
+      unsigned rx_workers;
     };
 
     // Internal buffer size.
     static const int c_bfr_size = 65535;
     // Port bind retries.
     static const int c_port_retries = 5;
+    // Maximum number of datagrams waiting to be sent.
+    static const size_t c_max_pending = 4 * UDPSocket::c_max_batch;
 
     struct Task: public DUNE::Tasks::Task
     {
@@ -97,6 +106,10 @@ namespace Transports
       uint8_t* m_bfr;
       //! UDP Socket.
       UDPSocket m_sock;
+      //! Outgoing datagram batches.
+      Sender m_sender;
+      //! Statistics report counter.
+      Time::Counter<float> m_stats_counter;
       //! Set of static nodes.
       std::set<NodeAddress> m_static_dsts;
       //! Set of destination nodes.
@@ -119,6 +132,7 @@ namespace Transports
       Task(const std::string& name, Tasks::Context& ctx):
         DUNE::Tasks::Task(name, ctx),
         m_bfr(NULL),
+        m_sender(m_sock),
         m_listener(NULL),
         m_lcomms(NULL)
       {
@@ -184,6 +198,23 @@ namespace Transports
         .defaultValue("")
         .description("Optional custom service type (imc+udp+<Custom Service Type>), empty entry gives default service (imc+udp)");
 
+        param("Coalescing Window", m_args.coalescing_window)
+        .defaultValue("0")
+        .minimumValue("0")
+        .units(Units::Second)
+        .description("Maximum time outgoing messages are held to be sent in a single batch, 0 to send them as soon as they are consumed");
+
+        param("Receive Workers", m_args.rx_workers)
+        .defaultValue("0")
+        .maximumValue("16")
+        .description("Number of threads that decode and dispatch incoming messages, 0 to do it in the listener thread. Messages of the same sender are always handled in order");
+
+        param("Statistics Period", m_args.stats_per)
+        .defaultValue("60")
+        .minimumValue("0")
+        .units(Units::Second)
+        .description("Period of the debug report of datagram and system call counts, 0 to disable");
+
         // Allocate space for internal buffer.
         m_bfr = new uint8_t[c_bfr_size];
 
@@ -203,6 +234,9 @@ namespace Transports
         if (paramChanged(m_args.contact_refresh_per))
           m_contacts_refresh_counter.setTop(m_args.contact_refresh_per);
 
+        if (paramChanged(m_args.stats_per))
+          m_stats_counter.setTop(m_args.stats_per);
+
         // Initialize set of static destinations.
         m_static_dsts.clear();
         for (unsigned int i = 0; i < m_args.destinations.size(); ++i)
@@ -299,7 +333,8 @@ namespace Transports
 
         // Start listener thread.
         m_listener = new Listener(*this, m_sock, m_lcomms,
-                                  m_args.contact_timeout, m_args.trace_in);
+                                  m_args.contact_timeout, m_args.trace_in,
+                                  m_args.rx_workers);
         m_listener->start();
 
         setEntityState(IMC::EntityState::ESTA_NORMAL, Status::CODE_ACTIVE);
@@ -308,6 +343,8 @@ namespace Transports
       void
       onResourceRelease(void)
       {
+        m_sender.flush();
+
         if (m_listener != NULL)
         {
           m_listener->stopAndJoin();
@@ -340,24 +377,57 @@ namespace Transports
           msg->toText(std::cerr);
 
         uint16_t rv = IMC::Packet::serialize(msg, m_bfr, c_bfr_size);
+        m_sender.queue(m_bfr, rv);
 
         // Send to static nodes.
         std::set<NodeAddress>::iterator itr = m_static_dsts.begin();
         for (; itr != m_static_dsts.end(); ++itr)
-        {
-          try
-          {
-            m_sock.write(m_bfr, rv, itr->getAddress(), itr->getPort());
-          }
-          catch (...)
-          { }
-        }
+          m_sender.add(itr->getAddress(), itr->getPort());
 
         if (m_args.dynamic_nodes)
         {
           // Send to dynamic nodes.
-          m_node_table.send(m_sock, m_bfr, rv, msg->getId());
+          m_node_table.send(m_sender, msg->getId());
+        }
+
+        if (m_args.coalescing_window <= 0
+            || m_sender.getPending() >= c_max_pending
+            || m_sender.getQueuedBytes() >= (size_t)c_bfr_size)
+        {
+          m_sender.flush();
         }
+        else
+        {
+          m_sender.schedule(m_args.coalescing_window);
+        }
+      }
+
+      //! Report and reset datagram statistics.
+      void
+      reportStatistics(void)
+      {
+        const Sender::Statistics& out = m_sender.getStatistics();
+        if (out.messages > 0)
+        {
+          debug("sent %llu messages as %llu datagrams in %llu system calls "
+                "(%.3f calls per message, %.1f datagrams per batch, largest batch %u)",
+                (unsigned long long)out.messages, (unsigned long long)out.datagrams,
+                (unsigned long long)out.syscalls, (double)out.syscalls / out.messages,
+                out.batches ? (double)out.datagrams / out.batches : 0.0, out.batch_max);
+        }
+
+        Listener::Statistics in;
+        m_listener->getStatistics(in);
+        if (in.datagrams > 0)
+        {
+          debug("received %llu datagrams in %llu system calls "
+                "(%.3f calls per datagram, largest batch %u, %llu dropped)",
+                (unsigned long long)in.datagrams, (unsigned long long)in.syscalls,
+                (double)in.syscalls / in.datagrams, in.batch_max,
+                (unsigned long long)in.dropped);
+        }
+
+        m_sender.resetStatistics();
       }
 
       void
@@ -409,7 +479,16 @@ namespace Transports
       {
         while (!stopping())
         {
-          waitForMessages(1.0);
+          // Flush before waiting, the flush may be overdue.
+          m_sender.flushIfDue();
+          waitForMessages(m_sender.getWaitTime(1.0));
+          m_sender.flushIfDue();
+
+          if (m_args.stats_per > 0 && m_stats_counter.overflow())
+          {
+            reportStatistics();
+            m_stats_counter.reset();
+          }
 
           // Check if it's time to update the contact list.
           if (m_contacts_refresh_counter.overflow())
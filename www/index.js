@@ -35,6 +35,8 @@ var g_data = null;
 var g_dune_logs = null;
 var g_dune_logbook = null;
 var g_logbook_timer = null;
+var g_stream = null;
+var g_messages = null;
 
 window.onload = function()
 {
@@ -114,15 +116,67 @@ function requestData()
     HTTP.get('dune/state/messages.js', handleData, options);
 };
 
+function startStream()
+{
+    g_stream = new EventSource('dune/state/stream');
+
+    g_stream.onerror = function()
+    {
+        setConnected(false);
+    };
+
+    // The first event after (re)connecting carries every message.
+    g_stream.onopen = function()
+    {
+        g_messages = {};
+        requestData();
+    };
+
+    g_stream.addEventListener('messages', function(event)
+    {
+        var updates = JSON.parse(event.data);
+        if (g_messages == null)
+            g_messages = {};
+
+        for (var key in updates)
+            g_messages[key] = updates[key];
+
+        if (g_data == null)
+            return;
+
+        setConnected(true);
+        g_data.dune_messages = [];
+        for (var key in g_messages)
+            g_data.dune_messages.push(g_messages[key]);
+
+        processData(g_data);
+    });
+};
+
 function handleData(text)
 {
     setConnected(true);
 
-    if (g_timer == null)
+    eval(text);
+
+    if (g_stream == null && typeof EventSource !== 'undefined')
+    {
+        startStream();
+    }
+    else if (g_stream == null && g_timer == null)
+    {
         g_timer = setInterval(requestData, 4000);
+    }
 
-    eval(text);
+    // Messages are kept up to date by the event stream.
+    if (g_stream != null && g_messages != null && g_data != null)
+        data.dune_messages = g_data.dune_messages;
 
+    processData(data);
+};
+
+function processData(data)
+{
     // Check UID.
     if (g_uid == null)
     {